@@ -0,0 +1,47 @@
+#include "alignment_score.h"
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "map_logic.h"
+
+static AlignmentBlock makeBlock(size_t sequences, size_t length) {
+    AlignmentBlock block;
+    block.reference = generateSequence(length, 1);
+    for (size_t i = 0; i < sequences; ++i) {
+        std::string s = generateSequence(length, 100 + i);
+        for (size_t c = i % 17; c < s.size(); c += 17) s[c] = '-';
+        block.sequences.push_back({"S" + std::to_string(i), SequenceType::DNA, s, s});
+    }
+    return block;
+}
+
+// Scoring a whole block, as after a load...
+BENCHMARK(AlignmentScore_FullRescore) {
+    AlignmentBlock block = makeBlock(200, state.scaled(10000));
+    AlignmentScorer scorer;
+    state.setItems(block.sequences.size() * block.sequences[0].aligned.size());
+    while (state.keepRunning()) {
+        scorer.reset(block);
+        doNotOptimize(scorer.sumOfPairs());
+    }
+}
+
+// ...versus keeping the score current through 1000 single-cell edits.
+BENCHMARK(AlignmentScore_IncrementalEdits) {
+    AlignmentBlock block = makeBlock(200, state.scaled(10000));
+    AlignmentScorer scorer;
+    scorer.reset(block);
+    const size_t length = block.sequences[0].aligned.size();
+    state.setItems(1000);
+    uint64_t step = 0;
+    while (state.keepRunning()) {
+        for (int i = 0; i < 1000; ++i, ++step) {
+            size_t seq = (step * 7919) % block.sequences.size();
+            size_t column = (step * 104729) % length;
+            char& cell = block.sequences[seq].aligned[column];
+            char before = cell;
+            cell = "ACGT-"[step % 5];
+            scorer.update(block, seq, column, before);
+        }
+        doNotOptimize(scorer.sumOfPairs());
+    }
+}
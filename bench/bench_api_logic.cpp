@@ -0,0 +1,47 @@
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "api_logic.h"
+
+BENCHMARK(Api_ParseGeneResponse) {
+    auto genes = generateGenes(state.scaled(100000));
+    const std::string body = genesToNcbiResponse(genes);
+    state.setItems(genes.size());
+    while (state.keepRunning()) {
+        size_t parsed = 0;
+        GeneJsonStreamParser parser([&](GeneModel&& g) { parsed += g.symbol.size(); });
+        parser.feed(body);
+        doNotOptimize(parsed);
+    }
+}
+
+BENCHMARK(Api_ParseGeneResponseChunked) {
+    // 16 KiB chunks, as a socket read loop would deliver them.
+    auto genes = generateGenes(state.scaled(100000));
+    const std::string body = genesToNcbiResponse(genes);
+    state.setItems(genes.size());
+    while (state.keepRunning()) {
+        size_t parsed = 0;
+        GeneJsonStreamParser parser([&](GeneModel&& g) { parsed += g.symbol.size(); });
+        for (size_t pos = 0; pos < body.size(); pos += 16384) {
+            parser.feed(body.data() + pos, std::min<size_t>(16384, body.size() - pos));
+        }
+        doNotOptimize(parsed);
+    }
+}
+
+BENCHMARK(Api_FetchBatched) {
+    // Batching, URL building and merging with an in-memory getter; the rate limit is lifted.
+    size_t count = state.scaled(20000);
+    auto genes = generateGenes(count);
+    std::vector<std::string> accessions;
+    for (const auto& g : genes) accessions.push_back(g.symbol);
+    const std::string body = genesToNcbiResponse(std::vector<GeneModel>(genes.begin(), genes.begin() + std::min<size_t>(200, count)));
+    NcbiFetchOptions options;
+    options.requestsPerSecond = 1e9;
+    auto getter = [&](const std::string&, const std::string&) { return body; };
+    state.setItems(count);
+    while (state.keepRunning()) {
+        auto fetched = fetchGeneDataFromNCBI(accessions, options, "", getter);
+        doNotOptimize(fetched);
+    }
+}
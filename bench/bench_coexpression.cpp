@@ -0,0 +1,44 @@
+#include "bench_runner.h"
+#include "coexpression.h"
+#include <random>
+#include <string>
+
+// Genes over 24 regions, each following one of 40 shared patterns plus noise.
+static std::vector<GeneModel> makeProfiledGenes(size_t count) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> noise(0.0, 0.3);
+    std::vector<std::string> regions;
+    for (int r = 0; r < 24; ++r) regions.push_back("region" + std::to_string(r));
+    std::vector<GeneModel> genes(count);
+    for (size_t g = 0; g < count; ++g) {
+        genes[g].symbol = "G" + std::to_string(g);
+        for (size_t r = 0; r < regions.size(); ++r) {
+            double pattern = double((g % 40 + 1) * (r + 3) % 17) / 17.0;
+            setRegionExpression(genes[g].brainRegionExpression, regions[r], pattern + noise(rng));
+        }
+    }
+    return genes;
+}
+
+// Gene pairs per second, keeping pairs with |r| >= 0.9...
+BENCHMARK(Coexpression_Threshold) {
+    auto genes = makeProfiledGenes(state.scaled(8000));
+    CoexpressionOptions options;
+    options.minCorrelation = 0.9;
+    state.setItems(genes.size() * (genes.size() - 1) / 2);
+    while (state.keepRunning()) {
+        doNotOptimize(buildCoexpressionNetwork(genes, options).edges.size());
+    }
+}
+
+// ...and each gene's ten strongest partners, which visits every pair twice.
+BENCHMARK(Coexpression_TopK) {
+    auto genes = makeProfiledGenes(state.scaled(8000));
+    CoexpressionOptions options;
+    options.minCorrelation = 0.0;
+    options.topK = 10;
+    state.setItems(genes.size() * (genes.size() - 1) / 2);
+    while (state.keepRunning()) {
+        doNotOptimize(buildCoexpressionNetwork(genes, options).edges.size());
+    }
+}
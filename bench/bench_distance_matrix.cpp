@@ -0,0 +1,36 @@
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "distance_matrix.h"
+
+// Samples diverging from a common ancestor at about 2% of columns.
+static std::vector<SequenceModel> makeSamples(size_t samples, size_t length) {
+    std::string ancestor = generateSequence(length, 3);
+    std::vector<SequenceModel> seqs;
+    for (size_t i = 0; i < samples; ++i) {
+        std::string s = ancestor;
+        for (size_t c = (i * 13) % 50; c < s.size(); c += 50) s[c] = "ACGT-"[(c + i) % 5];
+        seqs.push_back({"S" + std::to_string(i), SequenceType::DNA, s, s});
+    }
+    return seqs;
+}
+
+// Column comparisons per second over all pairs, tiled...
+BENCHMARK(Distances_Tiled) {
+    auto seqs = makeSamples(state.scaled(400), 50000);
+    state.setItems(seqs.size() * (seqs.size() - 1) / 2 * seqs[0].aligned.size());
+    while (state.keepRunning()) {
+        doNotOptimize(computeDistanceMatrix(seqs).pairCount());
+    }
+}
+
+// ...and walking every pair across the full length, as one big tile.
+BENCHMARK(Distances_Untiled) {
+    auto seqs = makeSamples(state.scaled(400), 50000);
+    DistanceOptions options;
+    options.tileSequences = seqs.size();
+    options.bandColumns = seqs[0].aligned.size() + 64;
+    state.setItems(seqs.size() * (seqs.size() - 1) / 2 * seqs[0].aligned.size());
+    while (state.keepRunning()) {
+        doNotOptimize(computeDistanceMatrix(seqs, options).pairCount());
+    }
+}
@@ -0,0 +1,68 @@
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "exporters.h"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+BENCHMARK(Export_GenesCSV) {
+    AlignmentMap map;
+    for (auto& g : generateGenes(state.scaled(1000000))) map.addGene(std::move(g));
+    std::string path = writeTempFile("bench_export_genes.csv", "");
+    state.setItems(map.getGenes().size());
+    while (state.keepRunning()) {
+        doNotOptimize(exportGenes(map, path, ExportFormat::CSV));
+    }
+    std::remove(path.c_str());
+}
+
+BENCHMARK(Export_GenesJSON) {
+    AlignmentMap map;
+    for (auto& g : generateGenes(state.scaled(1000000))) map.addGene(std::move(g));
+    std::string path = writeTempFile("bench_export_genes.json", "");
+    state.setItems(map.getGenes().size());
+    while (state.keepRunning()) {
+        doNotOptimize(exportGenes(map, path, ExportFormat::JSON));
+    }
+    std::remove(path.c_str());
+}
+
+// Baseline: the same CSV through std::ofstream and operator<< at round-trip precision.
+BENCHMARK(Export_GenesCSVIostream) {
+    auto genes = generateGenes(state.scaled(1000000));
+    std::string path = writeTempFile("bench_export_genes_iostream.csv", "");
+    state.setItems(genes.size());
+    while (state.keepRunning()) {
+        std::ofstream out(path);
+        out << std::setprecision(17);
+        out << "gene_name,knockout,status,expression_level,disorderTags,brainRegionExpression\n";
+        for (const auto& g : genes) {
+            out << g.symbol << ',' << (g.isKnockout ? "X" : "") << ',' << (g.isKnockout ? "Inactive" : "Active")
+                << ',' << g.expressionLevel << ',';
+            for (size_t i = 0; i < g.disorderTags.size(); ++i) out << (i ? ";" : "") << g.disorderTags[i];
+            out << ',';
+            bool first = true;
+            for (const auto& kv : g.brainRegionExpression) {
+                out << (first ? "" : ";") << kv.first << ':' << kv.second;
+                first = false;
+            }
+            out << '\n';
+        }
+        doNotOptimize(out.good());
+    }
+    std::remove(path.c_str());
+}
+
+BENCHMARK(Export_SequencesFASTA) {
+    std::vector<SequenceModel> sequences;
+    for (size_t i = 0; i < state.scaled(2000); ++i) {
+        std::string s = generateSequence(1000, i + 1);
+        sequences.push_back({"seq" + std::to_string(i), SequenceType::DNA, s, s});
+    }
+    std::string path = writeTempFile("bench_export_seqs.fasta", "");
+    state.setItems(sequences.size());
+    while (state.keepRunning()) {
+        doNotOptimize(exportSequences(sequences, path, ExportFormat::FASTA));
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,35 @@
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "expression_stats.h"
+
+BENCHMARK(Stats_SketchAdd) {
+    auto genes = generateGenes(state.scaled(1000000));
+    state.setItems(genes.size());
+    while (state.keepRunning()) {
+        ExpressionStatistics stats;
+        for (const auto& g : genes) stats.add(g);
+        doNotOptimize(stats);
+    }
+}
+
+// Percentile reads cost the same at any gene count.
+BENCHMARK(Stats_PercentileQuery) {
+    ExpressionStatistics stats;
+    for (const auto& g : generateGenes(state.scaled(1000000))) stats.add(g);
+    stats.compact();
+    state.setItems(1000);
+    while (state.keepRunning()) {
+        double sum = 0;
+        for (int i = 0; i < 1000; ++i) sum += stats.expression.quantile(0.5) + stats.expression.quantile(0.99);
+        doNotOptimize(sum);
+    }
+}
+
+BENCHMARK(Stats_TopKBySort) {
+    auto genes = generateGenes(state.scaled(1000000));
+    state.setItems(genes.size());
+    while (state.keepRunning()) {
+        auto top = selectTopGenes(genes, 50, [](const GeneModel& g) { return g.expressionLevel; });
+        doNotOptimize(top);
+    }
+}
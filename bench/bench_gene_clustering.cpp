@@ -0,0 +1,41 @@
+#include "bench_runner.h"
+#include "gene_clustering.h"
+#include <random>
+#include <string>
+
+// Genes over 24 regions, each following one of 40 shared patterns plus noise.
+static std::vector<GeneModel> makeProfiledGenes(size_t count) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> noise(0.0, 0.3);
+    std::vector<std::string> regions;
+    for (int r = 0; r < 24; ++r) regions.push_back("region" + std::to_string(r));
+    std::vector<GeneModel> genes(count);
+    for (size_t g = 0; g < count; ++g) {
+        genes[g].symbol = "G" + std::to_string(g);
+        for (size_t r = 0; r < regions.size(); ++r) {
+            double pattern = double((g % 40 + 1) * (r + 3) % 17) / 17.0;
+            setRegionExpression(genes[g].brainRegionExpression, regions[r], pattern + noise(rng));
+        }
+    }
+    return genes;
+}
+
+// Genes clustered per second with average linkage...
+BENCHMARK(Clustering_Average) {
+    auto genes = makeProfiledGenes(state.scaled(5000));
+    state.setItems(genes.size());
+    while (state.keepRunning()) {
+        doNotOptimize(clusterGenes(genes).merges.size());
+    }
+}
+
+// ...and with Ward linkage.
+BENCHMARK(Clustering_Ward) {
+    auto genes = makeProfiledGenes(state.scaled(5000));
+    ClusteringOptions options;
+    options.linkage = Linkage::Ward;
+    state.setItems(genes.size());
+    while (state.keepRunning()) {
+        doNotOptimize(clusterGenes(genes, options).merges.size());
+    }
+}
@@ -0,0 +1,61 @@
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "gene_query.h"
+#include <stdexcept>
+
+// Generated genes carry tags but no categories or scores; add a skewed
+// category vocabulary (a few common, most rare) and uniform scores.
+static AlignmentMap queryMap(size_t count) {
+    static const char* kCategories[] = {"dopamine receptor", "synaptic plasticity", "ion channel",
+                                        "neurotrophic factor", "transcription factor"};
+    SplitMix64 rng(99);
+    AlignmentMap map;
+    map.reserveGenes(count);
+    for (auto& g : generateGenes(count)) {
+        g.categories.emplace_back(kCategories[rng.below(64) == 0 ? rng.below(5) : 1 + rng.below(2)]);
+        g.polygenicScore = rng.unit();
+        map.addGene(std::move(g));
+    }
+    return map;
+}
+
+BENCHMARK(Query_SelectiveIndexed) {
+    AlignmentMap map = queryMap(state.scaled(1000000));
+    GeneQueryEngine engine(map);
+    GeneQuery query = parseGeneQuery("category = dopamine receptor AND expression > 6 AND tag contains ADHD");
+    state.setItems(1);
+    size_t matches = 0;
+    while (state.keepRunning()) {
+        matches = engine.evaluate(query).cardinality();
+        doNotOptimize(matches);
+    }
+    if (matches == 0) throw std::runtime_error("query matched nothing");
+}
+
+// The hand-written loop the query engine replaces.
+BENCHMARK(Query_SelectiveLinearScan) {
+    AlignmentMap map = queryMap(state.scaled(1000000));
+    state.setItems(1);
+    size_t matches = 0;
+    while (state.keepRunning()) {
+        matches = 0;
+        for (const auto& g : map.getGenes()) {
+            bool category = false, tag = false;
+            for (const auto& c : g.categories) category |= c == "dopamine receptor";
+            for (const auto& t : g.disorderTags) tag |= t == "ADHD";
+            matches += category && g.expressionLevel > 6 && tag;
+        }
+        doNotOptimize(matches);
+    }
+}
+
+BENCHMARK(Query_BroadIndexed) {
+    AlignmentMap map = queryMap(state.scaled(1000000));
+    GeneQueryEngine engine(map);
+    GeneQuery query = parseGeneQuery("(category = ion channel OR tag = Autism) AND polygenic >= 0.5");
+    state.setItems(1);
+    while (state.keepRunning()) {
+        GeneBitset result = engine.evaluate(query);
+        doNotOptimize(result);
+    }
+}
@@ -0,0 +1,51 @@
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "gene_snapshot.h"
+
+// Cost of a reader taking (and dropping) the current snapshot.
+BENCHMARK(Snapshot_Acquire) {
+    GeneSnapshotStore store;
+    store.append(generateGenes(state.scaled(200000)));
+    state.setItems(10000);
+    while (state.keepRunning()) {
+        size_t total = 0;
+        for (int i = 0; i < 10000; ++i) total += store.snapshot()->size();
+        doNotOptimize(total);
+    }
+}
+
+// Ingestion: 1000-gene batches published onto a growing store.
+BENCHMARK(Snapshot_AppendBatches) {
+    auto genes = generateGenes(state.scaled(200000));
+    state.setItems(genes.size());
+    while (state.keepRunning()) {
+        GeneSnapshotStore store;
+        for (size_t b = 0; b < genes.size(); b += 1000) {
+            GeneBatch batch = store.begin();
+            for (size_t i = b; i < std::min(genes.size(), b + 1000); ++i) batch.append(genes[i]);
+            store.publish(batch);
+        }
+        doNotOptimize(store);
+    }
+}
+
+// One edit publishes a new version by copying a single chunk...
+BENCHMARK(Snapshot_ToggleOneGene) {
+    auto genes = generateGenes(state.scaled(200000));
+    GeneSnapshotStore store;
+    store.append(genes);
+    state.setItems(1);
+    while (state.keepRunning()) {
+        doNotOptimize(store.toggleKnockout(genes[genes.size() / 2].symbol));
+    }
+}
+
+// ...where handing readers a private copy of the whole list copies every gene.
+BENCHMARK(Snapshot_ToggleOneGeneFullCopy) {
+    auto genes = generateGenes(state.scaled(200000));
+    state.setItems(1);
+    while (state.keepRunning()) {
+        auto copy = std::make_shared<const std::vector<GeneModel>>(genes);
+        doNotOptimize(copy);
+    }
+}
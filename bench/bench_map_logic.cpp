@@ -0,0 +1,168 @@
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "map_logic.h"
+#include <iostream>
+#include <stdexcept>
+
+// Loader benchmarks read from real files so stream and parsing costs are included.
+
+// A loader that silently drops records would look fast; fail the benchmark instead.
+static void checkLoaded(size_t loaded, size_t expected) {
+    if (loaded != expected) {
+        throw std::runtime_error("loaded " + std::to_string(loaded) + " of " + std::to_string(expected) + " records");
+    }
+}
+
+BENCHMARK(Loaders_GenesCSV) {
+    auto genes = generateGenes(state.scaled(200000));
+    std::string path = writeTempFile("genes.csv", genesToCSV(genes));
+    state.setItems(genes.size());
+    size_t loaded = 0;
+    while (state.keepRunning()) {
+        AlignmentMap map;
+        map.loadGenesFromCSV(path);
+        doNotOptimize(map);
+        loaded = map.getGenes().size();
+    }
+    checkLoaded(loaded, genes.size());
+}
+
+BENCHMARK(Loaders_GenesJSON) {
+    auto genes = generateGenes(state.scaled(200000));
+    std::string path = writeTempFile("genes.json", genesToJSON(genes));
+    state.setItems(genes.size());
+    size_t loaded = 0;
+    while (state.keepRunning()) {
+        AlignmentMap map;
+        map.loadGenesFromJSON(path);
+        doNotOptimize(map);
+        loaded = map.getGenes().size();
+    }
+    checkLoaded(loaded, genes.size());
+}
+
+// Same load with gene containers bump-allocated from the map's arena.
+BENCHMARK(Loaders_GenesCSVArena) {
+    auto genes = generateGenes(state.scaled(200000));
+    std::string path = writeTempFile("genes.csv", genesToCSV(genes));
+    state.setItems(genes.size());
+    size_t loaded = 0;
+    while (state.keepRunning()) {
+        AlignmentMap map;
+        map.setGeneStorage(GeneStorage::Arena);
+        map.loadGenesFromCSV(path);
+        doNotOptimize(map);
+        loaded = map.getGenes().size();
+    }
+    checkLoaded(loaded, genes.size());
+}
+
+BENCHMARK(Loaders_GenesJSONArena) {
+    auto genes = generateGenes(state.scaled(200000));
+    std::string path = writeTempFile("genes.json", genesToJSON(genes));
+    state.setItems(genes.size());
+    size_t loaded = 0;
+    while (state.keepRunning()) {
+        AlignmentMap map;
+        map.setGeneStorage(GeneStorage::Arena);
+        map.loadGenesFromJSON(path);
+        doNotOptimize(map);
+        loaded = map.getGenes().size();
+    }
+    checkLoaded(loaded, genes.size());
+}
+
+// 64 sample files, half CSV and half JSON, imported as one batch on all cores.
+BENCHMARK(Loaders_BatchImport) {
+    auto genes = generateGenes(state.scaled(200000));
+    const size_t files = 64;
+    std::vector<std::string> paths;
+    for (size_t f = 0; f < files; ++f) {
+        std::vector<GeneModel> part(genes.begin() + std::ptrdiff_t(genes.size() * f / files),
+                                    genes.begin() + std::ptrdiff_t(genes.size() * (f + 1) / files));
+        std::string name = "batch_" + std::to_string(f) + (f % 2 ? ".json" : ".csv");
+        paths.push_back(writeTempFile(name, f % 2 ? genesToJSON(part) : genesToCSV(part)));
+    }
+    state.setItems(genes.size());
+    size_t loaded = 0;
+    while (state.keepRunning()) {
+        AlignmentMap map;
+        map.importGeneFiles(paths);
+        doNotOptimize(map);
+        loaded = map.getGenes().size();
+    }
+    checkLoaded(loaded, genes.size());
+}
+
+// Teardown only: the map is filled untimed, then clearGenes() is measured.
+static void benchClearGenes(BenchState& state, GeneStorage storage) {
+    auto genes = generateGenes(state.scaled(500000));
+    state.setItems(genes.size());
+    AlignmentMap map;
+    map.setGeneStorage(storage);
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        for (const auto& g : genes) map.addGene(g);
+        state.resumeTiming();
+        map.clearGenes();
+    }
+    doNotOptimize(map);
+}
+
+BENCHMARK(Map_ClearGenesHeap) {
+    benchClearGenes(state, GeneStorage::Heap);
+}
+
+BENCHMARK(Map_ClearGenesArena) {
+    benchClearGenes(state, GeneStorage::Arena);
+}
+
+BENCHMARK(Loaders_SequencesCSV) {
+    size_t count = state.scaled(200);
+    std::string path = writeTempFile("sequences.csv", sequencesToCSV(count, 10000));
+    state.setItems(count);
+    size_t loaded = 0;
+    while (state.keepRunning()) {
+        AlignmentEditor editor;
+        editor.loadSequencesFromCSV(path);
+        doNotOptimize(editor);
+        loaded = editor.getSequences().size();
+    }
+    checkLoaded(loaded, count);
+}
+
+BENCHMARK(Map_CalculateStatistics) {
+    AlignmentMap map;
+    for (const auto& g : generateGenes(state.scaled(1000000))) map.addGene(g);
+    state.setItems(map.getGenes().size());
+    while (state.keepRunning()) {
+        GenomeStats stats = map.calculateStatistics();
+        doNotOptimize(stats);
+    }
+}
+
+BENCHMARK(Editor_ReverseComplement) {
+    // One long chromosome-scale sequence; the operation is applied to the selected one.
+    size_t length = state.scaled(10000000);
+    std::string path = writeTempFile("long_sequence.csv",
+                                     "sequence_id,sequence,annotations\nchr," + generateSequence(length) + ",synthetic\n");
+    AlignmentEditor editor;
+    editor.loadSequencesFromCSV(path);
+    state.setItems(length);
+    while (state.keepRunning()) {
+        editor.reverseComplementSelected();
+        doNotOptimize(editor);
+    }
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+// The editor only draws through the Windows console API.
+BENCHMARK(Render_AlignmentEditor) {
+    std::string path = writeTempFile("render_sequences.csv", sequencesToCSV(state.scaled(40), 2000));
+    AlignmentEditor editor;
+    editor.loadSequencesFromCSV(path);
+    state.setItems(1);
+    while (state.keepRunning()) editor.render(80, 24);
+    std::cout << std::string(24, '\n');
+}
+#endif
@@ -0,0 +1,39 @@
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "pathway_layout.h"
+
+// The pathway view's render path: layout (cold, warm after an edit, cached)
+// followed by projection onto the 80x24 console grid.
+
+BENCHMARK(Render_PathwayLayoutCold) {
+    Pathway pathway = generatePathway(state.scaled(2000), 2);
+    state.setItems(pathway.geneSymbols.size());
+    while (state.keepRunning()) {
+        PathwayLayout layout = computePathwayLayout(pathway);
+        doNotOptimize(layout);
+    }
+}
+
+BENCHMARK(Render_PathwayLayoutWarm) {
+    Pathway pathway = generatePathway(state.scaled(2000), 2);
+    PathwayLayout previous = computePathwayLayout(pathway);
+    pathway.geneSymbols.push_back("NEW");
+    pathway.interactions[pathway.geneSymbols[0]].push_back("NEW");
+    state.setItems(pathway.geneSymbols.size());
+    while (state.keepRunning()) {
+        PathwayLayout layout = computePathwayLayout(pathway, {}, &previous);
+        doNotOptimize(layout);
+    }
+}
+
+BENCHMARK(Render_PathwayGridFrame) {
+    // A steady-state frame: cache hit plus projection.
+    Pathway pathway = generatePathway(state.scaled(2000), 2);
+    PathwayLayoutCache cache;
+    cache.get(pathway);
+    state.setItems(1);
+    while (state.keepRunning()) {
+        auto placements = projectLayoutToGrid(cache.get(pathway), 78, 18);
+        doNotOptimize(placements);
+    }
+}
@@ -0,0 +1,36 @@
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "polygenic_score.h"
+#include <cstdio>
+#include <sstream>
+
+// Dosages for `variants` x 100 samples, with every other variant weighted
+// towards one of 2000 genes.
+static void writeInputs(size_t variants, std::string& weightsPath, std::string& dosagePath) {
+    std::ostringstream weights, dosages;
+    weights << "variant,gene,effect\n";
+    dosages << "variant";
+    for (int s = 0; s < 100; ++s) dosages << ",S" << s;
+    dosages << '\n';
+    for (size_t v = 0; v < variants; ++v) {
+        if (v % 2 == 0) weights << "rs" << v << ",GENE" << v % 2000 << ',' << double(v % 41) / 100.0 - 0.2 << '\n';
+        dosages << "rs" << v;
+        for (size_t s = 0; s < 100; ++s) dosages << ',' << (v * 31 + s * 7) % 3;
+        dosages << '\n';
+    }
+    weightsPath = writeTempFile("pgs_weights.csv", weights.str());
+    dosagePath = writeTempFile("pgs_dosages.csv", dosages.str());
+}
+
+// Variants streamed per second, weights loaded once.
+BENCHMARK(PolygenicScore_Stream) {
+    std::string weightsPath, dosagePath;
+    writeInputs(state.scaled(200000), weightsPath, dosagePath);
+    PolygenicWeights weights = PolygenicWeights::load(weightsPath);
+    state.setItems(state.scaled(200000));
+    while (state.keepRunning()) {
+        doNotOptimize(scorePolygenic(weights, dosagePath).variantsScored);
+    }
+    std::remove(weightsPath.c_str());
+    std::remove(dosagePath.c_str());
+}
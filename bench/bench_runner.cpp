@@ -0,0 +1,158 @@
+#include "bench_runner.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+// --- BenchState ---
+
+BenchState::BenchState(const BenchConfig& config) : config_(config) {}
+
+size_t BenchState::scaled(size_t base) const {
+    return std::max<size_t>(1, size_t(std::llround(double(base) * config_.scale)));
+}
+
+void BenchState::setItems(size_t items) {
+    items_ = items;
+}
+
+bool BenchState::keepRunning() {
+    auto now = std::chrono::steady_clock::now();
+    int warmup = std::max(0, config_.warmup);
+    if (runs_ > warmup) samples_.push_back(std::chrono::duration<double, std::nano>(now - started_).count() - pausedNs_);
+    if (runs_ == warmup + std::max(1, config_.repetitions)) return false;
+    ++runs_;
+    pausedNs_ = 0;
+    started_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+void BenchState::pauseTiming() {
+    pausedAt_ = std::chrono::steady_clock::now();
+}
+
+void BenchState::resumeTiming() {
+    pausedNs_ += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - pausedAt_).count();
+}
+
+// --- Reporting ---
+
+BenchResult summarizeSamples(const std::string& name, std::vector<double> samples, size_t items) {
+    BenchResult r;
+    r.name = name;
+    r.repetitions = int(samples.size());
+    r.items = items;
+    if (samples.empty()) return r;
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    r.minNs = samples.front();
+    r.medianNs = n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+    // Nearest-rank percentile.
+    r.p95Ns = samples[std::min(n - 1, size_t(std::ceil(0.95 * double(n))) - 1)];
+    r.meanNs = std::accumulate(samples.begin(), samples.end(), 0.0) / double(n);
+    if (items > 0 && r.medianNs > 0) r.itemsPerSecond = double(items) * 1e9 / r.medianNs;
+    return r;
+}
+
+static std::string formatDuration(double ns) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    if (ns >= 1e9) out << ns / 1e9 << " s";
+    else if (ns >= 1e6) out << ns / 1e6 << " ms";
+    else if (ns >= 1e3) out << ns / 1e3 << " us";
+    else out << ns << " ns";
+    return out.str();
+}
+
+static std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static bool writeJson(const std::string& path, const BenchConfig& config, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+    std::time_t now = std::time(nullptr);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    out << std::setprecision(12);
+    out << "{\n  \"timestamp\": \"" << stamp << "\",\n"
+        << "  \"config\": {\"warmup\": " << config.warmup << ", \"repetitions\": " << config.repetitions
+        << ", \"scale\": " << config.scale << "},\n"
+        << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"repetitions\": " << r.repetitions
+            << ", \"median_ns\": " << r.medianNs << ", \"p95_ns\": " << r.p95Ns
+            << ", \"min_ns\": " << r.minNs << ", \"mean_ns\": " << r.meanNs
+            << ", \"items\": " << r.items << ", \"items_per_second\": " << r.itemsPerSecond << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.good();
+}
+
+// --- Driver ---
+
+bool parseBenchArgs(int argc, char** argv, BenchConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        try {
+            if (arg == "--warmup" && hasValue) config.warmup = std::stoi(argv[++i]);
+            else if (arg == "--reps" && hasValue) config.repetitions = std::stoi(argv[++i]);
+            else if (arg == "--scale" && hasValue) config.scale = std::stod(argv[++i]);
+            else if (arg == "--filter" && hasValue) config.filter = argv[++i];
+            else if (arg == "--json" && hasValue) config.jsonPath = argv[++i];
+            else throw std::invalid_argument(arg);
+        } catch (const std::exception&) {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--warmup N] [--reps N] [--scale F] [--filter NAME] [--json PATH]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int run_all_benchmarks(const BenchConfig& config) {
+    std::vector<BenchResult> results;
+    int failed = 0;
+
+    std::cout << std::left << std::setw(34) << "Benchmark" << std::right
+              << std::setw(12) << "median" << std::setw(12) << "p95" << std::setw(14) << "items/s" << std::endl;
+    std::cout << std::string(72, '-') << std::endl;
+
+    for (const auto& benchmark : get_benchmarks()) {
+        if (!config.filter.empty() && benchmark.name.find(config.filter) == std::string::npos) continue;
+        std::cout << std::left << std::setw(34) << benchmark.name << std::flush;
+        BenchState state(config);
+        try {
+            benchmark.function(state);
+        } catch (const std::exception& e) {
+            std::cout << " FAILED: " << e.what() << std::endl;
+            failed++;
+            continue;
+        }
+        BenchResult r = summarizeSamples(benchmark.name, state.samples(), state.items());
+        std::ostringstream rate;
+        if (r.itemsPerSecond > 0) rate << std::scientific << std::setprecision(2) << r.itemsPerSecond;
+        std::cout << std::right << std::setw(12) << formatDuration(r.medianNs)
+                  << std::setw(12) << formatDuration(r.p95Ns) << std::setw(14) << rate.str() << std::endl;
+        results.push_back(r);
+    }
+
+    if (!config.jsonPath.empty() && !writeJson(config.jsonPath, config, results)) {
+        std::cerr << "Error: Could not write " << config.jsonPath << std::endl;
+        failed++;
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+#ifndef BENCH_RUNNER_H
+#define BENCH_RUNNER_H
+
+#include <chrono>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Minimal benchmark harness, registered like the TEST_CASEs in tests/
+//-----------------------------------------------------------------------------
+
+struct BenchConfig {
+    int         warmup = 1;    // untimed runs before measuring
+    int         repetitions = 5;
+    double      scale = 1.0;   // multiplies every benchmark's data size
+    std::string filter;        // run only benchmarks whose name contains this
+    std::string jsonPath;      // write results here when non-empty
+};
+
+// Passed to every benchmark. keepRunning() returns true warmup + repetitions
+// times and times each repetition between consecutive calls:
+//
+//     BENCHMARK(Example) {
+//         auto data = makeData(state.scaled(100000));   // untimed setup
+//         state.setItems(data.size());
+//         while (state.keepRunning()) work(data);       // timed
+//     }
+class BenchState {
+public:
+    explicit BenchState(const BenchConfig& config);
+
+    // Data size for a benchmark, scaled by --scale (at least 1).
+    size_t scaled(size_t base) const;
+    // Items processed per repetition; enables items/second in the report.
+    void setItems(size_t items);
+    bool keepRunning();
+    // Excludes per-repetition setup from the current sample.
+    void pauseTiming();
+    void resumeTiming();
+
+    const std::vector<double>& samples() const { return samples_; }
+    size_t items() const { return items_; }
+
+private:
+    const BenchConfig& config_;
+    int runs_ = 0;                // runs started so far
+    std::vector<double> samples_; // nanoseconds per repetition
+    size_t items_ = 0;
+    std::chrono::steady_clock::time_point started_;
+    std::chrono::steady_clock::time_point pausedAt_;
+    double pausedNs_ = 0;         // paused time within the current repetition
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void(BenchState&)> function;
+};
+
+inline std::vector<Benchmark>& get_benchmarks() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+struct BenchmarkRegister {
+    BenchmarkRegister(const std::string& name, std::function<void(BenchState&)> func) {
+        get_benchmarks().push_back({name, func});
+    }
+};
+
+#define BENCHMARK(name) \
+    void benchmark_##name(BenchState& state); \
+    BenchmarkRegister register_benchmark_##name(#name, benchmark_##name); \
+    void benchmark_##name(BenchState& state)
+
+// Keeps the compiler from discarding a result that is otherwise unused.
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(_MSC_VER)
+    static const void* volatile sink;
+    sink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+struct BenchResult {
+    std::string name;
+    int    repetitions = 0;
+    double medianNs = 0, p95Ns = 0, minNs = 0, meanNs = 0;
+    size_t items = 0;
+    double itemsPerSecond = 0;
+};
+
+// Summarizes raw per-repetition samples (nanoseconds).
+BenchResult summarizeSamples(const std::string& name, std::vector<double> samples, size_t items);
+
+// Parses --warmup N, --reps N, --scale F, --filter S and --json PATH.
+// @return False (after printing usage) on an unknown or malformed argument.
+bool parseBenchArgs(int argc, char** argv, BenchConfig& config);
+
+// Runs the registered benchmarks, prints a table and optionally writes JSON.
+int run_all_benchmarks(const BenchConfig& config);
+
+#endif // BENCH_RUNNER_H
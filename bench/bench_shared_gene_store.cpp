@@ -0,0 +1,42 @@
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "shared_gene_store.h"
+#include <cstdio>
+
+BENCHMARK(SharedStore_Build) {
+    auto genes = generateGenes(state.scaled(200000));
+    std::string path = writeTempFile("shared_genes.bin", "");
+    state.setItems(genes.size());
+    while (state.keepRunning()) {
+        doNotOptimize(buildSharedGeneStore(genes, path));
+    }
+    std::remove(path.c_str());
+}
+
+// What each extra reader process pays, against loading its own copy
+// (Loaders_GenesCSV) of the same genes.
+BENCHMARK(SharedStore_Attach) {
+    auto genes = generateGenes(state.scaled(200000));
+    std::string path = writeTempFile("shared_genes.bin", "");
+    buildSharedGeneStore(genes, path);
+    state.setItems(genes.size());
+    while (state.keepRunning()) {
+        SharedGeneStore store = SharedGeneStore::attach(path);
+        doNotOptimize(store.size());
+    }
+    std::remove(path.c_str());
+}
+
+BENCHMARK(SharedStore_FindSymbol) {
+    auto genes = generateGenes(state.scaled(200000));
+    std::string path = writeTempFile("shared_genes.bin", "");
+    buildSharedGeneStore(genes, path);
+    SharedGeneStore store = SharedGeneStore::attach(path);
+    state.setItems(10000);
+    while (state.keepRunning()) {
+        size_t found = 0;
+        for (size_t i = 0; i < 10000; ++i) found += store.find(genes[(i * 7919) % genes.size()].symbol) < store.size();
+        doNotOptimize(found);
+    }
+    std::remove(path.c_str());
+}
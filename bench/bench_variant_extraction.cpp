@@ -0,0 +1,39 @@
+#include "bench_runner.h"
+#include "data_generators.h"
+#include "variant_extraction.h"
+
+// Samples that differ from the reference at about one column in a thousand,
+// split between substitutions and short deletions.
+static AlignmentBlock makeSamples(size_t samples, size_t length) {
+    AlignmentBlock block;
+    block.reference = generateSequence(length, 1);
+    for (size_t i = 0; i < samples; ++i) {
+        std::string s = block.reference;
+        for (size_t c = (i * 37) % 1000; c + 3 < s.size(); c += 1000) {
+            if (c % 2) s[c] = s[c] == 'A' ? 'C' : 'A';
+            else s[c] = s[c + 1] = s[c + 2] = '-';
+        }
+        block.sequences.push_back({"S" + std::to_string(i), SequenceType::DNA, s, s});
+    }
+    return block;
+}
+
+// Bytes compared per second, with every variant recorded...
+BENCHMARK(Variants_Extract) {
+    AlignmentBlock block = makeSamples(200, state.scaled(250000));
+    state.setItems(block.sequences.size() * block.reference.size());
+    while (state.keepRunning()) {
+        doNotOptimize(extractVariants(block).variants.size());
+    }
+}
+
+// ...and counting only.
+BENCHMARK(Variants_CountOnly) {
+    AlignmentBlock block = makeSamples(200, state.scaled(250000));
+    VariantOptions options;
+    options.collectVariants = false;
+    state.setItems(block.sequences.size() * block.reference.size());
+    while (state.keepRunning()) {
+        doNotOptimize(extractVariants(block, options).sequences.size());
+    }
+}
@@ -0,0 +1,159 @@
+#include "data_generators.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+static const char* const kDisorders[] = {
+    "Schizophrenia", "ASD", "Bipolar", "Epilepsy", "Rett Syndrome", "Alzheimer's", "ADHD", "Depression"};
+static const char* const kRegions[] = {
+    "Cortex", "Hippocampus", "Cerebellum", "Striatum", "Thalamus", "Amygdala"};
+
+// --- SplitMix64 ---
+
+uint64_t SplitMix64::next() {
+    uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t SplitMix64::below(uint64_t bound) {
+    return bound == 0 ? 0 : next() % bound;
+}
+
+double SplitMix64::unit() {
+    return double(next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// --- Genes ---
+
+std::vector<GeneModel> generateGenes(size_t count, uint64_t seed) {
+    SplitMix64 rng(seed);
+    std::vector<GeneModel> genes(count);
+    for (size_t i = 0; i < count; ++i) {
+        GeneModel& g = genes[i];
+        g.symbol = "G" + std::to_string(i);
+        g.chromosome = "chr" + std::to_string(1 + rng.below(22));
+        g.start = int(rng.below(200000000));
+        g.end = g.start + 1000 + int(rng.below(100000));
+        // Two decimals keep text round-trips exact enough to compare.
+        g.expressionLevel = double(rng.below(1000)) / 100.0;
+        g.isKnockout = rng.below(10) == 0;
+        for (uint64_t t = rng.below(4); t > 0; --t) g.disorderTags.push_back(kDisorders[rng.below(8)]);
+        for (uint64_t r = rng.below(5); r > 0; --r) g.brainRegionExpression[kRegions[rng.below(6)]] = double(rng.below(100)) / 100.0;
+    }
+    return genes;
+}
+
+std::string genesToCSV(const std::vector<GeneModel>& genes) {
+    std::ostringstream out;
+    out << "gene_name,knockout,status,expression_level,disorderTags,brainRegionExpression\n";
+    for (const auto& g : genes) {
+        out << g.symbol << ',' << (g.isKnockout ? "X" : "") << ',' << (g.isKnockout ? "Inactive" : "Active")
+            << ',' << g.expressionLevel << ',';
+        for (size_t i = 0; i < g.disorderTags.size(); ++i) out << (i ? ";" : "") << g.disorderTags[i];
+        out << ',';
+        bool first = true;
+        for (const auto& kv : g.brainRegionExpression) {
+            out << (first ? "" : ";") << kv.first << ':' << kv.second;
+            first = false;
+        }
+        out << '\n';
+    }
+    return out.str();
+}
+
+// Shared by both JSON shapes; brainRegionExpression comes last because the
+// map loader ends each gene object at its first closing brace.
+static void writeGeneObject(std::ostream& out, const GeneModel& g) {
+    out << "    {\n      \"gene_name\": \"" << g.symbol << "\",\n"
+        << "      \"knockout\": " << (g.isKnockout ? "true" : "false") << ",\n"
+        << "      \"expression_level\": " << g.expressionLevel << ",\n"
+        << "      \"disorderTags\": [";
+    for (size_t i = 0; i < g.disorderTags.size(); ++i) out << (i ? ", " : "") << '"' << g.disorderTags[i] << '"';
+    out << "],\n      \"brainRegionExpression\": {";
+    bool first = true;
+    for (const auto& kv : g.brainRegionExpression) {
+        out << (first ? "" : ", ") << '"' << kv.first << "\": " << kv.second;
+        first = false;
+    }
+    out << "}\n    }";
+}
+
+std::string genesToJSON(const std::vector<GeneModel>& genes) {
+    std::ostringstream out;
+    out << "{\n  \"genes\": [\n";
+    for (size_t i = 0; i < genes.size(); ++i) {
+        writeGeneObject(out, genes[i]);
+        out << (i + 1 < genes.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+std::string genesToNcbiResponse(const std::vector<GeneModel>& genes) {
+    // The fetch parser reads the same per-gene fields; only the envelope differs.
+    std::ostringstream out;
+    out << "{\"total_count\": " << genes.size() << ", \"genes\": [\n";
+    for (size_t i = 0; i < genes.size(); ++i) {
+        writeGeneObject(out, genes[i]);
+        out << (i + 1 < genes.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+    return out.str();
+}
+
+// --- Sequences ---
+
+std::string generateSequence(size_t length, uint64_t seed) {
+    static const char kBases[] = {'A', 'C', 'G', 'T'};
+    SplitMix64 rng(seed);
+    std::string seq(length, 'A');
+    for (size_t i = 0; i < length; i += 32) {
+        uint64_t bits = rng.next();
+        for (size_t j = i; j < std::min(length, i + 32); ++j, bits >>= 2) seq[j] = kBases[bits & 3];
+    }
+    return seq;
+}
+
+std::string sequencesToCSV(size_t count, size_t length, uint64_t seed) {
+    std::string out = "sequence_id,sequence,annotations\n";
+    for (size_t i = 0; i < count; ++i) {
+        out += "seq" + std::to_string(i) + ',' + generateSequence(length, seed + i) + ",synthetic\n";
+    }
+    return out;
+}
+
+// --- Pathways ---
+
+Pathway generatePathway(size_t genes, size_t links, uint64_t seed) {
+    SplitMix64 rng(seed);
+    Pathway p;
+    p.name = "Synthetic" + std::to_string(genes);
+    p.description = "Generated benchmark pathway";
+    std::vector<size_t> endpoints; // every edge endpoint, for degree-proportional picks
+    for (size_t i = 0; i < genes; ++i) {
+        p.geneSymbols.push_back("G" + std::to_string(i));
+        for (size_t l = 0; l < links && i > 0; ++l) {
+            size_t target = endpoints.empty() ? rng.below(i) : endpoints[rng.below(endpoints.size())];
+            if (target == i) continue;
+            p.interactions[p.geneSymbols[target]].push_back(p.geneSymbols[i]);
+            endpoints.push_back(target);
+            endpoints.push_back(i);
+        }
+    }
+    return p;
+}
+
+// --- Files ---
+
+std::string writeTempFile(const std::string& name, const std::string& content) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / ("alignment_map_bench_" + name);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(content.data(), std::streamsize(content.size()));
+    if (!out.good()) throw std::runtime_error("Could not write " + path.string());
+    return path.string();
+}
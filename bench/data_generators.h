@@ -0,0 +1,52 @@
+#ifndef DATA_GENERATORS_H
+#define DATA_GENERATORS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Deterministic synthetic data for benchmarks
+//-----------------------------------------------------------------------------
+
+// SplitMix64: tiny, fast and, unlike the <random> distributions, produces the
+// same stream with every standard library, so generated data is identical on
+// any machine.
+class SplitMix64 {
+public:
+    explicit SplitMix64(uint64_t seed) : state_(seed) {}
+    uint64_t next();
+    // Uniform in [0, bound).
+    uint64_t below(uint64_t bound);
+    // Uniform in [0, 1).
+    double unit();
+
+private:
+    uint64_t state_;
+};
+
+// Genes with unique symbols, expression levels, 0-3 disorder tags and 0-4
+// brain-region values drawn from small fixed vocabularies.
+std::vector<GeneModel> generateGenes(size_t count, uint64_t seed = 42);
+
+// Serializes genes in the formats read by AlignmentMap::loadGenesFromCSV and
+// loadGenesFromJSON, and in the NCBI gene report shape parsed by the fetch API.
+std::string genesToCSV(const std::vector<GeneModel>& genes);
+std::string genesToJSON(const std::vector<GeneModel>& genes);
+std::string genesToNcbiResponse(const std::vector<GeneModel>& genes);
+
+// Random ACGT sequence of the given length.
+std::string generateSequence(size_t length, uint64_t seed = 7);
+
+// sequence_id,sequence,annotations CSV as read by AlignmentEditor::loadSequencesFromCSV.
+std::string sequencesToCSV(size_t count, size_t length, uint64_t seed = 7);
+
+// Scale-free-ish pathway: each new gene links to `links` earlier genes chosen
+// preferentially by degree.
+Pathway generatePathway(size_t genes, size_t links, uint64_t seed = 11);
+
+// Writes `content` to a file in the system temp directory and returns its path.
+std::string writeTempFile(const std::string& name, const std::string& content);
+
+#endif // DATA_GENERATORS_H
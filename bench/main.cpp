@@ -0,0 +1,7 @@
+#include "bench_runner.h"
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (!parseBenchArgs(argc, argv, config)) return 2;
+    return run_all_benchmarks(config);
+}
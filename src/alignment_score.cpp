@@ -0,0 +1,181 @@
+#include "alignment_score.h"
+#include "map_logic.h"
+#include "trace.h"
+#include <algorithm>
+#include <utility>
+
+// --- ScoringScheme ---
+
+ScoringScheme::ScoringScheme(int unknown, int gap) : gap_(gap) {
+    for (size_t a = 0; a < kSymbols; ++a) {
+        for (size_t b = 0; b < kSymbols; ++b) {
+            bool gapA = a == kGap, gapB = b == kGap;
+            table_[a][b] = (gapA && gapB) ? 0 : (gapA || gapB) ? gap : unknown;
+        }
+    }
+}
+
+void ScoringScheme::setScore(char a, char b, int value) {
+    table_[symbol(a)][symbol(b)] = value;
+    table_[symbol(b)][symbol(a)] = value;
+}
+
+ScoringScheme ScoringScheme::nucleotide(int match, int mismatch, int gap) {
+    ScoringScheme s(mismatch, gap);
+    for (char c : {'A', 'C', 'G', 'T', 'U'}) s.setScore(c, c, match);
+    s.setScore('T', 'U', match);
+    for (size_t b = 0; b < kSymbols; ++b) {
+        if (b == kGap) continue;
+        s.table_[symbol('N')][b] = 0;
+        s.table_[b][symbol('N')] = 0;
+    }
+    return s;
+}
+
+ScoringScheme ScoringScheme::blosum62(int gap) {
+    static const char kOrder[] = "ARNDCQEGHILKMFPSTWYVBZX";
+    static const signed char kScores[23][23] = {
+        { 4,-1,-2,-2, 0,-1,-1, 0,-2,-1,-1,-1,-1,-2,-1, 1, 0,-3,-2, 0,-2,-1, 0},
+        {-1, 5, 0,-2,-3, 1, 0,-2, 0,-3,-2, 2,-1,-3,-2,-1,-1,-3,-2,-3,-1, 0,-1},
+        {-2, 0, 6, 1,-3, 0, 0, 0, 1,-3,-3, 0,-2,-3,-2, 1, 0,-4,-2,-3, 3, 0,-1},
+        {-2,-2, 1, 6,-3, 0, 2,-1,-1,-3,-4,-1,-3,-3,-1, 0,-1,-4,-3,-3, 4, 1,-1},
+        { 0,-3,-3,-3, 9,-3,-4,-3,-3,-1,-1,-3,-1,-2,-3,-1,-1,-2,-2,-1,-3,-3,-2},
+        {-1, 1, 0, 0,-3, 5, 2,-2, 0,-3,-2, 1, 0,-3,-1, 0,-1,-2,-1,-2, 0, 3,-1},
+        {-1, 0, 0, 2,-4, 2, 5,-2, 0,-3,-3, 1,-2,-3,-1, 0,-1,-3,-2,-2, 1, 4,-1},
+        { 0,-2, 0,-1,-3,-2,-2, 6,-2,-4,-4,-2,-3,-3,-2, 0,-2,-2,-3,-3,-1,-2,-1},
+        {-2, 0, 1,-1,-3, 0, 0,-2, 8,-3,-3,-1,-2,-1,-2,-1,-2,-2, 2,-3, 0, 0,-1},
+        {-1,-3,-3,-3,-1,-3,-3,-4,-3, 4, 2,-3, 1, 0,-3,-2,-1,-3,-1, 3,-3,-3,-1},
+        {-1,-2,-3,-4,-1,-2,-3,-4,-3, 2, 4,-2, 2, 0,-3,-2,-1,-2,-1, 1,-4,-3,-1},
+        {-1, 2, 0,-1,-3, 1, 1,-2,-1,-3,-2, 5,-1,-3,-1, 0,-1,-3,-2,-2, 0, 1,-1},
+        {-1,-1,-2,-3,-1, 0,-2,-3,-2, 1, 2,-1, 5, 0,-2,-1,-1,-1,-1, 1,-3,-1,-1},
+        {-2,-3,-3,-3,-2,-3,-3,-3,-1, 0, 0,-3, 0, 6,-4,-2,-2, 1, 3,-1,-3,-3,-1},
+        {-1,-2,-2,-1,-3,-1,-1,-2,-2,-3,-3,-1,-2,-4, 7,-1,-1,-4,-3,-2,-2,-1,-2},
+        { 1,-1, 1, 0,-1, 0, 0, 0,-1,-2,-2, 0,-1,-2,-1, 4, 1,-3,-2,-2, 0, 0, 0},
+        { 0,-1, 0,-1,-1,-1,-1,-2,-2,-1,-1,-1,-1,-2,-1, 1, 5,-2,-2, 0,-1,-1, 0},
+        {-3,-3,-4,-4,-2,-2,-3,-2,-2,-3,-2,-3,-1, 1,-4,-3,-2,11, 2,-3,-4,-3,-2},
+        {-2,-2,-2,-3,-2,-1,-2,-3, 2,-1,-1,-2,-1, 3,-3,-2,-2, 2, 7,-1,-3,-2,-1},
+        { 0,-3,-3,-3,-1,-2,-2,-3,-3, 3, 1,-2, 1,-1,-2,-2, 0,-3,-1, 4,-3,-2,-1},
+        {-2,-1, 3, 4,-3, 0, 1,-1, 0,-3,-4, 0,-3,-3,-2, 0,-1,-4,-3,-3, 4, 1,-1},
+        {-1, 0, 0, 1,-3, 3, 4,-2, 0,-3,-3, 1,-1,-3,-1, 0,-1,-3,-2,-2, 1, 4,-1},
+        { 0,-1,-1,-1,-2,-1,-1,-1,-1,-1,-1,-1,-1,-1,-2, 0, 0,-2,-1,-1,-1,-1,-1},
+    };
+    ScoringScheme s(-1, gap); // unlisted letters score like X
+    for (size_t i = 0; i < 23; ++i)
+        for (size_t j = 0; j < 23; ++j)
+            s.table_[symbol(kOrder[i])][symbol(kOrder[j])] = kScores[i][j];
+    return s;
+}
+
+// --- AlignmentScorer ---
+
+// Positions past the end of a sequence are trailing gaps.
+static char cellAt(const std::string& s, size_t column) {
+    return column < s.size() ? s[column] : '-';
+}
+
+static bool isResidue(char c) {
+    return ScoringScheme::symbol(c) < ScoringScheme::kGap;
+}
+
+AlignmentScorer::AlignmentScorer(ScoringScheme scheme) : scheme_(std::move(scheme)) {}
+
+void AlignmentScorer::setScheme(ScoringScheme scheme, const AlignmentBlock& block) {
+    scheme_ = std::move(scheme);
+    reset(block);
+}
+
+void AlignmentScorer::countIdentity(IdentityCount& count, char ref, char c, bool add) const {
+    if (!isResidue(ref) || !isResidue(c)) return;
+    bool match = ScoringScheme::symbol(ref) == ScoringScheme::symbol(c);
+    if (add) {
+        ++count.compared;
+        count.matches += match;
+    } else {
+        --count.compared;
+        count.matches -= match;
+    }
+}
+
+void AlignmentScorer::reset(const AlignmentBlock& block) {
+    TRACE_SCOPE("AlignmentScorer::reset");
+    const auto& seqs = block.sequences;
+    size_t width = 0;
+    for (const auto& s : seqs) width = std::max(width, s.aligned.size());
+    columnScores_.assign(width, 0);
+    identity_.assign(seqs.size(), IdentityCount{});
+    total_ = 0;
+
+    // Symbol counts for a band of columns, filled row by row so each
+    // sequence is read sequentially. A column's score is then a sum over the
+    // symbol pairs present rather than over sequence pairs.
+    constexpr size_t kBand = 2048;
+    const size_t kS = ScoringScheme::kSymbols;
+    std::vector<uint32_t> counts(kBand * kS);
+    size_t present[ScoringScheme::kSymbols];
+    for (size_t first = 0; first < width; first += kBand) {
+        size_t band = std::min(kBand, width - first);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (const auto& s : seqs) {
+            for (size_t c = 0; c < band; ++c) ++counts[c * kS + ScoringScheme::symbol(cellAt(s.aligned, first + c))];
+        }
+        for (size_t c = 0; c < band; ++c) {
+            const uint32_t* n = &counts[c * kS];
+            size_t k = 0;
+            for (size_t a = 0; a < kS; ++a) if (n[a]) present[k++] = a;
+            int64_t score = 0;
+            for (size_t i = 0; i < k; ++i) {
+                size_t a = present[i];
+                const auto& row = scheme_.table_[a];
+                score += int64_t(n[a]) * (n[a] - 1) / 2 * row[a];
+                for (size_t j = i + 1; j < k; ++j) score += int64_t(n[a]) * n[present[j]] * row[present[j]];
+            }
+            columnScores_[first + c] = score;
+            total_ += score;
+        }
+    }
+
+    for (size_t i = 0; i < seqs.size(); ++i) {
+        const std::string& s = seqs[i].aligned;
+        size_t n = std::min(s.size(), block.reference.size());
+        for (size_t c = 0; c < n; ++c) countIdentity(identity_[i], block.reference[c], s[c], true);
+    }
+    TRACE_COUNTER_ADD("AlignmentScorer.columnsScored", width);
+}
+
+void AlignmentScorer::update(const AlignmentBlock& block, size_t seq, size_t column, char before) {
+    const char after = block.sequences[seq].aligned[column];
+    if (after == before) return;
+    const auto& was = scheme_.table_[ScoringScheme::symbol(before)];
+    const auto& now = scheme_.table_[ScoringScheme::symbol(after)];
+    int64_t delta = 0;
+    for (size_t j = 0; j < block.sequences.size(); ++j) {
+        if (j == seq) continue;
+        size_t other = ScoringScheme::symbol(cellAt(block.sequences[j].aligned, column));
+        delta += now[other] - was[other];
+    }
+    columnScores_[column] += delta;
+    total_ += delta;
+
+    char ref = cellAt(block.reference, column);
+    countIdentity(identity_[seq], ref, before, false);
+    countIdentity(identity_[seq], ref, after, true);
+}
+
+void AlignmentScorer::updateSequence(const AlignmentBlock& block, size_t seq, const std::string& before) {
+    const std::string& after = block.sequences[seq].aligned;
+    for (size_t c = 0; c < after.size() && c < before.size(); ++c) {
+        if (after[c] != before[c]) update(block, seq, c, before[c]);
+    }
+}
+
+double AlignmentScorer::identity(size_t seq) const {
+    const IdentityCount& count = identity_[seq];
+    return count.compared ? 100.0 * double(count.matches) / double(count.compared) : 0.0;
+}
+
+double AlignmentScorer::meanIdentity() const {
+    if (identity_.empty()) return 0.0;
+    double sum = 0.0;
+    for (size_t i = 0; i < identity_.size(); ++i) sum += identity(i);
+    return sum / double(identity_.size());
+}
@@ -0,0 +1,99 @@
+#ifndef ALIGNMENT_SCORE_H
+#define ALIGNMENT_SCORE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct AlignmentBlock;
+
+//-----------------------------------------------------------------------------
+// Alignment scoring
+//-----------------------------------------------------------------------------
+
+// Pair scores for residues and gaps. Letters are case-insensitive; '-' and
+// '.' are gaps; any other character scores like an unknown residue.
+class ScoringScheme {
+public:
+    // Match/mismatch scores with T and U treated as the same base. N pairs
+    // with anything for 0.
+    static ScoringScheme nucleotide(int match = 2, int mismatch = -1, int gap = -2);
+    // BLOSUM62 for the 20 amino acids plus B, Z and X.
+    static ScoringScheme blosum62(int gap = -4);
+
+    int score(char a, char b) const { return table_[symbol(a)][symbol(b)]; }
+    int gapPenalty() const { return gap_; }
+
+    // Sets the score of both a/b and b/a.
+    void setScore(char a, char b, int value);
+
+    // Dense symbol index: 0-25 for letters, then gap, then everything else.
+    static constexpr size_t kSymbols = 28;
+    static constexpr size_t kGap = 26;
+    static size_t symbol(char c) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (u >= 'a' && u <= 'z') return u - 'a';
+        if (u >= 'A' && u <= 'Z') return u - 'A';
+        return (u == '-' || u == '.') ? kGap : kGap + 1;
+    }
+
+private:
+    friend class AlignmentScorer;
+    ScoringScheme(int unknown, int gap);
+
+    std::array<std::array<int, kSymbols>, kSymbols> table_{};
+    int gap_ = 0;
+};
+
+// Sum-of-pairs score of an alignment block and each sequence's identity to
+// the block reference, kept current under single-cell edits.
+//
+// Gaps are linear: every residue/gap pair costs the gap penalty and gap/gap
+// pairs score 0, so each column's score depends on that column alone and an
+// edit only touches its own column. Sequences shorter than the longest one
+// are padded with trailing gaps. Identity counts the columns where both the
+// sequence and the reference have a residue.
+class AlignmentScorer {
+public:
+    explicit AlignmentScorer(ScoringScheme scheme = ScoringScheme::nucleotide());
+
+    const ScoringScheme& scheme() const { return scheme_; }
+    void setScheme(ScoringScheme scheme, const AlignmentBlock& block);
+
+    // Rescores every column. O(sequences x columns).
+    void reset(const AlignmentBlock& block);
+
+    // Call after block.sequences[seq].aligned[column] changed from `before`.
+    // O(sequences).
+    void update(const AlignmentBlock& block, size_t seq, size_t column, char before);
+    // Call after a whole sequence was rewritten in place (same length).
+    // O(sequences x changed columns).
+    void updateSequence(const AlignmentBlock& block, size_t seq, const std::string& before);
+
+    int64_t sumOfPairs() const { return total_; }
+    size_t columns() const { return columnScores_.size(); }
+    int64_t columnScore(size_t column) const { return columnScores_[column]; }
+
+    // Percent identity of one sequence to the reference, 0 if the two share
+    // no residue columns.
+    double identity(size_t seq) const;
+    // Mean identity over all sequences, 0 without sequences.
+    double meanIdentity() const;
+
+private:
+    struct IdentityCount {
+        size_t matches = 0;
+        size_t compared = 0;
+    };
+
+    ScoringScheme scheme_;
+    std::vector<int64_t> columnScores_;
+    std::vector<IdentityCount> identity_;
+    int64_t total_ = 0;
+
+    void countIdentity(IdentityCount& count, char ref, char c, bool add) const;
+};
+
+#endif // ALIGNMENT_SCORE_H
@@ -3,8 +3,16 @@
 #include <sstream>   // For std::stringstream
 #include <vector>
 #include <map>
+#include <cctype>
 #include <algorithm>
+#include <atomic>
 #include <functional>
+#include <iterator>
+#include <random>
+#include <thread>
+#include "gene_cache.h"
+#include "parallel_utils.h"
+#include "trace.h"
 
 // --- Private Helper Function Declarations ---
 
@@ -12,45 +20,338 @@
 // NOTE: This is a placeholder for a platform-specific implementation (e.g., using WinINet on Windows).
 static std::string httpGetRequest(const std::string& url, const std::string& api_key);
 
-// Parses a JSON response from the NCBI Gene API.
+// Parses a single gene object of an NCBI Gene API response.
 // NOTE: This is a placeholder for a minimal, purpose-built parser. It is NOT a full JSON parser.
-static std::vector<GeneModel> parseGeneJson(const std::string& json_response);
+static GeneModel parseGeneObject(const std::string& gene_blob);
+
+// Report fields requested for every gene; also part of the cache key.
+static const std::string kGeneReportFields =
+    "?table_fields=gene-id&table_fields=symbol&table_fields=description&table_fields=genomic-ranges";
+
+// Fetches, parses and merges all batches for the given accessions.
+static std::vector<GeneModel> fetchBatches(const std::vector<std::string>& gene_accessions,
+                                           const NcbiFetchOptions& options,
+                                           const std::string& api_key,
+                                           const HttpGetter& http_getter);
+
+// Upper-cased copy used to match returned symbols to requested accessions.
+static std::string upperCase(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return char(std::toupper(c)); });
+    return s;
+}
+
+// True for identifiers that are not gene symbols: RefSeq accessions (NM_000546),
+// versioned accessions (NM_000546.6), GenBank accessions (AB123456) and numeric
+// Gene IDs. A response names genes only by symbol, so these cannot be cached.
+static bool isAccessionNumber(const std::string& id) {
+    auto isDigit = [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; };
+    auto isAlpha = [](char c) { return std::isalpha(static_cast<unsigned char>(c)) != 0; };
+    if (id.empty()) return false;
+    if (id.find('.') != std::string::npos) return true;
+    if (std::all_of(id.begin(), id.end(), isDigit)) return true;
+    if (id.size() > 3 && isAlpha(id[0]) && isAlpha(id[1]) && id[2] == '_') return true;
+    size_t letters = 0;
+    while (letters < id.size() && isAlpha(id[letters])) ++letters;
+    return (letters == 1 || letters == 2) && id.size() - letters >= 5
+        && std::all_of(id.begin() + std::ptrdiff_t(letters), id.end(), isDigit);
+}
+
+// One request URL and the accessions it covers.
+struct BatchRequest {
+    std::string url;
+    std::vector<std::string> accessions;
+};
+
+// Thrown out of getBatchWithRetry when the caller's stop flag is raised.
+struct FetchCancelled {};
+
+// Splits accessions into request URLs bounded by batch size and URL length.
+static std::vector<BatchRequest> buildBatchRequests(const std::vector<std::string>& gene_accessions,
+                                                    const NcbiFetchOptions& options);
+
+// Requests per second to budget for: the configured rate, or NCBI's documented limit.
+static double effectiveRequestRate(const NcbiFetchOptions& options, const std::string& api_key);
+
+// Issues one request through the rate limiter and parses its body, retrying 429/5xx with
+// jittered backoff. Bodies from options.streamingGetter are parsed chunk by chunk as they arrive.
+// When `stop` is given and becomes true, throws FetchCancelled instead of issuing or waiting.
+static std::vector<GeneModel> getBatchWithRetry(const std::string& url, const std::string& api_key,
+                                                const HttpGetter& http_getter, RequestRateLimiter& limiter,
+                                                const NcbiFetchOptions& options,
+                                                const std::atomic<bool>* stop = nullptr);
+
+// Stores each fetched gene in the cache under the requested symbol it matches.
+static void cacheBatch(GeneCache& cache, const std::vector<std::string>& accessions,
+                       const std::vector<GeneModel>& genes);
 
 // --- Public Function Implementations ---
 
+NcbiHttpError::NcbiHttpError(int status, const std::string& message)
+    : std::runtime_error(message), status_(status) {}
+
+int NcbiHttpError::status() const {
+    return status_;
+}
+
+NcbiIncompleteResponse::NcbiIncompleteResponse(size_t bytes_received)
+    : std::runtime_error("Incomplete response from NCBI API after " + std::to_string(bytes_received) + " bytes."),
+      bytesReceived_(bytes_received) {}
+
+size_t NcbiIncompleteResponse::bytesReceived() const {
+    return bytesReceived_;
+}
+
+RequestRateLimiter::RequestRateLimiter(double requests_per_second, double burst)
+    : rate_(requests_per_second),
+      capacity_(std::max(1.0, burst)),
+      tokens_(std::max(1.0, burst)),
+      last_(std::chrono::steady_clock::now()) {}
+
+void RequestRateLimiter::acquire() {
+    if (rate_ <= 0.0) return;
+    std::chrono::duration<double> wait{0.0};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - last_).count();
+        last_ = now;
+        // Take the token now even if it has not accrued yet: a negative balance
+        // reserves the next slot, so waiters queue up without holding the lock.
+        tokens_ = std::min(capacity_, tokens_ + elapsed * rate_) - 1.0;
+        if (tokens_ < 0.0) wait = std::chrono::duration<double>(-tokens_ / rate_);
+    }
+    if (wait.count() > 0.0) std::this_thread::sleep_for(wait);
+}
+
 std::vector<GeneModel> fetchGeneDataFromNCBI(
     const std::vector<std::string>& gene_accessions,
     const std::string& api_key,
     const std::function<std::string(const std::string&, const std::string&)>& http_getter) {
+    return fetchGeneDataFromNCBI(gene_accessions, NcbiFetchOptions{}, api_key, http_getter);
+}
+
+std::vector<GeneModel> fetchGeneDataFromNCBI(
+    const std::vector<std::string>& gene_accessions,
+    const NcbiFetchOptions& options,
+    const std::string& api_key,
+    const HttpGetter& http_getter) {
+    TRACE_SCOPE("fetchGeneDataFromNCBI");
     if (gene_accessions.empty()) {
         return {};
     }
+    if (!options.cache) {
+        return fetchBatches(gene_accessions, options, api_key, http_getter);
+    }
 
-    // 1. Construct the URL for the NCBI API request.
-    const std::string base_url = "https://api.ncbi.nlm.nih.gov/datasets/v2alpha/gene/accession/";
-    std::stringstream url_stream;
-    url_stream << base_url;
-    for (size_t i = 0; i < gene_accessions.size(); ++i) {
-        url_stream << gene_accessions[i] << (i == gene_accessions.size() - 1 ? "" : ",");
+    // Serve hits from the cache and forward only the misses.
+    const size_t n = gene_accessions.size();
+    std::vector<GeneModel> byAccession(n);
+    std::vector<char> found(n, 0);
+    std::vector<std::string> missing;
+    for (size_t i = 0; i < n; ++i) {
+        if (!isAccessionNumber(gene_accessions[i])
+            && options.cache->get(gene_accessions[i], kGeneReportFields, byAccession[i])) found[i] = 1;
+        else missing.push_back(gene_accessions[i]);
+    }
+    TRACE_COUNTER_ADD("ncbi.cacheHits", n - missing.size());
+
+    std::vector<GeneModel> extra;
+    if (!missing.empty()) {
+        std::multimap<std::string, size_t> pending;
+        for (size_t i = 0; i < n; ++i) {
+            if (!found[i] && !isAccessionNumber(gene_accessions[i])) pending.insert({upperCase(gene_accessions[i]), i});
+        }
+        for (auto& model : fetchBatches(missing, options, api_key, http_getter)) {
+            auto it = pending.find(upperCase(model.symbol));
+            if (it == pending.end()) {
+                extra.push_back(std::move(model));
+                continue;
+            }
+            options.cache->put(gene_accessions[it->second], kGeneReportFields, model);
+            byAccession[it->second] = std::move(model);
+            found[it->second] = 1;
+            pending.erase(it);
+        }
     }
-    // Add parameters to get gene report
-    url_stream << "?table_fields=gene-id&table_fields=symbol&table_fields=description&table_fields=genomic-ranges";
 
-    // 2. Perform the HTTP GET request.
-    std::string json_response;
-    if (http_getter) {
-        json_response = http_getter(url_stream.str(), api_key);
-    } else {
-        json_response = httpGetRequest(url_stream.str(), api_key);
+    std::vector<GeneModel> models;
+    for (size_t i = 0; i < n; ++i) {
+        if (found[i]) models.push_back(std::move(byAccession[i]));
     }
+    std::move(extra.begin(), extra.end(), std::back_inserter(models));
+    return models;
+}
 
-    if (json_response.empty()) {
-        // Handle case where the request failed at the HTTP level
-        throw std::runtime_error("Failed to get a response from NCBI API.");
+static std::vector<GeneModel> fetchBatches(
+    const std::vector<std::string>& gene_accessions,
+    const NcbiFetchOptions& options,
+    const std::string& api_key,
+    const HttpGetter& http_getter) {
+    // 1. Construct one URL per batch of accessions.
+    std::vector<BatchRequest> requests = buildBatchRequests(gene_accessions, options);
+
+    // 2. Issue the batches concurrently under a shared rate budget.
+    double rps = effectiveRequestRate(options, api_key);
+    RequestRateLimiter limiter(rps);
+    std::vector<std::vector<GeneModel>> batches(requests.size());
+    parallelFor(requests.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            // 3. Fetch and parse the JSON response into GeneModel objects.
+            batches[i] = getBatchWithRetry(requests[i].url, api_key, http_getter, limiter, options);
+        }
+    }, std::max(1u, options.concurrency));
+
+    // 4. Merge in input order.
+    std::vector<GeneModel> models;
+    for (auto& batch : batches) {
+        std::move(batch.begin(), batch.end(), std::back_inserter(models));
     }
+    return models;
+}
 
-    // 3. Parse the JSON response into GeneModel objects.
-    return parseGeneJson(json_response);
+// --- Asynchronous Fetch ---
+
+struct NcbiFetchHandle::State {
+    std::vector<std::string> accessions;
+    NcbiFetchOptions options;
+    std::string apiKey;
+    HttpGetter httpGetter;
+
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> stop{false}; // cancelled, or a batch failed
+    std::atomic<bool> done{false};
+    mutable std::mutex mutex;      // guards ready and progress
+    std::vector<GeneModel> ready;
+    NcbiFetchProgress progress;
+    std::promise<void> promise;
+    std::shared_future<void> future;
+
+    void publish(std::vector<GeneModel>&& genes, size_t batches_done) {
+        // The sink runs before progress is counted, so isDone() implies every gene was handed over.
+        size_t count = genes.size();
+        if (options.batchSink && count > 0) options.batchSink(std::move(genes));
+        std::lock_guard<std::mutex> lock(mutex);
+        progress.genesReceived += count;
+        progress.batchesDone += batches_done;
+        if (!options.batchSink) std::move(genes.begin(), genes.end(), std::back_inserter(ready));
+    }
+
+    void run() {
+        TRACE_SCOPE("fetchGeneDataFromNCBIAsync");
+        try {
+            // Cache hits are queued at once; only misses are requested.
+            std::vector<std::string> missing;
+            if (options.cache) {
+                std::vector<GeneModel> hits;
+                GeneModel model;
+                for (const auto& accession : accessions) {
+                    if (!isAccessionNumber(accession) && options.cache->get(accession, kGeneReportFields, model)) {
+                        hits.push_back(std::move(model));
+                    }
+                    else missing.push_back(accession);
+                }
+                TRACE_COUNTER_ADD("ncbi.asyncCacheHits", hits.size());
+                publish(std::move(hits), 0);
+            } else {
+                missing = accessions;
+            }
+
+            std::vector<BatchRequest> requests = buildBatchRequests(missing, options);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                progress.batchesTotal = requests.size();
+            }
+            double rps = effectiveRequestRate(options, apiKey);
+            RequestRateLimiter limiter(rps);
+            parallelFor(requests.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    if (stop) {
+                        publish({}, 1);
+                        continue;
+                    }
+                    try {
+                        std::vector<GeneModel> genes =
+                            getBatchWithRetry(requests[i].url, apiKey, httpGetter, limiter, options, &stop);
+                        if (options.cache) cacheBatch(*options.cache, requests[i].accessions, genes);
+                        publish(std::move(genes), 1);
+                    } catch (const FetchCancelled&) {
+                        publish({}, 1);
+                    } catch (...) {
+                        stop = true;
+                        publish({}, 1);
+                        throw;
+                    }
+                }
+            }, std::max(1u, options.concurrency));
+            done = true;
+            promise.set_value();
+        } catch (...) {
+            done = true;
+            promise.set_exception(std::current_exception());
+        }
+    }
+};
+
+NcbiFetchHandle::NcbiFetchHandle(std::vector<std::string> gene_accessions,
+                                 NcbiFetchOptions options,
+                                 std::string api_key,
+                                 HttpGetter http_getter)
+    : state_(std::make_shared<State>()) {
+    state_->accessions = std::move(gene_accessions);
+    state_->options = std::move(options);
+    state_->apiKey = std::move(api_key);
+    state_->httpGetter = std::move(http_getter);
+    state_->future = state_->promise.get_future().share();
+    worker_ = std::thread([state = state_]() { state->run(); });
+}
+
+NcbiFetchHandle::~NcbiFetchHandle() {
+    cancel();
+    if (worker_.joinable()) worker_.join();
+}
+
+size_t NcbiFetchHandle::poll(std::vector<GeneModel>& out) {
+    std::vector<GeneModel> ready;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        ready.swap(state_->ready);
+    }
+    std::move(ready.begin(), ready.end(), std::back_inserter(out));
+    return ready.size();
+}
+
+NcbiFetchProgress NcbiFetchHandle::progress() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->progress;
+}
+
+void NcbiFetchHandle::cancel() {
+    state_->cancelled = true;
+    state_->stop = true;
+}
+
+bool NcbiFetchHandle::isCancelled() const {
+    return state_->cancelled;
+}
+
+bool NcbiFetchHandle::isDone() const {
+    return state_->done;
+}
+
+std::shared_future<void> NcbiFetchHandle::future() const {
+    return state_->future;
+}
+
+void NcbiFetchHandle::wait() const {
+    state_->future.get();
+}
+
+std::unique_ptr<NcbiFetchHandle> fetchGeneDataFromNCBIAsync(
+    const std::vector<std::string>& gene_accessions,
+    const NcbiFetchOptions& options,
+    const std::string& api_key,
+    const HttpGetter& http_getter) {
+    return std::make_unique<NcbiFetchHandle>(gene_accessions, options, api_key, http_getter);
 }
 
 // --- Private Helper Function Implementations ---
@@ -63,6 +364,115 @@ static std::string httpGetRequest(const std::string& url, const std::string& api
     return "";
 }
 
+static std::vector<BatchRequest> buildBatchRequests(const std::vector<std::string>& gene_accessions,
+                                                    const NcbiFetchOptions& options) {
+    const std::string base_url = "https://api.ncbi.nlm.nih.gov/datasets/v2alpha/gene/accession/";
+    // Add parameters to get gene report
+    const std::string& params = kGeneReportFields;
+    const size_t max_batch = std::max<size_t>(1, options.maxBatchSize);
+
+    std::vector<BatchRequest> requests;
+    BatchRequest batch;
+    std::string current;
+    size_t count = 0;
+    auto flush = [&]() {
+        if (count == 0) return;
+        batch.url = base_url + current + params;
+        requests.push_back(std::move(batch));
+        batch = BatchRequest{};
+        current.clear();
+        count = 0;
+    };
+    for (const auto& accession : gene_accessions) {
+        size_t projected = base_url.size() + current.size() + (count ? 1 : 0) + accession.size() + params.size();
+        if (count == max_batch || (count > 0 && projected > options.maxUrlLength)) flush();
+        if (count > 0) current += ',';
+        current += accession;
+        batch.accessions.push_back(accession);
+        ++count;
+    }
+    flush();
+    return requests;
+}
+
+static double effectiveRequestRate(const NcbiFetchOptions& options, const std::string& api_key) {
+    // NCBI allows 3 requests/second without a key and 10 with one.
+    return options.requestsPerSecond > 0 ? options.requestsPerSecond : (api_key.empty() ? 3.0 : 10.0);
+}
+
+static void cacheBatch(GeneCache& cache, const std::vector<std::string>& accessions,
+                       const std::vector<GeneModel>& genes) {
+    std::multimap<std::string, const std::string*> pending;
+    for (const auto& accession : accessions) {
+        if (!isAccessionNumber(accession)) pending.insert({upperCase(accession), &accession});
+    }
+    for (const auto& model : genes) {
+        auto it = pending.find(upperCase(model.symbol));
+        if (it == pending.end()) continue;
+        cache.put(*it->second, kGeneReportFields, model);
+        pending.erase(it);
+    }
+}
+
+static std::vector<GeneModel> getBatchWithRetry(const std::string& url, const std::string& api_key,
+                                                const HttpGetter& http_getter, RequestRateLimiter& limiter,
+                                                const NcbiFetchOptions& options,
+                                                const std::atomic<bool>* stop) {
+    thread_local std::mt19937 rng(std::random_device{}());
+    for (int attempt = 0;; ++attempt) {
+        if (stop && *stop) throw FetchCancelled{};
+        limiter.acquire();
+        try {
+            TRACE_SCOPE("ncbi.request");
+            // A fresh parser per attempt, so a failed partial body never leaks genes.
+            std::vector<GeneModel> genes;
+            GeneJsonStreamParser parser([&](GeneModel&& gene) { genes.push_back(std::move(gene)); });
+            size_t received = 0;
+            if (options.streamingGetter) {
+                options.streamingGetter(url, api_key, [&](const char* data, size_t size) {
+                    received += size;
+                    parser.feed(data, size);
+                });
+            } else {
+                std::string json_response = http_getter ? http_getter(url, api_key) : httpGetRequest(url, api_key);
+                received = json_response.size();
+                parser.feed(json_response);
+            }
+            if (received == 0) {
+                // Handle case where the request failed at the HTTP level
+                throw std::runtime_error("Failed to get a response from NCBI API.");
+            }
+            if (!parser.complete()) {
+                // A dropped connection or short read: the genes parsed so far are not the whole batch.
+                throw NcbiIncompleteResponse(received);
+            }
+            TRACE_COUNTER_ADD("ncbi.bytesReceived", received);
+            TRACE_COUNTER_ADD("ncbi.genesParsed", genes.size());
+            return genes;
+        } catch (const NcbiHttpError& e) {
+            bool retryable = e.status() == 429 || (e.status() >= 500 && e.status() < 600);
+            if (!retryable || attempt >= options.maxRetries) throw;
+            TRACE_COUNTER_ADD("ncbi.retries", 1);
+        } catch (const NcbiIncompleteResponse&) {
+            if (attempt >= options.maxRetries) throw;
+            TRACE_COUNTER_ADD("ncbi.retries", 1);
+        }
+        std::uniform_real_distribution<double> jitter(0.5, 1.5);
+        auto delay = std::chrono::duration<double, std::milli>(
+            double(options.baseBackoff.count()) * double(1u << std::min(attempt, 16)) * jitter(rng));
+        if (!stop) {
+            std::this_thread::sleep_for(delay);
+            continue;
+        }
+        // Sleep in short slices so a cancellation is noticed promptly.
+        auto until = std::chrono::steady_clock::now() + delay;
+        while (!*stop && std::chrono::steady_clock::now() < until) {
+            std::this_thread::sleep_for(std::min<std::chrono::duration<double, std::milli>>(
+                until - std::chrono::steady_clock::now(), std::chrono::milliseconds(20)));
+        }
+    }
+}
+
 // --- Minimalist JSON Parser Helper Functions ---
 
 // Trim whitespace from a string.
@@ -133,21 +543,21 @@ static double parse_double_value(const std::string& value) {
     }
 }
 
-static std::vector<std::string> parse_string_array(std::string value) {
-    std::vector<std::string> result;
+static StringList parse_string_array(std::string value) {
+    StringList result;
     if (value.length() < 2 || value.front() != '[' || value.back() != ']') return result;
     value = value.substr(1, value.length() - 2); // Remove brackets
 
     std::stringstream ss(value);
     std::string item;
     while(std::getline(ss, item, ',')) {
-        result.push_back(parse_string_value(trim(item)));
+        result.emplace_back(parse_string_value(trim(item)));
     }
     return result;
 }
 
-static std::map<std::string, double> parse_key_double_map(std::string value) {
-    std::map<std::string, double> result;
+static RegionExpressionMap parse_key_double_map(std::string value) {
+    RegionExpressionMap result;
     if (value.length() < 2 || value.front() != '{' || value.back() != '}') return result;
     value = value.substr(1, value.length() - 2); // Remove braces
     value.erase(std::remove(value.begin(), value.end(), '\n'), value.end());
@@ -160,50 +570,117 @@ static std::map<std::string, double> parse_key_double_map(std::string value) {
             std::string key = parse_string_value(trim(pair_str.substr(0, colon_pos)));
             double val = parse_double_value(trim(pair_str.substr(colon_pos + 1)));
             if (!key.empty()) {
-                result[key] = val;
+                setRegionExpression(result, key, val);
             }
         }
     }
     return result;
 }
 
-// Parses a JSON response from the NCBI Gene API.
+// Parses a single gene object of an NCBI Gene API response.
 // NOTE: This is a placeholder for a minimal, purpose-built parser. It is NOT a full JSON parser.
-static std::vector<GeneModel> parseGeneJson(const std::string& json_response) {
-    std::vector<GeneModel> models;
+static GeneModel parseGeneObject(const std::string& gene_blob) {
+    GeneModel model;
+    model.symbol = parse_string_value(find_value_simple(gene_blob, "gene_name"));
+    model.isKnockout = parse_bool_value(find_value_simple(gene_blob, "knockout"));
+    model.expressionLevel = parse_double_value(find_value_simple(gene_blob, "expression_level"));
+    model.disorderTags = parse_string_array(find_value_complex(gene_blob, "disorderTags"));
+    model.brainRegionExpression = parse_key_double_map(find_value_complex(gene_blob, "brainRegionExpression"));
+    return model;
+}
 
-    size_t genes_array_start = json_response.find("\"genes\": [");
-    if (genes_array_start == std::string::npos) {
-        return models;
-    }
-    genes_array_start += 10; // Move past '"genes": ['
+// --- GeneJsonStreamParser Implementation ---
+
+GeneJsonStreamParser::GeneJsonStreamParser(GeneCallback on_gene) : onGene_(std::move(on_gene)) {}
 
-    size_t search_pos = genes_array_start;
-    while (search_pos < json_response.length()) {
-        size_t obj_start = json_response.find('{', search_pos);
-        if (obj_start == std::string::npos) break;
+void GeneJsonStreamParser::feed(const std::string& chunk) {
+    feed(chunk.data(), chunk.size());
+}
 
-        int brace_count = 1;
-        size_t obj_end = obj_start + 1;
-        while (obj_end < json_response.length() && brace_count > 0) {
-            if (json_response[obj_end] == '{') brace_count++;
-            if (json_response[obj_end] == '}') brace_count--;
-            obj_end++;
+void GeneJsonStreamParser::feed(const char* data, size_t size) {
+    size_t i = 0;
+    while (i < size && mode_ != Mode::Done) {
+        if (mode_ == Mode::InObject) {
+            // Copy the object text in spans up to its closing brace.
+            size_t start = i;
+            for (; i < size; ++i) {
+                char c = data[i];
+                if (inString_) {
+                    if (escape_) escape_ = false;
+                    else if (c == '\\') escape_ = true;
+                    else if (c == '"') inString_ = false;
+                } else if (c == '"') {
+                    inString_ = true;
+                } else if (c == '{') {
+                    ++depth_;
+                } else if (c == '}' && --depth_ == 0) {
+                    break;
+                }
+            }
+            if (i == size) {
+                object_.append(data + start, size - start);
+                return;
+            }
+            object_.append(data + start, i + 1 - start);
+            ++i;
+            onGene_(parseGeneObject(object_));
+            ++emitted_;
+            object_.clear();
+            mode_ = Mode::InArray;
+            continue;
         }
 
-        if (brace_count == 0) {
-            std::string gene_blob = json_response.substr(obj_start, obj_end - obj_start);
-            GeneModel model;
-            model.symbol = parse_string_value(find_value_simple(gene_blob, "gene_name"));
-            model.isKnockout = parse_bool_value(find_value_simple(gene_blob, "knockout"));
-            model.expressionLevel = parse_double_value(find_value_simple(gene_blob, "expression_level"));
-            model.disorderTags = parse_string_array(find_value_complex(gene_blob, "disorderTags"));
-            model.brainRegionExpression = parse_key_double_map(find_value_complex(gene_blob, "brainRegionExpression"));
-            models.push_back(model);
-            search_pos = obj_end;
-        } else {
-            break; // Malformed JSON
+        char c = data[i++];
+        if (inString_) {
+            // Strings only matter while seeking the "genes" key.
+            if (escape_) escape_ = false;
+            else if (c == '\\') escape_ = true;
+            else if (c == '"') {
+                inString_ = false;
+                keyState_ = (mode_ == Mode::SeekGenes && key_ == "genes") ? 1 : 0;
+            } else if (key_.size() <= 5) {
+                key_ += c;
+            }
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') continue;
+
+        if (mode_ == Mode::SeekGenes) {
+            if (c == '"') {
+                inString_ = true;
+                key_.clear();
+                keyState_ = 0;
+            } else if (c == ':' && keyState_ == 1) {
+                keyState_ = 2;
+            } else if (c == '[' && keyState_ == 2) {
+                mode_ = Mode::InArray;
+                keyState_ = 0;
+            } else {
+                keyState_ = 0;
+                // A body whose top-level value ends without a "genes" array is complete and empty.
+                if (c == '{' || c == '[') ++seekDepth_;
+                else if ((c == '}' || c == ']') && --seekDepth_ == 0) mode_ = Mode::Done;
+            }
+        } else if (c == '{') {
+            mode_ = Mode::InObject;
+            object_.assign(1, c);
+            depth_ = 1;
+        } else if (c == ']') {
+            mode_ = Mode::Done;
+        } else if (c == '"') {
+            inString_ = true; // stray string element; skipped
         }
     }
-    return models;
-}
\ No newline at end of file
+}
+
+bool GeneJsonStreamParser::complete() const {
+    return mode_ == Mode::Done;
+}
+
+size_t GeneJsonStreamParser::genesEmitted() const {
+    return emitted_;
+}
+
+size_t GeneJsonStreamParser::bufferedBytes() const {
+    return object_.size();
+}
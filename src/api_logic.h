@@ -4,18 +4,209 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <stdexcept>
 #include "map_logic.h" // Assuming GeneModel is defined here
 
+class GeneCache;
+
+// Signature of the injectable HTTP GET used by the fetch functions.
+using HttpGetter = std::function<std::string(const std::string& url, const std::string& api_key)>;
+
+// Receives one piece of a response body; pieces arrive in order and may split tokens anywhere.
+using HttpChunkSink = std::function<void(const char* data, size_t size)>;
+
+// Streaming HTTP GET: delivers the body to `sink` as it is received and returns when it ends.
+// Errors are reported by throwing, as for HttpGetter.
+using StreamingHttpGetter = std::function<void(const std::string& url, const std::string& api_key,
+                                               const HttpChunkSink& sink)>;
+
+// Receives the genes of one finished batch of an asynchronous fetch.
+using GeneBatchSink = std::function<void(std::vector<GeneModel>&& genes)>;
+
+// An http_getter may throw this to report a non-2xx HTTP status.
+// 429 (Too Many Requests) and 5xx responses are retried with backoff; other statuses are rethrown.
+class NcbiHttpError : public std::runtime_error {
+public:
+    NcbiHttpError(int status, const std::string& message);
+    int status() const;
+
+private:
+    int status_;
+};
+
+// Thrown when a response body ends before its "genes" array is closed, e.g. after a
+// dropped connection or a short read. Retried like a 5xx; rethrown once retries run out.
+class NcbiIncompleteResponse : public std::runtime_error {
+public:
+    explicit NcbiIncompleteResponse(size_t bytes_received);
+    size_t bytesReceived() const;
+
+private:
+    size_t bytesReceived_;
+};
+
+// Tuning knobs for batched NCBI requests.
+struct NcbiFetchOptions {
+    size_t   maxBatchSize      = 200;  // accessions per request
+    size_t   maxUrlLength      = 2000; // characters per request URL
+    unsigned concurrency       = 4;    // requests in flight at once
+    double   requestsPerSecond = 0.0;  // 0 = NCBI limit: 3/s, or 10/s with an api_key
+    int      maxRetries        = 3;    // retries per batch on 429/5xx and truncated bodies
+    std::chrono::milliseconds baseBackoff{500}; // doubled per retry, with +/-50% jitter
+    GeneCache* cache           = nullptr; // optional on-disk cache of symbol lookups; only misses are requested
+    StreamingHttpGetter streamingGetter;  // when set, used instead of http_getter and parsed as it streams;
+                                          // called concurrently like http_getter, so it must be thread-safe
+    GeneBatchSink batchSink;              // async fetch only: when set, gets each batch on a worker thread
+                                          // instead of queueing it for poll(); must be thread-safe
+};
+
+// Resumable parser for gene report bodies. Input may be fed in arbitrary chunks;
+// each object of the "genes" array is parsed and handed to the callback as soon
+// as its closing brace arrives, so only the unfinished object is buffered.
+class GeneJsonStreamParser {
+public:
+    using GeneCallback = std::function<void(GeneModel&& gene)>;
+
+    explicit GeneJsonStreamParser(GeneCallback on_gene);
+
+    void feed(const char* data, size_t size);
+    void feed(const std::string& chunk);
+
+    // @return True once the "genes" array has been closed, or the top-level value has
+    // ended without one; false for truncated input.
+    bool complete() const;
+    size_t genesEmitted() const;
+    // Bytes currently held for an unfinished gene object.
+    size_t bufferedBytes() const;
+
+private:
+    enum class Mode { SeekGenes, InArray, InObject, Done };
+
+    GeneCallback onGene_;
+    Mode mode_ = Mode::SeekGenes;
+    bool inString_ = false;
+    bool escape_ = false;
+    int depth_ = 0;          // brace depth of the current gene object
+    int seekDepth_ = 0;      // nesting depth while seeking the "genes" array
+    std::string key_;        // last string seen while seeking (capped)
+    int keyState_ = 0;       // 0 none, 1 after a "genes" string, 2 after its colon
+    std::string object_;     // text of the unfinished gene object
+    size_t emitted_ = 0;
+};
+
+// Thread-safe token bucket. acquire() blocks until a request may be issued.
+class RequestRateLimiter {
+public:
+    RequestRateLimiter(double requests_per_second, double burst = 1.0);
+    void acquire();
+
+private:
+    std::mutex mutex_;
+    double rate_;
+    double capacity_;
+    double tokens_;
+    std::chrono::steady_clock::time_point last_;
+};
+
 // Fetches gene data from the NCBI Datasets API for a given list of gene accessions.
 // This is the primary public-facing function for the API module.
 //
 // @param gene_accessions A vector of strings, where each string is a gene symbol or accession number.
 // @param api_key An optional NCBI API key to increase rate limits.
 // @param http_getter An optional function to override the default HTTP GET behavior, for testing purposes.
+//        Requests use the default NcbiFetchOptions, so it is called from several threads at once
+//        and must be thread-safe.
 // @return A vector of GeneModel structs populated with the data fetched from the API.
 std::vector<GeneModel> fetchGeneDataFromNCBI(
     const std::vector<std::string>& gene_accessions,
     const std::string& api_key = "",
     const std::function<std::string(const std::string& url, const std::string& api_key)>& http_getter = nullptr);
 
+// Batched variant of fetchGeneDataFromNCBI. Accessions are split into requests bounded by
+// options.maxBatchSize and options.maxUrlLength, issued concurrently under a shared
+// requests-per-second budget, and the parsed genes are merged in input (batch) order.
+//
+// When options.cache is set, cached symbols are served without HTTP or parsing, fetched genes
+// are stored under the requested symbol they match, and results follow input order (genes that
+// match no requested symbol are appended at the end). Only symbols are cached: a response names
+// each gene by symbol alone, so accession numbers and numeric Gene IDs are always requested.
+//
+// @param gene_accessions Gene symbols or accession numbers; any number is accepted.
+// @param options Batch bounds, concurrency, rate limit and retry policy.
+// @param api_key An optional NCBI API key; raises the default rate limit to 10 requests/second.
+// @param http_getter An optional function to override the default HTTP GET behavior, for testing purposes.
+//        With options.concurrency > 1 it is called from several worker threads at once and must be
+//        thread-safe; set concurrency to 1 for a getter that is not.
+// @return The genes of all batches, concatenated in batch order.
+std::vector<GeneModel> fetchGeneDataFromNCBI(
+    const std::vector<std::string>& gene_accessions,
+    const NcbiFetchOptions& options,
+    const std::string& api_key = "",
+    const HttpGetter& http_getter = nullptr);
+
+//-----------------------------------------------------------------------------
+// Asynchronous fetch
+//-----------------------------------------------------------------------------
+
+struct NcbiFetchProgress {
+    size_t batchesTotal  = 0; // network requests planned (cache hits need none)
+    size_t batchesDone   = 0; // requests finished, failed or skipped after cancellation
+    size_t genesReceived = 0; // genes queued so far, including cache hits
+};
+
+// A batched fetch running on a background thread. Each batch's genes are queued as
+// soon as that batch is parsed (in completion order, not input order) and handed out
+// by poll(), so the owner - typically the UI thread - publishes them into an
+// AlignmentMap itself and the map never needs locking. With options.batchSink set,
+// batches go straight to the sink instead (e.g. GeneSnapshotStore::append), so the
+// owner never handles them. Destroying the handle cancels the fetch and waits for
+// requests already in flight.
+class NcbiFetchHandle {
+public:
+    // Starts the fetch immediately; arguments are as for the batched fetchGeneDataFromNCBI.
+    // The http_getter is called from worker threads and must be thread-safe.
+    NcbiFetchHandle(std::vector<std::string> gene_accessions,
+                    NcbiFetchOptions options,
+                    std::string api_key = "",
+                    HttpGetter http_getter = nullptr);
+    ~NcbiFetchHandle();
+    NcbiFetchHandle(const NcbiFetchHandle&) = delete;
+    NcbiFetchHandle& operator=(const NcbiFetchHandle&) = delete;
+
+    // Moves genes queued since the last call to the end of `out`. Never blocks on the network.
+    // @return The number of genes appended.
+    size_t poll(std::vector<GeneModel>& out);
+    NcbiFetchProgress progress() const;
+
+    // Requests cancellation: no further requests are issued and retry backoff ends early.
+    // Batches already queued stay available to poll().
+    void cancel();
+    bool isCancelled() const;
+    // True once every batch has been queued. Check it before poll(): a poll() after
+    // isDone() returns true drains the last genes; one before it may miss them.
+    bool isDone() const;
+
+    // Becomes ready when the fetch finishes; get() rethrows the first batch error.
+    // A cancelled fetch completes normally.
+    std::shared_future<void> future() const;
+    void wait() const;
+
+private:
+    struct State;
+    std::shared_ptr<State> state_;
+    std::thread worker_;
+};
+
+// Convenience wrapper that starts an NcbiFetchHandle.
+std::unique_ptr<NcbiFetchHandle> fetchGeneDataFromNCBIAsync(
+    const std::vector<std::string>& gene_accessions,
+    const NcbiFetchOptions& options = {},
+    const std::string& api_key = "",
+    const HttpGetter& http_getter = nullptr);
+
 #endif // API_LOGIC_H
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include "coexpression.h"
+#include "exporters.h"
+#include "parallel_utils.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string_view>
+#include <utility>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COEXPRESSION_SSE2 1
+#endif
+
+// --- Private Helper Functions ---
+
+namespace {
+
+// Replaces the measured values by their 1-based ranks, ties sharing the mean rank.
+void rankValues(std::vector<double>& values, const std::vector<char>& measured) {
+    std::vector<std::pair<double, size_t>> order;
+    for (size_t r = 0; r < values.size(); ++r) {
+        if (measured[r]) order.emplace_back(values[r], r);
+    }
+    std::sort(order.begin(), order.end());
+    for (size_t k = 0; k < order.size();) {
+        size_t end = k + 1;
+        while (end < order.size() && order[end].first == order[k].first) ++end;
+        const double rank = double(k + end + 1) / 2.0; // mean of ranks k+1 .. end
+        for (; k < end; ++k) values[order[k].second] = rank;
+    }
+}
+
+// Centres `values` on the measured mean, fills the gaps with it and scales
+// to unit length. @return False if the profile has no variation.
+bool standardize(std::vector<double>& values, const std::vector<char>& measured, size_t count) {
+    double mean = 0.0, largest = 0.0;
+    for (size_t r = 0; r < values.size(); ++r) {
+        if (!measured[r]) continue;
+        mean += values[r];
+        largest = std::max(largest, std::abs(values[r]));
+    }
+    mean /= double(count);
+    double squares = 0.0;
+    for (size_t r = 0; r < values.size(); ++r) {
+        values[r] = measured[r] ? values[r] - mean : 0.0;
+        squares += values[r] * values[r];
+    }
+    const double norm = std::sqrt(squares);
+    // Constant profiles leave only rounding noise after centring.
+    if (!(norm > 1e-12 * largest * std::sqrt(double(count)))) return false;
+    for (double& v : values) v /= norm;
+    return true;
+}
+
+// A top-K candidate. Ordered by `stronger`, a heap keeps the weakest on top;
+// equal strengths favour the lower node.
+struct Partner {
+    double strength;
+    uint32_t node;
+    double correlation;
+};
+
+bool stronger(const Partner& x, const Partner& y) {
+    if (x.strength != y.strength) return x.strength > y.strength;
+    return x.node < y.node;
+}
+
+} // namespace
+
+// --- Public API ---
+
+const char* correlationMethodName(CorrelationMethod method) {
+    return method == CorrelationMethod::Spearman ? "spearman" : "pearson";
+}
+
+bool parseCorrelationMethod(const std::string& text, CorrelationMethod& method) {
+    for (CorrelationMethod m : {CorrelationMethod::Pearson, CorrelationMethod::Spearman}) {
+        if (text == correlationMethodName(m)) {
+            method = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+ExpressionProfiles buildExpressionProfiles(const std::vector<GeneModel>& genes, CorrelationMethod method,
+                                           size_t minRegions, unsigned threads) {
+    TRACE_SCOPE("buildExpressionProfiles");
+    ExpressionProfiles p;
+    std::map<std::string_view, uint32_t> regionIds;
+    for (const auto& g : genes) {
+        for (const auto& region : g.brainRegionExpression) regionIds.emplace(region.first, 0);
+    }
+    for (auto& region : regionIds) {
+        region.second = uint32_t(p.regions.size());
+        p.regions.emplace_back(region.first);
+    }
+    const size_t dims = p.regions.size();
+    minRegions = std::max<size_t>(minRegions, 2);
+
+    std::vector<double> all(genes.size() * dims);
+    std::vector<char> keep(genes.size(), 0);
+    parallelFor(genes.size(), 256, [&](size_t begin, size_t end) {
+        std::vector<char> measured(dims);
+        std::vector<double> values(dims);
+        for (size_t g = begin; g < end; ++g) {
+            const auto& expression = genes[g].brainRegionExpression;
+            if (expression.size() < minRegions) continue;
+            std::fill(measured.begin(), measured.end(), 0);
+            for (const auto& region : expression) {
+                uint32_t r = regionIds.find(region.first)->second;
+                values[r] = region.second;
+                measured[r] = 1;
+            }
+            if (method == CorrelationMethod::Spearman) rankValues(values, measured);
+            if (!standardize(values, measured, expression.size())) continue;
+            std::copy(values.begin(), values.end(), all.begin() + std::ptrdiff_t(g * dims));
+            keep[g] = 1;
+        }
+    }, threads);
+
+    for (size_t g = 0; g < genes.size(); ++g) {
+        if (keep[g]) p.genes.push_back(g);
+    }
+    p.excludedGenes = genes.size() - p.genes.size();
+    p.values.resize(p.genes.size() * dims);
+    for (size_t node = 0; node < p.genes.size(); ++node) {
+        const double* src = &all[p.genes[node] * dims];
+        std::copy(src, src + dims, p.values.begin() + std::ptrdiff_t(node * dims));
+    }
+    return p;
+}
+
+std::vector<double> ExpressionProfiles::regionMajor() const {
+    const size_t n = genes.size(), dims = regions.size();
+    std::vector<double> columns(n * dims);
+    for (size_t node = 0; node < n; ++node)
+        for (size_t r = 0; r < dims; ++r) columns[r * n + node] = values[node * dims + r];
+    return columns;
+}
+
+void correlationBlock(const ExpressionProfiles& profiles, const std::vector<double>& regionMajor, size_t i,
+                      size_t rows, size_t j, size_t cols, double block[4][4]) {
+    // Every entry sums its products in region order, so a pair's value does
+    // not depend on where it falls in a block.
+    const size_t n = profiles.genes.size(), dims = profiles.regions.size();
+    const double* a = &profiles.values[i * dims];
+#ifdef COEXPRESSION_SSE2
+    if (rows == 4 && cols == 4) {
+        // A 4 x 4 block held in eight registers across the regions.
+        __m128d acc[4][2];
+        for (auto& row : acc) row[0] = row[1] = _mm_setzero_pd();
+        for (size_t r = 0; r < dims; ++r) {
+            const double* b = &regionMajor[r * n + j];
+            const __m128d lo = _mm_loadu_pd(b), hi = _mm_loadu_pd(b + 2);
+            for (size_t q = 0; q < 4; ++q) {
+                const __m128d x = _mm_set1_pd(a[q * dims + r]);
+                acc[q][0] = _mm_add_pd(acc[q][0], _mm_mul_pd(x, lo));
+                acc[q][1] = _mm_add_pd(acc[q][1], _mm_mul_pd(x, hi));
+            }
+        }
+        for (size_t q = 0; q < 4; ++q) {
+            _mm_storeu_pd(block[q], acc[q][0]);
+            _mm_storeu_pd(block[q] + 2, acc[q][1]);
+        }
+        return;
+    }
+#endif
+    for (size_t q = 0; q < rows; ++q)
+        for (size_t c = 0; c < cols; ++c) block[q][c] = 0.0;
+    for (size_t r = 0; r < dims; ++r) {
+        const double* b = &regionMajor[r * n + j];
+        for (size_t q = 0; q < rows; ++q) {
+            const double x = a[q * dims + r];
+            for (size_t c = 0; c < cols; ++c) block[q][c] += x * b[c];
+        }
+    }
+}
+
+CoexpressionNetwork buildCoexpressionNetwork(const std::vector<GeneModel>& genes, const CoexpressionOptions& options) {
+    TRACE_SCOPE("buildCoexpressionNetwork");
+    ExpressionProfiles profiles = buildExpressionProfiles(genes, options.method, options.minRegions, options.threads);
+    const std::vector<double> columns = profiles.regionMajor();
+    CoexpressionNetwork network;
+    network.genes = profiles.genes;
+    network.regions = profiles.regions;
+    network.excludedGenes = profiles.excludedGenes;
+    for (size_t g : network.genes) network.symbols.push_back(genes[g].symbol);
+
+    const size_t n = network.genes.size();
+    const size_t tile = std::max<size_t>(options.tileGenes, 1);
+    const size_t tiles = (n + tile - 1) / tile;
+    const size_t k = options.topK;
+    const double floor = options.minCorrelation;
+    network.pairsComputed = n < 2 ? 0 : (k ? n * (n - 1) : n * (n - 1) / 2);
+
+    // With a floor only, each row tile takes the pairs on and right of the
+    // diagonal. With top-K, a row tile owns its genes' heaps and takes
+    // every column tile, so no heap is shared between threads.
+    std::vector<std::vector<CoexpressionEdge>> tileEdges(tiles);
+    parallelFor(tiles, 1, [&](size_t begin, size_t end) {
+        std::vector<std::vector<Partner>> heaps;
+        std::vector<std::vector<CoexpressionEdge>> rowEdges(tile);
+        size_t i0 = 0;
+        auto keep = [&](size_t i, size_t j, double value) {
+            const double r = std::max(-1.0, std::min(1.0, value));
+            if (j == i || (!k && j < i) || std::abs(r) < floor) return;
+            if (!k) {
+                rowEdges[i - i0].push_back({uint32_t(i), uint32_t(j), r});
+                return;
+            }
+            std::vector<Partner>& heap = heaps[i - i0];
+            Partner candidate{std::abs(r), uint32_t(j), r};
+            if (heap.size() < k) {
+                heap.push_back(candidate);
+                std::push_heap(heap.begin(), heap.end(), stronger);
+            } else if (stronger(candidate, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), stronger);
+                heap.back() = candidate;
+                std::push_heap(heap.begin(), heap.end(), stronger);
+            }
+        };
+        for (size_t t = begin; t < end; ++t) {
+            i0 = t * tile;
+            const size_t i1 = std::min(n, i0 + tile);
+            std::vector<CoexpressionEdge>& edges = tileEdges[t];
+            heaps.assign(k ? i1 - i0 : 0, {});
+            for (size_t tj = k ? 0 : t; tj < tiles; ++tj) {
+                const size_t j0 = tj * tile, j1 = std::min(n, j0 + tile);
+                for (size_t i = i0; i < i1; i += 4) {
+                    const size_t rows = std::min<size_t>(4, i1 - i);
+                    for (size_t j = j0; j < j1; j += 4) {
+                        const size_t cols = std::min<size_t>(4, j1 - j);
+                        if (!k && j + cols <= i + 1) continue; // on or below the diagonal
+                        double block[4][4];
+                        correlationBlock(profiles, columns, i, rows, j, cols, block);
+                        for (size_t q = 0; q < rows; ++q)
+                            for (size_t c = 0; c < cols; ++c) keep(i + q, j + c, block[q][c]);
+                    }
+                }
+            }
+            // Rows were visited once per column tile; gathering them row by
+            // row leaves the tile's edges in pair order.
+            for (size_t i = i0; i < i1; ++i) {
+                std::vector<CoexpressionEdge>& row = rowEdges[i - i0];
+                edges.insert(edges.end(), row.begin(), row.end());
+                row.clear();
+                for (size_t p = 0; k && p < heaps[i - i0].size(); ++p) {
+                    const Partner& partner = heaps[i - i0][p];
+                    edges.push_back({uint32_t(std::min<size_t>(i, partner.node)),
+                                     uint32_t(std::max<size_t>(i, partner.node)), partner.correlation});
+                }
+            }
+        }
+    }, options.threads);
+
+    size_t total = 0;
+    for (const auto& edges : tileEdges) total += edges.size();
+    network.edges.reserve(total);
+    for (auto& edges : tileEdges) {
+        network.edges.insert(network.edges.end(), edges.begin(), edges.end());
+        std::vector<CoexpressionEdge>().swap(edges);
+    }
+    if (k) {
+        // Top-K edges can point back into earlier tiles, and pairs kept from
+        // both ends appear twice with the same value.
+        std::sort(network.edges.begin(), network.edges.end(), [](const CoexpressionEdge& x, const CoexpressionEdge& y) {
+            return x.a != y.a ? x.a < y.a : x.b < y.b;
+        });
+        network.edges.erase(std::unique(network.edges.begin(), network.edges.end(),
+                                        [](const CoexpressionEdge& x, const CoexpressionEdge& y) {
+                                            return x.a == y.a && x.b == y.b;
+                                        }),
+                            network.edges.end());
+    }
+
+    network.offsets.assign(n + 1, 0);
+    for (const auto& e : network.edges) {
+        ++network.offsets[e.a + 1];
+        ++network.offsets[e.b + 1];
+    }
+    for (size_t node = 0; node < n; ++node) network.offsets[node + 1] += network.offsets[node];
+    network.neighbours.resize(network.offsets[n]);
+    std::vector<size_t> fill(network.offsets.begin(), network.offsets.end() - 1);
+    for (const auto& e : network.edges) {
+        network.neighbours[fill[e.a]++] = {e.b, e.correlation};
+        network.neighbours[fill[e.b]++] = {e.a, e.correlation};
+    }
+    for (size_t node = 0; node < n; ++node) {
+        std::sort(network.neighbours.begin() + std::ptrdiff_t(network.offsets[node]),
+                  network.neighbours.begin() + std::ptrdiff_t(network.offsets[node + 1]),
+                  [](const CoexpressionNetwork::Neighbour& x, const CoexpressionNetwork::Neighbour& y) {
+                      double sx = std::abs(x.correlation), sy = std::abs(y.correlation);
+                      return sx != sy ? sx > sy : x.node < y.node;
+                  });
+    }
+    TRACE_COUNTER_ADD("buildCoexpressionNetwork.edges", network.edges.size());
+    return network;
+}
+
+bool writeCoexpressionEdgesCSV(const CoexpressionNetwork& network, const std::string& path) {
+    BufferedFileWriter out;
+    if (!out.open(path)) return false;
+    out.append("gene_a,gene_b,correlation\n");
+    for (const auto& e : network.edges) {
+        out.append(network.symbols[e.a]);
+        out.append(',');
+        out.append(network.symbols[e.b]);
+        out.append(',');
+        out.appendNumber(e.correlation);
+        out.append('\n');
+    }
+    return out.close();
+}
@@ -0,0 +1,102 @@
+#ifndef COEXPRESSION_H
+#define COEXPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Co-expression networks over brain-region profiles
+//-----------------------------------------------------------------------------
+//
+// Each gene's brainRegionExpression is a profile over the union of regions
+// seen in any gene. A gene needs `minRegions` measured regions and some
+// variation across them to take part; a region it lacks is filled with its
+// own mean, so it adds nothing to any correlation. For Spearman the
+// measured values are replaced by their ranks (ties share the mean rank).
+//
+// Profiles are centred and scaled to unit length, after which the
+// correlation of two genes is the dot product of their profiles and the
+// whole matrix is Z x Z^T. That product is computed one tile of rows
+// against one tile of columns at a time, in 4 x 4 blocks held in registers
+// and read from a region-major copy of Z, and every block is sparsified as
+// soon as it is done. Only the edges that survive are kept, so memory grows
+// with the edges rather than with the square of the gene count. Row tiles
+// are spread across worker threads and their edges concatenated in tile
+// order, so the network does not depend on the thread count.
+//
+// Edges are kept when |r| >= `minCorrelation`. With `topK` set, each gene
+// keeps only its K strongest partners by |r| (subject to the same floor),
+// and a pair is an edge when either gene keeps the other.
+
+enum class CorrelationMethod { Pearson, Spearman };
+
+const char* correlationMethodName(CorrelationMethod method); // "pearson" / "spearman"
+// @return False if `text` names no method.
+bool parseCorrelationMethod(const std::string& text, CorrelationMethod& method);
+
+// Standardized profiles of the genes that take part, as described above.
+struct ExpressionProfiles {
+    std::vector<size_t> genes;          // row -> index into the input genes
+    std::vector<std::string> regions;   // sorted
+    std::vector<double> values;         // row-major: genes.size() x regions.size()
+    size_t excludedGenes = 0;
+
+    // The same values region by region: value (row, r) is at [r * genes.size() + row].
+    std::vector<double> regionMajor() const;
+};
+
+ExpressionProfiles buildExpressionProfiles(const std::vector<GeneModel>& genes, CorrelationMethod method,
+                                           size_t minRegions = 3, unsigned threads = 0);
+
+// block[q][c] = profile (i + q) . profile (j + c), which is r up to rounding,
+// for q < rows and c < cols (each at most 4). For callers that walk the
+// correlation matrix in their own order.
+// @param regionMajor profiles.regionMajor(), computed once by the caller.
+void correlationBlock(const ExpressionProfiles& profiles, const std::vector<double>& regionMajor, size_t i,
+                      size_t rows, size_t j, size_t cols, double block[4][4]);
+
+struct CoexpressionOptions {
+    CorrelationMethod method = CorrelationMethod::Pearson;
+    double minCorrelation = 0.8;  // |r| floor for an edge
+    size_t topK = 0;              // 0 = keep every pair above the floor
+    size_t minRegions = 3;        // measured regions a gene needs
+    unsigned threads = 0;         // 0 = all cores
+    size_t tileGenes = 256;       // genes per row/column tile
+};
+
+struct CoexpressionEdge {
+    uint32_t a, b;       // node indices, a < b
+    double correlation;  // signed
+};
+
+struct CoexpressionNetwork {
+    std::vector<size_t> genes;          // node -> index into the input genes
+    std::vector<std::string> symbols;   // node -> gene symbol
+    std::vector<std::string> regions;   // the profile dimensions, sorted
+    std::vector<CoexpressionEdge> edges; // sorted by (a, b)
+    size_t excludedGenes = 0;           // too few regions or no variation
+    size_t pairsComputed = 0;
+
+    // Adjacency in compressed rows: node n's neighbours are
+    // neighbours[offsets[n] .. offsets[n + 1]), strongest |r| first.
+    struct Neighbour {
+        uint32_t node;
+        double correlation;
+    };
+    std::vector<size_t> offsets;
+    std::vector<Neighbour> neighbours;
+
+    size_t nodeCount() const { return genes.size(); }
+    size_t degree(size_t node) const { return offsets[node + 1] - offsets[node]; }
+};
+
+CoexpressionNetwork buildCoexpressionNetwork(const std::vector<GeneModel>& genes,
+                                             const CoexpressionOptions& options = {});
+
+// Writes gene_a,gene_b,correlation rows. @return False if the file could not be written.
+bool writeCoexpressionEdgesCSV(const CoexpressionNetwork& network, const std::string& path);
+
+#endif // COEXPRESSION_H
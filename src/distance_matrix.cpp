@@ -0,0 +1,259 @@
+#include "distance_matrix.h"
+#include "exporters.h"
+#include "parallel_utils.h"
+#include "trace.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// --- Private Helper Functions ---
+
+static inline unsigned popcount64(uint64_t x) {
+#if defined(_MSC_VER)
+    return unsigned(__popcnt64(x));
+#else
+    return unsigned(__builtin_popcountll(x));
+#endif
+}
+
+// Two-bit base codes: A=0, C=1, G=2, T/U=3; anything else is 4 (not compared).
+static const std::array<uint8_t, 256>& baseCodes() {
+    static const std::array<uint8_t, 256> codes = [] {
+        std::array<uint8_t, 256> c{};
+        c.fill(4);
+        const char* bases[] = {"Aa", "Cc", "Gg", "TtUu"};
+        for (uint8_t code = 0; code < 4; ++code)
+            for (const char* p = bases[code]; *p; ++p) c[static_cast<unsigned char>(*p)] = code;
+        return c;
+    }();
+    return codes;
+}
+
+// Sequence-major bit planes: word w of sequence s is at [s * words + w].
+struct PackedSequences {
+    size_t words = 0;
+    std::vector<uint64_t> lo, hi, valid;
+};
+
+static PackedSequences packSequences(const std::vector<SequenceModel>& sequences, unsigned threads) {
+    TRACE_SCOPE("packSequences");
+    PackedSequences packed;
+    size_t columns = 0;
+    for (const auto& s : sequences) columns = std::max(columns, s.aligned.size());
+    packed.words = (columns + 63) / 64;
+    const size_t total = sequences.size() * packed.words;
+    packed.lo.assign(total, 0);
+    packed.hi.assign(total, 0);
+    packed.valid.assign(total, 0);
+
+    const auto& codes = baseCodes();
+    parallelFor(sequences.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; ++s) {
+            const std::string& text = sequences[s].aligned;
+            uint64_t* lo = &packed.lo[s * packed.words];
+            uint64_t* hi = &packed.hi[s * packed.words];
+            uint64_t* valid = &packed.valid[s * packed.words];
+            for (size_t c = 0; c < text.size(); ++c) {
+                uint64_t code = codes[static_cast<unsigned char>(text[c])];
+                uint64_t bit = uint64_t(1) << (c % 64);
+                if (code < 4) {
+                    valid[c / 64] |= bit;
+                    if (code & 1) lo[c / 64] |= bit;
+                    if (code & 2) hi[c / 64] |= bit;
+                }
+            }
+        }
+    }, threads);
+    return packed;
+}
+
+// Per-byte bit counts of x: each byte holds 0-8.
+static inline uint64_t byteCounts(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    return (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+}
+
+// Sum of the eight byte lanes.
+static inline uint64_t sumBytes(uint64_t x) {
+    return (x * 0x0101010101010101ULL) >> 56;
+}
+
+// Adds the compared/mismatching column counts of sequences a and b over
+// words [first, last).
+static inline void comparePair(const PackedSequences& p, size_t a, size_t b, size_t first, size_t last,
+                               uint64_t& compared, uint64_t& mismatches) {
+    const uint64_t* loA = &p.lo[a * p.words];
+    const uint64_t* loB = &p.lo[b * p.words];
+    const uint64_t* hiA = &p.hi[a * p.words];
+    const uint64_t* hiB = &p.hi[b * p.words];
+    const uint64_t* vA = &p.valid[a * p.words];
+    const uint64_t* vB = &p.valid[b * p.words];
+    uint64_t c = 0, m = 0;
+#if defined(__POPCNT__) || defined(_MSC_VER)
+    for (size_t w = first; w < last; ++w) {
+        uint64_t both = vA[w] & vB[w];
+        c += popcount64(both);
+        m += popcount64(((loA[w] ^ loB[w]) | (hiA[w] ^ hiB[w])) & both);
+    }
+#else
+    // Without a popcount instruction, per-byte counts of up to 31 words are
+    // summed lane-wise (31 x 8 < 256) and reduced once per run.
+    for (size_t w = first; w < last;) {
+        const size_t runEnd = std::min(last, w + 31);
+        uint64_t cBytes = 0, mBytes = 0;
+        for (; w < runEnd; ++w) {
+            uint64_t both = vA[w] & vB[w];
+            cBytes += byteCounts(both);
+            mBytes += byteCounts(((loA[w] ^ loB[w]) | (hiA[w] ^ hiB[w])) & both);
+        }
+        c += sumBytes(cBytes);
+        m += sumBytes(mBytes);
+    }
+#endif
+    compared += c;
+    mismatches += m;
+}
+
+// --- Public API ---
+
+const char* distanceMeasureName(DistanceMeasure measure) {
+    switch (measure) {
+        case DistanceMeasure::Identity:    return "identity";
+        case DistanceMeasure::PDistance:   return "p";
+        case DistanceMeasure::JukesCantor: return "jc";
+    }
+    return "identity";
+}
+
+bool parseDistanceMeasure(const std::string& text, DistanceMeasure& measure) {
+    for (DistanceMeasure m : {DistanceMeasure::Identity, DistanceMeasure::PDistance, DistanceMeasure::JukesCantor}) {
+        if (text == distanceMeasureName(m)) {
+            measure = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+DistanceMatrix::DistanceMatrix(size_t sequences)
+    : n_(sequences),
+      mismatches_(sequences < 2 ? 0 : sequences * (sequences - 1) / 2, 0),
+      compared_(mismatches_.size(), 0) {}
+
+size_t DistanceMatrix::pairIndex(size_t i, size_t j, size_t n) {
+    return i * n - i * (i + 1) / 2 + (j - i - 1);
+}
+
+size_t DistanceMatrix::compared(size_t i, size_t j) const {
+    if (i == j) return 0;
+    if (i > j) std::swap(i, j);
+    return compared_[pairIndex(i, j, n_)];
+}
+
+size_t DistanceMatrix::mismatches(size_t i, size_t j) const {
+    if (i == j) return 0;
+    if (i > j) std::swap(i, j);
+    return mismatches_[pairIndex(i, j, n_)];
+}
+
+static double measureFromCounts(size_t compared, size_t mismatches, DistanceMeasure measure) {
+    if (compared == 0) return std::numeric_limits<double>::quiet_NaN();
+    // Exact for identical sequences; Jukes-Cantor would give -0 and print as "-0".
+    if (mismatches == 0) return measure == DistanceMeasure::Identity ? 1.0 : 0.0;
+    double p = double(mismatches) / double(compared);
+    switch (measure) {
+        case DistanceMeasure::Identity:  return 1.0 - p;
+        case DistanceMeasure::PDistance: return p;
+        case DistanceMeasure::JukesCantor:
+            return p >= 0.75 ? std::numeric_limits<double>::infinity() : -0.75 * std::log(1.0 - p * 4.0 / 3.0);
+    }
+    return p;
+}
+
+double DistanceMatrix::value(size_t i, size_t j, DistanceMeasure measure) const {
+    if (i == j) return measure == DistanceMeasure::Identity ? 1.0 : 0.0;
+    return measureFromCounts(compared(i, j), mismatches(i, j), measure);
+}
+
+std::vector<double> DistanceMatrix::condensed(DistanceMeasure measure) const {
+    std::vector<double> values(compared_.size());
+    for (size_t k = 0; k < values.size(); ++k) values[k] = measureFromCounts(compared_[k], mismatches_[k], measure);
+    return values;
+}
+
+DistanceMatrix computeDistanceMatrix(const std::vector<SequenceModel>& sequences, const DistanceOptions& options) {
+    TRACE_SCOPE("computeDistanceMatrix");
+    const size_t n = sequences.size();
+    DistanceMatrix matrix(n);
+    if (n < 2) return matrix;
+
+    const PackedSequences packed = packSequences(sequences, options.threads);
+    const size_t tile = std::max<size_t>(options.tileSequences, 1);
+    const size_t bandWords = std::max<size_t>(options.bandColumns / 64, 1);
+    const size_t tiles = (n + tile - 1) / tile;
+
+    // Tile pairs on and above the diagonal; each writes a disjoint set of pairs.
+    std::vector<std::pair<size_t, size_t>> work;
+    for (size_t ti = 0; ti < tiles; ++ti)
+        for (size_t tj = ti; tj < tiles; ++tj) work.emplace_back(ti, tj);
+
+    parallelFor(work.size(), 1, [&](size_t begin, size_t end) {
+        std::vector<uint64_t> compared(tile * tile), mismatches(tile * tile);
+        for (size_t k = begin; k < end; ++k) {
+            const size_t i0 = work[k].first * tile, i1 = std::min(n, i0 + tile);
+            const size_t j0 = work[k].second * tile, j1 = std::min(n, j0 + tile);
+            std::fill(compared.begin(), compared.end(), 0);
+            std::fill(mismatches.begin(), mismatches.end(), 0);
+            // One band of columns for every pair in the tile before moving
+            // on, so both tiles' words stay in cache across the pairs.
+            for (size_t w0 = 0; w0 < packed.words; w0 += bandWords) {
+                const size_t w1 = std::min(packed.words, w0 + bandWords);
+                for (size_t i = i0; i < i1; ++i) {
+                    for (size_t j = std::max(j0, i + 1); j < j1; ++j) {
+                        size_t slot = (i - i0) * tile + (j - j0);
+                        comparePair(packed, i, j, w0, w1, compared[slot], mismatches[slot]);
+                    }
+                }
+            }
+            for (size_t i = i0; i < i1; ++i) {
+                for (size_t j = std::max(j0, i + 1); j < j1; ++j) {
+                    size_t slot = (i - i0) * tile + (j - j0);
+                    size_t index = DistanceMatrix::pairIndex(i, j, n);
+                    matrix.compared_[index] = uint32_t(compared[slot]);
+                    matrix.mismatches_[index] = uint32_t(mismatches[slot]);
+                }
+            }
+        }
+    }, options.threads);
+    TRACE_COUNTER_ADD("computeDistanceMatrix.pairs", matrix.pairCount());
+    return matrix;
+}
+
+bool writeDistanceMatrixCSV(const DistanceMatrix& matrix, const std::vector<SequenceModel>& sequences,
+                            DistanceMeasure measure, const std::string& path) {
+    BufferedFileWriter out;
+    if (!out.open(path)) return false;
+    out.append("sequence");
+    for (const auto& s : sequences) {
+        out.append(',');
+        out.append(s.name);
+    }
+    out.append('\n');
+    for (size_t i = 0; i < matrix.size(); ++i) {
+        out.append(sequences[i].name);
+        for (size_t j = 0; j < matrix.size(); ++j) {
+            double v = matrix.value(i, j, measure);
+            out.append(',');
+            if (std::isinf(v)) out.append("inf");
+            else out.appendNumber(v);
+        }
+        out.append('\n');
+    }
+    return out.close();
+}
@@ -0,0 +1,73 @@
+#ifndef DISTANCE_MATRIX_H
+#define DISTANCE_MATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Pairwise sequence distances
+//-----------------------------------------------------------------------------
+//
+// Every pair of aligned sequences is compared over the columns where both
+// have a nucleotide (A, C, G, T or U, any case); gaps, N and other symbols
+// drop out pairwise. Sequences are packed into 2-bit base planes plus a
+// validity plane, so 64 columns are compared with a few XORs and two
+// popcounts. Pairs are processed in tiles of sequences and bands of columns
+// that stay in cache, with tiles spread across worker threads.
+
+enum class DistanceMeasure {
+    Identity,     // matching / compared (a similarity, 1 on the diagonal)
+    PDistance,    // mismatching / compared
+    JukesCantor   // -3/4 ln(1 - 4/3 p); infinite once p >= 0.75
+};
+
+const char* distanceMeasureName(DistanceMeasure measure);
+// Accepts "identity", "p" and "jc". @return False for anything else.
+bool parseDistanceMeasure(const std::string& text, DistanceMeasure& measure);
+
+struct DistanceOptions {
+    unsigned threads = 0;        // 0 = all cores
+    size_t tileSequences = 32;   // sequences per side of a tile
+    size_t bandColumns = 16384;  // columns per pass over a tile
+};
+
+// Symmetric pairwise counts stored once per unordered pair, in the condensed
+// row-major upper-triangle order: (0,1), (0,2), ..., (0,n-1), (1,2), ...
+class DistanceMatrix {
+public:
+    DistanceMatrix() = default;
+    explicit DistanceMatrix(size_t sequences);
+
+    size_t size() const { return n_; }
+    size_t pairCount() const { return mismatches_.size(); }
+    static size_t pairIndex(size_t i, size_t j, size_t n); // requires i < j < n
+
+    // Counts for a pair in either order; 0 on the diagonal.
+    size_t compared(size_t i, size_t j) const;
+    size_t mismatches(size_t i, size_t j) const;
+
+    // NaN for a pair with no comparable columns. The diagonal is 1 for
+    // Identity and 0 for the distances.
+    double value(size_t i, size_t j, DistanceMeasure measure) const;
+    // Every off-diagonal value in condensed order.
+    std::vector<double> condensed(DistanceMeasure measure) const;
+
+private:
+    friend DistanceMatrix computeDistanceMatrix(const std::vector<SequenceModel>&, const DistanceOptions&);
+
+    size_t n_ = 0;
+    std::vector<uint32_t> mismatches_;
+    std::vector<uint32_t> compared_;
+};
+
+DistanceMatrix computeDistanceMatrix(const std::vector<SequenceModel>& sequences, const DistanceOptions& options = {});
+
+// Writes a square matrix with a header row and column of sequence names.
+// @return False if the file could not be written.
+bool writeDistanceMatrixCSV(const DistanceMatrix& matrix, const std::vector<SequenceModel>& sequences,
+                            DistanceMeasure measure, const std::string& path);
+
+#endif // DISTANCE_MATRIX_H
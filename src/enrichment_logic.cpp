@@ -0,0 +1,151 @@
+#include "enrichment_logic.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <unordered_map>
+
+// --- Private Helper Functions ---
+
+static double logChoose(int n, int k) {
+    if (k < 0 || k > n) return -INFINITY;
+    return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+}
+
+// Number of distinct symbols in a (possibly unsorted, duplicated) symbol list.
+static int distinctCount(const std::vector<std::string>& symbols) {
+    std::vector<const std::string*> ptrs;
+    ptrs.reserve(symbols.size());
+    for (const auto& s : symbols) ptrs.push_back(&s);
+    std::sort(ptrs.begin(), ptrs.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+    auto last = std::unique(ptrs.begin(), ptrs.end(), [](const std::string* a, const std::string* b) { return *a == *b; });
+    return int(last - ptrs.begin());
+}
+
+// Benjamini-Hochberg step-up adjustment, written back into `fdr` of each result.
+// `tested` is the total number of hypotheses, which may exceed results.size()
+// when sets without any overlap (p = 1) were not materialised.
+static void adjustBenjaminiHochberg(std::vector<EnrichmentResult>& results, size_t tested) {
+    std::sort(results.begin(), results.end(), [](const EnrichmentResult& a, const EnrichmentResult& b) {
+        return a.pValue < b.pValue;
+    });
+    double running = 1.0;
+    for (size_t i = results.size(); i-- > 0;) {
+        double adj = results[i].pValue * double(tested) / double(i + 1);
+        running = std::min(running, adj);
+        results[i].fdr = std::min(1.0, running);
+    }
+}
+
+// --- Public Function Implementations ---
+
+double hypergeometricUpperTail(int k, int N, int K, int n) {
+    // At or below the lowest attainable overlap the whole support is counted.
+    int lo = std::max(0, n - (N - K));
+    if (k <= lo) return 1.0;
+    int hi = std::min(K, n);
+    if (k > hi || N <= 0) return 0.0;
+
+    // First term via log-binomials, then walk the tail with the term ratio
+    //   t(i+1)/t(i) = (K-i)(n-i) / ((i+1)(N-K-n+i+1)).
+    double logTerm = logChoose(K, k) + logChoose(N - K, n - k) - logChoose(N, n);
+    if (!std::isfinite(logTerm)) return 0.0;
+    double term = std::exp(logTerm);
+    double sum = term;
+    for (int i = k; i < hi; ++i) {
+        term *= double(K - i) * double(n - i) / (double(i + 1) * double(N - K - n + i + 1));
+        sum += term;
+        if (term < sum * 1e-16) break;
+    }
+    return std::min(1.0, sum);
+}
+
+std::vector<std::string> getKnockoutSymbols(const AlignmentMap& map) {
+    std::vector<std::string> symbols;
+    for (const auto& g : map.getGenes()) {
+        if (g.isKnockout) symbols.push_back(g.symbol);
+    }
+    return symbols;
+}
+
+std::vector<EnrichmentResult> runEnrichmentAnalysis(
+    const AlignmentMap& map,
+    const std::vector<std::string>& query_genes,
+    const EnrichmentOptions& options) {
+    const auto& pathways = map.getPathways();
+    const auto& geneSets = map.getGeneSets();
+    const auto& pathwayIndex = map.getPathwayIndex();
+    const auto& geneSetIndex = map.getGeneSetIndex();
+
+    // 1. Universe: every symbol the map knows about, plus the query itself.
+    std::set<std::string> query(query_genes.begin(), query_genes.end());
+    int universe = options.universeSize;
+    if (universe <= 0) {
+        std::set<std::string> all(query);
+        for (const auto& g : map.getGenes()) all.insert(g.symbol);
+        for (const auto& kv : pathwayIndex) all.insert(kv.first);
+        for (const auto& kv : geneSetIndex) all.insert(kv.first);
+        universe = int(all.size());
+    }
+    int n = int(query.size());
+
+    // 2. Overlap counting through the inverted index: cost is proportional to
+    //    the number of memberships of the query genes, not to the collection size.
+    std::unordered_map<size_t, std::vector<std::string>> pathwayHits, geneSetHits;
+    for (const auto& symbol : query) {
+        if (options.includePathways) {
+            for (size_t idx : map.getPathwaysForGene(symbol)) pathwayHits[idx].push_back(symbol);
+        }
+        if (options.includeGeneSets) {
+            for (size_t idx : map.getGeneSetsForGene(symbol)) geneSetHits[idx].push_back(symbol);
+        }
+    }
+
+    // 3. Candidate list covering every set that passes the size filters.
+    struct Candidate { bool isPathway; size_t index; };
+    std::vector<Candidate> candidates;
+    if (options.includePathways)
+        for (size_t i = 0; i < pathways.size(); ++i) candidates.push_back({true, i});
+    if (options.includeGeneSets)
+        for (size_t i = 0; i < geneSets.size(); ++i) candidates.push_back({false, i});
+
+    std::vector<int> sizes(candidates.size(), 0);
+    std::vector<EnrichmentResult> slots(candidates.size());
+    std::vector<char> keep(candidates.size(), 0);
+    std::vector<char> tested(candidates.size(), 0);
+
+    parallelFor(candidates.size(), 256, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            const auto& cand = candidates[c];
+            const auto& symbols = cand.isPathway ? pathways[cand.index].geneSymbols
+                                                 : geneSets[cand.index].geneSymbols;
+            int K = distinctCount(symbols);
+            if (K < options.minSetSize || (options.maxSetSize > 0 && K > options.maxSetSize)) continue;
+            tested[c] = 1;
+
+            auto& hits = cand.isPathway ? pathwayHits : geneSetHits;
+            auto it = hits.find(cand.index);
+            if (it == hits.end()) continue;
+
+            EnrichmentResult& r = slots[c];
+            r.name = cand.isPathway ? pathways[cand.index].name : geneSets[cand.index].name;
+            r.isPathway = cand.isPathway;
+            r.index = cand.index;
+            r.overlap = int(it->second.size());
+            r.setSize = K;
+            r.overlapGenes = it->second;
+            r.pValue = hypergeometricUpperTail(r.overlap, universe, K, n);
+            keep[c] = 1;
+        }
+    }, options.threads);
+
+    // 4. Collect and adjust for multiple testing.
+    std::vector<EnrichmentResult> results;
+    size_t testedCount = 0;
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        testedCount += tested[c];
+        if (keep[c]) results.push_back(std::move(slots[c]));
+    }
+    adjustBenjaminiHochberg(results, testedCount);
+    return results;
+}
@@ -0,0 +1,51 @@
+#ifndef ENRICHMENT_LOGIC_H
+#define ENRICHMENT_LOGIC_H
+
+#include <string>
+#include <vector>
+#include "map_logic.h"
+
+// Result of an over-representation test for one pathway or gene set.
+struct EnrichmentResult {
+    std::string name;
+    bool        isPathway  = false; // true: getPathways(), false: getGeneSets()
+    size_t      index      = 0;     // position in the originating vector
+    int         overlap    = 0;     // query genes found in the set (k)
+    int         setSize    = 0;     // distinct genes in the set (K)
+    double      pValue     = 1.0;   // hypergeometric upper tail P(X >= k)
+    double      fdr        = 1.0;   // Benjamini-Hochberg adjusted p-value
+    std::vector<std::string> overlapGenes;
+};
+
+struct EnrichmentOptions {
+    bool     includePathways = true;
+    bool     includeGeneSets = true;
+    int      minSetSize      = 1;
+    int      maxSetSize      = 0; // 0 = no upper bound
+    int      universeSize    = 0; // 0 = every symbol known to the map
+    unsigned threads         = 0; // 0 = all cores
+};
+
+// Runs a one-sided hypergeometric (Fisher exact) over-representation test of
+// `query_genes` against every pathway and gene set held by `map`.
+// Overlaps are counted through the map's inverted gene index, so only sets
+// that share at least one gene with the query are visited; p-values are then
+// computed in parallel and FDR-adjusted across all tested sets.
+//
+// @param map The map providing pathways, gene sets and the gene universe.
+// @param query_genes Gene symbols to test, e.g. the current knockouts. Duplicates are ignored.
+// @param options Set filters, universe override and thread count.
+// @return Results for sets with a non-zero overlap, sorted by ascending p-value.
+std::vector<EnrichmentResult> runEnrichmentAnalysis(
+    const AlignmentMap& map,
+    const std::vector<std::string>& query_genes,
+    const EnrichmentOptions& options = {});
+
+// Symbols of all genes currently marked as knockouts, in map order.
+std::vector<std::string> getKnockoutSymbols(const AlignmentMap& map);
+
+// Upper tail P(X >= k) of the hypergeometric distribution for a draw of
+// n items from a population of N containing K successes.
+double hypergeometricUpperTail(int k, int N, int K, int n);
+
+#endif // ENRICHMENT_LOGIC_H
@@ -0,0 +1,325 @@
+#include "exporters.h"
+#include "trace.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+// --- BufferedFileWriter ---
+
+BufferedFileWriter::BufferedFileWriter(size_t buffer_bytes)
+    : buffer_(std::max<size_t>(buffer_bytes, 512)) {}
+
+BufferedFileWriter::~BufferedFileWriter() {
+    close();
+}
+
+bool BufferedFileWriter::open(const std::string& path) {
+    close();
+    file_ = std::fopen(path.c_str(), "wb");
+    ok_ = file_ != nullptr;
+    used_ = 0;
+    written_ = 0;
+    // Our buffer already batches writes; a second one in stdio would only copy.
+    if (file_) std::setvbuf(file_, nullptr, _IONBF, 0);
+    return ok_;
+}
+
+bool BufferedFileWriter::close() {
+    if (!file_) return ok_;
+    flush();
+    if (std::fclose(file_) != 0) ok_ = false;
+    file_ = nullptr;
+    return ok_;
+}
+
+bool BufferedFileWriter::good() const {
+    return ok_ && file_ != nullptr;
+}
+
+size_t BufferedFileWriter::bytesWritten() const {
+    return written_;
+}
+
+void BufferedFileWriter::flush() {
+    if (used_ > 0 && ok_ && file_) {
+        if (std::fwrite(buffer_.data(), 1, used_, file_) != used_) ok_ = false;
+    }
+    used_ = 0;
+}
+
+// Room for `bytes` contiguous bytes at the end of the buffer (bytes must
+// not exceed the buffer size); the caller advances used_.
+char* BufferedFileWriter::reserve(size_t bytes) {
+    if (buffer_.size() - used_ < bytes) flush();
+    return buffer_.data() + used_;
+}
+
+void BufferedFileWriter::append(std::string_view text) {
+    written_ += text.size();
+    if (!ok_) return;
+    if (text.size() > buffer_.size() - used_) {
+        flush();
+        // Larger than the whole buffer (e.g. a chromosome): write it through.
+        if (text.size() >= buffer_.size()) {
+            if (file_ && std::fwrite(text.data(), 1, text.size(), file_) != text.size()) ok_ = false;
+            return;
+        }
+    }
+    std::memcpy(buffer_.data() + used_, text.data(), text.size());
+    used_ += text.size();
+}
+
+void BufferedFileWriter::append(char c) {
+    ++written_;
+    if (!ok_) return;
+    if (used_ == buffer_.size()) flush();
+    buffer_[used_++] = c;
+}
+
+void BufferedFileWriter::appendInteger(long long value) {
+    char* p = reserve(24);
+    char* end = std::to_chars(p, p + 24, value).ptr;
+    written_ += size_t(end - p);
+    used_ += size_t(end - p);
+}
+
+void BufferedFileWriter::appendNumber(double value, std::string_view non_finite) {
+    if (!std::isfinite(value)) {
+        append(non_finite);
+        return;
+    }
+    // Fixed notation of a double needs at most 309 integer digits plus the
+    // shortest round-trip fraction; 350 bytes covers every finite value.
+    const size_t room = 350;
+    char* p = reserve(room);
+    auto result = std::to_chars(p, p + room, value, std::chars_format::fixed);
+    size_t n = result.ec == std::errc() ? size_t(result.ptr - p) : 0;
+    written_ += n;
+    used_ += n;
+}
+
+void BufferedFileWriter::appendJsonString(std::string_view text) {
+    append('"');
+    size_t run = 0; // start of the pending unescaped run
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c != '"' && c != '\\' && c >= 0x20) continue;
+        append(text.substr(run, i - run));
+        switch (c) {
+            case '"':  append("\\\""); break;
+            case '\\': append("\\\\"); break;
+            case '\n': append("\\n"); break;
+            case '\r': append("\\r"); break;
+            case '\t': append("\\t"); break;
+            default: {
+                static const char hex[] = "0123456789abcdef";
+                char escape[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+                append(std::string_view(escape, 6));
+            }
+        }
+        run = i + 1;
+    }
+    append(text.substr(run));
+    append('"');
+}
+
+// --- Formats ---
+
+ExportFormat exportFormatForPath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    std::string ext = dot == std::string::npos ? "" : path.substr(dot + 1);
+    for (auto& c : ext) c = char(std::tolower(static_cast<unsigned char>(c)));
+    if (ext == "json") return ExportFormat::JSON;
+    if (ext == "fasta" || ext == "fa" || ext == "fas") return ExportFormat::FASTA;
+    return ExportFormat::CSV;
+}
+
+// Joins list items with `separator` (CSV) or writes a JSON string array.
+static void writeList(BufferedFileWriter& out, const StringList& items, bool json, char separator = ';') {
+    if (json) out.append('[');
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (i) out.append(json ? std::string_view(", ") : std::string_view(&separator, 1));
+        if (json) out.appendJsonString(items[i]);
+        else out.append(items[i]);
+    }
+    if (json) out.append(']');
+}
+
+// --- GeneExportStream ---
+
+GeneExportStream::GeneExportStream(const std::string& path, ExportFormat format, size_t buffer_bytes)
+    : out_(buffer_bytes), format_(format) {
+    if (format_ == ExportFormat::FASTA || !out_.open(path)) {
+        finished_ = true;
+        return;
+    }
+    if (format_ == ExportFormat::CSV) {
+        out_.append("gene_name,knockout,status,expression_level,disorderTags,brainRegionExpression\n");
+    } else {
+        // loadGenesFromJSON looks for exactly `"genes": [`.
+        out_.append("{\n  \"genes\": [");
+    }
+}
+
+GeneExportStream::~GeneExportStream() {
+    finish();
+}
+
+bool GeneExportStream::good() const {
+    return out_.good();
+}
+
+void GeneExportStream::write(const GeneModel& g) {
+    if (finished_) return;
+    const char* status = g.isKnockout ? "Inactive" : "Active";
+    if (format_ == ExportFormat::CSV) {
+        out_.append(g.symbol);
+        out_.append(g.isKnockout ? ",X," : ",,");
+        out_.append(status);
+        out_.append(',');
+        out_.appendNumber(g.expressionLevel);
+        out_.append(',');
+        writeList(out_, g.disorderTags, false);
+        out_.append(',');
+        bool first = true;
+        for (const auto& kv : g.brainRegionExpression) {
+            if (!first) out_.append(';');
+            out_.append(kv.first);
+            out_.append(':');
+            out_.appendNumber(kv.second);
+            first = false;
+        }
+        out_.append('\n');
+    } else {
+        out_.append(records_ ? ",\n    {\n      \"gene_name\": " : "\n    {\n      \"gene_name\": ");
+        out_.appendJsonString(g.symbol);
+        out_.append(g.isKnockout ? ",\n      \"knockout\": true" : ",\n      \"knockout\": false");
+        out_.append(",\n      \"status\": \"");
+        out_.append(status);
+        out_.append("\",\n      \"expression_level\": ");
+        out_.appendNumber(g.expressionLevel, "null");
+        out_.append(",\n      \"categories\": ");
+        writeList(out_, g.categories, true);
+        out_.append(",\n      \"disorderTags\": ");
+        writeList(out_, g.disorderTags, true);
+        // Must stay last: the loader ends a gene at its first closing brace.
+        out_.append(",\n      \"brainRegionExpression\": {");
+        bool first = true;
+        for (const auto& kv : g.brainRegionExpression) {
+            out_.append(first ? "\n        " : ",\n        ");
+            out_.appendJsonString(kv.first);
+            out_.append(": ");
+            out_.appendNumber(kv.second, "null");
+            first = false;
+        }
+        out_.append(first ? "}\n    }" : "\n      }\n    }");
+    }
+    ++records_;
+}
+
+bool GeneExportStream::finish() {
+    if (!finished_ && format_ == ExportFormat::JSON) out_.append(records_ ? "\n  ]\n}\n" : "]\n}\n");
+    finished_ = true;
+    return out_.close();
+}
+
+size_t GeneExportStream::recordsWritten() const {
+    return records_;
+}
+
+// --- SequenceExportStream ---
+
+static const char* sequenceTypeName(SequenceType type) {
+    switch (type) {
+        case SequenceType::DNA:     return "DNA";
+        case SequenceType::RNA:     return "RNA";
+        case SequenceType::Protein: return "Protein";
+    }
+    return "DNA";
+}
+
+SequenceExportStream::SequenceExportStream(const std::string& path, ExportFormat format,
+                                           size_t buffer_bytes, size_t fasta_width)
+    : out_(buffer_bytes), format_(format), fastaWidth_(std::max<size_t>(fasta_width, 1)) {
+    if (!out_.open(path)) {
+        finished_ = true;
+        return;
+    }
+    if (format_ == ExportFormat::CSV) out_.append("sequence_id,sequence,annotations\n");
+    else if (format_ == ExportFormat::JSON) out_.append("{\n  \"sequences\": [");
+}
+
+SequenceExportStream::~SequenceExportStream() {
+    finish();
+}
+
+bool SequenceExportStream::good() const {
+    return out_.good();
+}
+
+void SequenceExportStream::write(const SequenceModel& seq) {
+    if (finished_) return;
+    switch (format_) {
+        case ExportFormat::CSV:
+            // The loader drops rows with fewer than three fields, so the
+            // annotations column is never left empty.
+            out_.append(seq.name);
+            out_.append(',');
+            out_.append(seq.aligned);
+            out_.append(',');
+            out_.append(sequenceTypeName(seq.type));
+            out_.append('\n');
+            break;
+        case ExportFormat::JSON:
+            out_.append(records_ ? ",\n    {\n      \"sequence_id\": " : "\n    {\n      \"sequence_id\": ");
+            out_.appendJsonString(seq.name);
+            out_.append(",\n      \"sequence\": ");
+            out_.appendJsonString(seq.aligned);
+            out_.append("\n    }");
+            break;
+        case ExportFormat::FASTA:
+            out_.append('>');
+            out_.append(seq.name);
+            out_.append('\n');
+            for (size_t pos = 0; pos < seq.aligned.size(); pos += fastaWidth_) {
+                out_.append(std::string_view(seq.aligned).substr(pos, fastaWidth_));
+                out_.append('\n');
+            }
+            break;
+    }
+    ++records_;
+}
+
+bool SequenceExportStream::finish() {
+    if (!finished_ && format_ == ExportFormat::JSON) out_.append(records_ ? "\n  ]\n}\n" : "]\n}\n");
+    finished_ = true;
+    return out_.close();
+}
+
+size_t SequenceExportStream::recordsWritten() const {
+    return records_;
+}
+
+// --- Whole-collection exports ---
+
+bool exportGenes(const AlignmentMap& map, const std::string& path, ExportFormat format) {
+    TRACE_SCOPE("exportGenes");
+    GeneExportStream stream(path, format);
+    if (!stream.good()) return false;
+    for (const auto& g : map.getGenes()) stream.write(g);
+    return stream.finish();
+}
+
+bool exportSequences(const std::vector<SequenceModel>& sequences, const std::string& path, ExportFormat format) {
+    TRACE_SCOPE("exportSequences");
+    SequenceExportStream stream(path, format);
+    if (!stream.good()) return false;
+    for (const auto& s : sequences) stream.write(s);
+    return stream.finish();
+}
+
+bool exportSequences(const AlignmentBlock& block, const std::string& path, ExportFormat format) {
+    return exportSequences(block.sequences, path, format);
+}
@@ -0,0 +1,117 @@
+#ifndef EXPORTERS_H
+#define EXPORTERS_H
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Buffered output
+//-----------------------------------------------------------------------------
+
+constexpr size_t kDefaultExportBuffer = size_t(1) << 20;
+
+// Writes to a file through one large buffer with std::to_chars formatting,
+// bypassing iostreams. Errors are sticky: after a failed write good() stays
+// false and later appends are dropped.
+class BufferedFileWriter {
+public:
+    explicit BufferedFileWriter(size_t buffer_bytes = kDefaultExportBuffer);
+    ~BufferedFileWriter();
+    BufferedFileWriter(const BufferedFileWriter&) = delete;
+    BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+    bool open(const std::string& path);
+    // Flushes and closes. @return False if the file was never opened or any
+    // write (or the close) failed; repeated calls return the same result.
+    bool close();
+    bool good() const;
+    // Bytes handed to append*, buffered or not.
+    size_t bytesWritten() const;
+
+    void append(std::string_view text);
+    void append(char c);
+    void appendInteger(long long value);
+    // Shortest round-trip decimal in fixed notation, which the loaders'
+    // digit scanners accept (no exponent). Non-finite values become
+    // `non_finite` ("nan" suits CSV, "null" suits JSON).
+    void appendNumber(double value, std::string_view non_finite = "nan");
+    // Quoted, with JSON escapes.
+    void appendJsonString(std::string_view text);
+
+private:
+    std::FILE* file_ = nullptr;
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+    size_t written_ = 0;
+    bool ok_ = false; // false until a successful open()
+
+    void flush();
+    char* reserve(size_t bytes);
+};
+
+//-----------------------------------------------------------------------------
+// Streaming exporters
+//-----------------------------------------------------------------------------
+
+enum class ExportFormat { CSV, JSON, FASTA };
+
+// "csv", "json" or "fasta"/"fa"/"fas" from a path's extension; CSV otherwise.
+ExportFormat exportFormatForPath(const std::string& path);
+
+// Writes genes one record at a time, in the layouts loadGenesFromCSV and
+// loadGenesFromJSON read back. Nothing but the output buffer is held in
+// memory, so a stream can outlive the data it is fed from. Values that the
+// loaders' delimiter-based parsers cannot represent (commas in CSV fields,
+// quotes in JSON strings) are written as-is or escaped, and will not
+// round-trip through those loaders.
+class GeneExportStream {
+public:
+    // FASTA is not a gene format; opening with it fails.
+    GeneExportStream(const std::string& path, ExportFormat format, size_t buffer_bytes = kDefaultExportBuffer);
+    ~GeneExportStream();
+
+    bool good() const;
+    void write(const GeneModel& gene);
+    // Writes the JSON trailer and closes. @return False on any I/O error.
+    bool finish();
+    size_t recordsWritten() const;
+
+private:
+    BufferedFileWriter out_;
+    ExportFormat format_;
+    size_t records_ = 0;
+    bool finished_ = false;
+};
+
+// Writes sequences as CSV (sequence_id,sequence,annotations), JSON
+// ({"sequences": [...]}) or FASTA wrapped at `fasta_width` columns. The
+// aligned sequence is exported, so gaps and edits are kept.
+class SequenceExportStream {
+public:
+    SequenceExportStream(const std::string& path, ExportFormat format,
+                         size_t buffer_bytes = kDefaultExportBuffer, size_t fasta_width = 60);
+    ~SequenceExportStream();
+
+    bool good() const;
+    void write(const SequenceModel& sequence);
+    bool finish();
+    size_t recordsWritten() const;
+
+private:
+    BufferedFileWriter out_;
+    ExportFormat format_;
+    size_t fastaWidth_;
+    size_t records_ = 0;
+    bool finished_ = false;
+};
+
+// Whole-collection exports built on the streams above.
+// @return False if the file could not be written (or FASTA was asked for genes).
+bool exportGenes(const AlignmentMap& map, const std::string& path, ExportFormat format);
+bool exportSequences(const std::vector<SequenceModel>& sequences, const std::string& path, ExportFormat format);
+bool exportSequences(const AlignmentBlock& block, const std::string& path, ExportFormat format);
+
+#endif // EXPORTERS_H
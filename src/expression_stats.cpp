@@ -0,0 +1,283 @@
+#include "expression_stats.h"
+#include "map_logic.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string_view>
+
+static const double kNaN = std::numeric_limits<double>::quiet_NaN();
+static const double kPi = 3.14159265358979323846;
+
+// --- QuantileSketch ---
+
+QuantileSketch::QuantileSketch(double compression)
+    : compression_(std::max(10.0, compression)) {
+    clear();
+}
+
+void QuantileSketch::clear() {
+    min_ = std::numeric_limits<double>::infinity();
+    max_ = -std::numeric_limits<double>::infinity();
+    total_ = 0;
+    centroids_.clear();
+    buffer_.clear();
+}
+
+void QuantileSketch::add(double value, double weight) {
+    if (std::isnan(value) || !(weight > 0)) return;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    buffer_.push_back({value, weight});
+    total_ += weight;
+    if (buffer_.size() >= size_t(5 * compression_)) compact();
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    std::vector<Centroid> scratch;
+    for (const auto& c : other.folded(scratch)) add(c.mean, c.weight);
+    if (other.total_ > 0) {
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+}
+
+void QuantileSketch::compact() {
+    if (buffer_.empty()) return;
+    fold(buffer_);
+    centroids_.swap(buffer_);
+    buffer_.clear();
+}
+
+const std::vector<QuantileSketch::Centroid>& QuantileSketch::folded(std::vector<Centroid>& scratch) const {
+    if (buffer_.empty()) return centroids_;
+    scratch = buffer_;
+    fold(scratch);
+    return scratch;
+}
+
+// Merges the pending values with the centroids. Neighbours are combined
+// while the merged centroid spans at most one unit of
+// k(q) = d / 2pi * asin(2q - 1), which allows large centroids
+// mid-distribution and tiny ones at the tails. Output centroids are written
+// back over `work`, never ahead of the one being read.
+void QuantileSketch::fold(std::vector<Centroid>& work) const {
+    if (work.empty()) return;
+    auto byMean = [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; };
+    std::sort(work.begin(), work.end(), byMean);
+    size_t middle = work.size();
+    work.insert(work.end(), centroids_.begin(), centroids_.end());
+    std::inplace_merge(work.begin(), work.begin() + std::ptrdiff_t(middle), work.end(), byMean);
+
+    // The k-limit is turned into a weight limit once per output centroid,
+    // keeping the trigonometry out of the per-value loop.
+    const double scale = compression_ / (2 * kPi);
+    auto weightLimit = [&](double before) {
+        double k = scale * std::asin(2 * std::min(1.0, before / total_) - 1) + 1;
+        double q = k >= scale * kPi / 2 ? 1.0 : (1 + std::sin(k / scale)) / 2;
+        return q * total_;
+    };
+    size_t out = 0;
+    Centroid current = work[0];
+    double before = 0;
+    double limit = weightLimit(0);
+    for (size_t i = 1; i < work.size(); ++i) {
+        const Centroid next = work[i];
+        if (before + current.weight + next.weight <= limit) {
+            double weight = current.weight + next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / weight;
+            current.weight = weight;
+        } else {
+            work[out++] = current;
+            before += current.weight;
+            limit = weightLimit(before);
+            current = next;
+        }
+    }
+    work[out++] = current;
+    work.resize(out);
+}
+
+double QuantileSketch::quantile(double q) const {
+    std::vector<Centroid> scratch;
+    const auto& c = folded(scratch);
+    if (c.empty()) return kNaN;
+    if (q <= 0) return min_;
+    if (q >= 1) return max_;
+    double index = q * total_;
+
+    // Between the extremes and the outer centroids' centres, interpolate
+    // towards the exact min and max.
+    if (index < c.front().weight / 2) {
+        return min_ + (c.front().mean - min_) * index / (c.front().weight / 2);
+    }
+    if (total_ - index <= c.back().weight / 2) {
+        return max_ - (max_ - c.back().mean) * (total_ - index) / (c.back().weight / 2);
+    }
+    double atCentre = c.front().weight / 2;
+    for (size_t i = 0; i + 1 < c.size(); ++i) {
+        double step = (c[i].weight + c[i + 1].weight) / 2;
+        if (atCentre + step > index) {
+            double t = (index - atCentre) / step;
+            return c[i].mean + (c[i + 1].mean - c[i].mean) * t;
+        }
+        atCentre += step;
+    }
+    return c.back().mean;
+}
+
+double QuantileSketch::cdf(double x) const {
+    std::vector<Centroid> scratch;
+    const auto& c = folded(scratch);
+    if (c.empty() || std::isnan(x)) return kNaN;
+    if (x < min_) return 0.0;
+    if (x >= max_) return 1.0;
+    if (x < c.front().mean) {
+        return c.front().weight / 2 * (x - min_) / (c.front().mean - min_) / total_;
+    }
+    double atCentre = c.front().weight / 2;
+    for (size_t i = 0; i + 1 < c.size(); ++i) {
+        double step = (c[i].weight + c[i + 1].weight) / 2;
+        if (x < c[i + 1].mean) {
+            double span = c[i + 1].mean - c[i].mean;
+            double t = span > 0 ? (x - c[i].mean) / span : 1.0;
+            return (atCentre + step * t) / total_;
+        }
+        atCentre += step;
+    }
+    double tail = c.back().weight / 2 * (x - c.back().mean) / (max_ - c.back().mean);
+    return std::min(1.0, (atCentre + tail) / total_);
+}
+
+double QuantileSketch::count() const {
+    return total_;
+}
+
+double QuantileSketch::min() const {
+    return total_ > 0 ? min_ : kNaN;
+}
+
+double QuantileSketch::max() const {
+    return total_ > 0 ? max_ : kNaN;
+}
+
+size_t QuantileSketch::centroidCount() const {
+    std::vector<Centroid> scratch;
+    return folded(scratch).size();
+}
+
+// --- TopK ---
+
+// Higher value first; ties broken by symbol so the order is deterministic.
+static bool ranksHigher(const RankedGene& a, const RankedGene& b) {
+    return a.value > b.value || (a.value == b.value && a.symbol < b.symbol);
+}
+
+TopK::TopK(size_t capacity) : capacity_(capacity) {}
+
+void TopK::add(const std::string& symbol, double value) {
+    if (capacity_ == 0 || std::isnan(value)) return;
+    if (heap_.size() < capacity_) {
+        heap_.push_back({symbol, value});
+        std::push_heap(heap_.begin(), heap_.end(), ranksHigher);
+        return;
+    }
+    // Most candidates lose to the weakest retained gene; check before copying the symbol.
+    const RankedGene& weakest = heap_.front();
+    if (value < weakest.value || (value == weakest.value && !(symbol < weakest.symbol))) return;
+    std::pop_heap(heap_.begin(), heap_.end(), ranksHigher);
+    heap_.back() = {symbol, value};
+    std::push_heap(heap_.begin(), heap_.end(), ranksHigher);
+}
+
+void TopK::merge(const TopK& other) {
+    for (const auto& g : other.heap_) add(g.symbol, g.value);
+}
+
+void TopK::clear() {
+    heap_.clear();
+}
+
+std::vector<RankedGene> TopK::sorted(size_t k) const {
+    std::vector<RankedGene> out = heap_;
+    std::sort(out.begin(), out.end(), ranksHigher);
+    if (out.size() > k) out.resize(k);
+    return out;
+}
+
+size_t TopK::capacity() const {
+    return capacity_;
+}
+
+size_t TopK::size() const {
+    return heap_.size();
+}
+
+// Ranks (value, index) pairs, so only the winners' symbols are copied.
+template <typename Key>
+static std::vector<RankedGene> selectTop(const std::vector<GeneModel>& genes, size_t k, Key key) {
+    std::vector<std::pair<double, size_t>> candidates;
+    candidates.reserve(genes.size());
+    for (size_t i = 0; i < genes.size(); ++i) {
+        double v = key(genes[i]);
+        if (!std::isnan(v)) candidates.push_back({v, i});
+    }
+    k = std::min(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + std::ptrdiff_t(k), candidates.end(),
+                      [&](const auto& a, const auto& b) {
+                          return a.first > b.first || (a.first == b.first && genes[a.second].symbol < genes[b.second].symbol);
+                      });
+    std::vector<RankedGene> out;
+    out.reserve(k);
+    for (size_t i = 0; i < k; ++i) out.push_back({genes[candidates[i].second].symbol, candidates[i].first});
+    return out;
+}
+
+std::vector<RankedGene> selectTopGenes(const std::vector<GeneModel>& genes, size_t k,
+                                       double (*key)(const GeneModel&)) {
+    return selectTop(genes, k, key);
+}
+
+std::vector<RankedGene> selectTopGenesInRegion(const std::vector<GeneModel>& genes, size_t k,
+                                               const std::string& region) {
+    return selectTop(genes, k, [&](const GeneModel& g) {
+        auto it = g.brainRegionExpression.find(std::string_view(region));
+        return it == g.brainRegionExpression.end() ? kNaN : it->second;
+    });
+}
+
+// --- ExpressionStatistics ---
+
+void ExpressionStatistics::add(const GeneModel& gene) {
+    expression.add(gene.expressionLevel);
+    polygenicScore.add(gene.polygenicScore);
+    for (const auto& kv : gene.brainRegionExpression) {
+        std::string_view region(kv.first.data(), kv.first.size());
+        auto it = regions.find(region);
+        if (it == regions.end()) it = regions.emplace(std::string(region), QuantileSketch()).first;
+        it->second.add(kv.second);
+    }
+    topExpression.add(gene.symbol, gene.expressionLevel);
+    topPolygenicScore.add(gene.symbol, gene.polygenicScore);
+}
+
+void ExpressionStatistics::merge(const ExpressionStatistics& other) {
+    expression.merge(other.expression);
+    polygenicScore.merge(other.polygenicScore);
+    for (const auto& kv : other.regions) regions[kv.first].merge(kv.second);
+    topExpression.merge(other.topExpression);
+    topPolygenicScore.merge(other.topPolygenicScore);
+}
+
+void ExpressionStatistics::compact() {
+    expression.compact();
+    polygenicScore.compact();
+    for (auto& kv : regions) kv.second.compact();
+}
+
+void ExpressionStatistics::clear() {
+    expression.clear();
+    polygenicScore.clear();
+    regions.clear();
+    topExpression.clear();
+    topPolygenicScore.clear();
+}
@@ -0,0 +1,124 @@
+#ifndef EXPRESSION_STATS_H
+#define EXPRESSION_STATS_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+struct GeneModel;
+
+//-----------------------------------------------------------------------------
+// Streaming quantiles
+//-----------------------------------------------------------------------------
+
+// Mergeable t-digest. Values are buffered and periodically folded into at
+// most ~compression centroids, sized by the k1 scale function so they stay
+// small near the tails; p99 is therefore accurate to well under a percentile
+// rank. Memory and query cost are bounded by the compression, not by the
+// number of values added. NaN is ignored.
+//
+// Const members never modify the sketch, so concurrent queries are safe.
+// While values are pending, a query folds a private copy of the buffer;
+// compact() after a bulk load makes later queries read the centroids only.
+class QuantileSketch {
+public:
+    explicit QuantileSketch(double compression = 200.0);
+
+    void add(double value, double weight = 1.0);
+    // Adds every value summarised by `other` (e.g. a parallel load shard).
+    void merge(const QuantileSketch& other);
+    void clear();
+    // Folds the pending buffer into the centroids.
+    void compact();
+
+    // @param q Quantile in [0, 1]; 0.5 is the median.
+    // @return Estimated value at q, or NaN when empty.
+    double quantile(double q) const;
+    // Estimated fraction of values <= x.
+    double cdf(double x) const;
+
+    double count() const;
+    double min() const;
+    double max() const;
+    size_t centroidCount() const;
+
+private:
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+
+    double compression_;
+    double min_, max_;
+    double total_ = 0;                // weight of centroids_ plus buffer_
+    std::vector<Centroid> centroids_; // sorted by mean
+    std::vector<Centroid> buffer_;
+
+    // Replaces `work` (pending values, in any order) by its merge with
+    // centroids_, compressed to at most ~compression centroids.
+    void fold(std::vector<Centroid>& work) const;
+    // centroids_ when nothing is pending, otherwise a folded copy in `scratch`.
+    const std::vector<Centroid>& folded(std::vector<Centroid>& scratch) const;
+};
+
+//-----------------------------------------------------------------------------
+// Top-K selection
+//-----------------------------------------------------------------------------
+
+struct RankedGene {
+    std::string symbol;
+    double value = 0.0;
+};
+
+// Keeps the K largest values seen as a bounded min-heap: O(log K) per add,
+// O(K log K) to read in order. Ties rank by symbol so results are stable.
+class TopK {
+public:
+    explicit TopK(size_t capacity = 100);
+
+    void add(const std::string& symbol, double value);
+    void merge(const TopK& other);
+    void clear();
+
+    // Up to `k` (default: all retained) genes, highest value first.
+    std::vector<RankedGene> sorted(size_t k = size_t(-1)) const;
+    size_t capacity() const;
+    size_t size() const;
+
+private:
+    size_t capacity_;
+    std::vector<RankedGene> heap_; // min-heap: the weakest retained gene on top
+};
+
+// One-off top-K over any gene attribute (e.g. a brain region), by partial sort.
+// @param key Value to rank by; genes for which it returns NaN are skipped.
+std::vector<RankedGene> selectTopGenes(const std::vector<GeneModel>& genes, size_t k,
+                                       double (*key)(const GeneModel&));
+// Highest expression in one brain region; genes without the region are skipped.
+std::vector<RankedGene> selectTopGenesInRegion(const std::vector<GeneModel>& genes, size_t k,
+                                               const std::string& region);
+
+//-----------------------------------------------------------------------------
+// Per-map expression statistics
+//-----------------------------------------------------------------------------
+
+// Quantile sketches for expression, polygenic score and every brain region,
+// plus top-K lists for expression and polygenic score. Updated per gene;
+// shards built on separate threads combine with merge().
+struct ExpressionStatistics {
+    QuantileSketch expression;
+    QuantileSketch polygenicScore;
+    std::map<std::string, QuantileSketch, std::less<>> regions;
+    TopK topExpression;
+    TopK topPolygenicScore;
+
+    void add(const GeneModel& gene);
+    void merge(const ExpressionStatistics& other);
+    void clear();
+    // Compacts every sketch; see QuantileSketch::compact().
+    void compact();
+};
+
+#endif // EXPRESSION_STATS_H
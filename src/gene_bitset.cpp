@@ -0,0 +1,446 @@
+#include "gene_bitset.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// --- Private Helper Functions ---
+
+static inline unsigned popcount64(uint64_t x) {
+#if defined(_MSC_VER)
+    return unsigned(__popcnt64(x));
+#else
+    return unsigned(__builtin_popcountll(x));
+#endif
+}
+
+// Popcount of (a[i] & b[i]) over a full bitmap. Four independent accumulators
+// keep the popcnt units busy and let the compiler vectorise the AND.
+static size_t andPopcount(const uint64_t* a, const uint64_t* b) {
+    static_assert(GeneBitset::kBitmapWords % 4 == 0, "bitmap must be a multiple of 4 words");
+    size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    for (size_t i = 0; i < GeneBitset::kBitmapWords; i += 4) {
+        c0 += popcount64(a[i] & b[i]);
+        c1 += popcount64(a[i + 1] & b[i + 1]);
+        c2 += popcount64(a[i + 2] & b[i + 2]);
+        c3 += popcount64(a[i + 3] & b[i + 3]);
+    }
+    return c0 + c1 + c2 + c3;
+}
+
+enum { OpAnd = 0, OpOr = 1, OpAndNot = 2 };
+
+//-----------------------------------------------------------------------------
+// GeneUniverse
+//-----------------------------------------------------------------------------
+
+uint32_t GeneUniverse::intern(const std::string& symbol) {
+    auto it = ids_.find(symbol);
+    if (it != ids_.end()) return it->second;
+    uint32_t id = uint32_t(symbols_.size());
+    ids_.emplace(symbol, id);
+    symbols_.push_back(symbol);
+    return id;
+}
+
+int GeneUniverse::find(const std::string& symbol) const {
+    auto it = ids_.find(symbol);
+    return it == ids_.end() ? -1 : int(it->second);
+}
+
+const std::string& GeneUniverse::symbol(uint32_t id) const {
+    return symbols_.at(id);
+}
+
+size_t GeneUniverse::size() const {
+    return symbols_.size();
+}
+
+//-----------------------------------------------------------------------------
+// GeneBitset containers
+//-----------------------------------------------------------------------------
+
+void GeneBitset::toBitmap(Container& c) {
+    if (c.isBitmap()) return;
+    c.bitmap.assign(kBitmapWords, 0);
+    for (uint16_t v : c.array) c.bitmap[v >> 6] |= uint64_t(1) << (v & 63);
+    c.array.clear();
+    c.array.shrink_to_fit();
+}
+
+// Switches a bitmap container back to an array when it becomes sparse.
+void GeneBitset::normalise(Container& c) {
+    if (!c.isBitmap() || c.cardinality > kArrayMax) return;
+    c.array.clear();
+    c.array.reserve(c.cardinality);
+    for (size_t w = 0; w < kBitmapWords; ++w) {
+        uint64_t bits = c.bitmap[w];
+        while (bits) {
+            unsigned bit = popcount64((bits & (~bits + 1)) - 1);
+            c.array.push_back(uint16_t(w * 64 + bit));
+            bits &= bits - 1;
+        }
+    }
+    c.bitmap.clear();
+    c.bitmap.shrink_to_fit();
+}
+
+size_t GeneBitset::intersectCount(const Container& a, const Container& b) {
+    if (a.isBitmap() && b.isBitmap()) {
+        return andPopcount(a.bitmap.data(), b.bitmap.data());
+    }
+    if (a.isBitmap() != b.isBitmap()) {
+        const Container& arr = a.isBitmap() ? b : a;
+        const Container& bmp = a.isBitmap() ? a : b;
+        size_t n = 0;
+        for (uint16_t v : arr.array) n += (bmp.bitmap[v >> 6] >> (v & 63)) & 1;
+        return n;
+    }
+
+    // Array/array: linear merge, or galloping binary search when one side is
+    // much smaller than the other.
+    const auto& small = a.array.size() <= b.array.size() ? a.array : b.array;
+    const auto& large = a.array.size() <= b.array.size() ? b.array : a.array;
+    size_t n = 0;
+    if (small.size() * 32 < large.size()) {
+        auto lo = large.begin();
+        for (uint16_t v : small) {
+            lo = std::lower_bound(lo, large.end(), v);
+            if (lo == large.end()) break;
+            if (*lo == v) ++n;
+        }
+        return n;
+    }
+    size_t i = 0, j = 0;
+    while (i < small.size() && j < large.size()) {
+        uint16_t x = small[i], y = large[j];
+        n += (x == y);
+        i += (x <= y);
+        j += (y <= x);
+    }
+    return n;
+}
+
+GeneBitset::Container GeneBitset::combine(const Container& a, const Container& b, int op) {
+    Container out;
+    out.key = a.key;
+
+    if (!a.isBitmap() && !b.isBitmap()) {
+        auto dst = std::back_inserter(out.array);
+        if (op == OpAnd) std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), dst);
+        else if (op == OpOr) std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), dst);
+        else std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), dst);
+        out.cardinality = uint32_t(out.array.size());
+        if (out.cardinality > kArrayMax) toBitmap(out);
+        return out;
+    }
+
+    Container ta = a, tb = b;
+    toBitmap(ta);
+    toBitmap(tb);
+    out.bitmap.resize(kBitmapWords);
+    size_t card = 0;
+    for (size_t w = 0; w < kBitmapWords; ++w) {
+        uint64_t x = ta.bitmap[w], y = tb.bitmap[w];
+        uint64_t r = op == OpAnd ? (x & y) : op == OpOr ? (x | y) : (x & ~y);
+        out.bitmap[w] = r;
+        card += popcount64(r);
+    }
+    out.cardinality = uint32_t(card);
+    normalise(out);
+    return out;
+}
+
+//-----------------------------------------------------------------------------
+// GeneBitset
+//-----------------------------------------------------------------------------
+
+GeneBitset GeneBitset::fromIds(std::vector<uint32_t> ids) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    GeneBitset set;
+    for (size_t i = 0; i < ids.size();) {
+        Container c;
+        c.key = uint16_t(ids[i] >> 16);
+        size_t j = i;
+        while (j < ids.size() && (ids[j] >> 16) == c.key) {
+            c.array.push_back(uint16_t(ids[j] & 0xFFFF));
+            ++j;
+        }
+        c.cardinality = uint32_t(j - i);
+        if (c.cardinality > kArrayMax) toBitmap(c);
+        set.cardinality_ += c.cardinality;
+        set.containers_.push_back(std::move(c));
+        i = j;
+    }
+    return set;
+}
+
+GeneBitset GeneBitset::fromSymbols(const std::vector<std::string>& symbols, GeneUniverse& universe) {
+    std::vector<uint32_t> ids;
+    ids.reserve(symbols.size());
+    for (const auto& s : symbols) ids.push_back(universe.intern(s));
+    return fromIds(std::move(ids));
+}
+
+void GeneBitset::add(uint32_t id) {
+    uint16_t key = uint16_t(id >> 16), low = uint16_t(id & 0xFFFF);
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+                               [](const Container& c, uint16_t k) { return c.key < k; });
+    if (it == containers_.end() || it->key != key) {
+        Container c;
+        c.key = key;
+        it = containers_.insert(it, std::move(c));
+    }
+    if (it->isBitmap()) {
+        uint64_t& word = it->bitmap[low >> 6];
+        uint64_t mask = uint64_t(1) << (low & 63);
+        if (word & mask) return;
+        word |= mask;
+    } else {
+        auto pos = std::lower_bound(it->array.begin(), it->array.end(), low);
+        if (pos != it->array.end() && *pos == low) return;
+        it->array.insert(pos, low);
+    }
+    ++it->cardinality;
+    ++cardinality_;
+    if (!it->isBitmap() && it->cardinality > kArrayMax) toBitmap(*it);
+}
+
+bool GeneBitset::contains(uint32_t id) const {
+    uint16_t key = uint16_t(id >> 16), low = uint16_t(id & 0xFFFF);
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+                               [](const Container& c, uint16_t k) { return c.key < k; });
+    if (it == containers_.end() || it->key != key) return false;
+    if (it->isBitmap()) return (it->bitmap[low >> 6] >> (low & 63)) & 1;
+    return std::binary_search(it->array.begin(), it->array.end(), low);
+}
+
+size_t GeneBitset::cardinality() const {
+    return cardinality_;
+}
+
+bool GeneBitset::empty() const {
+    return cardinality_ == 0;
+}
+
+std::vector<uint32_t> GeneBitset::toIds() const {
+    std::vector<uint32_t> ids;
+    ids.reserve(cardinality_);
+    for (const auto& c : containers_) {
+        uint32_t high = uint32_t(c.key) << 16;
+        if (!c.isBitmap()) {
+            for (uint16_t v : c.array) ids.push_back(high | v);
+            continue;
+        }
+        for (size_t w = 0; w < kBitmapWords; ++w) {
+            uint64_t bits = c.bitmap[w];
+            while (bits) {
+                unsigned bit = popcount64((bits & (~bits + 1)) - 1);
+                ids.push_back(high | uint32_t(w * 64 + bit));
+                bits &= bits - 1;
+            }
+        }
+    }
+    return ids;
+}
+
+std::vector<std::string> GeneBitset::toSymbols(const GeneUniverse& universe) const {
+    std::vector<std::string> symbols;
+    for (uint32_t id : toIds()) symbols.push_back(universe.symbol(id));
+    return symbols;
+}
+
+size_t GeneBitset::intersectionCount(const GeneBitset& a, const GeneBitset& b) {
+    size_t n = 0, i = 0, j = 0;
+    while (i < a.containers_.size() && j < b.containers_.size()) {
+        const auto& x = a.containers_[i];
+        const auto& y = b.containers_[j];
+        if (x.key < y.key) ++i;
+        else if (y.key < x.key) ++j;
+        else { n += intersectCount(x, y); ++i; ++j; }
+    }
+    return n;
+}
+
+GeneBitset GeneBitset::intersect(const GeneBitset& a, const GeneBitset& b) {
+    GeneBitset out;
+    size_t i = 0, j = 0;
+    while (i < a.containers_.size() && j < b.containers_.size()) {
+        const auto& x = a.containers_[i];
+        const auto& y = b.containers_[j];
+        if (x.key < y.key) { ++i; continue; }
+        if (y.key < x.key) { ++j; continue; }
+        Container c = combine(x, y, OpAnd);
+        if (c.cardinality > 0) {
+            out.cardinality_ += c.cardinality;
+            out.containers_.push_back(std::move(c));
+        }
+        ++i; ++j;
+    }
+    return out;
+}
+
+GeneBitset GeneBitset::unite(const GeneBitset& a, const GeneBitset& b) {
+    GeneBitset out;
+    size_t i = 0, j = 0;
+    while (i < a.containers_.size() || j < b.containers_.size()) {
+        Container c;
+        if (j == b.containers_.size() || (i < a.containers_.size() && a.containers_[i].key < b.containers_[j].key)) {
+            c = a.containers_[i++];
+        } else if (i == a.containers_.size() || b.containers_[j].key < a.containers_[i].key) {
+            c = b.containers_[j++];
+        } else {
+            c = combine(a.containers_[i++], b.containers_[j++], OpOr);
+        }
+        out.cardinality_ += c.cardinality;
+        out.containers_.push_back(std::move(c));
+    }
+    return out;
+}
+
+GeneBitset GeneBitset::difference(const GeneBitset& a, const GeneBitset& b) {
+    GeneBitset out;
+    size_t j = 0;
+    for (const auto& x : a.containers_) {
+        while (j < b.containers_.size() && b.containers_[j].key < x.key) ++j;
+        Container c = (j < b.containers_.size() && b.containers_[j].key == x.key)
+                          ? combine(x, b.containers_[j], OpAndNot)
+                          : x;
+        if (c.cardinality > 0) {
+            out.cardinality_ += c.cardinality;
+            out.containers_.push_back(std::move(c));
+        }
+    }
+    return out;
+}
+
+double GeneBitset::jaccard(const GeneBitset& a, const GeneBitset& b) {
+    size_t inter = intersectionCount(a, b);
+    size_t uni = a.cardinality_ + b.cardinality_ - inter;
+    return uni == 0 ? 0.0 : double(inter) / double(uni);
+}
+
+//-----------------------------------------------------------------------------
+// All-pairs similarity
+//-----------------------------------------------------------------------------
+
+std::vector<GeneSetSimilarity> computeGeneSetSimilarities(
+    const std::vector<GeneBitset>& sets,
+    double min_jaccard,
+    unsigned threads) {
+    const size_t n = sets.size();
+    const size_t tile = 64;
+
+    // Process sets in ascending size order so that, for a threshold t, the
+    // partners of set i are a contiguous rank range: J <= |i| / |j| rules out
+    // every set larger than |i| / t before any counting happens.
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) {
+        return sets[x].cardinality() < sets[y].cardinality();
+    });
+    std::vector<size_t> sizes(n);
+    std::vector<std::vector<uint32_t>> members(n);
+    uint32_t maxId = 0;
+    for (size_t r = 0; r < n; ++r) {
+        members[r] = sets[order[r]].toIds();
+        sizes[r] = members[r].size();
+        if (!members[r].empty()) maxId = std::max(maxId, members[r].back());
+    }
+
+    // Gene-id postings (id -> ranks containing it, ascending). Only pairs that
+    // share at least one gene are ever touched.
+    std::vector<std::vector<uint32_t>> postings(n == 0 ? 0 : size_t(maxId) + 1);
+    for (size_t r = 0; r < n; ++r)
+        for (uint32_t id : members[r]) postings[id].push_back(uint32_t(r));
+
+    // Each row tile accumulates intersection counts against later ranks in a
+    // thread-local dense counter, then emits the pairs that pass.
+    const size_t rowTiles = (n + tile - 1) / tile;
+    std::vector<std::vector<GeneSetSimilarity>> perTile(rowTiles);
+    parallelFor(rowTiles, 1, [&](size_t begin, size_t end) {
+        std::vector<uint32_t> counts(n, 0);
+        std::vector<uint32_t> touched;
+        for (size_t t = begin; t < end; ++t) {
+            auto& out = perTile[t];
+            for (size_t r = t * tile; r < std::min(n, (t + 1) * tile); ++r) {
+                size_t ci = sizes[r];
+                if (ci == 0) continue;
+                uint32_t last = uint32_t(n);
+                if (min_jaccard > 0.0) {
+                    double maxSize = double(ci) / min_jaccard;
+                    last = uint32_t(std::upper_bound(sizes.begin() + r, sizes.end(), maxSize,
+                                                     [](double v, size_t sz) { return v < double(sz); }) - sizes.begin());
+                }
+                for (uint32_t id : members[r]) {
+                    const auto& list = postings[id];
+                    auto it = std::upper_bound(list.begin(), list.end(), uint32_t(r));
+                    for (; it != list.end() && *it < last; ++it) {
+                        if (counts[*it]++ == 0) touched.push_back(*it);
+                    }
+                }
+                for (uint32_t q : touched) {
+                    size_t inter = counts[q];
+                    counts[q] = 0;
+                    double jac = double(inter) / double(ci + sizes[q] - inter);
+                    if (jac < min_jaccard) continue;
+                    size_t a = order[r], b = order[q];
+                    out.push_back({std::min(a, b), std::max(a, b), inter, jac});
+                }
+                touched.clear();
+            }
+        }
+    }, threads);
+
+    std::vector<GeneSetSimilarity> result;
+    for (auto& v : perTile) result.insert(result.end(), v.begin(), v.end());
+    std::sort(result.begin(), result.end(), [](const GeneSetSimilarity& a, const GeneSetSimilarity& b) {
+        return a.first != b.first ? a.first < b.first : a.second < b.second;
+    });
+    return result;
+}
+
+std::vector<GeneSetSimilarity> computeGeneSetSimilarities(
+    const AlignmentMap& map,
+    double min_jaccard,
+    unsigned threads) {
+    GeneUniverse universe;
+    std::vector<GeneBitset> sets;
+    sets.reserve(map.getGeneSets().size());
+    for (const auto& gs : map.getGeneSets()) sets.push_back(GeneBitset::fromSymbols(gs.geneSymbols, universe));
+    return computeGeneSetSimilarities(sets, min_jaccard, threads);
+}
+
+std::vector<std::vector<size_t>> groupRedundantGeneSets(
+    size_t set_count,
+    const std::vector<GeneSetSimilarity>& similarities,
+    double threshold) {
+    std::vector<size_t> parent(set_count);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto root = [&](size_t x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    };
+    for (const auto& s : similarities) {
+        if (s.jaccard < threshold) continue;
+        size_t a = root(s.first), b = root(s.second);
+        if (a != b) parent[std::max(a, b)] = std::min(a, b);
+    }
+
+    std::vector<std::vector<size_t>> groups;
+    std::vector<size_t> groupOf(set_count, size_t(-1));
+    for (size_t i = 0; i < set_count; ++i) {
+        size_t r = root(i);
+        if (groupOf[r] == size_t(-1)) {
+            groupOf[r] = groups.size();
+            groups.emplace_back();
+        }
+        groups[groupOf[r]].push_back(i);
+    }
+    return groups;
+}
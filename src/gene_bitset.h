@@ -0,0 +1,113 @@
+#ifndef GENE_BITSET_H
+#define GENE_BITSET_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Dense gene-ID universe
+//-----------------------------------------------------------------------------
+
+// Maps gene symbols to dense 32-bit ids so sets can be stored as bitsets.
+class GeneUniverse {
+public:
+    uint32_t intern(const std::string& symbol);
+    int find(const std::string& symbol) const; // -1 if unknown
+    const std::string& symbol(uint32_t id) const;
+    size_t size() const;
+
+private:
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::vector<std::string> symbols_;
+};
+
+//-----------------------------------------------------------------------------
+// Compressed gene bitset
+//-----------------------------------------------------------------------------
+
+// Roaring-style bitset over gene ids. Ids are split into 65536-wide chunks;
+// each chunk is a sorted array of 16-bit offsets while it holds at most 4096
+// entries and a 1024-word bitmap once it grows past that.
+class GeneBitset {
+public:
+    static GeneBitset fromIds(std::vector<uint32_t> ids);
+    static GeneBitset fromSymbols(const std::vector<std::string>& symbols, GeneUniverse& universe);
+
+    void add(uint32_t id);
+    bool contains(uint32_t id) const;
+    size_t cardinality() const;
+    bool empty() const;
+    std::vector<uint32_t> toIds() const;
+    std::vector<std::string> toSymbols(const GeneUniverse& universe) const;
+
+    static size_t intersectionCount(const GeneBitset& a, const GeneBitset& b);
+    static GeneBitset intersect(const GeneBitset& a, const GeneBitset& b);
+    static GeneBitset unite(const GeneBitset& a, const GeneBitset& b);
+    static GeneBitset difference(const GeneBitset& a, const GeneBitset& b);
+    static double jaccard(const GeneBitset& a, const GeneBitset& b);
+
+    static constexpr size_t kArrayMax     = 4096;
+    static constexpr size_t kBitmapWords  = 1024;
+
+private:
+    struct Container {
+        uint16_t key = 0;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> array;  // used while !isBitmap
+        std::vector<uint64_t> bitmap; // kBitmapWords words once converted
+        bool isBitmap() const { return !bitmap.empty(); }
+    };
+
+    std::vector<Container> containers_; // sorted by key
+    size_t cardinality_ = 0;
+
+    static void toBitmap(Container& c);
+    static void normalise(Container& c);
+    static size_t intersectCount(const Container& a, const Container& b);
+    static Container combine(const Container& a, const Container& b, int op);
+};
+
+//-----------------------------------------------------------------------------
+// All-pairs gene set similarity
+//-----------------------------------------------------------------------------
+
+struct GeneSetSimilarity {
+    size_t first  = 0; // index into the input sets, first < second
+    size_t second = 0;
+    size_t intersection = 0;
+    double jaccard = 0.0;
+};
+
+// Computes Jaccard similarity for every pair of sets with jaccard >= min_jaccard.
+// Sets are ranked by size and processed in row tiles of 64 distributed over
+// `threads` workers. Intersections are counted through gene-id postings, so
+// pairs sharing no gene cost nothing, and with min_jaccard > 0 partners too
+// large to reach the threshold are cut off by rank.
+//
+// @param sets The bitsets to compare.
+// @param min_jaccard Minimum similarity to report (0 reports every overlapping pair).
+// @param threads Worker count (0 = all cores).
+// @return Matching pairs ordered by (first, second).
+std::vector<GeneSetSimilarity> computeGeneSetSimilarities(
+    const std::vector<GeneBitset>& sets,
+    double min_jaccard = 0.0,
+    unsigned threads = 0);
+
+// Convenience overload over AlignmentMap::getGeneSets(); indices refer to that vector.
+std::vector<GeneSetSimilarity> computeGeneSetSimilarities(
+    const AlignmentMap& map,
+    double min_jaccard = 0.0,
+    unsigned threads = 0);
+
+// Groups sets connected by pairs with jaccard >= threshold. Each group lists
+// set indices in ascending order; singletons are included so the result
+// covers all `set_count` sets.
+std::vector<std::vector<size_t>> groupRedundantGeneSets(
+    size_t set_count,
+    const std::vector<GeneSetSimilarity>& similarities,
+    double threshold);
+
+#endif // GENE_BITSET_H
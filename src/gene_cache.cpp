@@ -0,0 +1,226 @@
+#include "gene_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// --- Private Helper Functions ---
+
+static const char kMagic[4] = {'A', 'M', 'G', 'C'};
+static const uint32_t kFormatVersion = 1;
+
+static uint64_t fnv1a64(const std::string& s, uint64_t h = 1469598103934665603ULL) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Append-only little binary writer / bounds-checked reader for cache records.
+struct RecordWriter {
+    std::string buf;
+    template <typename T> void pod(const T& v) {
+        buf.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+    void str(std::string_view s) {
+        pod(uint32_t(s.size()));
+        buf.append(s);
+    }
+};
+
+struct RecordReader {
+    const std::string& buf;
+    size_t pos = 0;
+    bool ok = true;
+    template <typename T> T pod() {
+        T v{};
+        if (pos + sizeof(T) > buf.size()) { ok = false; return v; }
+        std::memcpy(&v, buf.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return v;
+    }
+    std::string str() {
+        uint32_t n = pod<uint32_t>();
+        if (!ok || pos + n > buf.size()) { ok = false; return {}; }
+        std::string s = buf.substr(pos, n);
+        pos += n;
+        return s;
+    }
+};
+
+static std::string encodeRecord(const std::string& key, const GeneModel& g) {
+    RecordWriter w;
+    w.buf.append(kMagic, 4);
+    w.pod(kFormatVersion);
+    w.pod(int64_t(nowSeconds()));
+    w.str(key);
+    w.str(g.symbol);
+    w.str(g.chromosome);
+    w.pod(int32_t(g.start));
+    w.pod(int32_t(g.end));
+    w.pod(g.expressionLevel);
+    w.pod(g.polygenicScore);
+    w.pod(uint8_t(g.isKnockout));
+    w.pod(uint32_t(g.categories.size()));
+    for (const auto& c : g.categories) w.str(c);
+    w.pod(uint32_t(g.disorderTags.size()));
+    for (const auto& t : g.disorderTags) w.str(t);
+    w.pod(uint32_t(g.brainRegionExpression.size()));
+    for (const auto& kv : g.brainRegionExpression) {
+        w.str(kv.first);
+        w.pod(kv.second);
+    }
+    return w.buf;
+}
+
+// Decodes a record, checking the embedded key (guards against hash collisions)
+// and reporting the creation time for TTL checks.
+static bool decodeRecord(const std::string& buf, const std::string& key, GeneModel& g, int64_t& created) {
+    if (buf.size() < 4 || std::memcmp(buf.data(), kMagic, 4) != 0) return false;
+    RecordReader r{buf, 4};
+    if (r.pod<uint32_t>() != kFormatVersion) return false;
+    created = r.pod<int64_t>();
+    if (r.str() != key) return false;
+    g = GeneModel{};
+    g.symbol = r.str();
+    g.chromosome = r.str();
+    g.start = r.pod<int32_t>();
+    g.end = r.pod<int32_t>();
+    g.expressionLevel = r.pod<double>();
+    g.polygenicScore = r.pod<double>();
+    g.isKnockout = r.pod<uint8_t>() != 0;
+    for (uint32_t n = r.pod<uint32_t>(); r.ok && n > 0; --n) g.categories.emplace_back(r.str());
+    for (uint32_t n = r.pod<uint32_t>(); r.ok && n > 0; --n) g.disorderTags.emplace_back(r.str());
+    for (uint32_t n = r.pod<uint32_t>(); r.ok && n > 0; --n) {
+        std::string region = r.str();
+        setRegionExpression(g.brainRegionExpression, region, r.pod<double>());
+    }
+    return r.ok;
+}
+
+// --- GeneCache Implementation ---
+
+GeneCache::GeneCache(const GeneCacheOptions& options) : options_(options) {
+    std::error_code ec;
+    fs::create_directories(options_.directory, ec);
+
+    // Rebuild the LRU list from modification times (oldest at the back).
+    std::vector<std::pair<fs::file_time_type, fs::directory_entry>> files;
+    for (const auto& entry : fs::directory_iterator(options_.directory, ec)) {
+        if (entry.is_regular_file(ec) && entry.path().extension() == ".gene") {
+            files.push_back({entry.last_write_time(ec), entry});
+        }
+    }
+    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (const auto& f : files) {
+        std::string name = f.second.path().filename().string();
+        uintmax_t bytes = f.second.file_size(ec);
+        lru_.push_back(name);
+        entries_[name] = {std::prev(lru_.end()), bytes};
+        totalBytes_ += bytes;
+    }
+    evictOverflow();
+}
+
+std::string GeneCache::pathFor(const std::string& accession, const std::string& fields) const {
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx.gene",
+                  static_cast<unsigned long long>(fnv1a64(fields, fnv1a64(accession + '\n'))));
+    return (fs::path(options_.directory) / name).string();
+}
+
+bool GeneCache::get(const std::string& accession, const std::string& fields, GeneModel& out) {
+    std::string path = pathFor(accession, fields);
+    std::string file = fs::path(path).filename().string();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.find(file) == entries_.end()) return false;
+
+    std::ifstream in(path, std::ios::binary);
+    std::string buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    int64_t created = 0;
+    if (!in.good() && !in.eof()) { erase(file); return false; }
+    if (!decodeRecord(buf, accession + '\n' + fields, out, created)) { erase(file); return false; }
+    if (nowSeconds() - created > options_.ttl.count()) { erase(file); return false; }
+    touch(file);
+    return true;
+}
+
+void GeneCache::put(const std::string& accession, const std::string& fields, const GeneModel& gene) {
+    std::string path = pathFor(accession, fields);
+    std::string file = fs::path(path).filename().string();
+    std::string buf = encodeRecord(accession + '\n' + fields, gene);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Write to a temporary name and rename so readers never see a torn record.
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return;
+        out.write(buf.data(), std::streamsize(buf.size()));
+        if (!out.good()) return;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) return;
+
+    auto it = entries_.find(file);
+    if (it != entries_.end()) {
+        totalBytes_ -= it->second.bytes;
+        lru_.erase(it->second.lru);
+    }
+    lru_.push_front(file);
+    entries_[file] = {lru_.begin(), buf.size()};
+    totalBytes_ += buf.size();
+    evictOverflow();
+}
+
+void GeneCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!lru_.empty()) erase(lru_.back());
+}
+
+size_t GeneCache::entryCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+uintmax_t GeneCache::totalBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totalBytes_;
+}
+
+// Caller holds mutex_.
+void GeneCache::touch(const std::string& file) {
+    auto& entry = entries_.at(file);
+    lru_.splice(lru_.begin(), lru_, entry.lru);
+    std::error_code ec;
+    fs::last_write_time(fs::path(options_.directory) / file, fs::file_time_type::clock::now(), ec);
+}
+
+// Caller holds mutex_.
+void GeneCache::erase(std::string file) {
+    auto it = entries_.find(file);
+    if (it == entries_.end()) return;
+    totalBytes_ -= it->second.bytes;
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+    std::error_code ec;
+    fs::remove(fs::path(options_.directory) / file, ec);
+}
+
+// Caller holds mutex_ (or is the constructor).
+void GeneCache::evictOverflow() {
+    while (totalBytes_ > options_.maxBytes && !lru_.empty()) erase(lru_.back());
+}
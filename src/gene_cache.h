@@ -0,0 +1,55 @@
+#ifndef GENE_CACHE_H
+#define GENE_CACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "map_logic.h"
+
+struct GeneCacheOptions {
+    std::string directory = ".gene_cache";
+    std::chrono::seconds ttl{7 * 24 * 3600};  // entries older than this are treated as misses
+    uintmax_t maxBytes = 256ull * 1024 * 1024; // least recently used entries are evicted past this
+};
+
+// Persistent, content-addressed cache of parsed GeneModel records.
+//
+// Each entry lives in its own file named after a 64-bit hash of the accession
+// and the requested fields, and holds the record in a compact binary form, so
+// a hit needs neither HTTP nor JSON parsing. Recency is kept in memory and
+// mirrored in file modification times, which seed the LRU order on startup.
+// All methods are thread-safe.
+class GeneCache {
+public:
+    explicit GeneCache(const GeneCacheOptions& options = {});
+
+    // Returns true and fills `out` on a fresh hit; expired entries are removed.
+    bool get(const std::string& accession, const std::string& fields, GeneModel& out);
+    void put(const std::string& accession, const std::string& fields, const GeneModel& gene);
+    void clear();
+
+    size_t entryCount() const;
+    uintmax_t totalBytes() const;
+    std::string pathFor(const std::string& accession, const std::string& fields) const;
+
+private:
+    struct Entry {
+        std::list<std::string>::iterator lru; // position in lru_ (front = most recent)
+        uintmax_t bytes = 0;
+    };
+
+    GeneCacheOptions options_;
+    mutable std::mutex mutex_;
+    std::list<std::string> lru_;
+    std::unordered_map<std::string, Entry> entries_; // keyed by file name
+    uintmax_t totalBytes_ = 0;
+
+    void touch(const std::string& file);
+    void erase(std::string file); // by value: callers pass lru_ entries it removes
+    void evictOverflow();
+};
+
+#endif // GENE_CACHE_H
@@ -0,0 +1,268 @@
+#include "gene_clustering.h"
+#include "coexpression.h"
+#include "exporters.h"
+#include "parallel_utils.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+// --- Private Helper Functions ---
+
+namespace {
+
+// The upper triangle of the distance matrix in 4 x 4 blocks of one cache
+// line each. Walking row a touches four of its entries per line on either
+// side of the diagonal, where a plain condensed layout touches one per line
+// for every k < a.
+class BlockedDistances {
+public:
+    explicit BlockedDistances(size_t n) : blocks_((n + 3) / 4), lines_(blocks_ * (blocks_ + 1) / 2) {}
+
+    float& at(size_t i, size_t j) {
+        if (i > j) std::swap(i, j);
+        return lines_[lineIndex(i / 4, j / 4)].v[(i % 4) * 4 + j % 4];
+    }
+    // Block (I, J), I <= J: entry (4I + q, 4J + c) is at [q * 4 + c].
+    float* block(size_t I, size_t J) { return lines_[lineIndex(I, J)].v; }
+    size_t blocks() const { return blocks_; }
+
+private:
+    struct alignas(64) Line {
+        float v[16];
+    };
+    size_t lineIndex(size_t I, size_t J) const { return I * (2 * blocks_ - I + 1) / 2 + (J - I); }
+
+    size_t blocks_;
+    std::vector<Line> lines_;
+};
+
+// Pairwise distances of the standardized profiles, computed a block at a
+// time with block rows spread across threads. Ward keeps squared
+// distances, which is what its update formula works on.
+BlockedDistances profileDistances(const ExpressionProfiles& p, Linkage linkage, unsigned threads) {
+    TRACE_SCOPE("profileDistances");
+    const size_t n = p.genes.size();
+    BlockedDistances distances(n);
+    const std::vector<double> columns = p.regionMajor();
+    parallelFor(distances.blocks(), 1, [&](size_t begin, size_t end) {
+        double block[4][4];
+        for (size_t I = begin; I < end; ++I) {
+            const size_t rows = std::min<size_t>(4, n - 4 * I);
+            for (size_t J = I; J < distances.blocks(); ++J) {
+                const size_t cols = std::min<size_t>(4, n - 4 * J);
+                correlationBlock(p, columns, 4 * I, rows, 4 * J, cols, block);
+                float* out = distances.block(I, J);
+                for (size_t q = 0; q < rows; ++q) {
+                    for (size_t c = 0; c < cols; ++c) {
+                        const double r = std::max(-1.0, std::min(1.0, block[q][c]));
+                        out[q * 4 + c] = float(linkage == Linkage::Ward ? 2.0 - 2.0 * r : 1.0 - r);
+                    }
+                }
+            }
+        }
+    }, threads);
+    return distances;
+}
+
+// Union-find over leaves; each root remembers the cluster id it stands for.
+class LeafForest {
+public:
+    explicit LeafForest(size_t leaves) : parent_(leaves), cluster_(leaves) {
+        for (size_t i = 0; i < leaves; ++i) parent_[i] = cluster_[i] = uint32_t(i);
+    }
+
+    uint32_t find(uint32_t leaf) {
+        while (parent_[leaf] != leaf) {
+            parent_[leaf] = parent_[parent_[leaf]];
+            leaf = parent_[leaf];
+        }
+        return leaf;
+    }
+
+    uint32_t clusterOf(uint32_t root) const { return cluster_[root]; }
+
+    void join(uint32_t rootA, uint32_t rootB, uint32_t cluster) {
+        parent_[rootA] = rootB;
+        cluster_[rootB] = cluster;
+    }
+
+private:
+    std::vector<uint32_t> parent_, cluster_;
+};
+
+struct RawMerge {
+    uint32_t a, b;  // a leaf of each cluster
+    double height;
+};
+
+// Nearest-neighbour chain over the distances, updated in place.
+std::vector<RawMerge> nearestNeighbourChain(BlockedDistances& d, size_t n, Linkage linkage) {
+    TRACE_SCOPE("nearestNeighbourChain");
+    std::vector<RawMerge> merges;
+    merges.reserve(n - 1);
+    auto at = [&](size_t i, size_t j) -> float& { return d.at(i, j); };
+
+    // Active clusters by slot, ascending; a cluster lives in the slot of one
+    // of its leaves. A plain array keeps the scans free of pointer chasing.
+    std::vector<uint32_t> active(n), size(n, 1);
+    for (size_t i = 0; i < n; ++i) active[i] = uint32_t(i);
+    std::vector<uint32_t> chain;
+    const uint32_t kNone = UINT32_MAX;
+
+    while (active.size() > 1) {
+        if (chain.empty()) chain.push_back(active.front());
+        uint32_t a, b;
+        float best;
+        for (;;) {
+            a = chain.back();
+            // Ties go to the previous link, so the chain cannot cycle.
+            b = chain.size() > 1 ? chain[chain.size() - 2] : kNone;
+            best = b == kNone ? std::numeric_limits<float>::infinity() : at(a, b);
+            for (uint32_t k : active) {
+                if (k == a) continue;
+                const float dk = at(a, k);
+                if (dk < best) {
+                    best = dk;
+                    b = k;
+                }
+            }
+            if (chain.size() > 1 && b == chain[chain.size() - 2]) break;
+            chain.push_back(b);
+        }
+        chain.pop_back();
+        chain.pop_back();
+        merges.push_back({a, b, linkage == Linkage::Ward ? std::sqrt(double(best)) : double(best)});
+
+        // The merged cluster takes the higher slot; the lower one retires.
+        const uint32_t keep = std::max(a, b), drop = std::min(a, b);
+        const double na = size[a], nb = size[b], dab = best;
+        for (uint32_t k : active) {
+            if (k == a || k == b) continue;
+            const double dak = at(a, k), dbk = at(b, k), nk = size[k];
+            double merged;
+            switch (linkage) {
+                case Linkage::Average:  merged = (na * dak + nb * dbk) / (na + nb); break;
+                case Linkage::Complete: merged = std::max(dak, dbk); break;
+                default:                merged = ((na + nk) * dak + (nb + nk) * dbk - nk * dab) / (na + nb + nk); break;
+            }
+            at(keep, k) = float(merged);
+        }
+        size[keep] = size[a] + size[b];
+        active.erase(std::lower_bound(active.begin(), active.end(), drop));
+    }
+    return merges;
+}
+
+} // namespace
+
+// --- Public API ---
+
+const char* linkageName(Linkage linkage) {
+    switch (linkage) {
+        case Linkage::Average:  return "average";
+        case Linkage::Complete: return "complete";
+        case Linkage::Ward:     return "ward";
+    }
+    return "average";
+}
+
+bool parseLinkage(const std::string& text, Linkage& linkage) {
+    for (Linkage l : {Linkage::Average, Linkage::Complete, Linkage::Ward}) {
+        if (text == linkageName(l)) {
+            linkage = l;
+            return true;
+        }
+    }
+    return false;
+}
+
+GeneDendrogram clusterGenes(const std::vector<GeneModel>& genes, const ClusteringOptions& options) {
+    TRACE_SCOPE("clusterGenes");
+    ExpressionProfiles profiles =
+        buildExpressionProfiles(genes, CorrelationMethod::Pearson, options.minRegions, options.threads);
+    GeneDendrogram dendrogram;
+    dendrogram.linkage = options.linkage;
+    dendrogram.genes = profiles.genes;
+    dendrogram.excludedGenes = profiles.excludedGenes;
+    for (size_t g : dendrogram.genes) dendrogram.symbols.push_back(genes[g].symbol);
+    const size_t n = dendrogram.genes.size();
+    if (n < 2) return dendrogram;
+
+    std::vector<RawMerge> raw;
+    {
+        BlockedDistances distances = profileDistances(profiles, options.linkage, options.threads);
+        raw = nearestNeighbourChain(distances, n, options.linkage);
+    }
+
+    // The chain finds merges out of height order; sort them (a merge never
+    // sits below one of its parts, and the stable sort keeps that order for
+    // equal heights) and name the clusters as SciPy does.
+    std::stable_sort(raw.begin(), raw.end(), [](const RawMerge& x, const RawMerge& y) { return x.height < y.height; });
+    LeafForest forest(n);
+    std::vector<uint32_t> sizes(n - 1);
+    for (size_t m = 0; m < raw.size(); ++m) {
+        const uint32_t ra = forest.find(raw[m].a), rb = forest.find(raw[m].b);
+        const uint32_t ca = forest.clusterOf(ra), cb = forest.clusterOf(rb);
+        auto sizeOf = [&](uint32_t cluster) { return cluster < n ? 1u : sizes[cluster - n]; };
+        sizes[m] = sizeOf(ca) + sizeOf(cb);
+        dendrogram.merges.push_back({std::min(ca, cb), std::max(ca, cb), raw[m].height, sizes[m]});
+        forest.join(ra, rb, uint32_t(n + m));
+    }
+    TRACE_COUNTER_ADD("clusterGenes.leaves", n);
+    return dendrogram;
+}
+
+std::vector<uint32_t> cutTree(const GeneDendrogram& dendrogram, size_t clusters) {
+    const size_t n = dendrogram.leafCount();
+    std::vector<uint32_t> labels(n);
+    if (n == 0) return labels;
+    clusters = std::max<size_t>(1, std::min(clusters, n));
+
+    // Merges are numbered in the order they were applied, so the first
+    // n - clusters of them join leaves exactly as that cut does.
+    LeafForest forest(n);
+    std::vector<uint32_t> leafOf(2 * n - 1);
+    for (size_t leaf = 0; leaf < n; ++leaf) leafOf[leaf] = uint32_t(leaf);
+    for (size_t m = 0; m < n - clusters; ++m) {
+        const ClusterMerge& merge = dendrogram.merges[m];
+        leafOf[n + m] = leafOf[merge.left];
+        forest.join(forest.find(leafOf[merge.left]), forest.find(leafOf[merge.right]), uint32_t(n + m));
+    }
+    std::vector<uint32_t> labelOfRoot(n, UINT32_MAX);
+    uint32_t nextLabel = 0;
+    for (size_t leaf = 0; leaf < n; ++leaf) {
+        uint32_t& label = labelOfRoot[forest.find(uint32_t(leaf))];
+        if (label == UINT32_MAX) label = nextLabel++;
+        labels[leaf] = label;
+    }
+    return labels;
+}
+
+std::vector<GeneSet> clusterGeneSets(const GeneDendrogram& dendrogram, size_t clusters, const std::string& prefix) {
+    std::vector<uint32_t> labels = cutTree(dendrogram, clusters);
+    std::vector<GeneSet> sets;
+    for (size_t leaf = 0; leaf < labels.size(); ++leaf) {
+        if (labels[leaf] == sets.size()) sets.push_back({prefix + "-" + std::to_string(sets.size() + 1), {}});
+        sets[labels[leaf]].geneSymbols.push_back(dendrogram.symbols[leaf]);
+    }
+    return sets;
+}
+
+bool writeLinkageCSV(const GeneDendrogram& dendrogram, const std::string& path) {
+    BufferedFileWriter out;
+    if (!out.open(path)) return false;
+    out.append("left,right,height,size\n");
+    for (const auto& m : dendrogram.merges) {
+        out.appendInteger(m.left);
+        out.append(',');
+        out.appendInteger(m.right);
+        out.append(',');
+        out.appendNumber(m.height);
+        out.append(',');
+        out.appendInteger(m.size);
+        out.append('\n');
+    }
+    return out.close();
+}
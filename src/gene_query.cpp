@@ -0,0 +1,594 @@
+#include "gene_query.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+// --- NumericRange / GeneQuery ---
+
+bool NumericRange::contains(double v) const {
+    return (includeMin ? v >= min : v > min) && (includeMax ? v <= max : v < max);
+}
+
+GeneQuery GeneQuery::has(GeneField field, std::string value) {
+    GeneQuery q;
+    q.kind_ = Kind::Has;
+    q.field_ = field;
+    q.value_ = std::move(value);
+    return q;
+}
+
+GeneQuery GeneQuery::range(GeneField field, NumericRange range) {
+    GeneQuery q;
+    q.kind_ = Kind::Range;
+    q.field_ = field;
+    q.range_ = range;
+    return q;
+}
+
+GeneQuery GeneQuery::greaterThan(GeneField field, double value) {
+    NumericRange r;
+    r.min = value;
+    r.includeMin = false;
+    return range(field, r);
+}
+
+GeneQuery GeneQuery::atLeast(GeneField field, double value) {
+    NumericRange r;
+    r.min = value;
+    return range(field, r);
+}
+
+GeneQuery GeneQuery::lessThan(GeneField field, double value) {
+    NumericRange r;
+    r.max = value;
+    r.includeMax = false;
+    return range(field, r);
+}
+
+GeneQuery GeneQuery::atMost(GeneField field, double value) {
+    NumericRange r;
+    r.max = value;
+    return range(field, r);
+}
+
+// Flattens nested terms of the same kind, so (a AND b) AND c has three children.
+GeneQuery GeneQuery::combine(Kind kind, GeneQuery a, GeneQuery b) {
+    GeneQuery q;
+    q.kind_ = kind;
+    for (GeneQuery* part : {&a, &b}) {
+        if (part->kind_ == kind) {
+            for (auto& child : part->children_) q.children_.push_back(std::move(child));
+        } else {
+            q.children_.push_back(std::move(*part));
+        }
+    }
+    return q;
+}
+
+GeneQuery operator&&(GeneQuery a, GeneQuery b) {
+    return GeneQuery::combine(GeneQuery::Kind::And, std::move(a), std::move(b));
+}
+
+GeneQuery operator||(GeneQuery a, GeneQuery b) {
+    return GeneQuery::combine(GeneQuery::Kind::Or, std::move(a), std::move(b));
+}
+
+GeneQuery operator!(GeneQuery a) {
+    if (a.kind_ == GeneQuery::Kind::Not) return std::move(a.children_[0]);
+    GeneQuery q;
+    q.kind_ = GeneQuery::Kind::Not;
+    q.children_.push_back(std::move(a));
+    return q;
+}
+
+static const char* fieldName(GeneField field) {
+    switch (field) {
+        case GeneField::Category:       return "category";
+        case GeneField::DisorderTag:    return "tag";
+        case GeneField::Expression:     return "expression";
+        case GeneField::PolygenicScore: return "polygenic";
+    }
+    return "?";
+}
+
+// Shortest text that parses back to the same double.
+static std::string formatNumber(double v) {
+    char buf[32];
+    auto result = std::to_chars(buf, buf + sizeof(buf), v);
+    return std::string(buf, result.ptr);
+}
+
+std::string GeneQuery::toString() const {
+    std::string field = fieldName(field_);
+    switch (kind_) {
+        case Kind::Has:
+            return field + " = \"" + value_ + "\"";
+        case Kind::Range: {
+            if (range_.min == range_.max && range_.includeMin && range_.includeMax) {
+                return field + " = " + formatNumber(range_.min);
+            }
+            bool hasMin = range_.min != -std::numeric_limits<double>::infinity();
+            bool hasMax = range_.max != std::numeric_limits<double>::infinity();
+            std::string lower = field + (range_.includeMin ? " >= " : " > ") + formatNumber(range_.min);
+            std::string upper = field + (range_.includeMax ? " <= " : " < ") + formatNumber(range_.max);
+            if (hasMin && hasMax) return "(" + lower + " AND " + upper + ")";
+            return hasMax ? upper : lower;
+        }
+        case Kind::Not: {
+            const GeneQuery& child = children_[0];
+            bool group = child.kind_ == Kind::And || child.kind_ == Kind::Or;
+            return "NOT " + (group ? "(" + child.toString() + ")" : child.toString());
+        }
+        case Kind::And:
+        case Kind::Or: {
+            if (children_.empty()) return kind_ == Kind::And ? "ALL" : "NOT ALL";
+            std::string out;
+            for (size_t i = 0; i < children_.size(); ++i) {
+                if (i) out += kind_ == Kind::And ? " AND " : " OR ";
+                bool group = kind_ == Kind::And && children_[i].kind_ == Kind::Or;
+                out += group ? "(" + children_[i].toString() + ")" : children_[i].toString();
+            }
+            return out;
+        }
+    }
+    return {};
+}
+
+// --- Parser ---
+
+namespace {
+
+struct QueryToken {
+    enum Type { Word, Quoted, Symbol, End } type = End;
+    std::string text;
+    size_t pos = 0;
+};
+
+class QueryParser {
+public:
+    explicit QueryParser(const std::string& text) : text_(text) { advance(); }
+
+    GeneQuery parse() {
+        GeneQuery q = parseOr();
+        if (token_.type != QueryToken::End) fail("unexpected '" + token_.text + "'");
+        return q;
+    }
+
+private:
+    const std::string& text_;
+    size_t pos_ = 0;
+    QueryToken token_;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::invalid_argument("parseGeneQuery: " + message + " at position " + std::to_string(token_.pos));
+    }
+
+    static std::string lower(std::string s) {
+        for (auto& c : s) c = char(std::tolower(static_cast<unsigned char>(c)));
+        return s;
+    }
+
+    bool isKeyword(const char* keyword) const {
+        return token_.type == QueryToken::Word && lower(token_.text) == keyword;
+    }
+
+    bool isSymbol(const char* symbol) const {
+        return token_.type == QueryToken::Symbol && token_.text == symbol;
+    }
+
+    void advance() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+        token_ = QueryToken{};
+        token_.pos = pos_;
+        if (pos_ >= text_.size()) return;
+        char c = text_[pos_];
+        if (c == '"') {
+            size_t close = text_.find('"', pos_ + 1);
+            if (close == std::string::npos) fail("unterminated quote");
+            token_.type = QueryToken::Quoted;
+            token_.text = text_.substr(pos_ + 1, close - pos_ - 1);
+            pos_ = close + 1;
+        } else if (c == '(' || c == ')' || c == '=') {
+            token_.type = QueryToken::Symbol;
+            token_.text = std::string(1, c);
+            ++pos_;
+        } else if (c == '<' || c == '>') {
+            token_.type = QueryToken::Symbol;
+            bool orEqual = pos_ + 1 < text_.size() && text_[pos_ + 1] == '=';
+            token_.text = text_.substr(pos_, orEqual ? 2 : 1);
+            pos_ += token_.text.size();
+        } else {
+            size_t end = pos_;
+            while (end < text_.size() && !std::isspace(static_cast<unsigned char>(text_[end]))
+                   && std::string("()=<>\"").find(text_[end]) == std::string::npos) {
+                ++end;
+            }
+            token_.type = QueryToken::Word;
+            token_.text = text_.substr(pos_, end - pos_);
+            pos_ = end;
+        }
+    }
+
+    GeneQuery parseOr() {
+        GeneQuery q = parseAnd();
+        while (isKeyword("or")) {
+            advance();
+            q = std::move(q) || parseAnd();
+        }
+        return q;
+    }
+
+    GeneQuery parseAnd() {
+        GeneQuery q = parseFactor();
+        while (isKeyword("and")) {
+            advance();
+            q = std::move(q) && parseFactor();
+        }
+        return q;
+    }
+
+    GeneQuery parseFactor() {
+        if (isKeyword("not")) {
+            advance();
+            return !parseFactor();
+        }
+        if (isKeyword("all")) {
+            advance();
+            return GeneQuery{};
+        }
+        if (isSymbol("(")) {
+            advance();
+            GeneQuery q = parseOr();
+            if (!isSymbol(")")) fail("expected ')'");
+            advance();
+            return q;
+        }
+        return parseComparison();
+    }
+
+    GeneQuery parseComparison() {
+        if (token_.type != QueryToken::Word) fail("expected a field name");
+        std::string name = lower(token_.text);
+        GeneField field;
+        if (name == "category" || name == "categories") field = GeneField::Category;
+        else if (name == "tag" || name == "tags" || name == "disorder") field = GeneField::DisorderTag;
+        else if (name == "expression" || name == "expr") field = GeneField::Expression;
+        else if (name == "polygenic" || name == "score") field = GeneField::PolygenicScore;
+        else fail("unknown field '" + token_.text + "'");
+        advance();
+
+        if (field == GeneField::Category || field == GeneField::DisorderTag) {
+            if (!isSymbol("=") && !isKeyword("contains")) fail("expected '=' or 'contains'");
+            advance();
+            return GeneQuery::has(field, parseText());
+        }
+
+        if (token_.type != QueryToken::Symbol || token_.text == "(" || token_.text == ")") {
+            fail("expected a comparison");
+        }
+        std::string op = token_.text;
+        advance();
+        double value = parseNumber();
+        if (op == "=") {
+            NumericRange r;
+            r.min = r.max = value;
+            return GeneQuery::range(field, r);
+        }
+        if (op == ">")  return GeneQuery::greaterThan(field, value);
+        if (op == ">=") return GeneQuery::atLeast(field, value);
+        if (op == "<")  return GeneQuery::lessThan(field, value);
+        return GeneQuery::atMost(field, value);
+    }
+
+    // A quoted string, or bare words up to the next AND / OR / ')'.
+    std::string parseText() {
+        if (token_.type == QueryToken::Quoted) {
+            std::string text = token_.text;
+            advance();
+            return text;
+        }
+        std::string text;
+        while (token_.type == QueryToken::Word && !isKeyword("and") && !isKeyword("or")) {
+            if (!text.empty()) text += ' ';
+            text += token_.text;
+            advance();
+        }
+        if (text.empty()) fail("expected a value");
+        return text;
+    }
+
+    double parseNumber() {
+        if (token_.type != QueryToken::Word) fail("expected a number");
+        size_t used = 0;
+        double value = 0.0;
+        try {
+            value = std::stod(token_.text, &used);
+        } catch (const std::exception&) {
+            used = 0;
+        }
+        if (used == 0 || used != token_.text.size()) fail("invalid number '" + token_.text + "'");
+        advance();
+        return value;
+    }
+};
+
+} // namespace
+
+GeneQuery parseGeneQuery(const std::string& text) {
+    return QueryParser(text).parse();
+}
+
+//-----------------------------------------------------------------------------
+// GeneQueryEngine
+//-----------------------------------------------------------------------------
+
+struct GeneQueryEngine::PlanNode {
+    GeneQuery::Kind kind = GeneQuery::Kind::And;
+    GeneField field = GeneField::Category;
+    std::string value;
+    const GeneBitset* postings = nullptr;   // Has; null when nothing matches
+    NumericRange range;                     // Range
+    const std::vector<std::pair<double, uint32_t>>* sorted = nullptr;
+    const std::vector<double>* values = nullptr;
+    size_t begin = 0, end = 0;              // Range: slice of *sorted
+    size_t estimate = 0;                    // exact for leaves, an upper bound otherwise
+    std::vector<PlanNode> children;
+};
+
+// An AND switches from bitmap intersection to per-gene checks once the
+// remaining term would materialise this many times more ids than survive.
+static const size_t kProbeRatio = 4;
+
+GeneQueryEngine::GeneQueryEngine(const AlignmentMap& map) : map_(&map) {
+    sync();
+}
+
+void GeneQueryEngine::sync() {
+    const auto& genes = map_->getGenes();
+    if (genes.size() < indexed_) {
+        rebuild();
+        return;
+    }
+    for (size_t i = indexed_; i < genes.size(); ++i) {
+        const GeneModel& g = genes[i];
+        uint32_t id = uint32_t(i);
+        for (const auto& c : g.categories) categories_[std::string(c.data(), c.size())].add(id);
+        for (const auto& t : g.disorderTags) tags_[std::string(t.data(), t.size())].add(id);
+        for (auto* ix : {&expression_, &polygenic_}) {
+            double v = ix == &expression_ ? g.expressionLevel : g.polygenicScore;
+            ix->byId.push_back(v);
+            // NaN has no place in the ordering and never satisfies a range.
+            if (!std::isnan(v)) ix->pending.push_back({v, id});
+        }
+    }
+    if (genes.size() != indexed_) allValid_ = false;
+    indexed_ = genes.size();
+}
+
+void GeneQueryEngine::rebuild() {
+    indexed_ = 0;
+    categories_.clear();
+    tags_.clear();
+    expression_ = NumericIndex{};
+    polygenic_ = NumericIndex{};
+    allValid_ = false;
+    sync();
+}
+
+size_t GeneQueryEngine::indexedGenes() const {
+    return indexed_;
+}
+
+// Merges pending entries into the sorted array on first use after a sync.
+GeneQueryEngine::NumericIndex& GeneQueryEngine::numeric(GeneField field) {
+    NumericIndex& ix = field == GeneField::Expression ? expression_ : polygenic_;
+    if (!ix.pending.empty()) {
+        std::sort(ix.pending.begin(), ix.pending.end());
+        size_t middle = ix.sorted.size();
+        ix.sorted.insert(ix.sorted.end(), ix.pending.begin(), ix.pending.end());
+        std::inplace_merge(ix.sorted.begin(), ix.sorted.begin() + std::ptrdiff_t(middle), ix.sorted.end());
+        ix.pending.clear();
+    }
+    return ix;
+}
+
+const GeneBitset* GeneQueryEngine::postings(GeneField field, const std::string& value) const {
+    const auto& index = field == GeneField::Category ? categories_ : tags_;
+    auto it = index.find(value);
+    return it == index.end() ? nullptr : &it->second;
+}
+
+const GeneBitset& GeneQueryEngine::allGenes() {
+    if (!allValid_) {
+        std::vector<uint32_t> ids(indexed_);
+        for (size_t i = 0; i < ids.size(); ++i) ids[i] = uint32_t(i);
+        all_ = GeneBitset::fromIds(std::move(ids));
+        allValid_ = true;
+    }
+    return all_;
+}
+
+// Intersects ranges on the same field, so "expression > 6 AND expression < 8"
+// becomes one slice of the sorted index.
+static std::vector<GeneQuery> mergeRanges(const std::vector<GeneQuery>& terms) {
+    std::vector<GeneQuery> out;
+    for (const auto& term : terms) {
+        if (term.kind() != GeneQuery::Kind::Range) {
+            out.push_back(term);
+            continue;
+        }
+        auto same = std::find_if(out.begin(), out.end(), [&](const GeneQuery& q) {
+            return q.kind() == GeneQuery::Kind::Range && q.field() == term.field();
+        });
+        if (same == out.end()) {
+            out.push_back(term);
+            continue;
+        }
+        NumericRange a = same->numericRange(), b = term.numericRange();
+        if (b.min > a.min || (b.min == a.min && !b.includeMin)) {
+            a.min = b.min;
+            a.includeMin = b.includeMin;
+        }
+        if (b.max < a.max || (b.max == a.max && !b.includeMax)) {
+            a.max = b.max;
+            a.includeMax = b.includeMax;
+        }
+        *same = GeneQuery::range(term.field(), a);
+    }
+    return out;
+}
+
+GeneQueryEngine::PlanNode GeneQueryEngine::compile(const GeneQuery& query) {
+    PlanNode node;
+    node.kind = query.kind();
+    node.field = query.field();
+    switch (query.kind()) {
+        case GeneQuery::Kind::Has:
+            node.value = query.value();
+            node.postings = postings(query.field(), query.value());
+            node.estimate = node.postings ? node.postings->cardinality() : 0;
+            break;
+        case GeneQuery::Kind::Range: {
+            const NumericIndex& ix = numeric(query.field());
+            const NumericRange& r = query.numericRange();
+            node.range = r;
+            node.sorted = &ix.sorted;
+            node.values = &ix.byId;
+            auto first = std::partition_point(ix.sorted.begin(), ix.sorted.end(), [&](const auto& e) {
+                return r.includeMin ? e.first < r.min : e.first <= r.min;
+            });
+            auto last = std::partition_point(first, ix.sorted.end(), [&](const auto& e) {
+                return r.includeMax ? e.first <= r.max : e.first < r.max;
+            });
+            node.begin = size_t(first - ix.sorted.begin());
+            node.end = size_t(last - ix.sorted.begin());
+            node.estimate = node.end - node.begin;
+            break;
+        }
+        case GeneQuery::Kind::Not:
+            node.children.push_back(compile(query.children()[0]));
+            node.estimate = indexed_ - std::min(indexed_, node.children[0].estimate);
+            break;
+        case GeneQuery::Kind::And: {
+            for (const auto& child : mergeRanges(query.children())) node.children.push_back(compile(child));
+            // Most selective positive terms first; negations are applied last
+            // as differences, so they never need the complement materialised.
+            std::stable_sort(node.children.begin(), node.children.end(), [](const PlanNode& a, const PlanNode& b) {
+                bool aNot = a.kind == GeneQuery::Kind::Not, bNot = b.kind == GeneQuery::Kind::Not;
+                if (aNot != bNot) return bNot;
+                return aNot ? a.children[0].estimate > b.children[0].estimate : a.estimate < b.estimate;
+            });
+            node.estimate = indexed_;
+            for (const auto& child : node.children) node.estimate = std::min(node.estimate, child.estimate);
+            break;
+        }
+        case GeneQuery::Kind::Or:
+            for (const auto& child : query.children()) {
+                node.children.push_back(compile(child));
+                node.estimate += node.children.back().estimate;
+            }
+            node.estimate = std::min(node.estimate, indexed_);
+            break;
+    }
+    return node;
+}
+
+bool GeneQueryEngine::probe(const PlanNode& node, uint32_t id) const {
+    if (node.kind == GeneQuery::Kind::Has) return node.postings && node.postings->contains(id);
+    return node.range.contains((*node.values)[id]);
+}
+
+GeneBitset GeneQueryEngine::run(const PlanNode& node) {
+    switch (node.kind) {
+        case GeneQuery::Kind::Has:
+            return node.postings ? *node.postings : GeneBitset{};
+        case GeneQuery::Kind::Range: {
+            std::vector<uint32_t> ids;
+            ids.reserve(node.end - node.begin);
+            if (node.estimate * 16 < indexed_) {
+                for (size_t i = node.begin; i < node.end; ++i) ids.push_back((*node.sorted)[i].second);
+            } else {
+                // Wide ranges: mark ids in a flag array and collect them in
+                // order, which is linear where sorting the slice is not.
+                std::vector<char> marked(indexed_, 0);
+                for (size_t i = node.begin; i < node.end; ++i) marked[(*node.sorted)[i].second] = 1;
+                for (size_t id = 0; id < marked.size(); ++id) {
+                    if (marked[id]) ids.push_back(uint32_t(id));
+                }
+            }
+            return GeneBitset::fromIds(std::move(ids));
+        }
+        case GeneQuery::Kind::Not:
+            return GeneBitset::difference(allGenes(), run(node.children[0]));
+        case GeneQuery::Kind::Or: {
+            GeneBitset acc;
+            for (const auto& child : node.children) acc = GeneBitset::unite(acc, run(child));
+            return acc;
+        }
+        case GeneQuery::Kind::And: {
+            if (node.children.empty()) return allGenes();
+            bool firstIsNot = node.children[0].kind == GeneQuery::Kind::Not;
+            GeneBitset acc = firstIsNot ? allGenes() : run(node.children[0]);
+            for (size_t i = firstIsNot ? 0 : 1; i < node.children.size() && !acc.empty(); ++i) {
+                const PlanNode& child = node.children[i];
+                bool negate = child.kind == GeneQuery::Kind::Not;
+                const PlanNode& term = negate ? child.children[0] : child;
+                bool leaf = term.kind == GeneQuery::Kind::Has || term.kind == GeneQuery::Kind::Range;
+                if (leaf && acc.cardinality() * kProbeRatio < term.estimate) {
+                    std::vector<uint32_t> kept;
+                    for (uint32_t id : acc.toIds()) {
+                        if (probe(term, id) != negate) kept.push_back(id);
+                    }
+                    acc = GeneBitset::fromIds(std::move(kept));
+                } else if (negate) {
+                    acc = GeneBitset::difference(acc, run(term));
+                } else {
+                    acc = GeneBitset::intersect(acc, run(term));
+                }
+            }
+            return acc;
+        }
+    }
+    return {};
+}
+
+GeneBitset GeneQueryEngine::evaluate(const GeneQuery& query) {
+    sync();
+    return run(compile(query));
+}
+
+std::vector<std::string> GeneQueryEngine::symbolsOf(const GeneBitset& genes) const {
+    const auto& all = map_->getGenes();
+    std::vector<std::string> symbols;
+    symbols.reserve(genes.cardinality());
+    for (uint32_t id : genes.toIds()) {
+        if (id < all.size()) symbols.push_back(all[id].symbol);
+    }
+    return symbols;
+}
+
+GeneSet GeneQueryEngine::select(const GeneQuery& query, const std::string& name) {
+    return GeneSet{name, symbolsOf(evaluate(query))};
+}
+
+void GeneQueryEngine::describe(const PlanNode& node, int depth, std::string& out) const {
+    out.append(size_t(depth) * 2, ' ');
+    switch (node.kind) {
+        case GeneQuery::Kind::Has:   out += std::string(fieldName(node.field)) + " = \"" + node.value + "\""; break;
+        case GeneQuery::Kind::Range: out += GeneQuery::range(node.field, node.range).toString(); break;
+        case GeneQuery::Kind::Not:   out += "NOT"; break;
+        case GeneQuery::Kind::And:   out += node.children.empty() ? "ALL" : "AND"; break;
+        case GeneQuery::Kind::Or:    out += "OR"; break;
+    }
+    out += "  ~" + std::to_string(node.estimate) + "\n";
+    for (const auto& child : node.children) describe(child, depth + 1, out);
+}
+
+std::string GeneQueryEngine::explain(const GeneQuery& query) {
+    sync();
+    std::string out;
+    describe(compile(query), 0, out);
+    return out;
+}
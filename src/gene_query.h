@@ -0,0 +1,133 @@
+#ifndef GENE_QUERY_H
+#define GENE_QUERY_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "gene_bitset.h"
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Gene filter expressions
+//-----------------------------------------------------------------------------
+
+enum class GeneField { Category, DisorderTag, Expression, PolygenicScore };
+
+struct NumericRange {
+    double min = -std::numeric_limits<double>::infinity();
+    double max =  std::numeric_limits<double>::infinity();
+    bool includeMin = true;
+    bool includeMax = true;
+    bool contains(double v) const;
+};
+
+// A boolean filter over genes: membership tests on categories and disorder
+// tags, numeric ranges on expression and polygenic score, combined with
+// &&, || and !.
+class GeneQuery {
+public:
+    enum class Kind { Has, Range, And, Or, Not };
+
+    // Genes whose categories (or disorder tags) include `value` exactly.
+    static GeneQuery has(GeneField field, std::string value);
+    static GeneQuery range(GeneField field, NumericRange range);
+    static GeneQuery greaterThan(GeneField field, double value);
+    static GeneQuery atLeast(GeneField field, double value);
+    static GeneQuery lessThan(GeneField field, double value);
+    static GeneQuery atMost(GeneField field, double value);
+
+    friend GeneQuery operator&&(GeneQuery a, GeneQuery b);
+    friend GeneQuery operator||(GeneQuery a, GeneQuery b);
+    friend GeneQuery operator!(GeneQuery a);
+
+    Kind kind() const { return kind_; }
+    GeneField field() const { return field_; }
+    const std::string& value() const { return value_; }
+    const NumericRange& numericRange() const { return range_; }
+    const std::vector<GeneQuery>& children() const { return children_; }
+
+    // Canonical text form, accepted by parseGeneQuery.
+    std::string toString() const;
+
+private:
+    Kind kind_ = Kind::And; // an empty And matches every gene
+    GeneField field_ = GeneField::Category;
+    std::string value_;
+    NumericRange range_;
+    std::vector<GeneQuery> children_;
+
+    static GeneQuery combine(Kind kind, GeneQuery a, GeneQuery b);
+};
+
+// Parses filters such as
+//     category = dopamine receptor AND expression > 6 AND tag contains ADHD
+// Fields: category, tag (or disorder), expression, polygenic (or score).
+// Categories and tags take "=" or "contains"; numbers take = < <= > >=.
+// AND binds tighter than OR; NOT and parentheses are supported, keywords are
+// case-insensitive and values may be quoted.
+// @throws std::invalid_argument with the offending position on a syntax error.
+GeneQuery parseGeneQuery(const std::string& text);
+
+//-----------------------------------------------------------------------------
+// Indexed query engine
+//-----------------------------------------------------------------------------
+
+// Answers GeneQuery filters over an AlignmentMap from inverted indexes.
+//
+// Gene ids are positions in map.getGenes(). Categories and tags map to
+// GeneBitset postings; expression and polygenic score are kept as
+// (value, id) arrays sorted by value, so a range is two binary searches.
+// A query is compiled into a plan whose AND terms run from the most to the
+// least selective; once the intermediate result is small, remaining terms
+// are checked per gene instead of materialising their bitmaps.
+//
+// The map is treated as append-only: evaluate() indexes genes added since
+// the last call. Call rebuild() after clearGenes() or a reload. Not
+// thread-safe; the map must outlive the engine.
+class GeneQueryEngine {
+public:
+    explicit GeneQueryEngine(const AlignmentMap& map);
+
+    // Indexes genes appended to the map since the last sync.
+    void sync();
+    void rebuild();
+    size_t indexedGenes() const;
+
+    GeneBitset evaluate(const GeneQuery& query);
+    // The matching genes as a named set, in map order.
+    GeneSet select(const GeneQuery& query, const std::string& name);
+    // One line per plan step with its estimated row count, for diagnostics.
+    std::string explain(const GeneQuery& query);
+
+    std::vector<std::string> symbolsOf(const GeneBitset& genes) const;
+
+private:
+    struct NumericIndex {
+        std::vector<std::pair<double, uint32_t>> sorted;
+        std::vector<std::pair<double, uint32_t>> pending; // appended, not yet merged
+        std::vector<double> byId;
+    };
+    struct PlanNode;
+
+    const AlignmentMap* map_;
+    size_t indexed_ = 0;
+    std::unordered_map<std::string, GeneBitset> categories_;
+    std::unordered_map<std::string, GeneBitset> tags_;
+    NumericIndex expression_;
+    NumericIndex polygenic_;
+    GeneBitset all_;
+    bool allValid_ = false;
+
+    NumericIndex& numeric(GeneField field);
+    const GeneBitset* postings(GeneField field, const std::string& value) const;
+    const GeneBitset& allGenes();
+    PlanNode compile(const GeneQuery& query);
+    GeneBitset run(const PlanNode& node);
+    bool probe(const PlanNode& node, uint32_t id) const;
+    void describe(const PlanNode& node, int depth, std::string& out) const;
+};
+
+#endif // GENE_QUERY_H
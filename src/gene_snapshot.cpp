@@ -0,0 +1,201 @@
+#include "gene_snapshot.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+
+// --- GeneSnapshot ---
+
+uint64_t GeneSnapshot::version() const {
+    return version_;
+}
+
+uint64_t GeneSnapshot::generation() const {
+    return generation_;
+}
+
+size_t GeneSnapshot::size() const {
+    return size_;
+}
+
+bool GeneSnapshot::empty() const {
+    return size_ == 0;
+}
+
+const GeneModel& GeneSnapshot::operator[](size_t index) const {
+    return (*chunks_[index / kGeneChunkSize])[index % kGeneChunkSize];
+}
+
+size_t GeneSnapshot::chunkCount() const {
+    return chunks_.size();
+}
+
+const std::shared_ptr<const GeneChunk>& GeneSnapshot::chunk(size_t index) const {
+    return chunks_[index];
+}
+
+MemoryReport GeneSnapshot::memoryReport() const {
+    MemoryAccount account;
+    account.add(chunks_.capacity() * sizeof(chunks_[0]));
+    for (const auto& c : chunks_) {
+        // make_shared puts the vector and its two reference counts in one block.
+        account.add(sizeof(GeneChunk) + 2 * sizeof(long) + c->capacity() * sizeof(GeneModel));
+        for (const auto& g : *c) account.add(heapBytes(g), 1);
+    }
+    MemoryReport report;
+    report.subsystems.push_back(account.snapshot("genes"));
+    return report;
+}
+
+// --- GeneBatch ---
+
+GeneBatch::GeneBatch(std::shared_ptr<const GeneSnapshot> base)
+    : base_(std::move(base)), chunks_(base_->chunks_), owned_(chunks_.size(), false), size_(base_->size_),
+      generation_(base_->generation_) {}
+
+size_t GeneBatch::size() const {
+    return size_;
+}
+
+const GeneModel& GeneBatch::operator[](size_t index) const {
+    return (*chunks_[index / kGeneChunkSize])[index % kGeneChunkSize];
+}
+
+// The chunk was either built by this batch or is shared with published
+// snapshots; in the latter case it is replaced by a private copy.
+GeneChunk& GeneBatch::ownChunk(size_t chunk) {
+    if (!owned_[chunk]) {
+        auto copy = std::make_shared<GeneChunk>();
+        copy->reserve(kGeneChunkSize);
+        copy->assign(chunks_[chunk]->begin(), chunks_[chunk]->end());
+        chunks_[chunk] = std::move(copy);
+        owned_[chunk] = true;
+    }
+    // Only this batch can reach an owned chunk until it is published.
+    return const_cast<GeneChunk&>(*chunks_[chunk]);
+}
+
+void GeneBatch::append(GeneModel gene) {
+    if (size_ % kGeneChunkSize == 0) {
+        auto fresh = std::make_shared<GeneChunk>();
+        fresh->reserve(kGeneChunkSize);
+        chunks_.push_back(std::move(fresh));
+        owned_.push_back(true);
+    }
+    ownChunk(chunks_.size() - 1).push_back(std::move(gene));
+    ++size_;
+}
+
+GeneModel& GeneBatch::edit(size_t index) {
+    if (index >= size_) throw std::out_of_range("GeneBatch::edit: index out of range");
+    return ownChunk(index / kGeneChunkSize)[index % kGeneChunkSize];
+}
+
+size_t GeneBatch::chunksWritten() const {
+    size_t n = 0;
+    for (bool owned : owned_) n += owned;
+    return n;
+}
+
+// --- GeneSnapshotStore ---
+
+GeneSnapshotStore::GeneSnapshotStore()
+    : current_(std::make_shared<const GeneSnapshot>()) {}
+
+std::shared_ptr<const GeneSnapshot> GeneSnapshotStore::snapshot() const {
+    return std::atomic_load(&current_);
+}
+
+uint64_t GeneSnapshotStore::version() const {
+    return snapshot()->version();
+}
+
+GeneBatch GeneSnapshotStore::begin() const {
+    return GeneBatch(snapshot());
+}
+
+bool GeneSnapshotStore::publish(GeneBatch& batch) {
+    TRACE_SCOPE("GeneSnapshotStore::publish");
+    auto next = std::make_shared<GeneSnapshot>();
+    next->version_ = batch.base_->version_ + 1;
+    next->generation_ = batch.generation_;
+    next->size_ = batch.size_;
+    next->chunks_ = batch.chunks_;
+    std::shared_ptr<const GeneSnapshot> published = std::move(next);
+    std::shared_ptr<const GeneSnapshot> expected = batch.base_;
+    if (!std::atomic_compare_exchange_strong(&current_, &expected, published)) return false;
+    // Published chunks are shared from now on; later edits must copy them.
+    batch.base_ = std::move(published);
+    std::fill(batch.owned_.begin(), batch.owned_.end(), false);
+    TRACE_COUNTER_ADD("GeneSnapshotStore.publishes", 1);
+    return true;
+}
+
+uint64_t GeneSnapshotStore::append(std::vector<GeneModel> genes) {
+    for (;;) {
+        GeneBatch batch = begin();
+        size_t first = batch.size();
+        for (auto& g : genes) batch.append(std::move(g));
+        if (publish(batch)) return batch.base_->version();
+        // Lost the race: take the genes back and retry on the newer snapshot.
+        for (size_t i = 0; i < genes.size(); ++i) genes[i] = std::move(batch.edit(first + i));
+    }
+}
+
+uint64_t GeneSnapshotStore::toggleKnockout(const std::string& symbol) {
+    for (;;) {
+        GeneBatch batch = begin();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (batch[i].symbol == symbol) {
+                GeneModel& g = batch.edit(i);
+                g.isKnockout = !g.isKnockout;
+            }
+        }
+        if (publish(batch)) return batch.base_->version();
+    }
+}
+
+uint64_t GeneSnapshotStore::clear() {
+    for (;;) {
+        GeneBatch batch = begin();
+        batch.chunks_.clear();
+        batch.owned_.clear();
+        batch.size_ = 0;
+        batch.generation_ = batch.base_->generation_ + 1;
+        if (publish(batch)) return batch.base_->version();
+    }
+}
+
+// --- GeneSnapshotStatistics ---
+
+const GenomeStats& GeneSnapshotStatistics::update(const GeneSnapshot& snapshot) {
+    if (valid_ && snapshot.version() == version_) return stats_;
+    if (!valid_ || snapshot.generation() != generation_) {
+        expression_.clear();
+        sketched_ = 0;
+    }
+    for (; sketched_ < snapshot.size(); ++sketched_) expression_.add(snapshot[sketched_].expressionLevel);
+    expression_.compact();
+
+    GenomeStats s;
+    s.totalGenes = int(snapshot.size());
+    double sumE = 0, sumP = 0;
+    snapshot.forEach([&](const GeneModel& g) {
+        sumE += g.expressionLevel;
+        sumP += g.polygenicScore;
+        if (g.isKnockout) s.totalKnockouts++;
+    });
+    if (s.totalGenes > 0) {
+        s.avgExpression = sumE / s.totalGenes;
+        s.avgPolyScore  = sumP / s.totalGenes;
+        s.medianExpression = expression_.quantile(0.5);
+        s.p99Expression    = expression_.quantile(0.99);
+    }
+    s.timestamp = makeTimestamp();
+    stats_ = std::move(s);
+    version_ = snapshot.version();
+    generation_ = snapshot.generation();
+    valid_ = true;
+    return stats_;
+}
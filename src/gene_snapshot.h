@@ -0,0 +1,132 @@
+#ifndef GENE_SNAPSHOT_H
+#define GENE_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Copy-on-write gene snapshots
+//-----------------------------------------------------------------------------
+
+// Genes per chunk. Every chunk but the last is full, so indexing is a divide.
+constexpr size_t kGeneChunkSize = 512;
+
+using GeneChunk = std::vector<GeneModel>;
+
+// An immutable, versioned view of a gene list. Genes are held in shared
+// chunks, so consecutive versions share every chunk a writer did not touch.
+// A snapshot stays valid, and unchanged, for as long as a reader holds it.
+class GeneSnapshot {
+public:
+    uint64_t version() const;
+    // Incremented by every GeneSnapshotStore::clear(). Within one generation
+    // a snapshot only ever gains genes at the end or has genes edited.
+    uint64_t generation() const;
+    size_t size() const;
+    bool empty() const;
+    const GeneModel& operator[](size_t index) const;
+
+    size_t chunkCount() const;
+    // For checking structural sharing: equal pointers are the same genes.
+    const std::shared_ptr<const GeneChunk>& chunk(size_t index) const;
+
+    // Calls fn(const GeneModel&) for every gene in order.
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& c : chunks_)
+            for (const auto& g : *c) fn(g);
+    }
+
+    // A "genes" subsystem covering this snapshot's chunks. Chunks shared with
+    // other versions are counted in full, as this snapshot keeps them alive.
+    MemoryReport memoryReport() const;
+
+private:
+    friend class GeneBatch;
+    friend class GeneSnapshotStore;
+
+    uint64_t version_ = 0;
+    uint64_t generation_ = 0;
+    size_t size_ = 0;
+    std::vector<std::shared_ptr<const GeneChunk>> chunks_;
+};
+
+// A writer's pending changes on top of one snapshot. Chunks are copied the
+// first time the batch changes them; nothing is visible to readers until
+// GeneSnapshotStore::publish(). Genes should use heap storage (not a map's
+// arena), since a snapshot can outlive the map they came from.
+class GeneBatch {
+public:
+    explicit GeneBatch(std::shared_ptr<const GeneSnapshot> base);
+
+    size_t size() const;
+    const GeneModel& operator[](size_t index) const;
+    void append(GeneModel gene);
+    // Mutable access; copies the gene's chunk on first use in this batch.
+    GeneModel& edit(size_t index);
+    // Number of chunks copied or created so far.
+    size_t chunksWritten() const;
+
+private:
+    friend class GeneSnapshotStore;
+
+    std::shared_ptr<const GeneSnapshot> base_;
+    std::vector<std::shared_ptr<const GeneChunk>> chunks_;
+    std::vector<bool> owned_; // chunk created by this batch, safe to mutate
+    size_t size_ = 0;
+    uint64_t generation_;
+
+    GeneChunk& ownChunk(size_t chunk);
+};
+
+// Holds the current snapshot. Readers call snapshot(), which takes no lock
+// of ours; with libstdc++ the atomic shared_ptr load itself can spin on a
+// short internal lock, but never waits for a writer's batch. Writers build a
+// GeneBatch and publish it with a compare-and-swap, so a batch based on a
+// stale snapshot is refused rather than overwriting another writer.
+class GeneSnapshotStore {
+public:
+    GeneSnapshotStore();
+
+    std::shared_ptr<const GeneSnapshot> snapshot() const;
+    uint64_t version() const;
+
+    GeneBatch begin() const;
+    // @return False if another batch was published since `batch` began;
+    // the batch is left intact so the caller can rebuild it.
+    bool publish(GeneBatch& batch);
+
+    // Convenience writers that retry until published.
+    // @return The version that contains the change.
+    uint64_t append(std::vector<GeneModel> genes);
+    // Flips the knockout flag of every gene with this symbol; one chunk copy each.
+    uint64_t toggleKnockout(const std::string& symbol);
+    uint64_t clear();
+
+private:
+    std::shared_ptr<const GeneSnapshot> current_; // accessed with std::atomic_load/store
+};
+
+// Status-line statistics over the snapshots one reader sees. update() is
+// free while the version is unchanged. On a new version it recounts the
+// sums and knockouts, but adds only the genes appended since the last
+// update to the expression sketch, as the store's writers only append and
+// toggle knockouts. A new generation (after clear()) restarts the sketch.
+// Not thread-safe: one instance per reader.
+class GeneSnapshotStatistics {
+public:
+    const GenomeStats& update(const GeneSnapshot& snapshot);
+
+private:
+    bool valid_ = false;
+    uint64_t version_ = 0;
+    uint64_t generation_ = 0;
+    size_t sketched_ = 0;
+    QuantileSketch expression_;
+    GenomeStats stats_;
+};
+
+#endif // GENE_SNAPSHOT_H
@@ -0,0 +1,199 @@
+#include "knockout_propagation.h"
+#include <algorithm>
+#include <deque>
+#include <set>
+
+KnockoutPropagator::KnockoutPropagator(const AlignmentMap& map) {
+    // 1. Nodes and de-duplicated edges from every pathway.
+    std::set<std::pair<int, int>> edges;
+    for (const auto& p : map.getPathways()) {
+        for (const auto& symbol : p.geneSymbols) nodeFor(symbol);
+        for (const auto& kv : p.interactions) {
+            int from = nodeFor(kv.first);
+            for (const auto& target : kv.second) edges.insert({from, nodeFor(target)});
+        }
+    }
+    for (const auto& g : map.getGenes()) nodeFor(g.symbol);
+
+    downstream_.assign(symbols_.size(), {});
+    inputs_.assign(symbols_.size(), 0);
+    lost_.assign(symbols_.size(), 0);
+    knockedOut_.assign(symbols_.size(), 0);
+    silenced_.assign(symbols_.size(), 0);
+    inRegion_.assign(symbols_.size(), 0);
+    for (const auto& e : edges) {
+        if (e.first == e.second) continue; // self-loops never change the outcome
+        downstream_[e.first].push_back(e.second);
+        inputs_[e.second]++;
+    }
+
+    // 2. Seed the existing knockouts; each one propagates incrementally.
+    for (const auto& g : map.getGenes()) {
+        if (g.isKnockout) setKnockout(g.symbol, true);
+    }
+    lastVisited_ = 0;
+}
+
+int KnockoutPropagator::nodeFor(const std::string& symbol) {
+    auto it = ids_.find(symbol);
+    if (it != ids_.end()) return it->second;
+    int id = int(symbols_.size());
+    ids_.emplace(symbol, id);
+    symbols_.push_back(symbol);
+    return id;
+}
+
+int KnockoutPropagator::find(const std::string& symbol) const {
+    auto it = ids_.find(symbol);
+    return it == ids_.end() ? -1 : it->second;
+}
+
+bool KnockoutPropagator::evaluate(int v) const {
+    return knockedOut_[v] || (inputs_[v] > 0 && lost_[v] == inputs_[v]);
+}
+
+// Worklist propagation of newly silenced genes. Adding a knockout only grows
+// the silenced set, so every gene flips at most once and the cost is bounded
+// by the flipped frontier and its out-edges.
+void KnockoutPropagator::propagate(std::deque<int> work) {
+    while (!work.empty()) {
+        int v = work.front();
+        work.pop_front();
+        ++lastVisited_;
+        bool now = evaluate(v);
+        if (bool(silenced_[v]) == now) continue;
+        silenced_[v] = now;
+        int delta = now ? 1 : -1;
+        for (int w : downstream_[v]) {
+            lost_[w] += delta;
+            if (bool(silenced_[w]) != evaluate(w)) work.push_back(w);
+        }
+    }
+}
+
+// Removing a knockout cannot simply be undone edge by edge: genes on a
+// feedback loop keep each other's inputs silenced. Every silenced gene
+// reachable from `start` through silenced genes may depend on it, so that
+// region is reset to active and the least fixpoint is rebuilt inside it.
+// Silenced genes outside the region do not depend on `start` and stay as is.
+void KnockoutPropagator::retractFrom(int start) {
+    std::vector<int> region;
+    if (silenced_[start]) {
+        region.push_back(start);
+        inRegion_[start] = 1;
+    }
+    for (size_t i = 0; i < region.size(); ++i) {
+        for (int w : downstream_[region[i]]) {
+            if (silenced_[w] && !inRegion_[w]) {
+                inRegion_[w] = 1;
+                region.push_back(w);
+            }
+        }
+    }
+    for (int v : region) {
+        inRegion_[v] = 0;
+        silenced_[v] = 0;
+        for (int w : downstream_[v]) lost_[w]--;
+    }
+    lastVisited_ = region.size();
+    propagate(std::deque<int>(region.begin(), region.end()));
+}
+
+void KnockoutPropagator::setKnockout(const std::string& symbol, bool knockedOut) {
+    int v = find(symbol);
+    if (v < 0) {
+        // Genes outside the pathway graph cannot affect anything else.
+        if (!knockedOut) return;
+        v = nodeFor(symbol);
+        downstream_.emplace_back();
+        inputs_.push_back(0);
+        lost_.push_back(0);
+        knockedOut_.push_back(0);
+        silenced_.push_back(0);
+        inRegion_.push_back(0);
+    }
+    if (bool(knockedOut_[v]) == knockedOut) {
+        lastVisited_ = 0;
+        return;
+    }
+    knockedOut_[v] = knockedOut;
+    if (knockedOut) {
+        lastVisited_ = 0;
+        propagate({v});
+    } else {
+        retractFrom(v);
+    }
+}
+
+void KnockoutPropagator::toggleKnockout(const std::string& symbol) {
+    int v = find(symbol);
+    setKnockout(symbol, v < 0 ? true : !knockedOut_[v]);
+}
+
+GeneImpact KnockoutPropagator::impactOf(int v) const {
+    GeneImpact gi;
+    gi.symbol = symbols_[v];
+    gi.knockedOut = knockedOut_[v];
+    gi.silenced = silenced_[v];
+    gi.lostInputs = lost_[v];
+    gi.totalInputs = inputs_[v];
+    if (gi.silenced) gi.score = 1.0;
+    else if (gi.totalInputs > 0) gi.score = double(gi.lostInputs) / gi.totalInputs;
+    return gi;
+}
+
+bool KnockoutPropagator::isSilenced(const std::string& symbol) const {
+    int v = find(symbol);
+    return v >= 0 && silenced_[v];
+}
+
+double KnockoutPropagator::impactScore(const std::string& symbol) const {
+    int v = find(symbol);
+    return v < 0 ? 0.0 : impactOf(v).score;
+}
+
+GeneImpact KnockoutPropagator::getImpact(const std::string& symbol) const {
+    int v = find(symbol);
+    if (v < 0) {
+        GeneImpact gi;
+        gi.symbol = symbol;
+        return gi;
+    }
+    return impactOf(v);
+}
+
+std::vector<GeneImpact> KnockoutPropagator::getAffectedGenes() const {
+    std::vector<GeneImpact> affected;
+    for (int v = 0; v < int(symbols_.size()); ++v) {
+        if (silenced_[v] || lost_[v] > 0) affected.push_back(impactOf(v));
+    }
+    return affected;
+}
+
+int KnockoutPropagator::perturbationDepth() const {
+    // Multi-source BFS from the knockouts, expanding only out of silenced genes.
+    std::vector<int> dist(symbols_.size(), -1);
+    std::deque<int> queue;
+    for (int v = 0; v < int(symbols_.size()); ++v) {
+        if (knockedOut_[v]) { dist[v] = 0; queue.push_back(v); }
+    }
+    int depth = 0;
+    while (!queue.empty()) {
+        int v = queue.front();
+        queue.pop_front();
+        depth = std::max(depth, dist[v]);
+        if (!silenced_[v]) continue;
+        for (int w : downstream_[v]) {
+            if (dist[w] < 0) { dist[w] = dist[v] + 1; queue.push_back(w); }
+        }
+    }
+    return depth;
+}
+
+size_t KnockoutPropagator::nodeCount() const {
+    return symbols_.size();
+}
+
+size_t KnockoutPropagator::lastUpdateVisited() const {
+    return lastVisited_;
+}
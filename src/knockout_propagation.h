@@ -0,0 +1,71 @@
+#ifndef KNOCKOUT_PROPAGATION_H
+#define KNOCKOUT_PROPAGATION_H
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "map_logic.h"
+
+// Downstream effect of the current knockouts on one gene.
+struct GeneImpact {
+    std::string symbol;
+    bool   knockedOut  = false;
+    bool   silenced    = false; // knocked out, or every upstream input is silenced
+    int    lostInputs  = 0;     // upstream regulators that are silenced
+    int    totalInputs = 0;
+    double score       = 0.0;   // 1.0 when silenced, otherwise lostInputs / totalInputs
+};
+
+// Propagates knockouts through the merged Pathway::interactions graph of an
+// AlignmentMap. A gene is silenced when it is knocked out itself or when it
+// has upstream inputs and all of them are silenced.
+//
+// Each gene keeps a counter of silenced inputs, so adding a knockout only
+// re-evaluates the frontier of genes whose state actually flips (plus their
+// direct successors) instead of recomputing the whole network. Removing one
+// re-evaluates the silenced genes downstream of it, which also releases
+// feedback loops that were only silenced through the knockout.
+class KnockoutPropagator {
+public:
+    KnockoutPropagator() = default;
+    // Builds the merged graph from all pathways and seeds knockouts from map.getGenes().
+    explicit KnockoutPropagator(const AlignmentMap& map);
+
+    void setKnockout(const std::string& symbol, bool knockedOut);
+    void toggleKnockout(const std::string& symbol);
+
+    bool isSilenced(const std::string& symbol) const;
+    double impactScore(const std::string& symbol) const;
+    GeneImpact getImpact(const std::string& symbol) const;
+
+    // Genes with a non-zero impact score, in graph insertion order.
+    std::vector<GeneImpact> getAffectedGenes() const;
+    // Hops from the nearest knockout to the farthest affected gene, following
+    // edges out of silenced genes only (0 when nothing is knocked out).
+    int perturbationDepth() const;
+
+    size_t nodeCount() const;
+    // Number of genes re-evaluated by the most recent setKnockout/toggleKnockout.
+    size_t lastUpdateVisited() const;
+
+private:
+    std::unordered_map<std::string, int> ids_;
+    std::vector<std::string> symbols_;
+    std::vector<std::vector<int>> downstream_;
+    std::vector<int> inputs_;
+    std::vector<int> lost_;
+    std::vector<char> knockedOut_;
+    std::vector<char> silenced_;
+    std::vector<char> inRegion_; // scratch for retractFrom, all zero between calls
+    size_t lastVisited_ = 0;
+
+    int nodeFor(const std::string& symbol);
+    int find(const std::string& symbol) const;
+    bool evaluate(int v) const;
+    void propagate(std::deque<int> work);
+    void retractFrom(int start);
+    GeneImpact impactOf(int v) const;
+};
+
+#endif // KNOCKOUT_PROPAGATION_H
@@ -1,4 +1,13 @@
 #include "map_logic.h"
+#include "api_logic.h"
+#include "distance_matrix.h"
+#include "exporters.h"
+#include "gene_cache.h"
+#include "gene_snapshot.h"
+#include "knockout_propagation.h"
+#include "pathway_layout.h"
+#include "trace.h"
+#include "variant_extraction.h"
 
 #include <windows.h>
 #include <iostream>
@@ -6,12 +15,27 @@
 #include <iomanip>
 #include <vector>
 #include <conio.h>
+#include <algorithm>
+#include <filesystem>
+#include <future>
 #include <iomanip>
+#include <memory>
+#include <sstream>
 #include <vector>
 
 // Console global handles
 static HANDLE hIn, hOut;
 
+// Pathway layouts, recomputed only when a pathway's graph changes
+static PathwayLayoutCache layoutCache;
+
+// NCBI lookups persisted across sessions
+static GeneCache geneCache;
+
+// Genes on screen. Background fetches and imports publish into it; each
+// frame draws from one snapshot, so ingestion never blocks a redraw.
+static GeneSnapshotStore geneStore;
+
 // Screen layout
 constexpr int SCREEN_W = 80;
 constexpr int SCREEN_H = 24;
@@ -31,21 +55,29 @@ struct UIState  {
     bool inAlign=false, inPathway=false;
     std::string statusMessage;
     int statusMessageCounter = 0; // Frames to show message
+    KnockoutPropagator* impact = nullptr; // downstream knockout effects
+    std::unique_ptr<NcbiFetchHandle> fetch; // background NCBI fetch, if any
+    std::future<BatchImportReport> import;  // background file import, if any
+    std::shared_ptr<const GeneSnapshot> genes; // this frame's genes
+    GeneSnapshotStatistics stats;
+    size_t propagated = 0; // genes whose knockouts have reached `impact`
 };
 
 // Forward prototypes
 void initConsole();
 void clearScreen();
-void drawMap(const AlignmentMap&, UIState&);
-void drawStats(const AlignmentMap&, UIState&);
+void drawMap(UIState&);
+void drawStats(UIState&);
 void drawAlignment(AlignmentEditor&, UIState&);
 void drawPathway(const AlignmentMap&, UIState&);
 void handleMainKey(int vk, AlignmentMap&, UIState&);
 void handleAlignKey(int vk, AlignmentEditor&, UIState&);
+void refreshGenes(UIState&);
+void checkBackgroundJobs(UIState&);
 
 // Helper to show a message for a few frames
 void showStatusMessage(const std::string& msg, UIState& st) {
-    st.statusMessage = msg;
+    st.statusMessage = msg.substr(0, SCREEN_W); // the footer pads to the screen width
     st.statusMessageCounter = 3; // Show for ~1-2 seconds
 }
 
@@ -92,14 +124,25 @@ int main() {
     editor.loadDemoDNA();
 
     UIState st;
+    KnockoutPropagator impact(map);
+    st.impact = &impact;
+    // From here on the genes live in geneStore; the map keeps the pathways.
+    geneStore.append(std::vector<GeneModel>(map.getGenes().begin(), map.getGenes().end()));
+    map.clearGenes();
+    refreshGenes(st);
+    st.propagated = st.genes->size();
     initConsole();
 
     // Main loop
     while (true) {
-        // Read one console event
-        INPUT_RECORD rec; DWORD cnt;
-        ReadConsoleInput(hIn, &rec, 1, &cnt);
-        if (rec.EventType == KEY_EVENT && rec.Event.KeyEvent.bKeyDown) {
+        // Read one console event; while a fetch, import or layout is running,
+        // wake up regularly to show its progress instead of blocking on input.
+        INPUT_RECORD rec; DWORD cnt = 0;
+        bool busy = st.fetch || st.import.valid() || layoutCache.pending() > 0;
+        if (!busy || WaitForSingleObject(hIn, 100) == WAIT_OBJECT_0) {
+            ReadConsoleInput(hIn, &rec, 1, &cnt);
+        }
+        if (cnt == 1 && rec.EventType == KEY_EVENT && rec.Event.KeyEvent.bKeyDown) {
             int vk = rec.Event.KeyEvent.wVirtualKeyCode;
             if (vk == VK_ESCAPE) {
                 if (st.inAlign) st.inAlign = false;
@@ -119,16 +162,19 @@ int main() {
                 handleMainKey(vk, map, st);
             }
         }
+        checkBackgroundJobs(st);
+        refreshGenes(st);
 
         // Redraw
+        TRACE_SCOPE("frame");
         clearScreen();
         if (st.inAlign) {
             drawAlignment(editor, st);
         } else if (st.inPathway) {
             drawPathway(map, st);
         } else {
-            drawMap(map, st);
-            drawStats(map, st);
+            drawMap(st);
+            drawStats(st);
             // Show footer with help text or a status message
             COORD p{0, SHORT(SCREEN_H-1)};
             SetConsoleCursorPosition(hOut, p);
@@ -168,8 +214,9 @@ void clearScreen() {
 }
 
 // draw 3D‐map stub
-void drawMap(const AlignmentMap& map, UIState& st) {
-    auto& G = map.getGenes();
+void drawMap(UIState& st) {
+    TRACE_SCOPE("drawMap");
+    const GeneSnapshot& G = *st.genes;
     for (int y=0; y<MAP_H; ++y) {
         COORD pos{0, SHORT(y)};
         SetConsoleCursorPosition(hOut,pos);
@@ -189,9 +236,10 @@ void drawMap(const AlignmentMap& map, UIState& st) {
 }
 
 // draw stats & selected gene
-void drawStats(const AlignmentMap& map, UIState& st) {
-    auto stats = map.calculateStatistics();
-    auto& G = map.getGenes();
+void drawStats(UIState& st) {
+    TRACE_SCOPE("drawStats");
+    const GenomeStats& stats = st.stats.update(*st.genes);
+    const GeneSnapshot& G = *st.genes;
     if (G.empty()) {
         COORD p{0, SHORT(MAP_H)};
         SetConsoleCursorPosition(hOut, p);
@@ -202,6 +250,9 @@ void drawStats(const AlignmentMap& map, UIState& st) {
 
     for (int i=0;i<STAT_H;++i) {
         COORD p{0, SHORT(MAP_H + i)};
+        SetConsoleCursorPosition(hOut, p);
+        std::cout << std::string(SCREEN_W, ' ');
+    }
 
     // Draw stats
     SetConsoleCursorPosition(hOut, {0, SHORT(MAP_H)});
@@ -209,7 +260,8 @@ void drawStats(const AlignmentMap& map, UIState& st) {
     std::cout << "--- Stats (Updated: " << stats.timestamp << ") ---";
     SetConsoleCursorPosition(hOut, {0, SHORT(MAP_H + 1)});
     std::cout << "Total Genes: " << stats.totalGenes << " | KOs: " << stats.totalKnockouts
-              << " | Avg Expr: " << stats.avgExpression;
+              << " | Avg Expr: " << stats.avgExpression
+              << " | Median: " << stats.medianExpression << " | P99: " << stats.p99Expression;
     SetConsoleCursorPosition(hOut, {0, SHORT(MAP_H + 2)});
     std::cout << std::string(SCREEN_W, '-');
 
@@ -233,11 +285,13 @@ void drawStats(const AlignmentMap& map, UIState& st) {
 
 // draw alignment editor
 void drawAlignment(AlignmentEditor& editor, UIState& st) {
+    TRACE_SCOPE("drawAlignment");
     editor.render(SCREEN_W, SCREEN_H);
 }
 
 // draw pathway view
 void drawPathway(const AlignmentMap& map, UIState& st) {
+    TRACE_SCOPE("drawPathway");
     auto& pathways = map.getPathways();
     if (pathways.empty()) {
         std::cout << "No pathways loaded.";
@@ -250,17 +304,29 @@ void drawPathway(const AlignmentMap& map, UIState& st) {
     SetConsoleCursorPosition(hOut, pos);
 
     std::cout << "Pathway: " << p.name << " (" << p.description << ")";
-    pos.Y = 2;
-    SetConsoleCursorPosition(hOut, pos);
 
-    // crude layout
+    // force-directed layout, cached per pathway until its graph changes and
+    // computed in the background; the previous layout stands in meanwhile
+    constexpr int TOP = 2;
+    const int rows = SCREEN_H - TOP - 1;
+    const PathwayLayout* layout = layoutCache.tryGet(p);
+    if (!layout) {
+        std::vector<std::string> canvas(SCREEN_H, std::string(SCREEN_W, ' '));
+        std::string note = "Laying out " + std::to_string(p.geneSymbols.size()) + " genes...";
+        canvas[TOP + rows / 2].replace(std::max(0, (SCREEN_W - int(note.size())) / 2), note.size(), note);
+        for (int y = TOP; y < SCREEN_H - 1; ++y) {
+            SetConsoleCursorPosition(hOut, {0, SHORT(y)});
+            std::cout << canvas[y];
+        }
+        return;
+    }
     std::map<std::string, COORD> genePositions;
-    int y = 5;
-    for(const auto& symbol : p.geneSymbols) {
-        genePositions[symbol] = {10, SHORT(y)};
-        y += 2;
+    for (const auto& cell : projectLayoutToGrid(*layout, SCREEN_W, rows)) {
+        genePositions[cell.symbol] = {SHORT(cell.x), SHORT(TOP + cell.y)};
     }
 
+    // compose the frame off-screen, then write each row once
+    std::vector<std::string> canvas(SCREEN_H, std::string(SCREEN_W, ' '));
     for(const auto& kv : p.interactions) {
         const auto& from = kv.first;
         for(const auto& to : kv.second) {
@@ -270,22 +336,32 @@ void drawPathway(const AlignmentMap& map, UIState& st) {
             COORD p1 = genePositions.at(from);
             COORD p2 = genePositions.at(to);
 
-            // very basic line drawing
+            // Bresenham line between label anchors
             int x1 = p1.X, y1 = p1.Y;
             int x2 = p2.X, y2 = p2.Y;
-
-            while(x1 != x2 || y1 != y2) {
-                if (x1 < x2) x1++; else if (x1 > x2) x1--;
-                if (y1 < y2) y1++; else if (y1 > y2) y1--;
-                SetConsoleCursorPosition(hOut, {SHORT(x1), SHORT(y1)});
-                std::cout << ".";
+            int dx = std::abs(x2 - x1), dy = -std::abs(y2 - y1);
+            int sx = x1 < x2 ? 1 : -1, sy = y1 < y2 ? 1 : -1;
+            int err = dx + dy;
+            while (x1 != x2 || y1 != y2) {
+                int e2 = 2 * err;
+                if (e2 >= dy) { err += dy; x1 += sx; }
+                if (e2 <= dx) { err += dx; y1 += sy; }
+                if (y1 >= 0 && y1 < SCREEN_H && x1 >= 0 && x1 < SCREEN_W) canvas[y1][x1] = '.';
             }
         }
     }
 
+    // silenced genes (knocked out or cut off from all inputs) use (), others []
     for(const auto& kv : genePositions) {
-        SetConsoleCursorPosition(hOut, kv.second);
-        std::cout << "[" << kv.first << "]";
+        bool silenced = st.impact && st.impact->isSilenced(kv.first);
+        std::string label = (silenced ? "(" : "[") + kv.first + (silenced ? ")" : "]");
+        auto& row = canvas[kv.second.Y];
+        for (size_t i = 0; i < label.size() && kv.second.X + i < row.size(); ++i) row[kv.second.X + i] = label[i];
+    }
+
+    for (int y = TOP; y < SCREEN_H - 1; ++y) {
+        SetConsoleCursorPosition(hOut, {0, SHORT(y)});
+        std::cout << canvas[y];
     }
 }
 
@@ -315,38 +391,170 @@ void handleMainKey(int vk, AlignmentMap& map, UIState& st) {
         case 'W':       st.cam.zoom  *= ZOOM_FACTOR; break;
         case 'S':       st.cam.zoom  /= ZOOM_FACTOR; break;
         case 'N': // Next Gene
-            if (!map.getGenes().empty())
-                st.geneIdx = (st.geneIdx + 1) % map.getGenes().size();
+            if (!st.genes->empty())
+                st.geneIdx = int((st.geneIdx + 1) % st.genes->size());
             break;
         case 'P': // Previous Gene
-            if (!map.getGenes().empty())
-                st.geneIdx = (st.geneIdx + map.getGenes().size() - 1) % map.getGenes().size();
+            if (!st.genes->empty())
+                st.geneIdx = int((st.geneIdx + st.genes->size() - 1) % st.genes->size());
             break;
         case 'K':
-            if (!map.getGenes().empty())
-                map.toggleKnockout(map.getGenes()[st.geneIdx].symbol);
+            if (!st.genes->empty()) {
+                const std::string symbol = (*st.genes)[st.geneIdx].symbol;
+                geneStore.toggleKnockout(symbol);
+                st.genes = geneStore.snapshot();
+                if (st.impact) {
+                    st.impact->toggleKnockout(symbol);
+                    showStatusMessage("KO " + symbol + ": " + std::to_string(st.impact->getAffectedGenes().size())
+                                      + " genes affected, reach " + std::to_string(st.impact->perturbationDepth()), st);
+                }
+            }
             break;
-        case 'L': 
-            std::string filepath = promptUser("Load gene file path (or Esc to cancel): ");
-            if (filepath.empty()) {
+        case 'M': {
+            // Genes live in the snapshot store; the map only holds pathways and gene sets.
+            MemoryReport report = st.genes->memoryReport();
+            for (const auto& s : map.memoryReport().subsystems)
+                if (s.name != "genes") report.subsystems.push_back(s);
+            const SubsystemMemory* genes = report.find("genes");
+            std::ostringstream msg;
+            msg << "Memory: " << formatBytes(report.totalBytes()) << " (peak " << formatBytes(report.peakBytes())
+                << "), genes " << formatBytes(genes->currentBytes) << " = "
+                << std::fixed << std::setprecision(0) << genes->bytesPerRecord() << " B/gene";
+            showStatusMessage(msg.str(), st);
+            break;
+        }
+        case 'T':
+            if (!kTracingEnabled) {
+                showStatusMessage("Tracing is off; rebuild with -DALIGNMENT_MAP_TRACING", st);
+            } else if (saveChromeTrace("alignment_map_trace.json")) {
+                showStatusMessage("Trace written to alignment_map_trace.json", st);
+            } else {
+                showStatusMessage("Error: Could not write trace file", st);
+            }
+            break;
+        case 'F': {
+            if (st.fetch) {
+                st.fetch->cancel();
+                showStatusMessage("Cancelling NCBI fetch...", st);
+                break;
+            }
+            std::string line = promptUser("Fetch accessions, comma separated (or Esc to cancel): ");
+            std::vector<std::string> accessions;
+            std::stringstream ss(line);
+            std::string accession;
+            while (std::getline(ss, accession, ',')) {
+                accession.erase(0, accession.find_first_not_of(' '));
+                accession.erase(accession.find_last_not_of(' ') + 1);
+                if (!accession.empty()) accessions.push_back(accession);
+            }
+            if (accessions.empty()) {
+                showStatusMessage("Fetch cancelled.", st);
+                break;
+            }
+            NcbiFetchOptions options;
+            options.cache = &geneCache;
+            // Workers publish each batch themselves; the UI thread never handles the genes.
+            options.batchSink = [](std::vector<GeneModel>&& genes) { geneStore.append(std::move(genes)); };
+            st.fetch = fetchGeneDataFromNCBIAsync(accessions, options);
+            showStatusMessage("Fetching " + std::to_string(accessions.size()) + " genes from NCBI ([F] to cancel)", st);
+            break;
+        }
+        case 'L': {
+            std::string line = promptUser("Load gene files or a directory, comma separated (or Esc to cancel): ");
+            std::vector<std::string> paths;
+            std::stringstream ss(line);
+            std::string path;
+            while (std::getline(ss, path, ',')) {
+                path.erase(0, path.find_first_not_of(' '));
+                path.erase(path.find_last_not_of(' ') + 1);
+                if (!path.empty()) paths.push_back(path);
+            }
+            if (paths.empty()) {
                 showStatusMessage("File loading cancelled.", st);
                 break;
             }
-            // Basic file type detection
-            if (filepath.size() > 5 && filepath.substr(filepath.size() - 5) == ".json") {
-                map.loadGenesFromJSON(filepath);
-                showStatusMessage("Loaded genes from JSON: " + filepath, st);
-            } else if (filepath.size() > 4 && filepath.substr(filepath.size() - 4) == ".csv") {
-                map.loadGenesFromCSV(filepath);
-                showStatusMessage("Loaded genes from CSV: " + filepath, st);
+            if (st.import.valid()) {
+                showStatusMessage("An import is already running.", st);
+                break;
+            }
+            // Formats are sniffed per file and files are parsed in parallel, on
+            // a background thread that publishes every gene in one batch.
+            st.import = std::async(std::launch::async, [paths] {
+                AlignmentMap loaded;
+                std::error_code ec;
+                BatchImportReport report = paths.size() == 1 && std::filesystem::is_directory(paths[0], ec)
+                    ? loaded.importGeneDirectory(paths[0])
+                    : loaded.importGeneFiles(paths);
+                geneStore.append(std::vector<GeneModel>(loaded.getGenes().begin(), loaded.getGenes().end()));
+                return report;
+            });
+            showStatusMessage("Importing " + std::to_string(paths.size()) + " paths...", st);
+            break;
+        }
+        case 'X': {
+            std::string filepath = promptUser("Export genes to .csv or .json path (or Esc to cancel): ");
+            if (filepath.empty()) {
+                showStatusMessage("Export cancelled.", st);
+                break;
+            }
+            GeneExportStream stream(filepath, exportFormatForPath(filepath));
+            if (stream.good()) st.genes->forEach([&](const GeneModel& g) { stream.write(g); });
+            if (stream.good() && stream.finish()) {
+                showStatusMessage("Exported " + std::to_string(st.genes->size()) + " genes to " + filepath, st);
             } else {
-                showStatusMessage("Error: Unknown file type for: " + filepath, st);
+                showStatusMessage("Error: Could not export genes to " + filepath, st);
             }
-            st.geneIdx = 0; // Reset index after loading
             break;
         }
+        }
    }
 
+// Takes this frame's snapshot. Genes published since the last frame bring no
+// pathway edges, so only their knockouts need propagating; the graph is not rebuilt.
+void refreshGenes(UIState& st) {
+    st.genes = geneStore.snapshot();
+    if (st.propagated > st.genes->size()) st.propagated = 0;
+    for (; st.propagated < st.genes->size(); ++st.propagated) {
+        const GeneModel& g = (*st.genes)[st.propagated];
+        if (st.impact && g.isKnockout) st.impact->setKnockout(g.symbol, true);
+    }
+    if (st.geneIdx >= int(st.genes->size())) st.geneIdx = 0;
+}
+
+// Reports on the background fetch and import. Their genes are already in
+// geneStore; this only shows progress and collects the outcome.
+void checkBackgroundJobs(UIState& st) {
+    if (st.import.valid() && st.import.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        BatchImportReport report = st.import.get();
+        std::ostringstream msg;
+        msg << "Loaded " << report.genesLoaded << " genes from " << report.files.size() << " files in "
+            << std::fixed << std::setprecision(0) << report.milliseconds << " ms";
+        if (size_t failed = report.failedFiles()) {
+            auto first = std::find_if(report.files.begin(), report.files.end(),
+                                      [](const GeneFileImport& f) { return !f.ok(); });
+            msg << "; " << failed << " failed (" << first->path << ": " << first->error << ")";
+        }
+        showStatusMessage(msg.str(), st);
+        st.geneIdx = 0; // Reset index after loading
+    }
+
+    if (!st.fetch) return;
+    NcbiFetchProgress progress = st.fetch->progress();
+    if (!st.fetch->isDone()) {
+        showStatusMessage("NCBI: " + std::to_string(progress.batchesDone) + "/" + std::to_string(progress.batchesTotal)
+                          + " batches, " + std::to_string(progress.genesReceived) + " genes ([F] cancel)", st);
+        return;
+    }
+    try {
+        st.fetch->wait();
+        showStatusMessage(std::string(st.fetch->isCancelled() ? "NCBI fetch cancelled: " : "NCBI fetch done: ")
+                          + std::to_string(progress.genesReceived) + " genes added", st);
+    } catch (const std::exception& e) {
+        showStatusMessage(std::string("NCBI fetch failed: ") + e.what(), st);
+    }
+    st.fetch.reset();
+}
+
 
 void handleAlignKey(int vk, AlignmentEditor& ed, UIState& st) {
     switch(vk) {
@@ -384,5 +592,54 @@ void handleAlignKey(int vk, AlignmentEditor& ed, UIState& st) {
 
             break;
         }
+
+        case 'X': {
+            std::string filepath = promptUser("Export sequences to .csv, .json or .fasta path (or Esc to cancel): ");
+            if (filepath.empty()) {
+                showStatusMessage("Export cancelled.", st);
+                break;
+            }
+            if (exportSequences(ed.getSequences(), filepath, exportFormatForPath(filepath))) {
+                showStatusMessage("Exported sequences to " + filepath, st);
+            } else {
+                showStatusMessage("Error: Could not export sequences to " + filepath, st);
+            }
+            break;
+        }
+
+        case 'D': {
+            const auto& seqs = ed.getSequences();
+            if (seqs.size() < 2) break;
+            // The sequence farthest on average from the rest is the likeliest outlier.
+            DistanceMatrix matrix = computeDistanceMatrix(seqs);
+            size_t outlier = 0;
+            double worst = -1.0;
+            for (size_t i = 0; i < seqs.size(); ++i) {
+                double sum = 0.0;
+                size_t pairs = 0;
+                for (size_t j = 0; j < seqs.size(); ++j) {
+                    double d = matrix.value(i, j, DistanceMeasure::PDistance);
+                    if (j != i && !std::isnan(d)) { sum += d; ++pairs; }
+                }
+                double mean = pairs ? sum / double(pairs) : 0.0;
+                if (mean > worst) { worst = mean; outlier = i; }
+            }
+            showStatusMessage("Most divergent: " + seqs[outlier].name + " (mean p-distance "
+                              + std::to_string(worst).substr(0, 5) + ")", st);
+            break;
+        }
+
+        case 'V': {
+            if (ed.getSequences().empty()) break;
+            VariantOptions options;
+            options.collectVariants = false;
+            VariantReport report = extractVariants(ed.getBlock(), options);
+            size_t i = size_t(ed.getSelectedSeq());
+            const SequenceVariantSummary& v = report.sequences[i];
+            showStatusMessage(ed.getSequences()[i].name + " vs reference: " + std::to_string(v.mismatches) + " SNV, "
+                              + std::to_string(v.insertions) + " ins (" + std::to_string(v.insertedBases) + " bp), "
+                              + std::to_string(v.deletions) + " del (" + std::to_string(v.deletedBases) + " bp)", st);
+            break;
+        }
     }
 }
@@ -1,6 +1,12 @@
 
 #include "map_logic.h"
+#include "parallel_utils.h"
+#include "trace.h"
+#include <cctype>
+#include <chrono>
+#include <cstring>
 #include <ctime>
+#include <filesystem>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
@@ -12,17 +18,18 @@
 #include <sstream>
 #include <vector>
 #include <cstddef>
+#include <utility>
+#include <unordered_map>
 
 //-----------------------------------------------------------------------------
 // AlignmentMap additional methods
 //-----------------------------------------------------------------------------
-void AlignmentMap::loadGenesFromCSV(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open CSV file " << filename << std::endl;
-        return;
-    }
-
+// Shared by the single-file loaders and the batch importer. Genes come from
+// makeGene() and go to emit(GeneModel&&); skipped records are noted in
+// report.warnings and unreadable files in report.error, so callers decide
+// whether to print them.
+template <typename MakeGene, typename Emit>
+static void parseGenesCSV(std::istream& file, MakeGene makeGene, Emit emit, GeneFileImport& report) {
     std::string line;
     // Skip header
     if (!std::getline(file, line)) return;
@@ -37,33 +44,33 @@ void AlignmentMap::loadGenesFromCSV(const std::string& filename) {
 
         // Require at least 4 fields (gene_name, knockout, status, expression_level)
         if (fields.size() < 4) {
-            std::cerr << "Warning: Skipping malformed CSV line: " << line << std::endl;
+            report.warnings.push_back("Skipping malformed CSV line: " + line);
             continue;
         }
 
-        GeneModel g;
+        GeneModel g = makeGene();
         g.symbol = fields[0];
         g.isKnockout = (fields[1] == "X");  // 'X' indicates knockout
         // Ignore status field or map if needed
         try {
             g.expressionLevel = std::stod(fields[3]);
         } catch (const std::exception&) {
-            std::cerr << "Warning: Invalid expression level in line: " << line << std::endl;
+            report.warnings.push_back("Invalid expression level in line: " + line);
             continue;
         }
 
 
-        // Parse categories from 5th column if it exists (semicolon-separated)
+        // Parse disorder tags from 5th column if it exists (semicolon-separated)
         if (fields.size() > 4) {
-            std::stringstream cat_ss(fields[4]);
-            std::string category;
-            while (std::getline(cat_ss, category, ';')) {
-                // trim whitespace from category
-                size_t first = category.find_first_not_of(" \t");
+            std::stringstream tag_ss(fields[4]);
+            std::string tag;
+            while (std::getline(tag_ss, tag, ';')) {
+                // trim whitespace from tag
+                size_t first = tag.find_first_not_of(" \t");
                 if (std::string::npos == first) continue;
-                size_t last = category.find_last_not_of(" \t");
-                g.categories.push_back(category.substr(first, (last - first + 1)));
-
+                size_t last = tag.find_last_not_of(" \t");
+                g.disorderTags.emplace_back(tag.substr(first, (last - first + 1)));
+            }
         }
 
         if (fields.size() > 5) {
@@ -74,7 +81,7 @@ void AlignmentMap::loadGenesFromCSV(const std::string& filename) {
                 if (sep != std::string::npos) {
                     std::string region = kv.substr(0, sep);
                     double expr = std::stod(kv.substr(sep + 1));
-                    g.brainRegionExpression[region] = expr;
+                    setRegionExpression(g.brainRegionExpression, region, expr);
                 }
             }
         }
@@ -85,25 +92,18 @@ void AlignmentMap::loadGenesFromCSV(const std::string& filename) {
         g.end = 0;
         g.polygenicScore = 0.0;
 
-        addGene(g);
+        emit(std::move(g));
+        ++report.genesLoaded;
     }
 }
 
-void AlignmentMap::loadGenesFromJSON(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cout << "DEBUG: JSON file not opened: " << filename << std::endl;
-        std::cerr << "Error: Could not open JSON file " << filename << std::endl;
-        return;
-    }
-
-    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-
+template <typename MakeGene, typename Emit>
+static void parseGenesJSON(const std::string& content, MakeGene makeGene, Emit emit, GeneFileImport& report) {
     // Basic JSON parsing - find "genes" array and parse objects
     // Note: For production, use a proper JSON library like nlohmann/json
     size_t pos = content.find("\"genes\": [");
     if (pos == std::string::npos) {
-        std::cerr << "Error: No 'genes' array found in JSON" << std::endl;
+        report.error = "No 'genes' array found in JSON";
         return;
     }
 
@@ -123,7 +123,7 @@ void AlignmentMap::loadGenesFromJSON(const std::string& filename) {
         std::string obj = arrayContent.substr(objStart, objEnd - objStart + 1);
 
         // Extract fields (basic string search)
-        GeneModel g;
+        GeneModel g = makeGene();
 
         // gene_name
         size_t namePos = obj.find("\"gene_name\":");
@@ -167,8 +167,11 @@ void AlignmentMap::loadGenesFromJSON(const std::string& filename) {
                 while ((currentPos = catArray.find('"', currentPos)) != std::string::npos) {
                     size_t quoteEnd = catArray.find('"', currentPos + 1);
                     if (quoteEnd == std::string::npos) break;
-                    g.categories.push_back(catArray.substr(currentPos + 1, quoteEnd - currentPos - 1));
+                    g.categories.emplace_back(catArray.substr(currentPos + 1, quoteEnd - currentPos - 1));
                     currentPos = quoteEnd + 1;
+                }
+            }
+        }
 
         // disorderTags
         size_t tagsPos = obj.find("\"disorderTags\":");
@@ -183,7 +186,7 @@ void AlignmentMap::loadGenesFromJSON(const std::string& filename) {
                     size_t quote1 = tag.find('"');
                     size_t quote2 = tag.find('"', quote1 + 1);
                     if (quote1 != std::string::npos && quote2 != std::string::npos) {
-                        g.disorderTags.push_back(tag.substr(quote1 + 1, quote2 - quote1 - 1));
+                        g.disorderTags.emplace_back(tag.substr(quote1 + 1, quote2 - quote1 - 1));
                     }
                 }
             }
@@ -206,7 +209,7 @@ void AlignmentMap::loadGenesFromJSON(const std::string& filename) {
                         if (quote1 != std::string::npos && quote2 != std::string::npos) {
                             std::string region = kv.substr(quote1 + 1, quote2 - quote1 - 1);
                             double expr = std::stod(kv.substr(sep + 1));
-                            g.brainRegionExpression[region] = expr;
+                            setRegionExpression(g.brainRegionExpression, region, expr);
                         }
                     }
 
@@ -220,15 +223,177 @@ void AlignmentMap::loadGenesFromJSON(const std::string& filename) {
         g.end = 0;
         g.polygenicScore = 0.0;
 
-        addGene(g);
+        emit(std::move(g));
+        ++report.genesLoaded;
         objStart = objEnd + 1;
     }
 }
 
+void AlignmentMap::loadGenesFromCSV(const std::string& filename) {
+    TRACE_SCOPE("loadGenesFromCSV");
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open CSV file " << filename << std::endl;
+        return;
+    }
+    GeneFileImport report;
+    parseGenesCSV(file, [this] { return newGene(); }, [this](GeneModel&& g) { addGene(std::move(g)); }, report);
+    for (const auto& warning : report.warnings) std::cerr << "Warning: " << warning << std::endl;
+    expressionStats_.compact();
+    TRACE_COUNTER_ADD("loadGenesFromCSV.genes", report.genesLoaded);
+}
+
+void AlignmentMap::loadGenesFromJSON(const std::string& filename) {
+    TRACE_SCOPE("loadGenesFromJSON");
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cout << "DEBUG: JSON file not opened: " << filename << std::endl;
+        std::cerr << "Error: Could not open JSON file " << filename << std::endl;
+        return;
+    }
+
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    GeneFileImport report;
+    parseGenesJSON(content, [this] { return newGene(); }, [this](GeneModel&& g) { addGene(std::move(g)); }, report);
+    if (!report.ok()) std::cerr << "Error: " << report.error << std::endl;
+    expressionStats_.compact();
+    TRACE_COUNTER_ADD("loadGenesFromJSON.genes", report.genesLoaded);
+}
+
+//-----------------------------------------------------------------------------
+// Batch import
+//-----------------------------------------------------------------------------
+GeneFileFormat sniffGeneFileFormat(std::string_view head) {
+    if (head.substr(0, 3) == "\xEF\xBB\xBF") head.remove_prefix(3);
+    size_t first = head.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) return GeneFileFormat::Unknown;
+    if (head[first] == '{' || head[first] == '[') return GeneFileFormat::JSON;
+    std::string_view line = head.substr(first, head.find('\n', first) - first);
+    return line.find(',') != std::string_view::npos ? GeneFileFormat::CSV : GeneFileFormat::Unknown;
+}
+
+size_t BatchImportReport::failedFiles() const {
+    return size_t(std::count_if(files.begin(), files.end(), [](const GeneFileImport& f) { return !f.ok(); }));
+}
+
+namespace {
+// One file's genes and statistics, parsed off the UI thread.
+struct ParsedGeneFile {
+    std::vector<GeneModel> genes;
+    ExpressionStatistics stats;
+};
+
+bool hasExtension(const std::string& path, const char* ext) {
+    size_t n = std::strlen(ext);
+    if (path.size() < n) return false;
+    for (size_t i = 0; i < n; ++i) {
+        if (std::tolower(static_cast<unsigned char>(path[path.size() - n + i])) != ext[i]) return false;
+    }
+    return true;
+}
+
+void parseGeneFile(GeneFileImport& report, ParsedGeneFile& parsed) {
+    auto started = std::chrono::steady_clock::now();
+    std::ifstream file(report.path, std::ios::binary);
+    if (!file.is_open()) {
+        report.error = "Could not open file";
+    } else {
+        char head[512];
+        file.read(head, sizeof head);
+        report.format = sniffGeneFileFormat(std::string_view(head, size_t(file.gcount())));
+        if (report.format == GeneFileFormat::Unknown) {
+            if (hasExtension(report.path, ".json")) report.format = GeneFileFormat::JSON;
+            else if (hasExtension(report.path, ".csv")) report.format = GeneFileFormat::CSV;
+        }
+        file.clear();
+        file.seekg(0);
+
+        auto makeGene = [] { return GeneModel(); };
+        auto emit = [&](GeneModel&& g) {
+            parsed.stats.add(g);
+            parsed.genes.push_back(std::move(g));
+        };
+        try {
+            if (report.format == GeneFileFormat::JSON) {
+                std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                parseGenesJSON(content, makeGene, emit, report);
+            } else if (report.format == GeneFileFormat::CSV) {
+                parseGenesCSV(file, makeGene, emit, report);
+            } else {
+                report.error = "Unrecognised file format";
+            }
+        } catch (const std::exception& e) {
+            report.error = std::string("Parse failed: ") + e.what();
+        }
+        if (!report.ok()) {
+            parsed = ParsedGeneFile();
+            report.genesLoaded = 0;
+        }
+    }
+    report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+}
+} // namespace
+
+BatchImportReport AlignmentMap::importGeneFiles(const std::vector<std::string>& paths, unsigned threads) {
+    TRACE_SCOPE("importGeneFiles");
+    auto started = std::chrono::steady_clock::now();
+    BatchImportReport report;
+    report.files.resize(paths.size());
+    std::vector<ParsedGeneFile> parsed(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) report.files[i].path = paths[i];
+
+    parallelFor(paths.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) parseGeneFile(report.files[i], parsed[i]);
+    }, threads);
+
+    // Merge in input order so the gene order is the same at any thread count.
+    size_t total = 0;
+    for (const auto& p : parsed) total += p.genes.size();
+    reserveGenes(genes_.size() + total);
+    for (auto& p : parsed) {
+        for (auto& g : p.genes) appendGene(std::move(g));
+        expressionStats_.merge(p.stats);
+        p = ParsedGeneFile();
+    }
+    expressionStats_.compact();
+    report.genesLoaded = total;
+    report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    TRACE_COUNTER_ADD("importGeneFiles.genes", total);
+    return report;
+}
+
+BatchImportReport AlignmentMap::importGeneDirectory(const std::string& directory, bool recursive, unsigned threads) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> paths;
+    std::error_code ec;
+    auto collect = [&](const fs::directory_entry& entry) {
+        std::error_code statusError; // an unreadable entry is skipped, not fatal
+        std::string name = entry.path().filename().string();
+        if (!name.empty() && name[0] != '.' && entry.is_regular_file(statusError)) paths.push_back(entry.path().string());
+    };
+    if (recursive) {
+        for (fs::recursive_directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) collect(*it);
+    } else {
+        for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) collect(*it);
+    }
+    if (ec) {
+        BatchImportReport report;
+        GeneFileImport failed;
+        failed.path = directory;
+        failed.error = "Could not read directory: " + ec.message();
+        report.files.push_back(std::move(failed));
+        return report;
+    }
+    std::sort(paths.begin(), paths.end());
+    return importGeneFiles(paths, threads);
+}
+
 //-----------------------------------------------------------------------------
 // AlignmentEditor additional methods
 //-----------------------------------------------------------------------------
 void AlignmentEditor::loadSequencesFromCSV(const std::string& filename) {
+    TRACE_SCOPE("loadSequencesFromCSV");
+    [[maybe_unused]] const size_t loadedBefore = block_.sequences.size();
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Error: Could not open CSV file " << filename << std::endl;
@@ -260,12 +425,15 @@ void AlignmentEditor::loadSequencesFromCSV(const std::string& filename) {
 
         // annotations ignored for now (no field in SequenceModel)
 
-        block_.sequences.push_back(seq);
+        addSequence(std::move(seq));
     }
-
+    scorer_.reset(block_);
+    TRACE_COUNTER_ADD("loadSequencesFromCSV.sequences", block_.sequences.size() - loadedBefore);
 }
 
 void AlignmentEditor::loadSequencesFromJSON(const std::string& filename) {
+    TRACE_SCOPE("loadSequencesFromJSON");
+    [[maybe_unused]] const size_t loadedBefore = block_.sequences.size();
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Error: Could not open JSON file " << filename << std::endl;
@@ -322,21 +490,194 @@ void AlignmentEditor::loadSequencesFromJSON(const std::string& filename) {
 
         // annotations ignored
 
-        block_.sequences.push_back(seq);
+        addSequence(std::move(seq));
         objStart = objEnd + 1;
     }
+    scorer_.reset(block_);
+    TRACE_COUNTER_ADD("loadSequencesFromJSON.sequences", block_.sequences.size() - loadedBefore);
 }
 
 //-----------------------------------------------------------------------------
 // AlignmentMap implementation
 //-----------------------------------------------------------------------------
 
+// --- Memory accounting helpers ---
+
+size_t heapBytes(const GeneModel& g) {
+    return heapBytes(g.symbol) + heapBytes(g.chromosome) + heapBytes(g.categories)
+         + heapBytes(g.disorderTags) + heapBytes(g.brainRegionExpression);
+}
+
+static size_t heapBytes(const Pathway& p) {
+    return heapBytes(p.name) + heapBytes(p.description) + heapBytes(p.geneSymbols) + heapBytes(p.interactions);
+}
+
+static size_t heapBytes(const GeneSet& gs) {
+    return heapBytes(gs.name) + heapBytes(gs.geneSymbols);
+}
+
+static size_t heapBytes(const SequenceModel& seq) {
+    return heapBytes(seq.name) + heapBytes(seq.raw) + heapBytes(seq.aligned);
+}
+
+// Accounts a vector's storage after an append. A reallocation briefly holds
+// both blocks, so the new one is added before the old one is released.
+template <typename T>
+static void accountGrowth(MemoryAccount& account, size_t old_capacity, const std::vector<T>& v) {
+    if (v.capacity() == old_capacity) return;
+    account.add(v.capacity() * sizeof(T));
+    account.release(old_capacity * sizeof(T));
+}
+
+// --- Gene storage ---
+
+// Counts what the arena draws from the heap.
+class GeneArenaUpstream : public std::pmr::memory_resource {
+public:
+    size_t bytes = 0;
+
+private:
+    void* do_allocate(size_t size, size_t alignment) override {
+        void* p = std::pmr::new_delete_resource()->allocate(size, alignment);
+        bytes += size;
+        return p;
+    }
+    void do_deallocate(void* p, size_t size, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+struct GeneArena::Resource {
+    GeneArenaUpstream upstream;
+    std::pmr::monotonic_buffer_resource arena{64 * 1024, &upstream};
+};
+
+std::pmr::memory_resource* GeneArena::resource() {
+    if (!resource_) {
+        resource_ = {new Resource, [](Resource* r) { delete r; }};
+    }
+    return &resource_->arena;
+}
+
+void GeneArena::release() {
+    resource_.reset();
+}
+
+size_t GeneArena::reservedBytes() const {
+    return resource_ ? resource_->upstream.bytes : 0;
+}
+
+void setRegionExpression(RegionExpressionMap& regions, std::string_view region, double value) {
+    auto it = regions.find(region);
+    if (it != regions.end()) it->second = value;
+    else regions.emplace(region, value);
+}
+
+// Rebuilds `g` with its containers on `resource`: a plain move when they are
+// already there, a copy into it otherwise.
+template <typename Gene>
+static GeneModel onResource(Gene&& g, std::pmr::memory_resource* resource) {
+    return GeneModel{std::forward<Gene>(g).symbol, std::forward<Gene>(g).chromosome,
+                     g.start, g.end, g.expressionLevel, g.polygenicScore, g.isKnockout,
+                     StringList(std::forward<Gene>(g).categories, resource),
+                     StringList(std::forward<Gene>(g).disorderTags, resource),
+                     RegionExpressionMap(std::forward<Gene>(g).brainRegionExpression, resource)};
+}
+
+void AlignmentMap::setGeneStorage(GeneStorage storage) {
+    geneStorage_ = storage;
+}
+
+GeneStorage AlignmentMap::geneStorage() const {
+    return geneStorage_;
+}
+
+void AlignmentMap::reserveGenes(size_t count) {
+    size_t capacity = genes_.capacity();
+    genes_.reserve(count);
+    accountGrowth(geneMemory_, capacity, genes_);
+}
+
+// The resource new and added genes should use.
+static std::pmr::memory_resource* geneResource(GeneStorage storage, GeneArena& arena) {
+    return storage == GeneStorage::Arena ? arena.resource() : std::pmr::get_default_resource();
+}
+
+GeneModel AlignmentMap::newGene() {
+    return onResource(GeneModel{}, geneResource(geneStorage_, geneArena_));
+}
+
 void AlignmentMap::addGene(const GeneModel& g) {
-    genes_.push_back(g);
+    size_t capacity = genes_.capacity();
+    genes_.push_back(onResource(g, geneResource(geneStorage_, geneArena_)));
+    accountGrowth(geneMemory_, capacity, genes_);
+    geneMemory_.add(heapBytes(genes_.back()), 1);
+    expressionStats_.add(genes_.back());
+}
+
+void AlignmentMap::addGene(GeneModel&& g) {
+    appendGene(std::move(g));
+    expressionStats_.add(genes_.back());
+}
+
+void AlignmentMap::appendGene(GeneModel&& g) {
+    size_t capacity = genes_.capacity();
+    genes_.push_back(onResource(std::move(g), geneResource(geneStorage_, geneArena_)));
+    accountGrowth(geneMemory_, capacity, genes_);
+    geneMemory_.add(heapBytes(genes_.back()), 1);
+}
+
+void AlignmentMap::clearGenes() {
+    // Swapping frees the vector's own block too; arena-backed containers
+    // only walk their nodes here, as deallocation into the arena is a no-op.
+    std::vector<GeneModel>().swap(genes_);
+    geneArena_.release();
+    geneMemory_.reset();
+    expressionStats_.clear();
+}
+
+const ExpressionStatistics& AlignmentMap::expressionStatistics() const {
+    return expressionStats_;
+}
+
+size_t AlignmentMap::geneArenaBytes() const {
+    return geneArena_.reservedBytes();
+}
+
+// Appends `pos` to the posting list of every distinct symbol in `symbols`.
+static void indexSymbols(std::map<std::string, std::vector<size_t>>& index,
+                         const std::vector<std::string>& symbols, size_t pos, MemoryAccount& memory) {
+    using Index = std::map<std::string, std::vector<size_t>>;
+    for (const auto& symbol : symbols) {
+        auto inserted = index.try_emplace(symbol);
+        if (inserted.second) {
+            memory.add(kTreeNodeOverhead + sizeof(Index::value_type) + heapBytes(inserted.first->first), 1);
+        }
+        auto& postings = inserted.first->second;
+        if (postings.empty() || postings.back() != pos) {
+            size_t capacity = postings.capacity();
+            postings.push_back(pos);
+            accountGrowth(memory, capacity, postings);
+        }
+    }
+}
+
+static const std::vector<size_t>& lookupSymbol(const std::map<std::string, std::vector<size_t>>& index,
+                                               const std::string& symbol) {
+    static const std::vector<size_t> empty;
+    auto it = index.find(symbol);
+    return it == index.end() ? empty : it->second;
 }
 
 void AlignmentMap::addPathway(const Pathway& p) {
+    size_t capacity = pathways_.capacity();
     pathways_.push_back(p);
+    accountGrowth(pathwayMemory_, capacity, pathways_);
+    pathwayMemory_.add(heapBytes(pathways_.back()), 1);
+    indexSymbols(pathwayIndex_, p.geneSymbols, pathways_.size() - 1, indexMemory_);
 }
 
 const std::vector<GeneModel>& AlignmentMap::getGenes() const {
@@ -348,13 +689,42 @@ const std::vector<Pathway>& AlignmentMap::getPathways() const {
 }
 
 void AlignmentMap::addGeneSet(const GeneSet& gs) {
+    size_t capacity = geneSets_.capacity();
     geneSets_.push_back(gs);
+    accountGrowth(geneSetMemory_, capacity, geneSets_);
+    geneSetMemory_.add(heapBytes(geneSets_.back()), 1);
+    indexSymbols(geneSetIndex_, gs.geneSymbols, geneSets_.size() - 1, indexMemory_);
 }
 
 const std::vector<GeneSet>& AlignmentMap::getGeneSets() const {
     return geneSets_;
 }
 
+const std::vector<size_t>& AlignmentMap::getPathwaysForGene(const std::string& symbol) const {
+    return lookupSymbol(pathwayIndex_, symbol);
+}
+
+const std::vector<size_t>& AlignmentMap::getGeneSetsForGene(const std::string& symbol) const {
+    return lookupSymbol(geneSetIndex_, symbol);
+}
+
+const std::map<std::string, std::vector<size_t>>& AlignmentMap::getPathwayIndex() const {
+    return pathwayIndex_;
+}
+
+const std::map<std::string, std::vector<size_t>>& AlignmentMap::getGeneSetIndex() const {
+    return geneSetIndex_;
+}
+
+MemoryReport AlignmentMap::memoryReport() const {
+    MemoryReport report;
+    report.subsystems.push_back(geneMemory_.snapshot("genes"));
+    report.subsystems.push_back(pathwayMemory_.snapshot("pathways"));
+    report.subsystems.push_back(geneSetMemory_.snapshot("geneSets"));
+    report.subsystems.push_back(indexMemory_.snapshot("geneIndex"));
+    return report;
+}
+
 GenomeStats AlignmentMap::calculateStatistics() const {
     GenomeStats s;
     s.totalGenes     = int(genes_.size());
@@ -367,6 +737,8 @@ GenomeStats AlignmentMap::calculateStatistics() const {
     if (s.totalGenes > 0) {
         s.avgExpression = sumE / s.totalGenes;
         s.avgPolyScore  = sumP / s.totalGenes;
+        s.medianExpression = expressionStats_.expression.quantile(0.5);
+        s.p99Expression    = expressionStats_.expression.quantile(0.99);
     }
     s.timestamp = makeTimestamp();
     return s;
@@ -381,7 +753,25 @@ void AlignmentMap::toggleKnockout(const std::string& symbol) {
     }
 }
 
-std::string AlignmentMap::makeTimestamp() const {
+size_t AlignmentMap::setPolygenicScores(const std::vector<std::string>& symbols, const std::vector<double>& scores) {
+    std::unordered_map<std::string_view, double> bySymbol;
+    bySymbol.reserve(symbols.size());
+    for (size_t i = 0; i < symbols.size() && i < scores.size(); ++i) bySymbol[symbols[i]] = scores[i];
+    size_t updated = 0;
+    expressionStats_.clear();
+    for (auto& g : genes_) {
+        auto it = bySymbol.find(g.symbol);
+        if (it != bySymbol.end()) {
+            g.polygenicScore = it->second;
+            ++updated;
+        }
+        expressionStats_.add(g);
+    }
+    expressionStats_.compact();
+    return updated;
+}
+
+std::string makeTimestamp() {
     auto now = std::time(nullptr);
     std::tm tm;
 #if defined(_WIN32) || defined(_WIN64)
@@ -445,6 +835,23 @@ void AlignmentEditor::loadDemoDNA() {
         {"GeneC", SequenceType::DNA,
           "ATCG-TCGAT-GATCG","ATCG-TCGAT-GATCG"}
     };
+    blockMemory_.reset();
+    blockMemory_.add(heapBytes(block_.reference) + block_.sequences.capacity() * sizeof(SequenceModel));
+    for (const auto& seq : block_.sequences) blockMemory_.add(heapBytes(seq), 1);
+    scorer_.reset(block_);
+}
+
+void AlignmentEditor::addSequence(SequenceModel seq) {
+    size_t capacity = block_.sequences.capacity();
+    block_.sequences.push_back(std::move(seq));
+    accountGrowth(blockMemory_, capacity, block_.sequences);
+    blockMemory_.add(heapBytes(block_.sequences.back()), 1);
+}
+
+MemoryReport AlignmentEditor::memoryReport() const {
+    MemoryReport report;
+    report.subsystems.push_back(blockMemory_.snapshot("alignment"));
+    return report;
 }
 
 void AlignmentEditor::render(int width, int height) const {
@@ -454,7 +861,13 @@ void AlignmentEditor::render(int width, int height) const {
     auto hOut = GetStdHandle(STD_OUTPUT_HANDLE);
     SetConsoleCursorPosition(hOut, pos);
     std::cout
-      << "MSA Editor [Esc=Back]";
+      << "MSA Editor [Esc=Back]  SP: " << scorer_.sumOfPairs();
+    if (block_.cursorPos < int(scorer_.columns())) std::cout << "  Col: " << scorer_.columnScore(size_t(block_.cursorPos));
+    if (block_.selectedSeq < int(block_.sequences.size())) {
+        std::cout << "  Id: " << std::fixed << std::setprecision(1)
+                  << scorer_.identity(size_t(block_.selectedSeq)) << "%"
+                  << std::defaultfloat << std::setprecision(6);
+    }
 
     // Reference
     pos.Y = 1;
@@ -496,7 +909,7 @@ void AlignmentEditor::render(int width, int height) const {
 void AlignmentEditor::moveCursor(int delta) {
     int len = int(block_.reference.size());
     block_.cursorPos =
-      std::clamp(block_.cursorPos + delta, 0, len-1);
+      std::clamp(block_.cursorPos + delta, 0, std::max(len-1, 0)); // no reference: stay at 0
 }
 
 void AlignmentEditor::selectSequence(int delta) {
@@ -509,28 +922,55 @@ void AlignmentEditor::toggleGap() {
     auto& s = block_.sequences[block_.selectedSeq];
     int p = block_.cursorPos;
     if (p<0||p>=int(s.aligned.size())) return;
+    char before = s.aligned[p];
     s.aligned[p] = (s.aligned[p]=='-' ? s.raw[p] : '-');
+    scorer_.update(block_, size_t(block_.selectedSeq), size_t(p), before);
 }
 
 void AlignmentEditor::reverseComplementSelected() {
     auto& s = block_.sequences[block_.selectedSeq];
+    size_t before = heapBytes(s.aligned);
     std::string rev;
     for (auto it = s.aligned.rbegin(); it != s.aligned.rend(); ++it)
         rev.push_back(complement(*it, s.type));
-    s.aligned = std::move(rev);
+    std::swap(s.aligned, rev);
+    blockMemory_.resize(before, heapBytes(s.aligned));
+    scorer_.updateSequence(block_, size_t(block_.selectedSeq), rev);
 }
 
 void AlignmentEditor::editSelectedBase(char base) {
     auto& s = block_.sequences[block_.selectedSeq];
     int p = block_.cursorPos;
     if (p<0||p>=int(s.aligned.size())) return;
+    char before = s.aligned[p];
     s.aligned[p] = std::toupper(base);
+    scorer_.update(block_, size_t(block_.selectedSeq), size_t(p), before);
 }
 
 const std::vector<SequenceModel>& AlignmentEditor::getSequences() const {
     return block_.sequences;
 }
 
+int AlignmentEditor::getCursorPos() const {
+    return block_.cursorPos;
+}
+
+int AlignmentEditor::getSelectedSeq() const {
+    return block_.selectedSeq;
+}
+
+const AlignmentBlock& AlignmentEditor::getBlock() const {
+    return block_;
+}
+
+const AlignmentScorer& AlignmentEditor::getScorer() const {
+    return scorer_;
+}
+
+void AlignmentEditor::setScoringScheme(ScoringScheme scheme) {
+    scorer_.setScheme(std::move(scheme), block_);
+}
+
 char AlignmentEditor::complement(char b, SequenceType t) const {
     switch (std::toupper(b)) {
         case 'A': return (t==SequenceType::RNA)? 'U':'T';
@@ -4,12 +4,24 @@
 #include <vector>
 #include <chrono>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
 #include <stddef.h>
+#include "alignment_score.h"
+#include "expression_stats.h"
+#include "memory_accounting.h"
 
 //-----------------------------------------------------------------------------
 // Gene‐map data structures
 //-----------------------------------------------------------------------------
 
+// Per-gene lists and maps draw from a memory resource so that bulk loads can
+// place them in an arena (see AlignmentMap::setGeneStorage). Copies fall back
+// to the default heap resource; moves keep the source's resource.
+using StringList          = std::pmr::vector<std::pmr::string>;
+using RegionExpressionMap = std::pmr::map<std::pmr::string, double, std::less<>>;
+
 struct GeneModel {
     std::string symbol;
     std::string chromosome;
@@ -18,17 +30,28 @@ struct GeneModel {
     double      expressionLevel = 0.0;
     double      polygenicScore  = 0.0;
     bool        isKnockout      = false;
-    std::vector<std::string> categories;
-    std::vector<std::string> disorderTags;
-    std::map<std::string, double> brainRegionExpression;
+    StringList  categories;
+    StringList  disorderTags;
+    RegionExpressionMap brainRegionExpression;
 
 };
 
+// Heap bytes owned by one gene's strings and containers, excluding the GeneModel itself.
+size_t heapBytes(const GeneModel& g);
+
+// Inserts or overwrites one region's expression without building a key first.
+void setRegionExpression(RegionExpressionMap& regions, std::string_view region, double value);
+
+// Local time as "YYYY-MM-DD HH:MM:SS", for GenomeStats::timestamp.
+std::string makeTimestamp();
+
 struct GenomeStats {
     int    totalGenes     = 0;
     int    totalKnockouts = 0;
     double avgExpression  = 0.0;
     double avgPolyScore   = 0.0;
+    double medianExpression = 0.0; // sketch estimates, see expressionStatistics()
+    double p99Expression    = 0.0;
     std::string timestamp;
 };
 
@@ -52,24 +75,137 @@ struct GeneSet {
     std::vector<std::string> geneSymbols;
 };
 
+enum class GeneStorage {
+    Heap,  // every gene container allocates individually (default)
+    Arena  // containers bump-allocate from a monotonic arena owned by the map
+};
+
+// Monotonic arena for gene containers. Copying a map gives the copy its own
+// empty arena (copied genes live on the heap); moving transfers it.
+class GeneArena {
+public:
+    GeneArena() = default;
+    GeneArena(const GeneArena&) {}
+    GeneArena& operator=(const GeneArena&) { return *this; }
+    GeneArena(GeneArena&&) noexcept = default;
+    // Swaps, so the old arena outlives the genes still being destroyed in
+    // the assignment that follows it in AlignmentMap's member order.
+    GeneArena& operator=(GeneArena&& other) noexcept { resource_.swap(other.resource_); return *this; }
+
+    std::pmr::memory_resource* resource();
+    // Frees every block at once; all containers using it must be gone.
+    void release();
+    // Bytes obtained from the heap so far.
+    size_t reservedBytes() const;
+
+private:
+    struct Resource;
+    std::unique_ptr<Resource, void (*)(Resource*)> resource_{nullptr, nullptr};
+};
+
+//-----------------------------------------------------------------------------
+// Batch import
+//-----------------------------------------------------------------------------
+
+enum class GeneFileFormat { Unknown, CSV, JSON };
+
+// Format from the first bytes of a file: an object or array is JSON, a first
+// line with a comma is CSV. Leading whitespace and a UTF-8 BOM are skipped.
+GeneFileFormat sniffGeneFileFormat(std::string_view head);
+
+// Outcome of importing one file.
+struct GeneFileImport {
+    std::string path;
+    GeneFileFormat format = GeneFileFormat::Unknown;
+    size_t genesLoaded = 0;
+    double milliseconds = 0.0;         // read and parse time
+    std::string error;                 // why the file could not be imported
+    std::vector<std::string> warnings; // records that were skipped
+    bool ok() const { return error.empty(); }
+};
+
+struct BatchImportReport {
+    std::vector<GeneFileImport> files; // in import order
+    size_t genesLoaded = 0;
+    double milliseconds = 0.0;         // wall time for the whole batch
+    size_t failedFiles() const;
+};
+
 class AlignmentMap {
 public:
     void addGene(const GeneModel& g);
+    void addGene(GeneModel&& g);
     const std::vector<GeneModel>& getGenes() const;
+
+    // Bulk-load mode. In Arena mode, genes added afterwards keep their
+    // categories, tags and region maps in one monotonic arena, so loading is
+    // a pointer bump per element. clearGenes() still destroys every string
+    // and map node, which is O(nodes), but their deallocations are no-ops and
+    // the arena goes back in a few large frees.
+    void setGeneStorage(GeneStorage storage);
+    GeneStorage geneStorage() const;
+    void reserveGenes(size_t count);
+    // An empty gene whose containers use the current storage; loaders fill
+    // it and pass it to addGene(GeneModel&&) so nothing is copied.
+    GeneModel newGene();
+    // Removes every gene and releases the arena. Each gene is still destroyed,
+    // as its symbol and chromosome live on the heap in either mode.
+    void clearGenes();
+    size_t geneArenaBytes() const;
+
+    // Read-only, like every const member: several threads may call it at
+    // once as long as none of them modifies the map.
     GenomeStats calculateStatistics() const;
     void loadGenesFromCSV(const std::string& filename);
     void loadGenesFromJSON(const std::string& filename);
+    // Parses files concurrently on up to `threads` workers (0 = all cores),
+    // then appends their genes in the order given, so the result does not
+    // depend on the thread count. Each format is sniffed from the content,
+    // falling back to the extension. Nothing is printed: timings, skipped
+    // records and errors come back per file.
+    BatchImportReport importGeneFiles(const std::vector<std::string>& paths, unsigned threads = 0);
+    // Every regular, non-hidden file in `directory` (and below it when
+    // recursive), in path order.
+    BatchImportReport importGeneDirectory(const std::string& directory, bool recursive = false, unsigned threads = 0);
     void toggleKnockout(const std::string& symbol);
+    // Sets the polygenic score of every gene whose symbol is in `symbols`
+    // (scores[i] belongs to symbols[i]); other genes keep theirs. The
+    // statistics are rebuilt. @return Number of genes updated.
+    size_t setPolygenicScores(const std::vector<std::string>& symbols, const std::vector<double>& scores);
     void addPathway(const Pathway& p);
     const std::vector<Pathway>& getPathways() const;
     void addGeneSet(const GeneSet& gs);
     const std::vector<GeneSet>& getGeneSets() const;
 
+    // Inverted gene index: positions in getPathways() / getGeneSets() whose
+    // geneSymbols contain the given symbol (empty if none).
+    const std::vector<size_t>& getPathwaysForGene(const std::string& symbol) const;
+    const std::vector<size_t>& getGeneSetsForGene(const std::string& symbol) const;
+    const std::map<std::string, std::vector<size_t>>& getPathwayIndex() const;
+    const std::map<std::string, std::vector<size_t>>& getGeneSetIndex() const;
+
+    // Quantile sketches and top-K lists over expression, polygenic score and
+    // brain regions, updated by every addGene() and reset by clearGenes().
+    const ExpressionStatistics& expressionStatistics() const;
+
+    // Current and peak bytes for the "genes", "pathways", "geneSets" and
+    // "geneIndex" subsystems, kept up to date as records are added.
+    MemoryReport memoryReport() const;
+
 private:
+    // Declared before genes_ so it is destroyed after them.
+    GeneArena geneArena_;
+    GeneStorage geneStorage_ = GeneStorage::Heap;
     std::vector<GeneModel> genes_;
     std::vector<Pathway> pathways_;
     std::vector<GeneSet> geneSets_;
-    std::string makeTimestamp() const;
+    std::map<std::string, std::vector<size_t>> pathwayIndex_;
+    std::map<std::string, std::vector<size_t>> geneSetIndex_;
+    MemoryAccount geneMemory_, pathwayMemory_, geneSetMemory_, indexMemory_;
+    ExpressionStatistics expressionStats_;
+    // addGene without the statistics update, for callers that merge
+    // precomputed statistics.
+    void appendGene(GeneModel&& g);
 };
 
 AlignmentMap createDemoMap();
@@ -110,9 +246,23 @@ public:
 
     // Public for testing purposes
     const std::vector<SequenceModel>& getSequences() const;
+    int getCursorPos() const;
+    int getSelectedSeq() const;
+    const AlignmentBlock& getBlock() const;
+
+    // Sum-of-pairs and identity to the reference, updated with every edit.
+    const AlignmentScorer& getScorer() const;
+    void setScoringScheme(ScoringScheme scheme);
+
+    // Bytes held by the "alignment" block: reference plus sequences.
+    MemoryReport memoryReport() const;
 
 private:
     AlignmentBlock block_;
+    MemoryAccount blockMemory_;
+    AlignmentScorer scorer_;
+
+    void addSequence(SequenceModel seq);
 
     char complement(char base, SequenceType type) const;
 };
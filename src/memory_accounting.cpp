@@ -0,0 +1,90 @@
+#include "memory_accounting.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+// --- MemoryReport ---
+
+size_t MemoryReport::totalBytes() const {
+    size_t total = 0;
+    for (const auto& s : subsystems) total += s.currentBytes;
+    return total;
+}
+
+size_t MemoryReport::peakBytes() const {
+    size_t total = 0;
+    for (const auto& s : subsystems) total += s.peakBytes;
+    return total;
+}
+
+const SubsystemMemory* MemoryReport::find(const std::string& name) const {
+    for (const auto& s : subsystems) {
+        if (s.name == name) return &s;
+    }
+    return nullptr;
+}
+
+MemoryReport mergeMemoryReports(const MemoryReport& a, const MemoryReport& b) {
+    MemoryReport merged = a;
+    merged.subsystems.insert(merged.subsystems.end(), b.subsystems.begin(), b.subsystems.end());
+    return merged;
+}
+
+std::string formatBytes(size_t bytes) {
+    static const char* const units[] = {"B", "KB", "MB", "GB", "TB"};
+    double value = double(bytes);
+    int unit = 0;
+    while (value >= 1024.0 && unit < 4) {
+        value /= 1024.0;
+        ++unit;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << value << ' ' << units[unit];
+    return out.str();
+}
+
+std::string formatMemoryReport(const MemoryReport& report) {
+    std::ostringstream out;
+    for (const auto& s : report.subsystems) {
+        out << std::left << std::setw(14) << s.name << std::right
+            << std::setw(11) << formatBytes(s.currentBytes) << "  peak " << std::setw(11) << formatBytes(s.peakBytes)
+            << "  " << s.records << " records";
+        if (s.records) out << ", " << std::fixed << std::setprecision(1) << s.bytesPerRecord() << " B/record";
+        out << '\n';
+    }
+    out << std::left << std::setw(14) << "total" << std::right << std::setw(11) << formatBytes(report.totalBytes())
+        << "  peak " << std::setw(11) << formatBytes(report.peakBytes()) << '\n';
+    return out.str();
+}
+
+// --- MemoryAccount ---
+
+void MemoryAccount::add(size_t bytes, size_t records) {
+    current_ += bytes;
+    records_ += records;
+    peak_ = std::max(peak_, current_);
+}
+
+void MemoryAccount::release(size_t bytes, size_t records) {
+    current_ -= std::min(current_, bytes);
+    records_ -= std::min(records_, records);
+}
+
+void MemoryAccount::resize(size_t before, size_t after) {
+    if (after >= before) add(after - before);
+    else release(before - after);
+}
+
+void MemoryAccount::reset() {
+    current_ = 0;
+    records_ = 0;
+}
+
+SubsystemMemory MemoryAccount::snapshot(const std::string& name) const {
+    SubsystemMemory s;
+    s.name = name;
+    s.currentBytes = current_;
+    s.peakBytes = peak_;
+    s.records = records_;
+    return s;
+}
@@ -0,0 +1,90 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Per-subsystem memory accounting
+//-----------------------------------------------------------------------------
+
+struct SubsystemMemory {
+    std::string name;
+    size_t currentBytes = 0;
+    size_t peakBytes    = 0;
+    size_t records      = 0;
+    double bytesPerRecord() const { return records ? double(currentBytes) / double(records) : 0.0; }
+};
+
+struct MemoryReport {
+    std::vector<SubsystemMemory> subsystems;
+    size_t totalBytes() const;
+    // Sum of subsystem peaks: an upper bound, since peaks need not coincide.
+    size_t peakBytes() const;
+    const SubsystemMemory* find(const std::string& name) const;
+};
+
+// Appends the subsystems of `other` (e.g. to combine map and editor reports).
+MemoryReport mergeMemoryReports(const MemoryReport& a, const MemoryReport& b);
+
+// One line per subsystem plus a total, with human-readable sizes.
+std::string formatMemoryReport(const MemoryReport& report);
+// "12.3 MB" style size.
+std::string formatBytes(size_t bytes);
+
+// Running totals for one subsystem, updated by the owner at every mutation.
+// Counts are plain integers: accounting costs a few additions per record,
+// so it stays on in production builds.
+class MemoryAccount {
+public:
+    void add(size_t bytes, size_t records = 0);
+    void release(size_t bytes, size_t records = 0);
+    // For an in-place change from `before` to `after` bytes.
+    void resize(size_t before, size_t after);
+    void reset();
+    SubsystemMemory snapshot(const std::string& name) const;
+
+private:
+    size_t current_ = 0;
+    size_t peak_    = 0;
+    size_t records_ = 0;
+};
+
+//-----------------------------------------------------------------------------
+// Footprint estimates for standard containers
+//-----------------------------------------------------------------------------
+// These inspect capacities rather than hooking the allocator, so they are
+// exact for the owned payload and approximate only the allocator's own
+// per-block bookkeeping (not counted) and tree-node headers (counted as
+// four pointers, as in the common red-black tree layouts).
+
+constexpr size_t kTreeNodeOverhead = 4 * sizeof(void*);
+
+// Heap bytes behind a string; zero while it fits the small-string buffer.
+// Allocator-generic so std::pmr containers are measured the same way.
+template <typename Alloc>
+size_t heapBytes(const std::basic_string<char, std::char_traits<char>, Alloc>& s) {
+    static const size_t inlineCapacity = std::basic_string<char, std::char_traits<char>, Alloc>().capacity();
+    return s.capacity() > inlineCapacity ? s.capacity() + 1 : 0;
+}
+
+inline size_t heapBytes(double) { return 0; }
+inline size_t heapBytes(size_t) { return 0; }
+
+template <typename T, typename Alloc>
+size_t heapBytes(const std::vector<T, Alloc>& v) {
+    size_t bytes = v.capacity() * sizeof(T);
+    for (const auto& item : v) bytes += heapBytes(item);
+    return bytes;
+}
+
+template <typename K, typename V, typename Compare, typename Alloc>
+size_t heapBytes(const std::map<K, V, Compare, Alloc>& m) {
+    size_t bytes = m.size() * (kTreeNodeOverhead + sizeof(typename std::map<K, V, Compare, Alloc>::value_type));
+    for (const auto& kv : m) bytes += heapBytes(kv.first) + heapBytes(kv.second);
+    return bytes;
+}
+
+#endif // MEMORY_ACCOUNTING_H
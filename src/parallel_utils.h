@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Minimal fork/join helpers shared by the analysis modules
+//-----------------------------------------------------------------------------
+
+// Number of worker threads to use when the caller passes 0.
+inline unsigned defaultThreadCount() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// Splits [0, count) into chunks of at most `grain` items and calls
+// fn(begin, end) for each chunk on up to `threads` workers (0 = all cores).
+// The calling thread participates; the first exception thrown by a chunk is
+// rethrown once all workers have joined.
+template <typename Fn>
+void parallelFor(size_t count, size_t grain, Fn&& fn, unsigned threads = 0) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    size_t chunks = (count + grain - 1) / grain;
+    unsigned workers = threads == 0 ? defaultThreadCount() : threads;
+    workers = unsigned(std::min<size_t>(workers, chunks));
+
+    if (workers <= 1) {
+        for (size_t b = 0; b < count; b += grain) fn(b, std::min(count, b + grain));
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&]() {
+        for (size_t c = next++; c < chunks; c = next++) {
+            size_t b = c * grain;
+            try {
+                fn(b, std::min(count, b + grain));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                next = chunks; // stop handing out work
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned i = 1; i < workers; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
+// A fixed team of worker threads for many short fork/join rounds, such as the
+// iterations of a simulation, which would otherwise start threads each round.
+// parallelFor() has the same contract as the free function; rounds from
+// different threads must not overlap.
+class ForkJoinPool {
+public:
+    // @param threads Total workers including the calling thread (0 = all cores).
+    explicit ForkJoinPool(unsigned threads = 0) {
+        unsigned workers = threads == 0 ? defaultThreadCount() : threads;
+        for (unsigned i = 1; i < workers; ++i) threads_.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ForkJoinPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    ForkJoinPool(const ForkJoinPool&) = delete;
+    ForkJoinPool& operator=(const ForkJoinPool&) = delete;
+
+    template <typename Fn>
+    void parallelFor(size_t count, size_t grain, Fn&& fn) {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+        size_t chunks = (count + grain - 1) / grain;
+        if (threads_.empty() || chunks == 1) {
+            for (size_t b = 0; b < count; b += grain) fn(b, std::min(count, b + grain));
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = [&fn](size_t begin, size_t end) { fn(begin, end); };
+            count_ = count;
+            grain_ = grain;
+            chunks_ = chunks;
+            next_ = 0;
+            error_ = nullptr;
+            active_ = unsigned(threads_.size());
+            ++round_;
+        }
+        wake_.notify_all();
+        runChunks();
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return active_ == 0; });
+        job_ = nullptr;
+        if (error_) std::rethrow_exception(error_);
+    }
+
+private:
+    void workerLoop() {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stop_ || round_ != seen; });
+                if (stop_) return;
+                seen = round_;
+            }
+            runChunks();
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--active_ == 0) done_.notify_one();
+        }
+    }
+
+    // Every round waits for all workers, so job_ and the bounds are stable here.
+    void runChunks() {
+        for (size_t c = next_++; c < chunks_; c = next_++) {
+            size_t b = c * grain_;
+            try {
+                job_(b, std::min(count_, b + grain_));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) error_ = std::current_exception();
+                next_ = chunks_; // stop handing out work
+            }
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wake_, done_;
+    bool stop_ = false;
+    uint64_t round_ = 0;
+    unsigned active_ = 0;
+    std::function<void(size_t, size_t)> job_;
+    size_t count_ = 0, grain_ = 1, chunks_ = 0;
+    std::atomic<size_t> next_{0};
+    std::exception_ptr error_;
+};
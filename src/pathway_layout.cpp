@@ -0,0 +1,380 @@
+#include "pathway_layout.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+// --- Private Helper Functions ---
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+// Barnes-Hut quadtree over the current node positions. Children are created
+// lazily; points that still coincide at the depth limit share one leaf.
+class QuadTree {
+public:
+    QuadTree(const std::vector<LayoutPoint>& pts) : pts_(pts) {
+        double minX = pts[0].x, maxX = pts[0].x, minY = pts[0].y, maxY = pts[0].y;
+        for (const auto& p : pts) {
+            minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        }
+        Node root;
+        root.cx = (minX + maxX) / 2;
+        root.cy = (minY + maxY) / 2;
+        root.half = std::max(maxX - minX, maxY - minY) / 2 + 1e-6;
+        nodes_.reserve(pts.size() * 2);
+        nodes_.push_back(root);
+        for (int i = 0; i < int(pts.size()); ++i) insert(i);
+    }
+
+    // Accumulates the repulsive force k^2 / d acting on point i.
+    void repulsion(int i, double k2, double theta, double& fx, double& fy) const {
+        const LayoutPoint& p = pts_[i];
+        int stack[128];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& n = nodes_[stack[--top]];
+            if (n.mass == 0 || n.point == i) continue;
+            double dx = p.x - n.mx, dy = p.y - n.my;
+            double d2 = dx * dx + dy * dy;
+            bool leaf = n.child[0] < 0 && n.child[1] < 0 && n.child[2] < 0 && n.child[3] < 0;
+            if (leaf || (!contains(n, p) && (4 * n.half * n.half) < theta * theta * d2)) {
+                double mass = n.mass - (leaf && n.point == -2 && contains(n, p) ? 1 : 0);
+                if (mass <= 0) continue;
+                if (d2 < 1e-12) {
+                    // Coincident: nudge deterministically by index.
+                    double a = 2.399963 * i;
+                    fx += std::cos(a) * 1e-2;
+                    fy += std::sin(a) * 1e-2;
+                    continue;
+                }
+                double f = k2 * mass / d2; // (k^2 / d) * (dx / d)
+                fx += dx * f;
+                fy += dy * f;
+                continue;
+            }
+            for (int c : n.child) {
+                if (c >= 0 && top < 128) stack[top++] = c;
+            }
+        }
+    }
+
+private:
+    struct Node {
+        double cx = 0, cy = 0, half = 0; // square bounds
+        double mx = 0, my = 0, mass = 0; // centre of mass
+        int child[4] = {-1, -1, -1, -1};
+        int point = -1;                  // single point index, -2 = several
+        int depth = 0;
+    };
+
+    const std::vector<LayoutPoint>& pts_;
+    std::vector<Node> nodes_;
+
+    static bool contains(const Node& n, const LayoutPoint& p) {
+        return std::abs(p.x - n.cx) <= n.half && std::abs(p.y - n.cy) <= n.half;
+    }
+
+    int quadrant(const Node& n, const LayoutPoint& p) const {
+        return (p.x >= n.cx ? 1 : 0) + (p.y >= n.cy ? 2 : 0);
+    }
+
+    int childFor(int ni, int q) {
+        if (nodes_[ni].child[q] >= 0) return nodes_[ni].child[q];
+        Node c;
+        const Node& n = nodes_[ni];
+        c.half = n.half / 2;
+        c.cx = n.cx + ((q & 1) ? c.half : -c.half);
+        c.cy = n.cy + ((q & 2) ? c.half : -c.half);
+        c.depth = n.depth + 1;
+        nodes_.push_back(c);
+        int idx = int(nodes_.size()) - 1;
+        nodes_[ni].child[q] = idx;
+        return idx;
+    }
+
+    void addMass(Node& n, const LayoutPoint& p) {
+        n.mx = (n.mx * n.mass + p.x) / (n.mass + 1);
+        n.my = (n.my * n.mass + p.y) / (n.mass + 1);
+        n.mass += 1;
+    }
+
+    void insert(int i) {
+        const LayoutPoint& p = pts_[i];
+        int ni = 0;
+        while (true) {
+            Node& n = nodes_[ni];
+            bool leaf = n.child[0] < 0 && n.child[1] < 0 && n.child[2] < 0 && n.child[3] < 0;
+            if (leaf && n.mass == 0) {
+                n.point = i;
+                addMass(n, p);
+                return;
+            }
+            if (leaf && (n.depth >= 40 || n.point == -2)) {
+                n.point = -2;
+                addMass(n, p);
+                return;
+            }
+            if (leaf) {
+                // Split: push the resident point one level down.
+                int resident = n.point;
+                n.point = -1;
+                int q = quadrant(n, pts_[resident]);
+                int c = childFor(ni, q);
+                nodes_[c].point = resident;
+                addMass(nodes_[c], pts_[resident]);
+            }
+            addMass(nodes_[ni], p);
+            ni = childFor(ni, quadrant(nodes_[ni], p));
+        }
+    }
+};
+
+uint64_t fnv1a(uint64_t h, const std::string& s) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= 0xFF; // separator so ("ab","c") != ("a","bc")
+    h *= 1099511628211ULL;
+    return h;
+}
+
+} // namespace
+
+// --- Public Function Implementations ---
+
+uint64_t pathwayGraphVersion(const Pathway& pathway) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const auto& s : pathway.geneSymbols) h = fnv1a(h, s);
+    h = fnv1a(h, "->");
+    for (const auto& kv : pathway.interactions) {
+        h = fnv1a(h, kv.first);
+        for (const auto& t : kv.second) h = fnv1a(h, t);
+    }
+    return h;
+}
+
+PathwayLayout computePathwayLayout(
+    const Pathway& pathway,
+    const LayoutOptions& options,
+    const PathwayLayout* warm_start) {
+    PathwayLayout layout;
+    layout.graphVersion = pathwayGraphVersion(pathway);
+
+    // 1. Nodes and undirected, de-duplicated adjacency.
+    std::unordered_map<std::string, int> ids;
+    auto nodeFor = [&](const std::string& s) {
+        auto it = ids.find(s);
+        if (it != ids.end()) return it->second;
+        int id = int(layout.symbols.size());
+        ids.emplace(s, id);
+        layout.symbols.push_back(s);
+        return id;
+    };
+    for (const auto& s : pathway.geneSymbols) nodeFor(s);
+    std::set<std::pair<int, int>> edgeSet;
+    for (const auto& kv : pathway.interactions) {
+        int a = nodeFor(kv.first);
+        for (const auto& t : kv.second) {
+            int b = nodeFor(t);
+            if (a != b) edgeSet.insert({std::min(a, b), std::max(a, b)});
+        }
+    }
+    const int n = int(layout.symbols.size());
+    std::vector<std::vector<int>> adj(n);
+    for (const auto& e : edgeSet) {
+        adj[e.first].push_back(e.second);
+        adj[e.second].push_back(e.first);
+    }
+    layout.positions.resize(n);
+    if (n == 0) return layout;
+
+    // 2. Initial positions: previous layout where possible, otherwise a circle.
+    const double k = 1.0;
+    const double radius = std::sqrt(double(n)) * k;
+    std::vector<char> placed(n, 0);
+    if (warm_start) {
+        std::unordered_map<std::string, LayoutPoint> prev;
+        for (size_t i = 0; i < warm_start->symbols.size() && i < warm_start->positions.size(); ++i)
+            prev[warm_start->symbols[i]] = warm_start->positions[i];
+        for (int i = 0; i < n; ++i) {
+            auto it = prev.find(layout.symbols[i]);
+            if (it != prev.end()) { layout.positions[i] = it->second; placed[i] = 1; }
+        }
+    }
+    bool warm = std::any_of(placed.begin(), placed.end(), [](char c) { return c != 0; });
+    for (int i = 0; i < n; ++i) {
+        if (placed[i]) continue;
+        double a = 2 * kPi * i / n;
+        LayoutPoint p{radius * std::cos(a), radius * std::sin(a)};
+        int neighbours = 0;
+        LayoutPoint sum;
+        for (int j : adj[i]) {
+            if (!placed[j]) continue;
+            sum.x += layout.positions[j].x;
+            sum.y += layout.positions[j].y;
+            ++neighbours;
+        }
+        if (neighbours > 0) {
+            // Next to the placed neighbours, offset along a golden-angle spiral.
+            p.x = sum.x / neighbours + 0.5 * k * std::cos(2.399963 * i);
+            p.y = sum.y / neighbours + 0.5 * k * std::sin(2.399963 * i);
+        }
+        layout.positions[i] = p;
+    }
+
+    // 3. Fruchterman-Reingold iterations with linear cooling.
+    const int iterations = warm ? options.warmIterations : options.iterations;
+    const double t0 = warm ? k : radius / 2;
+    std::vector<LayoutPoint> disp(n);
+    // One team of threads for all iterations; each iteration is a short round.
+    size_t chunks = (size_t(n) + 63) / 64;
+    unsigned threads = options.threads == 0 ? defaultThreadCount() : options.threads;
+    ForkJoinPool pool(unsigned(std::min<size_t>(threads, chunks)));
+    for (int it = 0; it < iterations; ++it) {
+        double temp = t0 * (1.0 - double(it) / iterations) + 1e-3;
+        QuadTree tree(layout.positions);
+        pool.parallelFor(size_t(n), 64, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                double fx = 0, fy = 0;
+                tree.repulsion(int(i), k * k, options.theta, fx, fy);
+                const LayoutPoint& p = layout.positions[i];
+                for (int j : adj[i]) {
+                    double dx = p.x - layout.positions[j].x;
+                    double dy = p.y - layout.positions[j].y;
+                    double d = std::sqrt(dx * dx + dy * dy);
+                    fx -= dx * d / k; // (d^2 / k) * (dx / d)
+                    fy -= dy * d / k;
+                }
+                disp[i] = {fx, fy};
+            }
+        });
+        for (int i = 0; i < n; ++i) {
+            double len = std::sqrt(disp[i].x * disp[i].x + disp[i].y * disp[i].y);
+            if (len < 1e-12) continue;
+            double step = std::min(len, temp);
+            layout.positions[i].x += disp[i].x / len * step;
+            layout.positions[i].y += disp[i].y / len * step;
+        }
+    }
+    layout.iterations = iterations;
+    return layout;
+}
+
+const PathwayLayout& PathwayLayoutCache::get(const Pathway& pathway, const LayoutOptions& options) {
+    // A synchronous layout supersedes any background one for this pathway.
+    auto job = pending_.find(pathway.name);
+    if (job != pending_.end()) {
+        retired_.push_back(std::move(job->second.result));
+        pending_.erase(job);
+    }
+    uint64_t version = pathwayGraphVersion(pathway);
+    auto it = layouts_.find(pathway.name);
+    if (it != layouts_.end() && it->second.graphVersion == version) return it->second;
+    if (it == layouts_.end()) {
+        return layouts_[pathway.name] = computePathwayLayout(pathway, options);
+    }
+    PathwayLayout updated = computePathwayLayout(pathway, options, &it->second);
+    it->second = std::move(updated);
+    return it->second;
+}
+
+const PathwayLayout* PathwayLayoutCache::tryGet(const Pathway& pathway, const LayoutOptions& options) {
+    collectFinished();
+    uint64_t version = pathwayGraphVersion(pathway);
+    auto it = layouts_.find(pathway.name);
+    const PathwayLayout* previous = it != layouts_.end() ? &it->second : nullptr;
+    if (previous && previous->graphVersion == version) return previous;
+
+    auto job = pending_.find(pathway.name);
+    if (job == pending_.end() || job->second.version != version) {
+        // The task works on copies, so the caller may change or drop the pathway meanwhile.
+        // A task for an outdated version is left to finish; its result is replaced.
+        std::optional<PathwayLayout> warm;
+        if (previous) warm = *previous;
+        Pending next;
+        next.version = version;
+        next.result = std::async(std::launch::async, [pathway, options, warm = std::move(warm)] {
+            return computePathwayLayout(pathway, options, warm ? &*warm : nullptr);
+        });
+        if (job != pending_.end()) retired_.push_back(std::move(job->second.result));
+        pending_[pathway.name] = std::move(next);
+    }
+    return previous;
+}
+
+size_t PathwayLayoutCache::pending() const {
+    return pending_.size();
+}
+
+void PathwayLayoutCache::collectFinished() {
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (it->second.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        layouts_[it->first] = it->second.result.get();
+        it = pending_.erase(it);
+    }
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(), [](std::future<PathwayLayout>& f) {
+        return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), retired_.end());
+}
+
+void PathwayLayoutCache::clear() {
+    layouts_.clear();
+    // Results of running tasks are dropped; their futures still join in the destructor.
+    for (auto& kv : pending_) retired_.push_back(std::move(kv.second.result));
+    pending_.clear();
+}
+
+size_t PathwayLayoutCache::size() const {
+    return layouts_.size();
+}
+
+std::vector<GridPlacement> projectLayoutToGrid(const PathwayLayout& layout, int width, int height) {
+    std::vector<GridPlacement> out;
+    const int n = int(layout.positions.size());
+    if (n == 0 || width <= 0 || height <= 0) return out;
+
+    double minX = layout.positions[0].x, maxX = minX, minY = layout.positions[0].y, maxY = minY;
+    size_t maxLabel = 0;
+    for (int i = 0; i < n; ++i) {
+        minX = std::min(minX, layout.positions[i].x); maxX = std::max(maxX, layout.positions[i].x);
+        minY = std::min(minY, layout.positions[i].y); maxY = std::max(maxY, layout.positions[i].y);
+        maxLabel = std::max(maxLabel, layout.symbols[i].size() + 2);
+    }
+    int usableW = std::max(1, width - int(maxLabel));
+    double spanX = std::max(maxX - minX, 1e-9), spanY = std::max(maxY - minY, 1e-9);
+
+    // Occupied label cells per row, to shift colliding labels up or down.
+    std::vector<std::vector<char>> used(height, std::vector<char>(width, 0));
+    auto fits = [&](int x, int y, int len) {
+        for (int c = std::max(0, x - 1); c < std::min(width, x + len + 1); ++c)
+            if (used[y][c]) return false;
+        return true;
+    };
+
+    out.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        int len = int(layout.symbols[i].size()) + 2;
+        int x = int(std::lround((layout.positions[i].x - minX) / spanX * (usableW - 1)));
+        int y = int(std::lround((layout.positions[i].y - minY) / spanY * (height - 1)));
+        int chosen = y;
+        for (int off = 0; off < height; ++off) {
+            if (y + off < height && fits(x, y + off, len)) { chosen = y + off; break; }
+            if (y - off >= 0 && fits(x, y - off, len)) { chosen = y - off; break; }
+        }
+        for (int c = x; c < std::min(width, x + len); ++c) used[chosen][c] = 1;
+        out.push_back({layout.symbols[i], x, chosen});
+    }
+    return out;
+}
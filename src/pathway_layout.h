@@ -0,0 +1,96 @@
+#ifndef PATHWAY_LAYOUT_H
+#define PATHWAY_LAYOUT_H
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Force-directed pathway layout
+//-----------------------------------------------------------------------------
+
+struct LayoutPoint {
+    double x = 0.0;
+    double y = 0.0;
+};
+
+struct PathwayLayout {
+    std::vector<std::string> symbols;   // node order
+    std::vector<LayoutPoint> positions; // parallel to symbols
+    uint64_t graphVersion = 0;          // pathwayGraphVersion() of the laid-out pathway
+    int iterations = 0;                 // force iterations spent on the last (re)layout
+};
+
+struct LayoutOptions {
+    int      iterations     = 300;  // cold start
+    int      warmIterations = 60;   // warm start from a previous layout
+    double   theta          = 0.8;  // Barnes-Hut opening angle (0 = exact)
+    unsigned threads        = 0;    // 0 = all cores
+};
+
+// Structural hash of a pathway's nodes and edges; changes whenever a gene or
+// interaction is added or removed.
+uint64_t pathwayGraphVersion(const Pathway& pathway);
+
+// Fruchterman-Reingold layout with Barnes-Hut approximated repulsion. Forces
+// for each iteration are accumulated in parallel over nodes, by one team of
+// threads that lives for the whole call. When `warm_start`
+// is given, nodes it already contains keep their positions and new nodes are
+// seeded next to their placed neighbours, so only a short, cool relaxation runs.
+//
+// @param pathway The pathway to lay out (nodes: geneSymbols plus interaction endpoints).
+// @param options Iteration counts, opening angle and threads.
+// @param warm_start Optional previous layout of the same pathway.
+// @return Positions in an abstract unit square-ish coordinate space.
+PathwayLayout computePathwayLayout(
+    const Pathway& pathway,
+    const LayoutOptions& options = {},
+    const PathwayLayout* warm_start = nullptr);
+
+// Per-pathway layout cache keyed by pathway name and graph version. A lookup
+// with an unchanged graph is free; a changed graph is re-laid out warm.
+// Not thread-safe: one thread calls every member.
+class PathwayLayoutCache {
+public:
+    // Lays out the pathway on the calling thread if the cache is out of date.
+    const PathwayLayout& get(const Pathway& pathway, const LayoutOptions& options = {});
+    // Never blocks: if the cache is out of date, starts a background layout
+    // (at most one per pathway and version) and returns the previous layout
+    // of this pathway, or nullptr if there is none yet. Call again, e.g. on
+    // the next frame, to pick up the result.
+    const PathwayLayout* tryGet(const Pathway& pathway, const LayoutOptions& options = {});
+    // Background layouts not yet picked up by tryGet().
+    size_t pending() const;
+    void clear();
+    size_t size() const;
+
+private:
+    struct Pending {
+        uint64_t version = 0;
+        std::future<PathwayLayout> result;
+    };
+
+    std::map<std::string, PathwayLayout> layouts_;
+    std::map<std::string, Pending> pending_;
+    std::vector<std::future<PathwayLayout>> retired_; // superseded tasks, joined when done
+    void collectFinished();
+};
+
+//-----------------------------------------------------------------------------
+// Terminal projection
+//-----------------------------------------------------------------------------
+
+struct GridPlacement {
+    std::string symbol;
+    int x = 0; // column of the label's opening bracket
+    int y = 0; // row
+};
+
+// Scales a layout into a width x height character grid, leaving room for
+// "[SYMBOL]" labels and nudging labels vertically to avoid overlaps.
+std::vector<GridPlacement> projectLayoutToGrid(const PathwayLayout& layout, int width, int height);
+
+#endif // PATHWAY_LAYOUT_H
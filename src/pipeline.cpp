@@ -0,0 +1,491 @@
+#include "pipeline.h"
+#include "coexpression.h"
+#include "distance_matrix.h"
+#include "exporters.h"
+#include "gene_clustering.h"
+#include "gene_query.h"
+#include "parallel_utils.h"
+#include "polygenic_score.h"
+#include "shared_gene_store.h"
+#include "trace.h"
+#include "variant_extraction.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// What a command touches, for grouping commands into concurrent stages.
+enum Resource : unsigned { Genes = 1, Sequences = 2 };
+
+struct CommandSpec {
+    const char* verb;
+    size_t minArgs, maxArgs;
+    unsigned reads, writes;
+    bool restOfLine; // the remainder of the line is one argument
+};
+
+constexpr size_t kMany = size_t(-1);
+
+const CommandSpec kCommands[] = {
+    {"load genes",       1, kMany, 0,         Genes,     false},
+    {"load sequences",   1, 1,     0,         Sequences, false},
+    {"demo sequences",   0, 0,     0,         Sequences, false},
+    {"knockout",         1, 1,     0,         Genes,     false},
+    {"score polygenic",  2, 3,     0,         Genes,     false},
+    {"stats",            0, 0,     Genes,     0,         false},
+    {"query",            1, 1,     Genes,     0,         true},
+    {"top expression",   1, 1,     Genes,     0,         false},
+    {"top polygenic",    1, 1,     Genes,     0,         false},
+    {"top region",       2, 2,     Genes,     0,         false},
+    {"coexpression pearson",  2, 3, Genes,    0,         false},
+    {"coexpression spearman", 2, 3, Genes,    0,         false},
+    {"cluster average",  1, 2,     0,         Genes,     false},
+    {"cluster complete", 1, 2,     0,         Genes,     false},
+    {"cluster ward",     1, 2,     0,         Genes,     false},
+    {"seq select",       1, 1,     0,         Sequences, false},
+    {"seq cursor",       1, 1,     0,         Sequences, false},
+    {"seq gap",          0, 0,     0,         Sequences, false},
+    {"seq revcomp",      0, 0,     0,         Sequences, false},
+    {"seq edit",         1, 1,     0,         Sequences, false},
+    {"seq show",         0, 0,     Sequences, 0,         false},
+    {"seq score",        0, 0,     Sequences, 0,         false},
+    {"seq variants",     0, 0,     Sequences, 0,         false},
+    {"seq distances",    0, 1,     Sequences, 0,         false},
+    {"export genes",     1, 1,     Genes,     0,         false},
+    {"export sequences", 1, 1,     Sequences, 0,         false},
+    {"export shared",    1, 1,     Genes,     0,         false},
+    {"export variants",  1, 1,     Sequences, 0,         false},
+    {"export distances", 1, 2,     Sequences, 0,         false},
+};
+
+const CommandSpec& specOf(const std::string& verb) {
+    for (const auto& spec : kCommands) {
+        if (verb == spec.verb) return spec;
+    }
+    throw std::logic_error("pipeline: no spec for " + verb);
+}
+
+std::vector<std::string> splitWords(const std::string& text) {
+    std::vector<std::string> words;
+    std::istringstream in(text);
+    for (std::string w; in >> w;) words.push_back(w);
+    return words;
+}
+
+// Thrown by a command to report a failure in its output block.
+struct CommandError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+size_t parseCount(const std::string& text, const char* what) {
+    size_t value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+        throw CommandError(std::string("invalid ") + what + ": " + text);
+    }
+    return value;
+}
+
+std::string formatNumber(double value) {
+    std::ostringstream s;
+    s << value;
+    return s.str();
+}
+
+// State shared by the commands of one run. The query engine indexes new
+// genes lazily and is not safe for concurrent use, so commands that use it
+// take `cacheMutex`.
+struct PipelineContext {
+    AlignmentMap& map;
+    AlignmentEditor& editor;
+    GeneQueryEngine engine;
+    std::mutex cacheMutex;
+
+    PipelineContext(AlignmentMap& m, AlignmentEditor& e) : map(m), editor(e), engine(m) {}
+};
+
+void printImport(std::ostringstream& out, const BatchImportReport& report, size_t& failures) {
+    for (const auto& file : report.files) {
+        out << "  " << file.path << ": ";
+        if (file.ok()) out << file.genesLoaded << " genes";
+        else out << "error: " << file.error;
+        if (!file.warnings.empty()) out << ", " << file.warnings.size() << " records skipped";
+        out << '\n';
+    }
+    failures += report.failedFiles();
+}
+
+void printRanked(std::ostringstream& out, const std::vector<RankedGene>& genes) {
+    for (const auto& g : genes) out << "  " << g.symbol << ' ' << formatNumber(g.value) << '\n';
+}
+
+void requireSequences(const AlignmentEditor& editor) {
+    if (editor.getSequences().empty()) throw CommandError("no sequences loaded");
+}
+
+DistanceMeasure distanceArgument(const std::vector<std::string>& args, size_t index) {
+    DistanceMeasure measure = DistanceMeasure::PDistance;
+    if (args.size() > index && !parseDistanceMeasure(args[index], measure)) {
+        throw CommandError("unknown distance: " + args[index] + " (identity, p or jc)");
+    }
+    return measure;
+}
+
+// Runs one command, writing its result lines to `out`.
+void execute(const PipelineCommand& cmd, PipelineContext& ctx, std::ostringstream& out) {
+    TRACE_SCOPE("pipeline command");
+    const auto& a = cmd.args;
+    const std::string& v = cmd.verb;
+    AlignmentMap& map = ctx.map;
+    AlignmentEditor& editor = ctx.editor;
+
+    if (v == "load genes") {
+        size_t failures = 0;
+        std::vector<std::string> files;
+        for (const auto& path : a) {
+            std::error_code ec;
+            if (std::filesystem::is_directory(path, ec)) printImport(out, map.importGeneDirectory(path), failures);
+            else files.push_back(path);
+        }
+        if (!files.empty()) printImport(out, map.importGeneFiles(files), failures);
+        out << "  total genes: " << map.getGenes().size() << '\n';
+        if (failures) throw CommandError(std::to_string(failures) + " files could not be imported");
+    } else if (v == "load sequences") {
+        std::ifstream probe(a[0], std::ios::binary);
+        if (!probe) throw CommandError("could not open " + a[0]);
+        char head[512];
+        probe.read(head, sizeof head);
+        size_t before = editor.getSequences().size();
+        if (sniffGeneFileFormat(std::string_view(head, size_t(probe.gcount()))) == GeneFileFormat::JSON) {
+            editor.loadSequencesFromJSON(a[0]);
+        } else {
+            editor.loadSequencesFromCSV(a[0]);
+        }
+        out << "  sequences loaded: " << editor.getSequences().size() - before << '\n';
+    } else if (v == "demo sequences") {
+        editor.loadDemoDNA();
+        out << "  sequences: " << editor.getSequences().size() << '\n';
+    } else if (v == "knockout") {
+        auto& genes = map.getGenes();
+        auto it = std::find_if(genes.begin(), genes.end(), [&](const GeneModel& g) { return g.symbol == a[0]; });
+        if (it == genes.end()) throw CommandError("no gene " + a[0]);
+        map.toggleKnockout(a[0]);
+        out << "  " << a[0] << (it->isKnockout ? " knocked out" : " restored") << '\n';
+    } else if (v == "score polygenic") {
+        PolygenicScoreReport report = scorePolygenic(PolygenicWeights::load(a[0]), a[1]);
+        size_t updated = applyPolygenicScores(report, map);
+        {
+            // Scores changed in place, which the incremental index cannot see.
+            std::lock_guard<std::mutex> lock(ctx.cacheMutex);
+            ctx.engine.rebuild();
+        }
+        out << "  variants: " << report.variantsRead << " read, " << report.variantsScored << " scored\n"
+            << "  samples: " << report.samples.size() << ", missing dosages: " << report.missingDosages << '\n'
+            << "  genes updated: " << updated << '\n';
+        if (report.malformedRows) out << "  malformed rows skipped: " << report.malformedRows << '\n';
+        if (a.size() > 2) {
+            if (!writeSampleScoresCSV(report, a[2])) throw CommandError("could not write " + a[2]);
+            out << "  wrote sample scores to " << a[2] << '\n';
+        }
+    } else if (v == "stats") {
+        GenomeStats s = map.calculateStatistics();
+        out << "  genes: " << s.totalGenes << '\n'
+            << "  knockouts: " << s.totalKnockouts << '\n'
+            << "  mean expression: " << formatNumber(s.avgExpression) << '\n'
+            << "  median expression: " << formatNumber(s.medianExpression) << '\n'
+            << "  p99 expression: " << formatNumber(s.p99Expression) << '\n'
+            << "  mean polygenic score: " << formatNumber(s.avgPolyScore) << '\n';
+    } else if (v == "query") {
+        GeneQuery query = parseGeneQuery(a[0]);
+        std::vector<std::string> symbols;
+        {
+            std::lock_guard<std::mutex> lock(ctx.cacheMutex);
+            symbols = ctx.engine.symbolsOf(ctx.engine.evaluate(query));
+        }
+        out << "  matches: " << symbols.size() << '\n';
+        for (const auto& s : symbols) out << "  " << s << '\n';
+    } else if (v == "top expression" || v == "top polygenic") {
+        const ExpressionStatistics& stats = map.expressionStatistics();
+        const TopK& top = v == "top expression" ? stats.topExpression : stats.topPolygenicScore;
+        size_t k = parseCount(a[0], "count");
+        if (k <= top.capacity()) {
+            printRanked(out, top.sorted(k));
+        } else if (v == "top expression") {
+            printRanked(out, selectTopGenes(map.getGenes(), k, [](const GeneModel& g) { return g.expressionLevel; }));
+        } else {
+            printRanked(out, selectTopGenes(map.getGenes(), k, [](const GeneModel& g) { return g.polygenicScore; }));
+        }
+    } else if (v == "top region") {
+        printRanked(out, selectTopGenesInRegion(map.getGenes(), parseCount(a[1], "count"), a[0]));
+    } else if (v == "coexpression pearson" || v == "coexpression spearman") {
+        CoexpressionOptions options;
+        parseCorrelationMethod(v.substr(v.find(' ') + 1), options.method);
+        if (a[0] == "top") {
+            options.topK = parseCount(a[1], "count");
+            options.minCorrelation = 0.0;
+        } else if (a[0] == "min") {
+            const std::string& text = a[1];
+            auto result = std::from_chars(text.data(), text.data() + text.size(), options.minCorrelation);
+            if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+                throw CommandError("invalid correlation: " + text);
+            }
+        } else {
+            throw CommandError("expected min <r> or top <k>, got " + a[0]);
+        }
+        CoexpressionNetwork network = buildCoexpressionNetwork(map.getGenes(), options);
+        out << "  genes: " << network.nodeCount() << " over " << network.regions.size() << " regions, "
+            << network.excludedGenes << " excluded\n"
+            << "  edges: " << network.edges.size() << '\n';
+        if (a.size() > 2) {
+            if (!writeCoexpressionEdgesCSV(network, a[2])) throw CommandError("could not write " + a[2]);
+            out << "  wrote edges to " << a[2] << '\n';
+        }
+    } else if (v == "cluster average" || v == "cluster complete" || v == "cluster ward") {
+        ClusteringOptions options;
+        parseLinkage(v.substr(v.find(' ') + 1), options.linkage);
+        size_t k = parseCount(a[0], "cluster count");
+        if (k == 0) throw CommandError("cluster count must be at least 1");
+        GeneDendrogram tree = clusterGenes(map.getGenes(), options);
+        if (tree.leafCount() == 0) throw CommandError("no genes with a brain-region profile");
+        std::vector<GeneSet> sets = clusterGeneSets(tree, k, linkageName(options.linkage));
+        for (const auto& set : sets) map.addGeneSet(set);
+        out << "  genes: " << tree.leafCount() << " clustered, " << tree.excludedGenes << " excluded\n";
+        for (const auto& set : sets) out << "  " << set.name << ": " << set.geneSymbols.size() << " genes\n";
+        if (a.size() > 1) {
+            if (!writeLinkageCSV(tree, a[1])) throw CommandError("could not write " + a[1]);
+            out << "  wrote linkage to " << a[1] << '\n';
+        }
+    } else if (v == "seq select") {
+        requireSequences(editor);
+        size_t index = parseCount(a[0], "sequence index");
+        if (index >= editor.getSequences().size()) throw CommandError("no sequence " + a[0]);
+        editor.selectSequence(int(index) - editor.getSelectedSeq());
+        out << "  selected: " << editor.getSequences()[index].name << '\n';
+    } else if (v == "seq cursor") {
+        requireSequences(editor);
+        size_t position = parseCount(a[0], "position");
+        editor.moveCursor(int(std::min<size_t>(position, 1u << 30)) - editor.getCursorPos());
+        out << "  cursor: " << editor.getCursorPos() << '\n';
+    } else if (v == "seq gap" || v == "seq revcomp" || v == "seq edit") {
+        requireSequences(editor);
+        if (v == "seq gap") editor.toggleGap();
+        else if (v == "seq revcomp") editor.reverseComplementSelected();
+        else if (a[0].size() != 1 || !std::isalpha(static_cast<unsigned char>(a[0][0]))) throw CommandError("invalid base: " + a[0]);
+        else editor.editSelectedBase(a[0][0]);
+        const SequenceModel& s = editor.getSequences()[size_t(editor.getSelectedSeq())];
+        out << "  " << s.name << ' ' << s.aligned << '\n';
+    } else if (v == "seq show") {
+        for (const auto& s : editor.getSequences()) out << "  " << s.name << ' ' << s.aligned << '\n';
+    } else if (v == "seq score") {
+        const AlignmentScorer& scorer = editor.getScorer();
+        out << "  sum-of-pairs: " << scorer.sumOfPairs() << '\n';
+        const auto& seqs = editor.getSequences();
+        for (size_t i = 0; i < seqs.size(); ++i) {
+            out << "  " << seqs[i].name << " identity: " << std::fixed << std::setprecision(1)
+                << scorer.identity(i) << "%\n" << std::defaultfloat;
+        }
+    } else if (v == "seq variants") {
+        VariantOptions options;
+        options.collectVariants = false;
+        VariantReport report = extractVariants(editor.getBlock(), options);
+        const auto& seqs = editor.getSequences();
+        for (size_t i = 0; i < seqs.size(); ++i) {
+            const SequenceVariantSummary& s = report.sequences[i];
+            out << "  " << seqs[i].name << " snv " << s.mismatches << " ins " << s.insertions << " (" << s.insertedBases
+                << " bp) del " << s.deletions << " (" << s.deletedBases << " bp)\n";
+        }
+    } else if (v == "seq distances") {
+        DistanceMeasure measure = distanceArgument(a, 0);
+        const auto& seqs = editor.getSequences();
+        DistanceMatrix matrix = computeDistanceMatrix(seqs);
+        for (size_t i = 0; i < seqs.size(); ++i) {
+            out << "  " << seqs[i].name;
+            for (size_t j = 0; j < seqs.size(); ++j) out << ' ' << formatNumber(matrix.value(i, j, measure));
+            out << '\n';
+        }
+    } else if (v == "export genes") {
+        ExportFormat format = exportFormatForPath(a[0]);
+        if (format == ExportFormat::FASTA) throw CommandError("genes export as .csv or .json");
+        if (!exportGenes(map, a[0], format)) throw CommandError("could not write " + a[0]);
+        out << "  wrote " << map.getGenes().size() << " genes to " << a[0] << '\n';
+    } else if (v == "export sequences") {
+        if (!exportSequences(editor.getSequences(), a[0], exportFormatForPath(a[0]))) {
+            throw CommandError("could not write " + a[0]);
+        }
+        out << "  wrote " << editor.getSequences().size() << " sequences to " << a[0] << '\n';
+    } else if (v == "export shared") {
+        if (!buildSharedGeneStore(map.getGenes(), a[0])) throw CommandError("could not write " + a[0]);
+        out << "  wrote shared store of " << map.getGenes().size() << " genes to " << a[0] << '\n';
+    } else if (v == "export variants") {
+        VariantReport report = extractVariants(editor.getBlock());
+        if (!writeVariantsCSV(report, editor.getBlock(), a[0])) throw CommandError("could not write " + a[0]);
+        out << "  wrote " << report.variants.size() << " variants to " << a[0] << '\n';
+    } else if (v == "export distances") {
+        DistanceMeasure measure = distanceArgument(a, 1);
+        const auto& seqs = editor.getSequences();
+        if (!writeDistanceMatrixCSV(computeDistanceMatrix(seqs), seqs, measure, a[0])) {
+            throw CommandError("could not write " + a[0]);
+        }
+        out << "  wrote " << seqs.size() << " x " << seqs.size() << ' ' << distanceMeasureName(measure)
+            << " matrix to " << a[0] << '\n';
+    }
+}
+
+// Writes finished results to the output in script order.
+class OrderedOutput {
+public:
+    OrderedOutput(std::ostream& out, size_t count) : out_(out), results_(count), done_(count, false) {}
+
+    void complete(size_t index, std::string text) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        results_[index] = std::move(text);
+        done_[index] = true;
+        bool wrote = false;
+        while (next_ < done_.size() && done_[next_]) {
+            out_ << results_[next_];
+            std::string().swap(results_[next_]);
+            ++next_;
+            wrote = true;
+        }
+        if (wrote) out_.flush();
+    }
+
+private:
+    std::ostream& out_;
+    std::vector<std::string> results_;
+    std::vector<bool> done_;
+    size_t next_ = 0;
+    std::mutex mutex_;
+};
+
+} // namespace
+
+std::vector<PipelineCommand> parsePipelineScript(std::istream& in) {
+    std::vector<PipelineCommand> script;
+    std::string line;
+    for (int lineNo = 1; std::getline(in, line); ++lineNo) {
+        std::string text = line.substr(0, line.find('#'));
+        if (!text.empty() && text.back() == '\r') text.pop_back();
+        std::vector<std::string> words = splitWords(text);
+        if (words.empty()) continue;
+
+        auto fail = [&](const std::string& message) {
+            throw std::invalid_argument("pipeline line " + std::to_string(lineNo) + ": " + message);
+        };
+        // Two-word verbs ("load genes") take precedence over one-word ones.
+        const CommandSpec* spec = nullptr;
+        size_t verbWords = 0;
+        for (const auto& candidate : kCommands) {
+            std::vector<std::string> verb = splitWords(candidate.verb);
+            if (verb.size() > words.size() || verb.size() <= verbWords) continue;
+            if (std::equal(verb.begin(), verb.end(), words.begin())) {
+                spec = &candidate;
+                verbWords = verb.size();
+            }
+        }
+        if (!spec) fail("unknown command '" + words[0] + "'");
+
+        PipelineCommand cmd;
+        cmd.line = lineNo;
+        cmd.verb = spec->verb;
+        text.erase(0, text.find_first_not_of(" \t"));
+        text.erase(text.find_last_not_of(" \t") + 1);
+        cmd.text = text;
+        if (spec->restOfLine) {
+            // Skip the verb's words, keeping the remainder verbatim.
+            size_t pos = 0;
+            for (size_t w = 0; w < verbWords; ++w) {
+                pos = text.find_first_not_of(" \t", pos);
+                pos = text.find_first_of(" \t", pos);
+            }
+            size_t start = pos == std::string::npos ? std::string::npos : text.find_first_not_of(" \t", pos);
+            if (start != std::string::npos) cmd.args.push_back(text.substr(start));
+        } else {
+            cmd.args.assign(words.begin() + std::ptrdiff_t(verbWords), words.end());
+        }
+        if (cmd.args.size() < spec->minArgs || cmd.args.size() > spec->maxArgs) {
+            fail("wrong number of arguments for '" + cmd.verb + "'");
+        }
+        if (cmd.verb == "query") {
+            try {
+                parseGeneQuery(cmd.args[0]);
+            } catch (const std::invalid_argument& e) {
+                fail(e.what());
+            }
+        }
+        script.push_back(std::move(cmd));
+    }
+    return script;
+}
+
+PipelineReport runPipeline(const std::vector<PipelineCommand>& script, AlignmentMap& map,
+                           AlignmentEditor& editor, std::ostream& out, const PipelineOptions& options) {
+    TRACE_SCOPE("runPipeline");
+    using Clock = std::chrono::steady_clock;
+    auto started = Clock::now();
+    PipelineContext ctx(map, editor);
+    OrderedOutput output(out, script.size());
+    PipelineReport report;
+    report.commands = script.size();
+    std::mutex reportMutex;
+
+    auto runOne = [&](size_t i) {
+        const PipelineCommand& cmd = script[i];
+        auto commandStart = Clock::now();
+        std::ostringstream body;
+        std::string error;
+        try {
+            execute(cmd, ctx, body);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        std::ostringstream block;
+        block << '[' << cmd.line << "] " << cmd.text;
+        if (options.timings) {
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - commandStart).count();
+            block << " (" << std::fixed << std::setprecision(3) << ms << " ms)";
+        }
+        block << '\n' << body.str();
+        if (!error.empty()) {
+            block << "  error: " << error << '\n';
+            std::lock_guard<std::mutex> lock(reportMutex);
+            ++report.failed;
+        }
+        output.complete(i, block.str());
+    };
+
+    // A stage grows until the next command conflicts with one already in it.
+    for (size_t begin = 0; begin < script.size();) {
+        unsigned reads = 0, writes = 0;
+        size_t end = begin;
+        while (end < script.size()) {
+            const CommandSpec& spec = specOf(script[end].verb);
+            bool conflicts = (spec.writes & (reads | writes)) || (spec.reads & writes);
+            if (end > begin && (conflicts || !options.parallelStages)) break;
+            reads |= spec.reads;
+            writes |= spec.writes;
+            ++end;
+        }
+        // Indexing new genes up front keeps the stage's concurrent readers
+        // from doing it under the lock one by one.
+        if (end - begin > 1 && (reads & Genes)) ctx.engine.sync();
+        parallelFor(end - begin, 1, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) runOne(begin + i);
+        }, options.threads);
+        ++report.stages;
+        begin = end;
+    }
+
+    report.milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+    return report;
+}
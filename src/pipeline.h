@@ -0,0 +1,77 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Headless pipeline scripts
+//-----------------------------------------------------------------------------
+//
+// One command per line; '#' starts a comment. Paths and names are single
+// words, except that `query` takes the rest of the line.
+//
+//   load genes <file-or-directory>...   batch import (format sniffed per file)
+//   load sequences <file>               CSV or JSON sequences
+//   demo sequences                      the built-in demo alignment
+//   knockout <symbol>                   toggle a gene's knockout flag
+//   score polygenic <weights> <dosages> [sample-scores.csv]
+//                                       gene scores into the map, see polygenic_score.h
+//   stats                               gene count, knockouts, mean/median/p99
+//   query <gene query>                  matching symbols, see parseGeneQuery
+//   top expression|polygenic <k>        highest-ranked genes
+//   top region <region> <k>
+//   coexpression pearson|spearman min <r> | top <k> [edges.csv]
+//                                       gene network over brain regions, see coexpression.h
+//   cluster average|complete|ward <k> [linkage.csv]
+//                                       cut into k gene sets "<linkage>-1" ..., see gene_clustering.h
+//   seq select <index> | seq cursor <position>
+//   seq gap | seq revcomp | seq edit <base>
+//   seq show                            names and aligned sequences
+//   seq score                           sum-of-pairs and identity to the reference
+//   seq variants                        SNV, insertion and deletion counts per sequence
+//   seq distances [identity|p|jc]       pairwise matrix (default p-distance)
+//   export genes <path>                 .csv or .json
+//   export sequences <path>             .csv, .json or .fasta
+//   export shared <path>                read-only store for SharedGeneStore::attach
+//   export variants <path>              every variant against the reference, as CSV
+//   export distances <path> [measure]   pairwise matrix as CSV
+
+struct PipelineCommand {
+    int line = 0;
+    std::string verb;              // e.g. "load genes", "stats"
+    std::vector<std::string> args;
+    std::string text;              // the line as written, for output
+};
+
+// @return The commands in order.
+// @throws std::invalid_argument naming the line of an unknown command, a
+// wrong argument count or a malformed query.
+std::vector<PipelineCommand> parsePipelineScript(std::istream& in);
+
+struct PipelineOptions {
+    unsigned threads = 0;          // workers per stage (0 = all cores)
+    bool parallelStages = true;    // false runs every command on its own
+    bool timings = true;           // per-command times in the output
+};
+
+struct PipelineReport {
+    size_t commands = 0;
+    size_t failed = 0;
+    size_t stages = 0;
+    double milliseconds = 0.0;
+};
+
+// Runs a script against `map` and `editor`. Consecutive commands that do not
+// conflict (none writes what another reads or writes, e.g. exports and
+// queries over the genes while the sequences are edited) form one stage and
+// run concurrently. Each command's output is written to `out` in script
+// order as soon as it and every command before it have finished. A failing
+// command is reported in the output and does not stop the script.
+PipelineReport runPipeline(const std::vector<PipelineCommand>& script, AlignmentMap& map,
+                           AlignmentEditor& editor, std::ostream& out, const PipelineOptions& options = {});
+
+#endif // PIPELINE_H
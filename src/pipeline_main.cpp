@@ -0,0 +1,65 @@
+// Headless driver: runs a pipeline script without the console UI, for batch
+// jobs on Linux servers (see pipeline.h for the script commands).
+//
+//   alignment_pipeline [--threads N] [--serial] [--no-timings] <script | ->
+
+#include "pipeline.h"
+#include "trace.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+static int usage() {
+    std::cerr << "Usage: alignment_pipeline [--threads N] [--serial] [--no-timings] <script | ->\n";
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    std::ios::sync_with_stdio(false);
+    PipelineOptions options;
+    const char* scriptPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--serial") == 0) {
+            options.parallelStages = false;
+        } else if (std::strcmp(argv[i], "--no-timings") == 0) {
+            options.timings = false;
+        } else if (!scriptPath && (argv[i][0] != '-' || std::strcmp(argv[i], "-") == 0)) {
+            scriptPath = argv[i];
+        } else {
+            return usage();
+        }
+    }
+    if (!scriptPath) return usage();
+
+    std::vector<PipelineCommand> script;
+    try {
+        if (std::strcmp(scriptPath, "-") == 0) {
+            script = parsePipelineScript(std::cin);
+        } else {
+            std::ifstream file(scriptPath);
+            if (!file) {
+                std::cerr << "Error: Could not open script " << scriptPath << std::endl;
+                return 2;
+            }
+            script = parsePipelineScript(file);
+        }
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+
+    AlignmentMap map;
+    AlignmentEditor editor;
+    PipelineReport report = runPipeline(script, map, editor, std::cout, options);
+    std::cout << "pipeline: " << report.commands << " commands in " << report.stages << " stages, "
+              << report.failed << " failed";
+    if (options.timings) std::cout << ", " << std::fixed << std::setprecision(1) << report.milliseconds << " ms";
+    std::cout << std::endl;
+    return report.failed == 0 ? 0 : 1;
+}
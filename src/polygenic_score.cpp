@@ -0,0 +1,298 @@
+#include "polygenic_score.h"
+#include "exporters.h"
+#include "parallel_utils.h"
+#include "trace.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string_view>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define POLYGENIC_SSE2 1
+#endif
+
+// --- Private Helper Functions ---
+
+static char detectDelimiter(const std::string& header) {
+    return header.find('\t') != std::string::npos ? '\t' : ',';
+}
+
+static void stripCarriageReturn(std::string& line) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+}
+
+// Splits `line` on `delimiter` into `fields`, reusing its storage.
+static void splitFields(std::string_view line, char delimiter, std::vector<std::string_view>& fields) {
+    fields.clear();
+    size_t start = 0;
+    for (;;) {
+        const void* hit = std::memchr(line.data() + start, delimiter, line.size() - start);
+        size_t end = hit ? size_t(static_cast<const char*>(hit) - line.data()) : line.size();
+        fields.push_back(line.substr(start, end - start));
+        if (!hit) return;
+        start = end + 1;
+    }
+}
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '"')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '"')) s.remove_suffix(1);
+    return s;
+}
+
+static bool parseDouble(std::string_view text, double& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+static bool isMissing(std::string_view text) {
+    return text.empty() || text == "NA" || text == ".";
+}
+
+// acc[i] += a * x[i], four lanes per step.
+static void multiplyAccumulate(double* acc, const double* x, double a, size_t n) {
+    size_t i = 0;
+#ifdef POLYGENIC_SSE2
+    const __m128d scale = _mm_set1_pd(a);
+    for (; i + 4 <= n; i += 4) {
+        __m128d lo = _mm_add_pd(_mm_loadu_pd(acc + i), _mm_mul_pd(scale, _mm_loadu_pd(x + i)));
+        __m128d hi = _mm_add_pd(_mm_loadu_pd(acc + i + 2), _mm_mul_pd(scale, _mm_loadu_pd(x + i + 2)));
+        _mm_storeu_pd(acc + i, lo);
+        _mm_storeu_pd(acc + i + 2, hi);
+    }
+#endif
+    for (; i < n; ++i) acc[i] += a * x[i];
+}
+
+// --- PolygenicWeights ---
+
+PolygenicWeights PolygenicWeights::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) throw std::runtime_error("could not open weights file " + path);
+    return read(in);
+}
+
+PolygenicWeights PolygenicWeights::read(std::istream& in) {
+    TRACE_SCOPE("PolygenicWeights::read");
+    PolygenicWeights w;
+    std::string line;
+    if (!std::getline(in, line)) throw std::runtime_error("weights file is empty");
+    stripCarriageReturn(line);
+    const char delimiter = detectDelimiter(line);
+    std::vector<std::string_view> fields;
+    splitFields(line, delimiter, fields);
+    if (fields.size() < 3) throw std::runtime_error("weights header needs variant, gene and effect columns");
+
+    while (std::getline(in, line)) {
+        stripCarriageReturn(line);
+        if (line.empty()) continue;
+        splitFields(line, delimiter, fields);
+        double effect = 0.0;
+        if (fields.size() < 3 || trim(fields[0]).empty() || trim(fields[1]).empty()
+            || !parseDouble(trim(fields[2]), effect)) {
+            ++w.skipped_;
+            continue;
+        }
+        std::string gene(trim(fields[1]));
+        auto id = w.geneIds_.try_emplace(gene, uint32_t(w.genes_.size()));
+        if (id.second) w.genes_.push_back(std::move(gene));
+
+        // Prepend to the variant's chain; the order within a chain only
+        // affects which gene is credited first.
+        uint32_t index = uint32_t(w.entries_.size());
+        auto head = w.firstEntry_.try_emplace(std::string(trim(fields[0])), kEnd);
+        w.entries_.push_back({id.first->second, head.first->second, effect});
+        head.first->second = index;
+    }
+    return w;
+}
+
+uint32_t PolygenicWeights::first(const std::string& variant) const {
+    auto it = firstEntry_.find(variant);
+    return it == firstEntry_.end() ? kEnd : it->second;
+}
+
+// --- Scoring ---
+
+namespace {
+
+// Sums for one block of dosage rows.
+struct PartialScores {
+    std::vector<double> samples;
+    std::vector<double> genes;
+    std::vector<size_t> geneVariants;
+    size_t read = 0, scored = 0, missing = 0, malformed = 0;
+
+    // Scratch for parsing, kept between blocks.
+    std::vector<std::string_view> fields;
+    std::vector<double> dosages;
+    std::vector<uint32_t> missingAt;
+    std::string variant;
+
+    void reset(size_t sampleCount, size_t geneCount) {
+        samples.assign(sampleCount, 0.0);
+        genes.assign(geneCount, 0.0);
+        geneVariants.assign(geneCount, 0);
+        read = scored = missing = malformed = 0;
+    }
+};
+
+void scoreRow(const PolygenicWeights& weights, const std::string& line, char delimiter, PartialScores& p) {
+    if (line.empty()) return;
+    ++p.read;
+    // Look the variant up before splitting the rest: unweighted rows are skipped cheaply.
+    size_t cut = line.find(delimiter);
+    std::string_view id = trim(std::string_view(line).substr(0, cut));
+    p.variant.assign(id.data(), id.size());
+    uint32_t first = weights.first(p.variant);
+    if (first == PolygenicWeights::kEnd) return;
+
+    const size_t sampleCount = p.samples.size();
+    splitFields(line, delimiter, p.fields);
+    if (p.fields.size() != sampleCount + 1) {
+        ++p.malformed;
+        return;
+    }
+    p.dosages.resize(sampleCount);
+    p.missingAt.clear();
+    double present = 0.0;
+    for (size_t s = 0; s < sampleCount; ++s) {
+        std::string_view field = trim(p.fields[s + 1]);
+        if (isMissing(field)) {
+            p.missingAt.push_back(uint32_t(s));
+            continue;
+        }
+        if (!parseDouble(field, p.dosages[s])) {
+            ++p.malformed;
+            return;
+        }
+        present += p.dosages[s];
+    }
+    const size_t observed = sampleCount - p.missingAt.size();
+    const double mean = observed ? present / double(observed) : 0.0;
+    for (uint32_t s : p.missingAt) p.dosages[s] = mean;
+    p.missing += p.missingAt.size();
+    const double rowSum = present + mean * double(p.missingAt.size());
+
+    double effect = 0.0;
+    for (uint32_t e = first; e != PolygenicWeights::kEnd; e = weights.entry(e).next) {
+        const auto& entry = weights.entry(e);
+        effect += entry.effect;
+        p.genes[entry.gene] += entry.effect * rowSum;
+        ++p.geneVariants[entry.gene];
+    }
+    multiplyAccumulate(p.samples.data(), p.dosages.data(), effect, sampleCount);
+    ++p.scored;
+}
+
+} // namespace
+
+PolygenicScoreReport scorePolygenic(const PolygenicWeights& weights, const std::string& dosagePath,
+                                    const PolygenicScoreOptions& options) {
+    std::ifstream in(dosagePath);
+    if (!in.is_open()) throw std::runtime_error("could not open dosage file " + dosagePath);
+    return scorePolygenic(weights, in, options);
+}
+
+PolygenicScoreReport scorePolygenic(const PolygenicWeights& weights, std::istream& dosages,
+                                    const PolygenicScoreOptions& options) {
+    TRACE_SCOPE("scorePolygenic");
+    auto started = std::chrono::steady_clock::now();
+    PolygenicScoreReport report;
+
+    std::string header;
+    if (!std::getline(dosages, header)) throw std::runtime_error("dosage file is empty");
+    stripCarriageReturn(header);
+    const char delimiter = detectDelimiter(header);
+    std::vector<std::string_view> fields;
+    splitFields(header, delimiter, fields);
+    if (fields.size() < 2) throw std::runtime_error("dosage header has no sample columns");
+    for (size_t i = 1; i < fields.size(); ++i) report.samples.emplace_back(trim(fields[i]));
+
+    const size_t sampleCount = report.samples.size();
+    const size_t geneCount = weights.genes().size();
+    report.genes = weights.genes();
+    report.sampleScores.assign(sampleCount, 0.0);
+    report.geneScores.assign(geneCount, 0.0);
+    report.geneVariants.assign(geneCount, 0);
+
+    // One block of rows per worker per round; lines keep their capacity
+    // between rounds, so steady-state reading does not allocate.
+    const unsigned workers = options.threads == 0 ? defaultThreadCount() : options.threads;
+    const size_t blockRows = std::max<size_t>(options.blockVariants, 1);
+    std::vector<std::vector<std::string>> blocks(workers, std::vector<std::string>(blockRows));
+    std::vector<size_t> filled(workers, 0);
+    std::vector<PartialScores> partials(workers);
+
+    for (bool eof = false; !eof;) {
+        size_t used = 0;
+        while (used < workers && !eof) {
+            size_t n = 0;
+            while (n < blockRows && std::getline(dosages, blocks[used][n])) {
+                stripCarriageReturn(blocks[used][n]);
+                ++n;
+            }
+            eof = n < blockRows;
+            if (n == 0) break;
+            filled[used++] = n;
+        }
+        if (used == 0) break;
+
+        parallelFor(used, 1, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; ++b) {
+                PartialScores& p = partials[b];
+                p.reset(sampleCount, geneCount);
+                for (size_t r = 0; r < filled[b]; ++r) scoreRow(weights, blocks[b][r], delimiter, p);
+            }
+        }, workers);
+
+        // Merge in file order so the sums do not depend on scheduling.
+        for (size_t b = 0; b < used; ++b) {
+            const PartialScores& p = partials[b];
+            for (size_t s = 0; s < sampleCount; ++s) report.sampleScores[s] += p.samples[s];
+            for (size_t g = 0; g < geneCount; ++g) {
+                report.geneScores[g] += p.genes[g];
+                report.geneVariants[g] += p.geneVariants[g];
+            }
+            report.variantsRead += p.read;
+            report.variantsScored += p.scored;
+            report.missingDosages += p.missing;
+            report.malformedRows += p.malformed;
+        }
+    }
+
+    for (double& g : report.geneScores) g /= double(sampleCount);
+    report.milliseconds =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    TRACE_COUNTER_ADD("scorePolygenic.variants", report.variantsRead);
+    return report;
+}
+
+size_t applyPolygenicScores(const PolygenicScoreReport& report, AlignmentMap& map) {
+    std::vector<std::string> symbols;
+    std::vector<double> scores;
+    for (size_t g = 0; g < report.genes.size(); ++g) {
+        if (report.geneVariants[g] == 0) continue;
+        symbols.push_back(report.genes[g]);
+        scores.push_back(report.geneScores[g]);
+    }
+    return map.setPolygenicScores(symbols, scores);
+}
+
+bool writeSampleScoresCSV(const PolygenicScoreReport& report, const std::string& path) {
+    BufferedFileWriter out;
+    if (!out.open(path)) return false;
+    out.append("sample,score\n");
+    for (size_t s = 0; s < report.samples.size(); ++s) {
+        out.append(report.samples[s]);
+        out.append(',');
+        out.appendNumber(report.sampleScores[s]);
+        out.append('\n');
+    }
+    return out.close();
+}
@@ -0,0 +1,97 @@
+#ifndef POLYGENIC_SCORE_H
+#define POLYGENIC_SCORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Polygenic scores
+//-----------------------------------------------------------------------------
+//
+// Inputs are delimited text with a header row; the delimiter is a tab if the
+// header has one, a comma otherwise.
+//
+//   weights:  variant,gene,effect     one row per variant/gene pair
+//   dosages:  variant,S1,S2,...       one row per variant, 0-2 per sample;
+//                                     NA, '.' or an empty field is missing
+//
+// A sample's score is the sum of effect x dosage over every weight row whose
+// variant appears in the dosage file. A gene's score is the same sum over
+// its own variants, averaged over samples, so the gene scores add up to the
+// mean sample score. A missing dosage is replaced by the variant's mean over
+// the samples that have one.
+//
+// The dosage file is streamed: rows are read in blocks of `blockVariants`,
+// at most one block per worker is held at a time, and blocks are parsed and
+// accumulated in parallel. Memory is bounded by the weights plus
+// threads x blockVariants rows, however many variants the file holds.
+// Partial sums are merged in file order, so results do not depend on the
+// thread count.
+
+class PolygenicWeights {
+public:
+    // @throws std::runtime_error if the file cannot be read or its header
+    // has fewer than three columns.
+    static PolygenicWeights load(const std::string& path);
+    static PolygenicWeights read(std::istream& in);
+
+    size_t size() const { return entries_.size(); }  // weight rows kept
+    size_t skippedRows() const { return skipped_; }  // malformed rows
+    const std::vector<std::string>& genes() const { return genes_; }
+
+    struct Entry {
+        uint32_t gene;   // index into genes()
+        uint32_t next;   // next entry for the same variant, or kEnd
+        double effect;
+    };
+    static constexpr uint32_t kEnd = UINT32_MAX;
+    // First entry for a variant, or kEnd.
+    uint32_t first(const std::string& variant) const;
+    const Entry& entry(uint32_t index) const { return entries_[index]; }
+
+private:
+    std::vector<std::string> genes_;
+    std::unordered_map<std::string, uint32_t> geneIds_;
+    std::unordered_map<std::string, uint32_t> firstEntry_;
+    std::vector<Entry> entries_;
+    size_t skipped_ = 0;
+};
+
+struct PolygenicScoreOptions {
+    unsigned threads = 0;         // 0 = all cores
+    size_t blockVariants = 4096;  // dosage rows per block
+};
+
+struct PolygenicScoreReport {
+    std::vector<std::string> samples;    // from the dosage header
+    std::vector<double> sampleScores;
+    std::vector<std::string> genes;      // = PolygenicWeights::genes()
+    std::vector<double> geneScores;
+    std::vector<size_t> geneVariants;    // scored variants per gene
+    size_t variantsRead = 0;
+    size_t variantsScored = 0;           // rows with at least one weight
+    size_t missingDosages = 0;
+    size_t malformedRows = 0;            // wrong field count or bad number
+    double milliseconds = 0.0;
+};
+
+// @throws std::runtime_error if the dosage file cannot be read or has no
+// sample columns.
+PolygenicScoreReport scorePolygenic(const PolygenicWeights& weights, const std::string& dosagePath,
+                                    const PolygenicScoreOptions& options = {});
+PolygenicScoreReport scorePolygenic(const PolygenicWeights& weights, std::istream& dosages,
+                                    const PolygenicScoreOptions& options = {});
+
+// Writes the gene scores into the map's genes. Genes without a scored
+// variant are left unchanged. @return Number of map genes updated.
+size_t applyPolygenicScores(const PolygenicScoreReport& report, AlignmentMap& map);
+
+// Writes sample,score rows. @return False if the file could not be written.
+bool writeSampleScoresCSV(const PolygenicScoreReport& report, const std::string& path);
+
+#endif // POLYGENIC_SCORE_H
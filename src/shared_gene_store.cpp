@@ -0,0 +1,393 @@
+#include "shared_gene_store.h"
+#include "exporters.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#if defined(_WIN32) || defined(_WIN64)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace L = shared_gene_layout;
+
+// The layout is copied byte for byte between processes.
+static_assert(std::is_trivially_copyable<L::Header>::value, "header must be plain data");
+static_assert(std::is_trivially_copyable<L::GeneRecord>::value, "records must be plain data");
+static_assert(sizeof(L::Header) % 8 == 0 && sizeof(L::GeneRecord) % 8 == 0 && sizeof(L::RegionRecord) % 8 == 0,
+              "sections stay 8-byte aligned");
+
+static const char kMagic[8] = {'A', 'M', 'G', 'E', 'N', 'E', 'S', '\0'};
+
+static uint64_t alignUp(uint64_t value) {
+    return (value + 7) & ~uint64_t(7);
+}
+
+// --- Building ---
+
+template <typename T>
+static void writeSection(BufferedFileWriter& out, const std::vector<T>& items) {
+    std::string_view bytes(reinterpret_cast<const char*>(items.data()), items.size() * sizeof(T));
+    out.append(bytes);
+    static const char zeros[8] = {};
+    out.append(std::string_view(zeros, size_t(alignUp(bytes.size()) - bytes.size())));
+}
+
+bool buildSharedGeneStore(const std::vector<GeneModel>& genes, const std::string& path) {
+    TRACE_SCOPE("buildSharedGeneStore");
+    // Symbols are unique but categories, tags, region names and chromosomes
+    // repeat across most genes, so the pool stores each distinct string once.
+    std::vector<char> pool;
+    std::unordered_map<std::string_view, L::StringRef> interned;
+    auto intern = [&](std::string_view s) {
+        auto it = interned.find(s);
+        if (it != interned.end()) return it->second;
+        L::StringRef ref{pool.size(), uint32_t(s.size()), 0};
+        pool.insert(pool.end(), s.begin(), s.end());
+        interned.emplace(s, ref);
+        return ref;
+    };
+
+    std::vector<L::GeneRecord> records(genes.size());
+    std::vector<L::StringRef> lists;
+    std::vector<L::RegionRecord> regions;
+    for (size_t i = 0; i < genes.size(); ++i) {
+        const GeneModel& g = genes[i];
+        L::GeneRecord& r = records[i];
+        r.symbol = intern(g.symbol);
+        r.chromosome = intern(g.chromosome);
+        r.start = g.start;
+        r.end = g.end;
+        r.expressionLevel = g.expressionLevel;
+        r.polygenicScore = g.polygenicScore;
+        r.isKnockout = g.isKnockout;
+        r.categoriesBegin = uint32_t(lists.size());
+        r.categoryCount = uint32_t(g.categories.size());
+        for (const auto& c : g.categories) lists.push_back(intern(c));
+        r.tagsBegin = uint32_t(lists.size());
+        r.tagCount = uint32_t(g.disorderTags.size());
+        for (const auto& t : g.disorderTags) lists.push_back(intern(t));
+        // The region map is ordered by name, which is what lookups search on.
+        r.regionsBegin = uint32_t(regions.size());
+        r.regionCount = uint32_t(g.brainRegionExpression.size());
+        for (const auto& kv : g.brainRegionExpression) regions.push_back({intern(kv.first), kv.second});
+    }
+    if (genes.size() > std::numeric_limits<uint32_t>::max() || lists.size() > std::numeric_limits<uint32_t>::max()
+        || regions.size() > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+
+    std::vector<uint32_t> symbolIndex(genes.size());
+    for (size_t i = 0; i < symbolIndex.size(); ++i) symbolIndex[i] = uint32_t(i);
+    std::stable_sort(symbolIndex.begin(), symbolIndex.end(),
+                     [&](uint32_t a, uint32_t b) { return genes[a].symbol < genes[b].symbol; });
+
+    L::Header h{};
+    std::memcpy(h.magic, kMagic, sizeof kMagic);
+    h.version = L::kVersion;
+    h.headerBytes = sizeof(L::Header);
+    h.geneCount = genes.size();
+    h.listCount = lists.size();
+    h.regionCount = regions.size();
+    h.stringBytes = pool.size();
+    h.genesOffset = sizeof(L::Header);
+    h.symbolIndexOffset = h.genesOffset + alignUp(records.size() * sizeof(L::GeneRecord));
+    h.listsOffset = h.symbolIndexOffset + alignUp(symbolIndex.size() * sizeof(uint32_t));
+    h.regionsOffset = h.listsOffset + alignUp(lists.size() * sizeof(L::StringRef));
+    h.stringsOffset = h.regionsOffset + alignUp(regions.size() * sizeof(L::RegionRecord));
+    h.totalBytes = h.stringsOffset + alignUp(pool.size());
+
+    std::string temp = path + ".building";
+    {
+        BufferedFileWriter out;
+        if (!out.open(temp)) return false;
+        out.append(std::string_view(reinterpret_cast<const char*>(&h), sizeof h));
+        writeSection(out, records);
+        writeSection(out, symbolIndex);
+        writeSection(out, lists);
+        writeSection(out, regions);
+        writeSection(out, pool);
+        if (!out.close()) {
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    if (ec) std::remove(temp.c_str());
+    return !ec;
+}
+
+// --- SharedGeneStore ---
+
+SharedGeneStore::~SharedGeneStore() {
+    detach();
+}
+
+SharedGeneStore::SharedGeneStore(SharedGeneStore&& other) noexcept {
+    *this = std::move(other);
+}
+
+SharedGeneStore& SharedGeneStore::operator=(SharedGeneStore&& other) noexcept {
+    if (this != &other) {
+        detach();
+        std::swap(base_, other.base_);
+        std::swap(bytes_, other.bytes_);
+        std::swap(header_, other.header_);
+        std::swap(genes_, other.genes_);
+        std::swap(symbolIndex_, other.symbolIndex_);
+        std::swap(lists_, other.lists_);
+        std::swap(regions_, other.regions_);
+        std::swap(strings_, other.strings_);
+#if defined(_WIN32) || defined(_WIN64)
+        std::swap(mapping_, other.mapping_);
+#endif
+    }
+    return *this;
+}
+
+void SharedGeneStore::detach() {
+    if (base_) {
+#if defined(_WIN32) || defined(_WIN64)
+        UnmapViewOfFile(base_);
+        if (mapping_) CloseHandle(static_cast<HANDLE>(mapping_));
+        mapping_ = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(base_), bytes_);
+#endif
+    }
+    base_ = nullptr;
+    bytes_ = 0;
+    header_ = nullptr;
+    genes_ = nullptr;
+    symbolIndex_ = nullptr;
+    lists_ = nullptr;
+    regions_ = nullptr;
+    strings_ = nullptr;
+}
+
+// True if `count` records at `offset` lie inside the mapping and are aligned
+// for their widest member; the mapping itself starts on a page boundary.
+template <typename Record>
+static bool sectionFits(uint64_t offset, uint64_t count, uint64_t total) {
+    return offset % alignof(Record) == 0 && offset <= total && count <= (total - offset) / sizeof(Record);
+}
+
+SharedGeneStore SharedGeneStore::attach(const std::string& path) {
+    TRACE_SCOPE("SharedGeneStore::attach");
+    SharedGeneStore store;
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("SharedGeneStore: cannot open " + path);
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < LONGLONG(sizeof(L::Header))) {
+        CloseHandle(file);
+        throw std::runtime_error("SharedGeneStore: not a gene store: " + path);
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) throw std::runtime_error("SharedGeneStore: cannot map " + path);
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        throw std::runtime_error("SharedGeneStore: cannot map " + path);
+    }
+    store.mapping_ = mapping;
+    store.base_ = static_cast<const unsigned char*>(view);
+    store.bytes_ = size_t(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("SharedGeneStore: cannot open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < off_t(sizeof(L::Header))) {
+        ::close(fd);
+        throw std::runtime_error("SharedGeneStore: not a gene store: " + path);
+    }
+    void* view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (view == MAP_FAILED) throw std::runtime_error("SharedGeneStore: cannot map " + path);
+    store.base_ = static_cast<const unsigned char*>(view);
+    store.bytes_ = size_t(st.st_size);
+#endif
+
+    const auto* h = reinterpret_cast<const L::Header*>(store.base_);
+    uint64_t total = store.bytes_;
+    bool valid = std::memcmp(h->magic, kMagic, sizeof kMagic) == 0 && h->version == L::kVersion
+        && h->headerBytes == sizeof(L::Header) && h->totalBytes == total
+        && sectionFits<L::GeneRecord>(h->genesOffset, h->geneCount, total)
+        && sectionFits<uint32_t>(h->symbolIndexOffset, h->geneCount, total)
+        && sectionFits<L::StringRef>(h->listsOffset, h->listCount, total)
+        && sectionFits<L::RegionRecord>(h->regionsOffset, h->regionCount, total)
+        && sectionFits<char>(h->stringsOffset, h->stringBytes, total);
+    if (!valid) throw std::runtime_error("SharedGeneStore: not a gene store or wrong version: " + path);
+
+    store.header_ = h;
+    store.genes_ = reinterpret_cast<const L::GeneRecord*>(store.base_ + h->genesOffset);
+    store.symbolIndex_ = reinterpret_cast<const uint32_t*>(store.base_ + h->symbolIndexOffset);
+    store.lists_ = reinterpret_cast<const L::StringRef*>(store.base_ + h->listsOffset);
+    store.regions_ = reinterpret_cast<const L::RegionRecord*>(store.base_ + h->regionsOffset);
+    store.strings_ = reinterpret_cast<const char*>(store.base_ + h->stringsOffset);
+    return store;
+}
+
+bool SharedGeneStore::attached() const {
+    return base_ != nullptr;
+}
+
+size_t SharedGeneStore::size() const {
+    return header_ ? size_t(header_->geneCount) : 0;
+}
+
+SharedGeneView SharedGeneStore::operator[](size_t index) const {
+    return SharedGeneView(this, genes_ + index);
+}
+
+// Out-of-range references (a damaged file) read as empty strings.
+std::string_view SharedGeneStore::text(const L::StringRef& ref) const {
+    uint64_t poolBytes = header_->stringBytes;
+    if (ref.offset > poolBytes || ref.length > poolBytes - ref.offset) return {};
+    return std::string_view(strings_ + ref.offset, ref.length);
+}
+
+size_t SharedGeneStore::find(std::string_view symbol) const {
+    const uint32_t* first = symbolIndex_;
+    const uint32_t* last = symbolIndex_ + size();
+    const uint32_t* it = std::lower_bound(first, last, symbol, [&](uint32_t id, std::string_view s) {
+        return id < size() && text(genes_[id].symbol) < s;
+    });
+    if (it == last || *it >= size() || text(genes_[*it].symbol) != symbol) return size();
+    return *it;
+}
+
+bool SharedGeneStore::verify() const {
+    if (!header_) return false;
+    auto refOk = [&](const L::StringRef& ref) {
+        return ref.offset <= header_->stringBytes && ref.length <= header_->stringBytes - ref.offset;
+    };
+    auto rangeOk = [](uint64_t begin, uint64_t count, uint64_t limit) { return begin <= limit && count <= limit - begin; };
+    for (size_t i = 0; i < size(); ++i) {
+        const L::GeneRecord& r = genes_[i];
+        if (!refOk(r.symbol) || !refOk(r.chromosome)) return false;
+        if (!rangeOk(r.categoriesBegin, r.categoryCount, header_->listCount)) return false;
+        if (!rangeOk(r.tagsBegin, r.tagCount, header_->listCount)) return false;
+        if (!rangeOk(r.regionsBegin, r.regionCount, header_->regionCount)) return false;
+        if (symbolIndex_[i] >= size()) return false;
+        if (i > 0 && text(genes_[symbolIndex_[i]].symbol) < text(genes_[symbolIndex_[i - 1]].symbol)) return false;
+    }
+    for (uint64_t i = 0; i < header_->listCount; ++i) {
+        if (!refOk(lists_[i])) return false;
+    }
+    for (uint64_t i = 0; i < header_->regionCount; ++i) {
+        if (!refOk(regions_[i].name)) return false;
+    }
+    return true;
+}
+
+size_t SharedGeneStore::mappedBytes() const {
+    return bytes_;
+}
+
+// --- SharedGeneView ---
+
+std::string_view SharedGeneView::symbol() const {
+    return store_->text(record_->symbol);
+}
+
+std::string_view SharedGeneView::chromosome() const {
+    return store_->text(record_->chromosome);
+}
+
+int SharedGeneView::start() const {
+    return record_->start;
+}
+
+int SharedGeneView::end() const {
+    return record_->end;
+}
+
+double SharedGeneView::expressionLevel() const {
+    return record_->expressionLevel;
+}
+
+double SharedGeneView::polygenicScore() const {
+    return record_->polygenicScore;
+}
+
+bool SharedGeneView::isKnockout() const {
+    return record_->isKnockout != 0;
+}
+
+size_t SharedGeneView::categoryCount() const {
+    return record_->categoryCount;
+}
+
+size_t SharedGeneView::disorderTagCount() const {
+    return record_->tagCount;
+}
+
+size_t SharedGeneView::regionCount() const {
+    return record_->regionCount;
+}
+
+std::string_view SharedGeneView::category(size_t i) const {
+    uint64_t at = uint64_t(record_->categoriesBegin) + i;
+    return i < record_->categoryCount && at < store_->header_->listCount ? store_->text(store_->lists_[at]) : std::string_view();
+}
+
+std::string_view SharedGeneView::disorderTag(size_t i) const {
+    uint64_t at = uint64_t(record_->tagsBegin) + i;
+    return i < record_->tagCount && at < store_->header_->listCount ? store_->text(store_->lists_[at]) : std::string_view();
+}
+
+std::string_view SharedGeneView::regionName(size_t i) const {
+    uint64_t at = uint64_t(record_->regionsBegin) + i;
+    return i < record_->regionCount && at < store_->header_->regionCount ? store_->text(store_->regions_[at].name)
+                                                                         : std::string_view();
+}
+
+double SharedGeneView::regionValue(size_t i) const {
+    uint64_t at = uint64_t(record_->regionsBegin) + i;
+    return i < record_->regionCount && at < store_->header_->regionCount ? store_->regions_[at].value
+                                                                         : std::nan("");
+}
+
+double SharedGeneView::regionExpression(std::string_view region) const {
+    size_t lo = 0, hi = regionCount();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (regionName(mid) < region) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < regionCount() && regionName(lo) == region ? regionValue(lo) : std::nan("");
+}
+
+GeneModel SharedGeneView::materialize() const {
+    GeneModel g;
+    g.symbol = std::string(symbol());
+    g.chromosome = std::string(chromosome());
+    g.start = start();
+    g.end = end();
+    g.expressionLevel = expressionLevel();
+    g.polygenicScore = polygenicScore();
+    g.isKnockout = isKnockout();
+    for (size_t i = 0; i < categoryCount(); ++i) g.categories.emplace_back(category(i));
+    for (size_t i = 0; i < disorderTagCount(); ++i) g.disorderTags.emplace_back(disorderTag(i));
+    for (size_t i = 0; i < regionCount(); ++i) setRegionExpression(g.brainRegionExpression, regionName(i), regionValue(i));
+    return g;
+}
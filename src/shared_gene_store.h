@@ -0,0 +1,150 @@
+#ifndef SHARED_GENE_STORE_H
+#define SHARED_GENE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Shared-memory gene store
+//-----------------------------------------------------------------------------
+//
+// A read-only gene map laid out as one relocatable block: fixed-size records
+// that refer to each other and to a deduplicated string pool by offset, never
+// by pointer. One process builds the file; any number of processes map it
+// read-only and share the same physical pages. Attaching maps the file and
+// checks its header, so it costs the same for ten genes or ten million.
+//
+// For a store that lives only in memory, build it under /dev/shm (where
+// shm_open objects live on Linux); any other path gives a file-backed store
+// that the page cache shares the same way.
+
+namespace shared_gene_layout {
+
+struct StringRef {
+    uint64_t offset;  // into the string pool
+    uint32_t length;
+    uint32_t unused;
+};
+
+struct Header {
+    char     magic[8];  // "AMGENES\0"
+    uint32_t version;
+    uint32_t headerBytes;
+    uint64_t totalBytes;
+    uint64_t geneCount;
+    uint64_t genesOffset, symbolIndexOffset, listsOffset, regionsOffset, stringsOffset;
+    uint64_t listCount, regionCount, stringBytes;
+};
+
+struct GeneRecord {
+    StringRef symbol;
+    StringRef chromosome;
+    int32_t   start, end;
+    double    expressionLevel;
+    double    polygenicScore;
+    uint32_t  isKnockout;
+    uint32_t  categoriesBegin, categoryCount;  // into the list section
+    uint32_t  tagsBegin, tagCount;
+    uint32_t  regionsBegin, regionCount;       // into the region section, sorted by name
+    uint32_t  unused;
+};
+
+struct RegionRecord {
+    StringRef name;
+    double    value;
+};
+
+constexpr uint32_t kVersion = 1;
+
+} // namespace shared_gene_layout
+
+// Writes `genes` in the shared layout. The file is written beside `path` and
+// renamed into place, so processes attached to an older store keep a
+// consistent view. @return False if the file could not be written.
+bool buildSharedGeneStore(const std::vector<GeneModel>& genes, const std::string& path);
+
+class SharedGeneStore;
+
+// One gene in a mapped store. Strings point into the mapping and stay valid
+// while the store is attached.
+class SharedGeneView {
+public:
+    std::string_view symbol() const;
+    std::string_view chromosome() const;
+    int start() const;
+    int end() const;
+    double expressionLevel() const;
+    double polygenicScore() const;
+    bool isKnockout() const;
+
+    size_t categoryCount() const;
+    std::string_view category(size_t i) const;
+    size_t disorderTagCount() const;
+    std::string_view disorderTag(size_t i) const;
+    size_t regionCount() const;
+    std::string_view regionName(size_t i) const;
+    double regionValue(size_t i) const;
+    // Expression in one region by binary search, NaN if the gene has none.
+    double regionExpression(std::string_view region) const;
+
+    // A heap-backed copy for code that needs a GeneModel.
+    GeneModel materialize() const;
+
+private:
+    friend class SharedGeneStore;
+    SharedGeneView(const SharedGeneStore* store, const shared_gene_layout::GeneRecord* record)
+        : store_(store), record_(record) {}
+
+    const SharedGeneStore* store_;
+    const shared_gene_layout::GeneRecord* record_;
+};
+
+class SharedGeneStore {
+public:
+    SharedGeneStore() = default;
+    ~SharedGeneStore();
+    SharedGeneStore(SharedGeneStore&& other) noexcept;
+    SharedGeneStore& operator=(SharedGeneStore&& other) noexcept;
+    SharedGeneStore(const SharedGeneStore&) = delete;
+    SharedGeneStore& operator=(const SharedGeneStore&) = delete;
+
+    // Maps a store read-only.
+    // @throws std::runtime_error if the file cannot be mapped or its header
+    // or section bounds are inconsistent.
+    static SharedGeneStore attach(const std::string& path);
+    void detach();
+    bool attached() const;
+
+    size_t size() const;
+    SharedGeneView operator[](size_t index) const;
+    // Index of the gene with this symbol, or size() if there is none.
+    size_t find(std::string_view symbol) const;
+
+    // Checks every record's string, list and region references. Linear in
+    // the store size; attach() only checks the header.
+    bool verify() const;
+    size_t mappedBytes() const;
+
+private:
+    friend class SharedGeneView;
+
+    const unsigned char* base_ = nullptr;
+    size_t bytes_ = 0;
+    const shared_gene_layout::Header* header_ = nullptr;
+    const shared_gene_layout::GeneRecord* genes_ = nullptr;
+    const uint32_t* symbolIndex_ = nullptr; // gene ids sorted by symbol
+    const shared_gene_layout::StringRef* lists_ = nullptr;
+    const shared_gene_layout::RegionRecord* regions_ = nullptr;
+    const char* strings_ = nullptr;
+#if defined(_WIN32) || defined(_WIN64)
+    void* mapping_ = nullptr; // file mapping handle
+#endif
+
+    std::string_view text(const shared_gene_layout::StringRef& ref) const;
+};
+
+#endif // SHARED_GENE_STORE_H
@@ -0,0 +1,194 @@
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// --- Private Types ---
+
+struct TraceEvent {
+    const char* name;
+    int64_t startNs;
+    int64_t value;    // duration for complete events, total for counters
+    uint32_t tid;
+    char phase;       // 'X' complete, 'C' counter
+};
+
+// Single-writer ring. The mutex is only contended while a dump or clear runs.
+struct TraceRing {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    size_t next = 0;
+    bool wrapped = false;
+
+    void push(const TraceEvent& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        events[next] = e;
+        if (++next == events.size()) {
+            next = 0;
+            wrapped = true;
+        }
+    }
+};
+
+// Owns every ring. Rings of finished threads go to a free list and are reused,
+// so short-lived worker threads (parallelFor) do not grow memory without bound.
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceRing>> rings;
+    std::vector<TraceRing*> freeRings;
+    size_t capacity = 32768;
+    uint32_t nextTid = 1;
+};
+
+static TraceRegistry& registry() {
+    // Never destroyed: thread_local slots may release rings during shutdown.
+    static TraceRegistry* instance = new TraceRegistry();
+    return *instance;
+}
+
+struct ThreadSlot {
+    TraceRing* ring = nullptr;
+    uint32_t tid = 0;
+
+    ~ThreadSlot() {
+        if (!ring) return;
+        TraceRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.freeRings.push_back(ring);
+    }
+};
+
+static ThreadSlot& threadSlot() {
+    thread_local ThreadSlot slot;
+    if (!slot.ring) {
+        TraceRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        slot.tid = reg.nextTid++;
+        if (!reg.freeRings.empty()) {
+            slot.ring = reg.freeRings.back();
+            reg.freeRings.pop_back();
+        } else {
+            reg.rings.push_back(std::make_unique<TraceRing>());
+            slot.ring = reg.rings.back().get();
+        }
+        std::lock_guard<std::mutex> ringLock(slot.ring->mutex);
+        if (slot.ring->events.size() != reg.capacity) {
+            slot.ring->events.assign(std::max<size_t>(1, reg.capacity), TraceEvent{});
+            slot.ring->next = 0;
+            slot.ring->wrapped = false;
+        }
+    }
+    return slot;
+}
+
+// Snapshot of one ring in recording order.
+static void copyEvents(TraceRing& ring, std::vector<TraceEvent>& out) {
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    if (ring.wrapped) out.insert(out.end(), ring.events.begin() + ring.next, ring.events.end());
+    out.insert(out.end(), ring.events.begin(), ring.events.begin() + ring.next);
+}
+
+static void writeJsonString(std::ostream& out, const char* s) {
+    out << '"';
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') out << '\\';
+        if (static_cast<unsigned char>(*s) >= 0x20) out << *s;
+    }
+    out << '"';
+}
+
+// --- Public Function Implementations ---
+
+int64_t traceNowNs() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void traceRecordComplete(const char* name, int64_t start_ns, int64_t duration_ns) {
+    ThreadSlot& slot = threadSlot();
+    slot.ring->push({name, start_ns, duration_ns, slot.tid, 'X'});
+}
+
+void traceRecordCounter(const char* name, int64_t value) {
+    ThreadSlot& slot = threadSlot();
+    slot.ring->push({name, traceNowNs(), value, slot.tid, 'C'});
+}
+
+void writeChromeTrace(std::ostream& out) {
+    std::vector<TraceEvent> events;
+    {
+        TraceRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (auto& ring : reg.rings) copyEvents(*ring, events);
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const TraceEvent& a, const TraceEvent& b) { return a.startNs < b.startNs; });
+
+    std::vector<uint32_t> tids;
+    for (const auto& e : events) tids.push_back(e.tid);
+    std::sort(tids.begin(), tids.end());
+    tids.erase(std::unique(tids.begin(), tids.end()), tids.end());
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (uint32_t tid : tids) {
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid
+            << ", \"args\": {\"name\": \"thread " << tid << "\"}}";
+        first = false;
+    }
+    // Timestamps are microseconds; keep nanosecond resolution as decimals.
+    for (const auto& e : events) {
+        out << (first ? "" : ",\n") << "{\"name\": ";
+        writeJsonString(out, e.name);
+        out << ", \"ph\": \"" << e.phase << "\", \"pid\": 1, \"tid\": " << e.tid
+            << ", \"ts\": " << e.startNs / 1000 << '.' << char('0' + e.startNs / 100 % 10)
+            << char('0' + e.startNs / 10 % 10) << char('0' + e.startNs % 10);
+        if (e.phase == 'X') {
+            out << ", \"dur\": " << e.value / 1000 << '.' << char('0' + e.value / 100 % 10)
+                << char('0' + e.value / 10 % 10) << char('0' + e.value % 10);
+        } else {
+            out << ", \"args\": {\"value\": " << e.value << '}';
+        }
+        out << '}';
+        first = false;
+    }
+    out << "\n]}\n";
+}
+
+bool saveChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+    writeChromeTrace(out);
+    return out.good();
+}
+
+void clearTrace() {
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& ring : reg.rings) {
+        std::lock_guard<std::mutex> ringLock(ring->mutex);
+        ring->next = 0;
+        ring->wrapped = false;
+    }
+}
+
+size_t traceEventCount() {
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    size_t total = 0;
+    for (auto& ring : reg.rings) {
+        std::lock_guard<std::mutex> ringLock(ring->mutex);
+        total += ring->wrapped ? ring->events.size() : ring->next;
+    }
+    return total;
+}
+
+void setTraceRingCapacity(size_t events) {
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.capacity = std::max<size_t>(1, events);
+}
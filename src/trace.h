@@ -0,0 +1,85 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+//-----------------------------------------------------------------------------
+// Scoped timers and counters, exported as Chrome trace-event JSON
+//-----------------------------------------------------------------------------
+//
+// Instrument code with the TRACE_* macros. They expand to nothing unless the
+// build defines ALIGNMENT_MAP_TRACING, so release builds pay nothing. Each
+// thread records into its own fixed-size ring buffer (oldest events are
+// overwritten), so recording never allocates after the first event and never
+// contends with other threads. saveChromeTrace() writes everything recorded
+// so far in a format Perfetto (ui.perfetto.dev) and chrome://tracing open.
+//
+// Names must be string literals or otherwise outlive the trace.
+
+#if defined(ALIGNMENT_MAP_TRACING)
+constexpr bool kTracingEnabled = true;
+#else
+constexpr bool kTracingEnabled = false;
+#endif
+
+// Nanoseconds since the trace epoch (first use in the process).
+int64_t traceNowNs();
+void traceRecordComplete(const char* name, int64_t start_ns, int64_t duration_ns);
+void traceRecordCounter(const char* name, int64_t value);
+
+// Records the lifetime of the enclosing scope as one complete event.
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name_(name), start_(traceNowNs()) {}
+    ~TraceScope() { traceRecordComplete(name_, start_, traceNowNs() - start_); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    int64_t start_;
+};
+
+// A monotonic, thread-safe running total; every add() records its new value.
+class TraceCounter {
+public:
+    explicit TraceCounter(const char* name) : name_(name) {}
+    void add(int64_t delta) { traceRecordCounter(name_, value_.fetch_add(delta, std::memory_order_relaxed) + delta); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    const char* name_;
+    std::atomic<int64_t> value_{0};
+};
+
+// Writes {"traceEvents": [...]} with one thread-name record per recording thread.
+void writeChromeTrace(std::ostream& out);
+// @return False if the file could not be written.
+bool saveChromeTrace(const std::string& path);
+// Drops all recorded events; counters keep their totals.
+void clearTrace();
+// Events currently held across all ring buffers.
+size_t traceEventCount();
+// Events per thread ring (default 32768); applies to rings (re)used afterwards.
+void setTraceRingCapacity(size_t events);
+
+#if defined(ALIGNMENT_MAP_TRACING)
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+// Each call site keeps its own total, so give every counter a single site.
+#define TRACE_COUNTER_ADD(name, delta)                 \
+    do {                                               \
+        static TraceCounter traceCounter_(name);       \
+        traceCounter_.add(int64_t(delta));             \
+    } while (0)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_COUNTER_ADD(name, delta) ((void)0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,200 @@
+#include "variant_extraction.h"
+#include "exporters.h"
+#include "parallel_utils.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <utility>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VARIANT_SSE2 1
+#endif
+
+// --- Private Helper Functions ---
+
+static inline unsigned countTrailingZeros(unsigned x) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return unsigned(index);
+#else
+    return unsigned(__builtin_ctz(x));
+#endif
+}
+
+static inline unsigned popcount32(unsigned x) {
+#if defined(_MSC_VER)
+    return unsigned(__popcnt(x));
+#else
+    return unsigned(__builtin_popcount(x));
+#endif
+}
+
+static inline bool isGap(char c) {
+    return c == '-' || c == '.';
+}
+
+static inline char upper(char c) {
+    return (c >= 'a' && c <= 'z') ? char(c - 'a' + 'A') : c;
+}
+
+// Length of the common prefix of a[0, n) and b[0, n).
+static size_t matchingPrefix(const char* a, const char* b, size_t n) {
+    size_t i = 0;
+#ifdef VARIANT_SSE2
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        unsigned equal = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+        if (equal != 0xFFFF) return i + countTrailingZeros(~equal);
+    }
+#endif
+    for (; i + 8 <= n; i += 8) {
+        uint64_t x, y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        if (x != y) break;
+    }
+    while (i < n && a[i] == b[i]) ++i;
+    return i;
+}
+
+// Gap characters in p[0, n).
+static size_t countGaps(const char* p, size_t n) {
+    size_t gaps = 0, i = 0;
+#ifdef VARIANT_SSE2
+    const __m128i dash = _mm_set1_epi8('-'), dot = _mm_set1_epi8('.');
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i gap = _mm_or_si128(_mm_cmpeq_epi8(x, dash), _mm_cmpeq_epi8(x, dot));
+        gaps += popcount32(unsigned(_mm_movemask_epi8(gap)));
+    }
+#endif
+    for (; i < n; ++i) gaps += isGap(p[i]);
+    return gaps;
+}
+
+// Diffs one sequence against the reference. Identical stretches are skipped
+// in bulk while no insertion or deletion is open; the open event would
+// otherwise need every column to decide where it ends.
+static void scanSequence(const std::string& ref, const std::string& seq, size_t index, bool refHasGaps,
+                         bool collect, SequenceVariantSummary& summary, std::vector<Variant>& out) {
+    const size_t overlap = std::min(ref.size(), seq.size());
+    size_t refPos = 0;
+    Variant open{};
+    bool isOpen = false;
+    auto close = [&]() {
+        if (isOpen && collect) out.push_back(std::move(open));
+        isOpen = false;
+    };
+
+    size_t c = 0;
+    while (c < seq.size()) {
+        if (!isOpen && c < overlap) {
+            size_t same = matchingPrefix(ref.data() + c, seq.data() + c, overlap - c);
+            if (same > 0) {
+                size_t bases = same - (refHasGaps ? countGaps(ref.data() + c, same) : 0);
+                refPos += bases;
+                summary.compared += bases;
+                c += same;
+                continue;
+            }
+        }
+
+        const char r = c < overlap ? ref[c] : '-';
+        const char a = seq[c];
+        const bool refGap = isGap(r), seqGap = isGap(a);
+        if (refGap && seqGap) {
+            ++c;
+            continue;
+        }
+        if (!refGap && !seqGap) {
+            close();
+            ++summary.compared;
+            if (upper(r) != upper(a)) {
+                ++summary.mismatches;
+                if (collect) out.push_back({VariantType::SNV, index, c, refPos, std::string(1, r), std::string(1, a)});
+            }
+            ++refPos;
+        } else {
+            VariantType type = refGap ? VariantType::Insertion : VariantType::Deletion;
+            if (isOpen && open.type != type) close();
+            if (!isOpen) {
+                open = Variant{type, index, c, refPos, {}, {}};
+                isOpen = true;
+                ++(refGap ? summary.insertions : summary.deletions);
+            }
+            if (refGap) {
+                ++summary.insertedBases;
+                if (collect) open.alt.push_back(a);
+            } else {
+                ++summary.deletedBases;
+                if (collect) open.ref.push_back(r);
+                ++refPos;
+            }
+        }
+        ++c;
+    }
+    close();
+}
+
+// --- Public API ---
+
+const char* variantTypeName(VariantType type) {
+    switch (type) {
+        case VariantType::SNV:       return "SNV";
+        case VariantType::Insertion: return "INS";
+        case VariantType::Deletion:  return "DEL";
+    }
+    return "SNV";
+}
+
+VariantReport extractVariants(const AlignmentBlock& block, const VariantOptions& options) {
+    TRACE_SCOPE("extractVariants");
+    const auto& seqs = block.sequences;
+    const std::string& ref = block.reference;
+    const bool refHasGaps = countGaps(ref.data(), ref.size()) > 0;
+
+    VariantReport report;
+    report.sequences.resize(seqs.size());
+    std::vector<std::vector<Variant>> perSequence(seqs.size());
+    parallelFor(seqs.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            scanSequence(ref, seqs[i].aligned, i, refHasGaps, options.collectVariants,
+                         report.sequences[i], perSequence[i]);
+        }
+    }, options.threads);
+
+    size_t total = 0;
+    for (const auto& v : perSequence) total += v.size();
+    report.variants.reserve(total);
+    for (auto& v : perSequence) std::move(v.begin(), v.end(), std::back_inserter(report.variants));
+    TRACE_COUNTER_ADD("extractVariants.variants", total);
+    return report;
+}
+
+bool writeVariantsCSV(const VariantReport& report, const AlignmentBlock& block, const std::string& path) {
+    BufferedFileWriter out;
+    if (!out.open(path)) return false;
+    out.append("sequence,type,column,position,ref,alt\n");
+    for (const auto& v : report.variants) {
+        out.append(block.sequences[v.sequence].name);
+        out.append(',');
+        out.append(variantTypeName(v.type));
+        out.append(',');
+        out.appendInteger((long long)v.column);
+        out.append(',');
+        out.appendInteger((long long)v.position);
+        out.append(',');
+        out.append(v.ref);
+        out.append(',');
+        out.append(v.alt);
+        out.append('\n');
+    }
+    return out.close();
+}
@@ -0,0 +1,64 @@
+#ifndef VARIANT_EXTRACTION_H
+#define VARIANT_EXTRACTION_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "map_logic.h"
+
+//-----------------------------------------------------------------------------
+// Reference-diff variant extraction
+//-----------------------------------------------------------------------------
+//
+// Compares every aligned sequence with the block reference column by column.
+// Runs of identical bytes are skipped 16 (SSE2) or 8 (portable) at a time,
+// so a block that mostly agrees with its reference is read at close to
+// memory speed; only differing columns are classified one by one.
+//
+// '-' and '.' are gaps and letters compare case-insensitively. A column
+// where both the sequence and the reference have a gap belongs to neither
+// side and does not interrupt an insertion or deletion. Columns past the
+// reference's end are insertions; columns past the sequence's end are not
+// covered and yield nothing.
+
+enum class VariantType { SNV, Insertion, Deletion };
+
+const char* variantTypeName(VariantType type);
+
+struct Variant {
+    VariantType type;
+    size_t      sequence;  // index into AlignmentBlock::sequences
+    size_t      column;    // first alignment column
+    // 0-based position in the ungapped reference: the substituted or first
+    // deleted base, or the base an insertion precedes.
+    size_t      position;
+    std::string ref;       // reference bases, empty for insertions
+    std::string alt;       // sequence bases, empty for deletions
+};
+
+struct SequenceVariantSummary {
+    size_t compared = 0;       // columns where both have a base
+    size_t mismatches = 0;     // = SNVs
+    size_t insertions = 0;     // events
+    size_t insertedBases = 0;
+    size_t deletions = 0;      // events
+    size_t deletedBases = 0;
+};
+
+struct VariantReport {
+    std::vector<Variant> variants;                  // by sequence, then column
+    std::vector<SequenceVariantSummary> sequences;  // one per block sequence
+};
+
+struct VariantOptions {
+    unsigned threads = 0;      // 0 = all cores; sequences are split across workers
+    bool collectVariants = true; // false fills only the per-sequence summaries
+};
+
+VariantReport extractVariants(const AlignmentBlock& block, const VariantOptions& options = {});
+
+// Writes sequence,type,column,position,ref,alt rows.
+// @return False if the file could not be written.
+bool writeVariantsCSV(const VariantReport& report, const AlignmentBlock& block, const std::string& path);
+
+#endif // VARIANT_EXTRACTION_H
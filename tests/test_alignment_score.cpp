@@ -0,0 +1,158 @@
+#include "alignment_score.h"
+#include "map_logic.h"
+#include "test_runner.h"
+#include <cmath>
+#include <random>
+
+// Sum-of-pairs by definition: every pair of sequences in every column.
+static int64_t naiveSumOfPairs(const AlignmentBlock& block, const ScoringScheme& scheme) {
+    size_t width = 0;
+    for (const auto& s : block.sequences) width = std::max(width, s.aligned.size());
+    int64_t total = 0;
+    for (size_t c = 0; c < width; ++c) {
+        for (size_t i = 0; i < block.sequences.size(); ++i) {
+            for (size_t j = i + 1; j < block.sequences.size(); ++j) {
+                const std::string& a = block.sequences[i].aligned;
+                const std::string& b = block.sequences[j].aligned;
+                total += scheme.score(c < a.size() ? a[c] : '-', c < b.size() ? b[c] : '-');
+            }
+        }
+    }
+    return total;
+}
+
+static SequenceModel sequence(const std::string& name, const std::string& aligned) {
+    return {name, SequenceType::DNA, aligned, aligned};
+}
+
+// Test the substitution tables and a block scored by hand.
+TEST_CASE(AlignmentScorer_ScoresAndIdentity) {
+    // Given the default nucleotide scheme and BLOSUM62
+    ScoringScheme dna = ScoringScheme::nucleotide(2, -1, -2);
+    ScoringScheme protein = ScoringScheme::blosum62(-4);
+
+    // Then matches, mismatches, gaps and aliases score as documented
+    ASSERT_EQUAL(dna.score('A', 'a'), 2);
+    ASSERT_EQUAL(dna.score('T', 'U'), 2);
+    ASSERT_EQUAL(dna.score('G', 'C'), -1);
+    ASSERT_EQUAL(dna.score('N', 'G'), 0);
+    ASSERT_EQUAL(dna.score('A', '-'), -2);
+    ASSERT_EQUAL(dna.score('N', '.'), -2);
+    ASSERT_EQUAL(dna.score('-', '-'), 0);
+    ASSERT_EQUAL(protein.score('W', 'W'), 11);
+    ASSERT_EQUAL(protein.score('I', 'V'), 3);
+    ASSERT_EQUAL(protein.score('E', 'Z'), 4);
+    ASSERT_EQUAL(protein.score('P', '-'), -4);
+    bool symmetric = true;
+    for (char a : std::string("ARNDCQEGHILKMFPSTWYVBZX"))
+        for (char b : std::string("ARNDCQEGHILKMFPSTWYVBZX")) symmetric = symmetric && protein.score(a, b) == protein.score(b, a);
+    ASSERT_TRUE(symmetric);
+
+    // Given a block with a mismatch and a gap in the second column
+    AlignmentBlock block;
+    block.reference = "AC";
+    block.sequences = {sequence("s0", "AC"), sequence("s1", "AT"), sequence("s2", "A-")};
+
+    // When it is scored
+    AlignmentScorer scorer(dna);
+    scorer.reset(block);
+
+    // Then column 0 is three A/A pairs and column 1 is C/T, C/- and T/-
+    ASSERT_EQUAL(scorer.columns(), 2);
+    ASSERT_EQUAL(scorer.columnScore(0), 6);
+    ASSERT_EQUAL(scorer.columnScore(1), -5);
+    ASSERT_EQUAL(scorer.sumOfPairs(), 1);
+
+    // And identity skips the column where s2 has a gap
+    ASSERT_EQUAL(scorer.identity(0), 100.0);
+    ASSERT_EQUAL(scorer.identity(1), 50.0);
+    ASSERT_EQUAL(scorer.identity(2), 100.0);
+    ASSERT_TRUE(std::abs(scorer.meanIdentity() - 250.0 / 3) < 1e-9);
+
+    // And a shorter sequence is padded with trailing gaps
+    block.sequences.push_back(sequence("s3", "A"));
+    scorer.reset(block);
+    ASSERT_EQUAL(scorer.sumOfPairs(), naiveSumOfPairs(block, dna));
+    ASSERT_EQUAL(scorer.identity(3), 100.0);
+}
+
+// Test that single-cell and whole-sequence updates agree with a full rescore.
+TEST_CASE(AlignmentScorer_IncrementalMatchesRescore) {
+    // Given a random block of ragged sequences
+    std::mt19937 rng(7);
+    const std::string alphabet = "ACGTN-";
+    AlignmentBlock block;
+    for (int i = 0; i < 40; ++i) block.reference.push_back(alphabet[rng() % 4]);
+    for (int s = 0; s < 12; ++s) {
+        std::string aligned;
+        for (int i = 0, n = 30 + int(rng() % 11); i < n; ++i) aligned.push_back(alphabet[rng() % alphabet.size()]);
+        block.sequences.push_back(sequence("s" + std::to_string(s), aligned));
+    }
+    ScoringScheme dna = ScoringScheme::nucleotide();
+    AlignmentScorer scorer(dna);
+    scorer.reset(block);
+    ASSERT_EQUAL(scorer.sumOfPairs(), naiveSumOfPairs(block, dna));
+
+    // When hundreds of cells are edited and reported one at a time
+    for (int edit = 0; edit < 500; ++edit) {
+        size_t s = rng() % block.sequences.size();
+        std::string& aligned = block.sequences[s].aligned;
+        size_t c = rng() % aligned.size();
+        char before = aligned[c];
+        aligned[c] = alphabet[rng() % alphabet.size()];
+        scorer.update(block, s, c, before);
+    }
+
+    // And one sequence is rewritten wholesale
+    std::string before = block.sequences[3].aligned;
+    std::reverse(block.sequences[3].aligned.begin(), block.sequences[3].aligned.end());
+    scorer.updateSequence(block, 3, before);
+
+    // Then every column, the total and every identity match a fresh scorer
+    AlignmentScorer fresh(dna);
+    fresh.reset(block);
+    ASSERT_EQUAL(scorer.sumOfPairs(), fresh.sumOfPairs());
+    ASSERT_EQUAL(scorer.sumOfPairs(), naiveSumOfPairs(block, dna));
+    bool columnsMatch = true, identitiesMatch = true;
+    for (size_t c = 0; c < fresh.columns(); ++c) columnsMatch = columnsMatch && scorer.columnScore(c) == fresh.columnScore(c);
+    for (size_t s = 0; s < block.sequences.size(); ++s) identitiesMatch = identitiesMatch && scorer.identity(s) == fresh.identity(s);
+    ASSERT_TRUE(columnsMatch);
+    ASSERT_TRUE(identitiesMatch);
+}
+
+// Test that the editor keeps its score current through edits.
+TEST_CASE(AlignmentEditor_LiveScore) {
+    // Given the demo alignment
+    AlignmentEditor editor;
+    editor.loadDemoDNA();
+    auto rescored = [&editor]() {
+        AlignmentBlock block;
+        block.reference = "ATCGATCGATCGATCG";
+        block.sequences = editor.getSequences();
+        AlignmentScorer scorer;
+        scorer.reset(block);
+        return scorer;
+    };
+    ASSERT_EQUAL(editor.getScorer().sumOfPairs(), rescored().sumOfPairs());
+    ASSERT_EQUAL(editor.getScorer().identity(0), 100.0);
+
+    // When a gap is toggled, a base edited and a sequence reverse-complemented
+    editor.selectSequence(1);
+    editor.moveCursor(2);
+    editor.toggleGap();
+    editor.moveCursor(3);
+    editor.editSelectedBase('g');
+    editor.selectSequence(1);
+    editor.reverseComplementSelected();
+
+    // Then the live score equals a full rescore after each kind of edit
+    AlignmentScorer expected = rescored();
+    ASSERT_EQUAL(editor.getScorer().sumOfPairs(), expected.sumOfPairs());
+    ASSERT_EQUAL(editor.getScorer().identity(1), expected.identity(1));
+    ASSERT_EQUAL(editor.getScorer().identity(2), expected.identity(2));
+
+    // And switching schemes rescores the block
+    editor.setScoringScheme(ScoringScheme::nucleotide(1, -3, -5));
+    ASSERT_EQUAL(editor.getScorer().sumOfPairs(),
+                 naiveSumOfPairs({"", editor.getSequences()}, ScoringScheme::nucleotide(1, -3, -5)));
+}
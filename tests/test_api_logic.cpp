@@ -1,9 +1,15 @@
 #include "api_logic.h"
+#include "gene_snapshot.h"
 #include "test_runner.h"
 #include <vector>
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <algorithm>
 
 // Test that the fetch function throws an exception when the HTTP getter returns an empty string.
 TEST_CASE(ApiLogic_FetchDataThrowsOnEmptyResponse) {
@@ -82,3 +88,358 @@ TEST_CASE(ApiLogic_ParsingComplexJson) {
     ASSERT_EQUAL(gene3.brainRegionExpression.size(), 1);
     ASSERT_EQUAL(gene3.brainRegionExpression.at("Parietal Lobe"), 0.9);
 }
+
+// Builds a gene JSON response echoing the accessions requested in the URL.
+static std::string echoAccessions(const std::string& url) {
+    size_t begin = url.find("accession/") + 10;
+    std::string list = url.substr(begin, url.find('?') - begin);
+    std::stringstream ss(list), json;
+    std::string accession;
+    json << "{\"genes\": [";
+    bool first = true;
+    while (std::getline(ss, accession, ',')) {
+        json << (first ? "" : ",") << "{\"gene_name\": \"" << accession << "\", \"expression_level\": 1.0}";
+        first = false;
+    }
+    json << "]}";
+    return json.str();
+}
+
+// Test that large accession lists are split into bounded batches and merged in order.
+TEST_CASE(ApiLogic_BatchedFetchPreservesOrder) {
+    // Given 450 accessions and a batch size of 200
+    std::vector<std::string> accessions;
+    for (int i = 0; i < 450; ++i) accessions.push_back("GENE" + std::to_string(i));
+    NcbiFetchOptions options;
+    options.maxBatchSize = 200;
+    options.concurrency = 3;
+    options.requestsPerSecond = 1000;
+
+    std::mutex mutex;
+    std::vector<size_t> url_lengths;
+    auto mock_getter = [&](const std::string& url, const std::string&) -> std::string {
+        std::lock_guard<std::mutex> lock(mutex);
+        url_lengths.push_back(url.size());
+        return echoAccessions(url);
+    };
+
+    // When fetching
+    std::vector<GeneModel> genes = fetchGeneDataFromNCBI(accessions, options, "", mock_getter);
+
+    // Then three requests were made and the genes come back in input order
+    ASSERT_EQUAL(url_lengths.size(), 3);
+    ASSERT_EQUAL(genes.size(), 450);
+    for (size_t i = 0; i < genes.size(); ++i) {
+        ASSERT_EQUAL(genes[i].symbol, accessions[i]);
+    }
+
+    // And with a tight URL limit no request exceeds it
+    url_lengths.clear();
+    options.maxUrlLength = 300;
+    genes = fetchGeneDataFromNCBI(accessions, options, "", mock_getter);
+    ASSERT_EQUAL(genes.size(), 450);
+    ASSERT_TRUE(url_lengths.size() > 3);
+    for (size_t len : url_lengths) ASSERT_TRUE(len <= 300);
+}
+
+// Test that 429/5xx responses are retried and other HTTP errors are not.
+TEST_CASE(ApiLogic_RetriesTransientErrors) {
+    NcbiFetchOptions options;
+    options.baseBackoff = std::chrono::milliseconds(1);
+    options.requestsPerSecond = 1000;
+
+    // Given a getter that is throttled twice before succeeding
+    int calls = 0;
+    auto flaky_getter = [&](const std::string& url, const std::string&) -> std::string {
+        if (++calls <= 2) throw NcbiHttpError(calls == 1 ? 429 : 503, "busy");
+        return echoAccessions(url);
+    };
+
+    // Then the fetch succeeds on the third attempt
+    auto genes = fetchGeneDataFromNCBI({"BRCA1"}, options, "", flaky_getter);
+    ASSERT_EQUAL(calls, 3);
+    ASSERT_EQUAL(genes.size(), 1);
+
+    // Given a getter that always returns 404
+    calls = 0;
+    auto missing_getter = [&](const std::string&, const std::string&) -> std::string {
+        ++calls;
+        throw NcbiHttpError(404, "not found");
+    };
+
+    // Then the error surfaces immediately without retries
+    bool thrown = false;
+    try {
+        fetchGeneDataFromNCBI({"BRCA1"}, options, "", missing_getter);
+    } catch (const NcbiHttpError& e) {
+        thrown = true;
+        ASSERT_EQUAL(e.status(), 404);
+    }
+    ASSERT_TRUE(thrown);
+    ASSERT_EQUAL(calls, 1);
+}
+
+// Test that the token bucket spaces requests to the configured rate.
+TEST_CASE(ApiLogic_RateLimiterSpacesRequests) {
+    // Given a limiter of 50 requests/second without burst
+    RequestRateLimiter limiter(50.0, 1.0);
+
+    // When acquiring six tokens
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 6; ++i) limiter.acquire();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Then the five waits take at least ~100 ms
+    ASSERT_TRUE(elapsed >= 0.09);
+}
+
+// Test that concurrent waiters reserve consecutive slots of one shared budget.
+TEST_CASE(ApiLogic_RateLimiterConcurrentWaiters) {
+    // Given a limiter of 20 requests/second without burst
+    RequestRateLimiter limiter(20.0);
+
+    // When four threads acquire two tokens each
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) threads.emplace_back([&] { limiter.acquire(); limiter.acquire(); });
+    for (auto& t : threads) t.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Then the eight tokens take seven intervals, not more
+    ASSERT_TRUE(elapsed >= 0.34);
+    ASSERT_TRUE(elapsed < 0.6);
+}
+
+// Test that an asynchronous fetch hands out batches while later ones are still in flight.
+TEST_CASE(ApiLogic_AsyncFetchStreamsBatches) {
+    // Given five single-accession batches served by a slow getter
+    NcbiFetchOptions options;
+    options.maxBatchSize = 1;
+    options.concurrency = 1;
+    options.requestsPerSecond = 1000;
+    auto slow_getter = [](const std::string& url, const std::string&) -> std::string {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return echoAccessions(url);
+    };
+
+    // When polling until the fetch completes
+    auto fetch = fetchGeneDataFromNCBIAsync({"A", "B", "C", "D", "E"}, options, "", slow_getter);
+    std::vector<GeneModel> genes;
+    bool partial = false;
+    while (!fetch->isDone()) {
+        if (fetch->poll(genes) > 0 && !fetch->isDone()) partial = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    fetch->wait();
+    fetch->poll(genes);
+
+    // Then genes arrived before the end, and every batch was delivered
+    ASSERT_TRUE(partial);
+    ASSERT_EQUAL(genes.size(), 5);
+    ASSERT_EQUAL(fetch->progress().batchesTotal, 5);
+    ASSERT_EQUAL(fetch->progress().batchesDone, 5);
+    ASSERT_EQUAL(fetch->progress().genesReceived, 5);
+}
+
+// Test that a batch sink receives every gene instead of poll().
+TEST_CASE(ApiLogic_AsyncFetchPublishesToSink) {
+    // Given six accessions in three batches and a sink into a snapshot store
+    NcbiFetchOptions options;
+    options.maxBatchSize = 2;
+    options.concurrency = 3;
+    options.requestsPerSecond = 1000;
+    GeneSnapshotStore store;
+    options.batchSink = [&](std::vector<GeneModel>&& genes) { store.append(std::move(genes)); };
+    auto getter = [](const std::string& url, const std::string&) { return echoAccessions(url); };
+
+    // When the fetch completes
+    auto fetch = fetchGeneDataFromNCBIAsync({"A", "B", "C", "D", "E", "F"}, options, "", getter);
+    fetch->wait();
+
+    // Then every gene is in the store, one version per batch, and none is left to poll
+    std::vector<GeneModel> polled;
+    ASSERT_EQUAL(fetch->poll(polled), 0);
+    auto snapshot = store.snapshot();
+    ASSERT_EQUAL(snapshot->size(), 6);
+    ASSERT_EQUAL(store.version(), 3);
+    std::vector<std::string> symbols;
+    snapshot->forEach([&](const GeneModel& g) { symbols.push_back(g.symbol); });
+    std::sort(symbols.begin(), symbols.end());
+    ASSERT_TRUE(symbols == std::vector<std::string>({"A", "B", "C", "D", "E", "F"}));
+    ASSERT_EQUAL(fetch->progress().genesReceived, 6);
+    ASSERT_EQUAL(fetch->progress().batchesDone, 3);
+}
+
+// Test that cancelling stops issuing requests and that batch errors reach the future.
+TEST_CASE(ApiLogic_AsyncFetchCancelAndErrors) {
+    // Given twenty slow single-accession batches
+    NcbiFetchOptions options;
+    options.maxBatchSize = 1;
+    options.concurrency = 1;
+    options.requestsPerSecond = 1000;
+    std::atomic<int> calls{0};
+    auto slow_getter = [&](const std::string& url, const std::string&) -> std::string {
+        ++calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return echoAccessions(url);
+    };
+    std::vector<std::string> accessions;
+    for (int i = 0; i < 20; ++i) accessions.push_back("GENE" + std::to_string(i));
+
+    // When cancelling after the first batch arrives
+    auto fetch = fetchGeneDataFromNCBIAsync(accessions, options, "", slow_getter);
+    while (fetch->progress().genesReceived == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    fetch->cancel();
+    fetch->wait();
+
+    // Then the fetch completes early without error and accounts for every batch
+    ASSERT_TRUE(fetch->isCancelled());
+    ASSERT_TRUE(calls.load() < 20);
+    ASSERT_EQUAL(fetch->progress().batchesDone, 20);
+    std::vector<GeneModel> genes;
+    ASSERT_EQUAL(fetch->poll(genes), size_t(calls.load()));
+
+    // Given a getter that fails permanently
+    auto failing_getter = [](const std::string&, const std::string&) -> std::string {
+        throw NcbiHttpError(404, "not found");
+    };
+
+    // Then waiting rethrows the error
+    auto failed = fetchGeneDataFromNCBIAsync({"BRCA1"}, options, "", failing_getter);
+    bool thrown = false;
+    try {
+        failed->wait();
+    } catch (const NcbiHttpError& e) {
+        thrown = true;
+        ASSERT_EQUAL(e.status(), 404);
+    }
+    ASSERT_TRUE(thrown);
+    ASSERT_TRUE(failed->isDone());
+}
+
+// Test that the stream parser emits each gene as soon as its object closes, whatever the chunking.
+TEST_CASE(ApiLogic_StreamParserHandlesAnyChunking) {
+    // Given the complex test response
+    std::ifstream file("tests/new_gene_data.json");
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string body = buffer.str();
+
+    for (size_t chunk : {size_t(1), size_t(7), body.size()}) {
+        // When feeding it in chunks of the given size
+        std::vector<GeneModel> genes;
+        GeneJsonStreamParser parser([&](GeneModel&& g) { genes.push_back(std::move(g)); });
+        size_t max_buffered = 0;
+        for (size_t pos = 0; pos < body.size(); pos += chunk) {
+            parser.feed(body.data() + pos, std::min(chunk, body.size() - pos));
+            max_buffered = std::max(max_buffered, parser.bufferedBytes());
+        }
+
+        // Then all genes are parsed and at most one object was buffered at a time
+        ASSERT_TRUE(parser.complete());
+        ASSERT_EQUAL(parser.genesEmitted(), 3);
+        ASSERT_EQUAL(genes.size(), 3);
+        ASSERT_EQUAL(genes[1].symbol, "HTT");
+        ASSERT_EQUAL(genes[1].isKnockout, true);
+        ASSERT_EQUAL(genes[2].brainRegionExpression.at("Parietal Lobe"), 0.9);
+        ASSERT_TRUE(max_buffered < body.size() / 2);
+    }
+
+    // Given braces inside strings and a body cut off mid-object
+    std::vector<GeneModel> genes;
+    GeneJsonStreamParser parser([&](GeneModel&& g) { genes.push_back(std::move(g)); });
+    parser.feed("{\"note\": \"{[\", \"genes\" : [{\"description\": \"a } b\", \"gene_name\": \"EGFR\"},");
+    ASSERT_EQUAL(genes.size(), 1);
+    ASSERT_EQUAL(genes[0].symbol, "EGFR");
+    parser.feed("{\"gene_name\": \"TP");
+
+    // Then the partial object is held back and the stream is reported incomplete
+    ASSERT_EQUAL(genes.size(), 1);
+    ASSERT_FALSE(parser.complete());
+    ASSERT_TRUE(parser.bufferedBytes() > 0);
+}
+
+// Test that a streaming getter feeds the fetch without materializing the body.
+TEST_CASE(ApiLogic_StreamingGetterFetch) {
+    // Given a streaming getter that sends each echoed response three bytes at a time
+    NcbiFetchOptions options;
+    options.maxBatchSize = 2;
+    options.requestsPerSecond = 1000;
+    std::atomic<int> chunks{0};
+    options.streamingGetter = [&](const std::string& url, const std::string&, const HttpChunkSink& sink) {
+        std::string body = echoAccessions(url);
+        for (size_t pos = 0; pos < body.size(); pos += 3) {
+            sink(body.data() + pos, std::min<size_t>(3, body.size() - pos));
+            ++chunks;
+        }
+    };
+
+    // When fetching five accessions
+    auto genes = fetchGeneDataFromNCBI({"A", "B", "C", "D", "E"}, options);
+
+    // Then the genes arrive in order from many small chunks
+    ASSERT_EQUAL(genes.size(), 5);
+    ASSERT_EQUAL(genes[0].symbol, "A");
+    ASSERT_EQUAL(genes[4].symbol, "E");
+    ASSERT_TRUE(chunks.load() > 30);
+
+    // And a stream that delivers nothing is reported as a failed response
+    options.streamingGetter = [](const std::string&, const std::string&, const HttpChunkSink&) {};
+    bool thrown = false;
+    try {
+        fetchGeneDataFromNCBI({"A"}, options);
+    } catch (const std::runtime_error& e) {
+        thrown = true;
+        ASSERT_EQUAL(std::string(e.what()), std::string("Failed to get a response from NCBI API."));
+    }
+    ASSERT_TRUE(thrown);
+}
+
+// Test that a body cut off mid-array is retried instead of returned as a partial batch.
+TEST_CASE(ApiLogic_TruncatedBodyIsRetried) {
+    NcbiFetchOptions options;
+    options.baseBackoff = std::chrono::milliseconds(1);
+    options.requestsPerSecond = 1000;
+    options.maxRetries = 2;
+
+    // Given a streaming getter whose first response stops after the first gene
+    int calls = 0;
+    options.streamingGetter = [&](const std::string& url, const std::string&, const HttpChunkSink& sink) {
+        std::string body = echoAccessions(url);
+        if (++calls == 1) body.resize(body.find("},") + 2);
+        sink(body.data(), body.size());
+    };
+
+    // When fetching three accessions
+    auto genes = fetchGeneDataFromNCBI({"A", "B", "C"}, options);
+
+    // Then the short read was retried and the whole batch came back
+    ASSERT_EQUAL(calls, 2);
+    ASSERT_EQUAL(genes.size(), 3);
+
+    // Given a plain getter that always stops mid-array
+    options.streamingGetter = nullptr;
+    calls = 0;
+    auto short_getter = [&](const std::string& url, const std::string&) -> std::string {
+        ++calls;
+        std::string body = echoAccessions(url);
+        return body.substr(0, body.size() - 2);
+    };
+
+    // Then the fetch fails once the retries are used up
+    bool thrown = false;
+    try {
+        fetchGeneDataFromNCBI({"A", "B"}, options, "", short_getter);
+    } catch (const NcbiIncompleteResponse& e) {
+        thrown = true;
+        ASSERT_TRUE(e.bytesReceived() > 0);
+    }
+    ASSERT_TRUE(thrown);
+    ASSERT_EQUAL(calls, 3);
+
+    // And a complete body without a "genes" array is an empty batch, not a truncated one
+    auto empty_getter = [](const std::string&, const std::string&) -> std::string {
+        return "{\"total_count\": 0, \"messages\": [{\"note\": \"no match\"}]}";
+    };
+    ASSERT_TRUE(fetchGeneDataFromNCBI({"A"}, options, "", empty_getter).empty());
+}
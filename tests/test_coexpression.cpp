@@ -0,0 +1,176 @@
+#include "coexpression.h"
+#include "test_runner.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+static GeneModel profiledGene(const std::string& symbol, const std::vector<std::pair<std::string, double>>& regions) {
+    GeneModel g{symbol, "1", 0, 10, 1.0, 0.0, false, {}};
+    for (const auto& r : regions) setRegionExpression(g.brainRegionExpression, r.first, r.second);
+    return g;
+}
+
+// Naive correlation of two complete profiles, ranking first for Spearman.
+static double naiveCorrelation(std::vector<double> x, std::vector<double> y, bool spearman) {
+    auto rank = [](std::vector<double>& v) {
+        std::vector<double> ranked(v.size());
+        for (size_t i = 0; i < v.size(); ++i) {
+            double below = 0, equal = 0;
+            for (double w : v) {
+                below += w < v[i];
+                equal += w == v[i];
+            }
+            ranked[i] = below + (equal + 1) / 2;
+        }
+        v = ranked;
+    };
+    if (spearman) {
+        rank(x);
+        rank(y);
+    }
+    double mx = 0, my = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        mx += x[i] / double(x.size());
+        my += y[i] / double(y.size());
+    }
+    double sxy = 0, sxx = 0, syy = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        sxy += (x[i] - mx) * (y[i] - my);
+        sxx += (x[i] - mx) * (x[i] - mx);
+        syy += (y[i] - my) * (y[i] - my);
+    }
+    return sxy / std::sqrt(sxx * syy);
+}
+
+// Test Pearson, Spearman, exclusions, adjacency and export on a small map.
+TEST_CASE(Coexpression_HandCheckedNetwork) {
+    // Given two genes rising together, one falling, one non-linear but
+    // monotone, one flat and one with too few regions
+    std::vector<GeneModel> genes = {
+        profiledGene("UP1", {{"amygdala", 1}, {"cortex", 2}, {"hippocampus", 3}, {"striatum", 4}}),
+        profiledGene("UP2", {{"amygdala", 2}, {"cortex", 4}, {"hippocampus", 6}, {"striatum", 8}}),
+        profiledGene("DOWN", {{"amygdala", 4}, {"cortex", 3}, {"hippocampus", 2}, {"striatum", 1}}),
+        profiledGene("CURVE", {{"amygdala", 1}, {"cortex", 2}, {"hippocampus", 4}, {"striatum", 100}}),
+        profiledGene("FLAT", {{"amygdala", 5}, {"cortex", 5}, {"hippocampus", 5}, {"striatum", 5}}),
+        profiledGene("SPARSE", {{"cortex", 1}, {"thalamus", 2}}),
+    };
+
+    // When a Pearson network is built with a 0.99 floor
+    CoexpressionOptions options;
+    options.minCorrelation = 0.99;
+    CoexpressionNetwork pearson = buildCoexpressionNetwork(genes, options);
+
+    // Then the flat and sparse genes are left out, and the regions are the union
+    ASSERT_EQUAL(pearson.nodeCount(), 4);
+    ASSERT_EQUAL(pearson.excludedGenes, 2);
+    ASSERT_TRUE(pearson.symbols == std::vector<std::string>({"UP1", "UP2", "DOWN", "CURVE"}));
+    ASSERT_EQUAL(pearson.regions.size(), 5);
+    ASSERT_EQUAL(pearson.pairsComputed, 6);
+
+    // And only the linear pairs pass, with their signs
+    ASSERT_EQUAL(pearson.edges.size(), 3);
+    ASSERT_TRUE(pearson.edges[0].a == 0 && pearson.edges[0].b == 1 && std::abs(pearson.edges[0].correlation - 1) < 1e-12);
+    ASSERT_TRUE(pearson.edges[1].a == 0 && pearson.edges[1].b == 2 && std::abs(pearson.edges[1].correlation + 1) < 1e-12);
+    ASSERT_TRUE(pearson.edges[2].a == 1 && pearson.edges[2].b == 2);
+    ASSERT_EQUAL(pearson.degree(0), 2);
+    ASSERT_EQUAL(pearson.degree(3), 0);
+
+    // When Spearman is used instead
+    options.method = CorrelationMethod::Spearman;
+    CoexpressionNetwork spearman = buildCoexpressionNetwork(genes, options);
+
+    // Then the monotone curve joins the rising genes
+    ASSERT_EQUAL(spearman.edges.size(), 6);
+    ASSERT_EQUAL(spearman.degree(3), 3);
+    const auto& first = spearman.neighbours[spearman.offsets[3]];
+    ASSERT_TRUE(std::abs(std::abs(first.correlation) - 1) < 1e-12);
+
+    // And with top-1 and no floor each gene keeps one partner, unioned
+    options.minCorrelation = 0.0;
+    options.topK = 1;
+    CoexpressionNetwork top = buildCoexpressionNetwork(genes, options);
+    ASSERT_EQUAL(top.edges.size(), 3);
+    bool everyoneHasOne = true;
+    for (size_t node = 0; node < top.nodeCount(); ++node) everyoneHasOne = everyoneHasOne && top.degree(node) >= 1;
+    ASSERT_TRUE(everyoneHasOne);
+
+    // And the edges can be exported
+    ASSERT_TRUE(writeCoexpressionEdgesCSV(pearson, "test_coexpression.csv"));
+    std::ifstream in("test_coexpression.csv");
+    std::string header, line;
+    std::getline(in, header);
+    std::getline(in, line);
+    ASSERT_EQUAL(header, "gene_a,gene_b,correlation");
+    ASSERT_EQUAL(line, "UP1,UP2,1");
+    in.close();
+    std::remove("test_coexpression.csv");
+}
+
+// Test that tiles, threads and top-K agree with a naive dense matrix.
+TEST_CASE(Coexpression_TilesMatchDenseMatrix) {
+    // Given 53 genes over 9 regions with ties, built from a few shared patterns
+    std::mt19937 rng(11);
+    const int regions = 9;
+    std::vector<std::vector<double>> profiles;
+    std::vector<GeneModel> genes;
+    for (int g = 0; g < 53; ++g) {
+        std::vector<double> values;
+        std::vector<std::pair<std::string, double>> named;
+        for (int r = 0; r < regions; ++r) {
+            double v = double((g % 4 + 1) * r % 7) + double(rng() % 4);
+            values.push_back(v);
+            named.emplace_back("region" + std::to_string(r), v);
+        }
+        profiles.push_back(values);
+        genes.push_back(profiledGene("G" + std::to_string(g), named));
+    }
+
+    for (bool spearman : {false, true}) {
+        // When built whole on one thread and in small tiles on four
+        CoexpressionOptions whole;
+        whole.method = spearman ? CorrelationMethod::Spearman : CorrelationMethod::Pearson;
+        whole.minCorrelation = 0.5;
+        whole.threads = 1;
+        CoexpressionOptions tiled = whole;
+        tiled.threads = 4;
+        tiled.tileGenes = 7;
+        CoexpressionNetwork a = buildCoexpressionNetwork(genes, whole);
+        CoexpressionNetwork b = buildCoexpressionNetwork(genes, tiled);
+
+        // Then both hold exactly the pairs of the dense matrix above the floor
+        std::vector<std::vector<double>> dense(53, std::vector<double>(53));
+        size_t expected = 0;
+        for (size_t i = 0; i < 53; ++i) {
+            for (size_t j = i + 1; j < 53; ++j) {
+                dense[i][j] = dense[j][i] = naiveCorrelation(profiles[i], profiles[j], spearman);
+                expected += std::abs(dense[i][j]) >= 0.5 + 1e-9;
+            }
+        }
+        bool same = a.edges.size() == b.edges.size();
+        for (size_t e = 0; same && e < a.edges.size(); ++e) {
+            same = a.edges[e].a == b.edges[e].a && a.edges[e].b == b.edges[e].b
+                && std::abs(a.edges[e].correlation - dense[a.edges[e].a][a.edges[e].b]) < 1e-9
+                && std::abs(b.edges[e].correlation - a.edges[e].correlation) < 1e-12;
+        }
+        ASSERT_TRUE(same);
+        ASSERT_TRUE(a.edges.size() >= expected && a.edges.size() < expected + 5);
+
+        // And top-3 keeps each gene's three strongest partners
+        tiled.topK = 3;
+        tiled.minCorrelation = 0.0;
+        CoexpressionNetwork top = buildCoexpressionNetwork(genes, tiled);
+        bool strongest = true;
+        for (size_t i = 0; i < 53; ++i) {
+            std::vector<double> strengths;
+            for (size_t j = 0; j < 53; ++j) {
+                if (j != i) strengths.push_back(std::abs(dense[i][j]));
+            }
+            std::sort(strengths.rbegin(), strengths.rend());
+            const auto& best = top.neighbours[top.offsets[i]];
+            strongest = strongest && top.degree(i) >= 3 && std::abs(std::abs(best.correlation) - strengths[0]) < 1e-9;
+        }
+        ASSERT_TRUE(strongest);
+    }
+}
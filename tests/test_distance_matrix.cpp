@@ -0,0 +1,132 @@
+#include "distance_matrix.h"
+#include "test_runner.h"
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+static SequenceModel sequence(const std::string& name, const std::string& aligned) {
+    return {name, SequenceType::DNA, aligned, aligned};
+}
+
+// Test identity, p-distance and Jukes-Cantor on a block checked by hand.
+TEST_CASE(DistanceMatrix_HandCheckedMeasures) {
+    // Given three sequences with a gap, an N, mixed case and a U
+    std::vector<SequenceModel> seqs = {sequence("a", "ACGTACGT"),
+                                       sequence("b", "acgaACG-"),
+                                       sequence("c", "TGCAnCGU")};
+
+    // When the matrix is computed
+    DistanceMatrix m = computeDistanceMatrix(seqs);
+
+    // Then gaps and N drop out pairwise, case is ignored and U equals T
+    ASSERT_EQUAL(m.size(), 3);
+    ASSERT_EQUAL(m.pairCount(), 3);
+    ASSERT_EQUAL(m.compared(0, 1), 7);
+    ASSERT_EQUAL(m.mismatches(1, 0), 1);
+    ASSERT_EQUAL(m.compared(0, 2), 7);
+    ASSERT_EQUAL(m.mismatches(0, 2), 4);
+    ASSERT_EQUAL(m.compared(1, 2), 6);
+    ASSERT_EQUAL(m.mismatches(1, 2), 3);
+
+    // And the measures follow from the counts
+    ASSERT_EQUAL(m.value(1, 1, DistanceMeasure::Identity), 1.0);
+    ASSERT_EQUAL(m.value(1, 1, DistanceMeasure::JukesCantor), 0.0);
+    ASSERT_TRUE(std::abs(m.value(0, 1, DistanceMeasure::Identity) - 6.0 / 7) < 1e-12);
+    ASSERT_TRUE(std::abs(m.value(1, 2, DistanceMeasure::PDistance) - 0.5) < 1e-12);
+    ASSERT_TRUE(std::abs(m.value(2, 1, DistanceMeasure::JukesCantor) - (-0.75 * std::log(1 - 4.0 / 3 * 0.5))) < 1e-12);
+    ASSERT_TRUE(std::abs(m.value(0, 2, DistanceMeasure::PDistance) - 4.0 / 7) < 1e-12);
+    std::vector<double> condensed = m.condensed(DistanceMeasure::PDistance);
+    ASSERT_EQUAL(condensed.size(), 3);
+    ASSERT_TRUE(std::abs(condensed[DistanceMatrix::pairIndex(1, 2, 3)] - 0.5) < 1e-12);
+
+    // And a pair with no comparable columns is NaN, and Jukes-Cantor saturates past p = 0.75
+    DistanceMatrix none = computeDistanceMatrix({sequence("x", "AC--"), sequence("y", "--GT")});
+    ASSERT_TRUE(std::isnan(none.value(0, 1, DistanceMeasure::PDistance)));
+    DistanceMatrix saturated = computeDistanceMatrix({sequence("x", "ACGT"), sequence("y", "CATG")});
+    ASSERT_TRUE(std::isinf(saturated.value(0, 1, DistanceMeasure::JukesCantor)));
+
+    // And the CSV has a named header row and column
+    ASSERT_TRUE(writeDistanceMatrixCSV(m, seqs, DistanceMeasure::PDistance, "test_distances.csv"));
+    std::ifstream in("test_distances.csv");
+    std::string header, first, last;
+    std::getline(in, header);
+    std::getline(in, first);
+    std::getline(in, last);
+    std::getline(in, last);
+    ASSERT_EQUAL(header, "sequence,a,b,c");
+    ASSERT_EQUAL(first.substr(0, 4), "a,0,");
+    ASSERT_EQUAL(last.substr(last.size() - 2), ",0");
+    in.close();
+    std::remove("test_distances.csv");
+}
+
+// Test that identical sequences are at distance +0 and print as "0", not "-0".
+TEST_CASE(DistanceMatrix_IdenticalSequencesPrintZero) {
+    // Given two identical sequences and a third that differs
+    std::vector<SequenceModel> seqs = {sequence("x", "ACGTACGT"), sequence("y", "ACGTACGT"),
+                                       sequence("z", "ACGTACGA")};
+    DistanceMatrix m = computeDistanceMatrix(seqs);
+
+    // When measuring the identical pair, then no measure carries a sign bit
+    ASSERT_EQUAL(m.value(0, 1, DistanceMeasure::JukesCantor), 0.0);
+    ASSERT_FALSE(std::signbit(m.value(0, 1, DistanceMeasure::JukesCantor)));
+    ASSERT_FALSE(std::signbit(m.condensed(DistanceMeasure::JukesCantor)[0]));
+    ASSERT_EQUAL(m.value(0, 1, DistanceMeasure::Identity), 1.0);
+
+    // And the Jukes-Cantor CSV rows show plain zeros
+    std::string path = (std::filesystem::temp_directory_path() / "alignment_map_identical_distances.csv").string();
+    ASSERT_TRUE(writeDistanceMatrixCSV(m, seqs, DistanceMeasure::JukesCantor, path));
+    std::ifstream in(path);
+    std::string header, first, second;
+    std::getline(in, header);
+    std::getline(in, first);
+    std::getline(in, second);
+    in.close();
+    std::remove(path.c_str());
+    ASSERT_EQUAL(first.substr(0, 6), "x,0,0,");
+    ASSERT_EQUAL(second.substr(0, 6), "y,0,0,");
+}
+
+// Test that tiling, column bands and threads do not change any count.
+TEST_CASE(DistanceMatrix_TilesMatchPairwiseScan) {
+    // Given 37 ragged sequences over ACGT, N and gaps
+    std::mt19937 rng(5);
+    std::vector<SequenceModel> seqs;
+    for (int s = 0; s < 37; ++s) {
+        std::string text;
+        for (int c = 0, n = 150 + int(rng() % 120); c < n; ++c) text.push_back("ACGTACGTN-"[rng() % 10]);
+        seqs.push_back(sequence("s" + std::to_string(s), text));
+    }
+
+    // When computed with small tiles and bands on several threads
+    DistanceOptions options;
+    options.threads = 4;
+    options.tileSequences = 5;
+    options.bandColumns = 64;
+    DistanceMatrix tiled = computeDistanceMatrix(seqs, options);
+    DistanceMatrix whole = computeDistanceMatrix(seqs);
+
+    // Then every pair matches a direct character comparison
+    auto code = [](char c) { c = char(std::toupper(c)); return c == 'U' ? 'T' : c; };
+    bool same = true;
+    for (size_t i = 0; i < seqs.size(); ++i) {
+        for (size_t j = i + 1; j < seqs.size(); ++j) {
+            size_t compared = 0, mismatches = 0;
+            const std::string& a = seqs[i].aligned;
+            const std::string& b = seqs[j].aligned;
+            for (size_t c = 0; c < std::min(a.size(), b.size()); ++c) {
+                bool baseA = std::string("ACGT").find(code(a[c])) != std::string::npos;
+                bool baseB = std::string("ACGT").find(code(b[c])) != std::string::npos;
+                if (!baseA || !baseB) continue;
+                ++compared;
+                mismatches += code(a[c]) != code(b[c]);
+            }
+            same = same && tiled.compared(i, j) == compared && tiled.mismatches(j, i) == mismatches
+                        && whole.compared(i, j) == compared && whole.mismatches(i, j) == mismatches;
+        }
+    }
+    ASSERT_TRUE(same);
+}
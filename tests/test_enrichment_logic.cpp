@@ -0,0 +1,55 @@
+#include "enrichment_logic.h"
+#include "test_runner.h"
+#include <cmath>
+
+// Test the hypergeometric tail against hand-computed values.
+TEST_CASE(Enrichment_HypergeometricTail) {
+    // Drawing all 3 successes out of 10 with 3 draws: 1 / C(10,3)
+    ASSERT_TRUE(std::abs(hypergeometricUpperTail(3, 10, 3, 3) - 1.0 / 120.0) < 1e-12);
+    // P(X >= 0) is always 1, and an impossible overlap has probability 0
+    ASSERT_EQUAL(hypergeometricUpperTail(0, 10, 3, 3), 1.0);
+    ASSERT_EQUAL(hypergeometricUpperTail(4, 10, 3, 3), 0.0);
+    // P(X >= 1) = 1 - C(7,3)/C(10,3) = 1 - 35/120
+    ASSERT_TRUE(std::abs(hypergeometricUpperTail(1, 10, 3, 3) - 85.0 / 120.0) < 1e-12);
+}
+
+// Test the tail at the lower edge of the support.
+TEST_CASE(Enrichment_HypergeometricTailLowerBound) {
+    // 5 draws from 10 with 8 successes always overlap by at least 3
+    ASSERT_EQUAL(hypergeometricUpperTail(3, 10, 8, 5), 1.0);
+    ASSERT_EQUAL(hypergeometricUpperTail(2, 10, 8, 5), 1.0);
+    // P(X >= 4) = 1 - C(8,3)C(2,2)/C(10,5) = 1 - 56/252
+    ASSERT_TRUE(std::abs(hypergeometricUpperTail(4, 10, 8, 5) - 196.0 / 252.0) < 1e-12);
+}
+
+// Test that knockouts concentrated in one pathway rank that pathway first.
+TEST_CASE(Enrichment_RanksOverlappingSetsFirst) {
+    // Given the demo pathways, a background of unrelated genes and a gene set
+    AlignmentMap map;
+    for (const auto& p : createDemoPathways()) map.addPathway(p);
+    map.addGeneSet({"Synapse", {"GRIN2B", "CAMK2A", "DLG4"}});
+    for (int i = 0; i < 40; ++i) map.addGene({"BG" + std::to_string(i), "1", 0, 0, 1.0, 0.0, false});
+    map.addGene({"CREB1", "14", 0, 0, 5.0, 0.0, true});
+    map.addGene({"GRIN2B", "12", 0, 0, 5.0, 0.0, true});
+    map.addGene({"CAMK2A", "5", 0, 0, 5.0, 0.0, true});
+
+    // When testing the current knockouts
+    auto query = getKnockoutSymbols(map);
+    ASSERT_EQUAL(query.size(), 3);
+    auto results = runEnrichmentAnalysis(map, query);
+
+    // Then only sets sharing genes with the query are reported, best first
+    ASSERT_EQUAL(results.size(), 2);
+    ASSERT_EQUAL(results[0].name, "Neural Plasticity");
+    ASSERT_TRUE(results[0].isPathway);
+    ASSERT_EQUAL(results[0].overlap, 3);
+    ASSERT_EQUAL(results[0].setSize, 4);
+    ASSERT_EQUAL(results[1].name, "Synapse");
+    ASSERT_EQUAL(results[1].overlap, 2);
+    ASSERT_TRUE(results[0].pValue < results[1].pValue);
+
+    // And FDR is adjusted over all three tested sets
+    ASSERT_TRUE(results[0].fdr >= results[0].pValue);
+    ASSERT_TRUE(results[0].fdr <= results[1].fdr);
+    ASSERT_TRUE(std::abs(results[0].fdr - std::min(1.0, results[0].pValue * 3.0)) < 1e-12);
+}
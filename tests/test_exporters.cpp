@@ -0,0 +1,101 @@
+#include "exporters.h"
+#include "test_runner.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+static std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// Test that exported genes load back unchanged, in both schemas and with edits applied.
+TEST_CASE(Exporters_GeneRoundTrip) {
+    // Given the sample genes with one knockout toggled and awkward values added
+    AlignmentMap map;
+    map.loadGenesFromJSON("tests/genes.json");
+    ASSERT_TRUE(map.getGenes().size() > 1);
+    map.toggleKnockout(map.getGenes()[0].symbol);
+    GeneModel extra;
+    extra.symbol = "EXTRA1";
+    extra.expressionLevel = 0.1 + 0.2; // needs all 17 digits to round-trip
+    extra.categories = {"synthetic"};
+    setRegionExpression(extra.brainRegionExpression, "Cortex", 1234567.5);
+    map.addGene(extra);
+
+    for (ExportFormat format : {ExportFormat::CSV, ExportFormat::JSON}) {
+        // When exported and loaded into a fresh map
+        std::string path = format == ExportFormat::CSV ? "test_export_genes.csv" : "test_export_genes.json";
+        ASSERT_TRUE(exportGenes(map, path, format));
+        AlignmentMap loaded;
+        if (format == ExportFormat::CSV) loaded.loadGenesFromCSV(path);
+        else loaded.loadGenesFromJSON(path);
+        std::remove(path.c_str());
+
+        // Then every exported field comes back exactly
+        const auto& a = map.getGenes();
+        const auto& b = loaded.getGenes();
+        ASSERT_EQUAL(b.size(), a.size());
+        for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+            ASSERT_EQUAL(b[i].symbol, a[i].symbol);
+            ASSERT_EQUAL(b[i].isKnockout, a[i].isKnockout);
+            ASSERT_EQUAL(b[i].expressionLevel, a[i].expressionLevel);
+            ASSERT_TRUE(b[i].disorderTags == a[i].disorderTags);
+            ASSERT_TRUE(b[i].brainRegionExpression == a[i].brainRegionExpression);
+            // The CSV schema has no categories column
+            if (format == ExportFormat::JSON) ASSERT_TRUE(b[i].categories == a[i].categories);
+        }
+    }
+
+    // And FASTA is refused for genes, as is an unwritable path
+    ASSERT_FALSE(exportGenes(map, "test_export_genes.fa", ExportFormat::FASTA));
+    ASSERT_FALSE(exportGenes(map, "no_such_dir/genes.csv", ExportFormat::CSV));
+}
+
+// Test streaming sequence export after edits, in CSV, JSON and FASTA.
+TEST_CASE(Exporters_SequenceStreams) {
+    // Given the demo alignment with a gap inserted and a base edited
+    AlignmentEditor editor;
+    editor.loadDemoDNA();
+    editor.toggleGap();
+    editor.moveCursor(3);
+    editor.editSelectedBase('T');
+    const auto& sequences = editor.getSequences();
+
+    for (ExportFormat format : {ExportFormat::CSV, ExportFormat::JSON}) {
+        // When exported and loaded into a fresh editor
+        std::string path = format == ExportFormat::CSV ? "test_export_seqs.csv" : "test_export_seqs.json";
+        ASSERT_TRUE(exportSequences(sequences, path, format));
+        AlignmentEditor loaded;
+        if (format == ExportFormat::CSV) loaded.loadSequencesFromCSV(path);
+        else loaded.loadSequencesFromJSON(path);
+        std::remove(path.c_str());
+
+        // Then the edited (aligned) sequences come back
+        ASSERT_EQUAL(loaded.getSequences().size(), sequences.size());
+        for (size_t i = 0; i < sequences.size() && i < loaded.getSequences().size(); ++i) {
+            ASSERT_EQUAL(loaded.getSequences()[i].name, sequences[i].name);
+            ASSERT_EQUAL(loaded.getSequences()[i].aligned, sequences[i].aligned);
+        }
+    }
+
+    // When streaming a long record as FASTA through a buffer smaller than the record
+    SequenceModel longSeq{"chrTest", SequenceType::DNA, "", std::string(1000, 'A') + "CG"};
+    {
+        SequenceExportStream stream("test_export_seqs.fasta", exportFormatForPath("test_export_seqs.fasta"), 600, 100);
+        ASSERT_TRUE(stream.good());
+        stream.write(longSeq);
+        stream.write(sequences[0]);
+        ASSERT_EQUAL(stream.recordsWritten(), 2);
+        ASSERT_TRUE(stream.finish());
+    }
+    std::string fasta = readFile("test_export_seqs.fasta");
+    std::remove("test_export_seqs.fasta");
+
+    // Then the header is followed by lines wrapped at the requested width
+    ASSERT_EQUAL(fasta.substr(0, 9), ">chrTest\n");
+    ASSERT_EQUAL(fasta.find('\n', 9), size_t(9 + 100));
+    size_t tail = fasta.find("CG\n>");
+    ASSERT_TRUE(tail != std::string::npos);
+    ASSERT_EQUAL(fasta.substr(tail + 3, sequences[0].name.size() + 2), ">" + sequences[0].name + "\n");
+}
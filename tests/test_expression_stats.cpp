@@ -0,0 +1,136 @@
+#include "expression_stats.h"
+#include "map_logic.h"
+#include "test_runner.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Deterministic skewed values: squares of uniforms, so the upper tail is sparse.
+static std::vector<double> skewedValues(size_t count, uint64_t seed) {
+    std::vector<double> values;
+    for (size_t i = 0; i < count; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        double u = double(seed >> 11) / double(1ULL << 53);
+        values.push_back(10.0 * u * u);
+    }
+    return values;
+}
+
+// Fraction of `sorted` that is <= x.
+static double exactRank(const std::vector<double>& sorted, double x) {
+    return double(std::upper_bound(sorted.begin(), sorted.end(), x) - sorted.begin()) / double(sorted.size());
+}
+
+// Test that the sketch tracks median and tails within a small rank error, also when merged from shards.
+TEST_CASE(QuantileSketch_AccuracyAndMerge) {
+    // Given 200000 skewed values, added whole and as four shards
+    auto values = skewedValues(200000, 1);
+    QuantileSketch whole;
+    std::vector<QuantileSketch> shards(4);
+    for (size_t i = 0; i < values.size(); ++i) {
+        whole.add(values[i]);
+        shards[i % 4].add(values[i]);
+    }
+    QuantileSketch merged;
+    for (const auto& shard : shards) merged.merge(shard);
+    std::sort(values.begin(), values.end());
+
+    // Then estimates land within 0.5% rank of the truth, tighter at the tails
+    for (const QuantileSketch* sketch : {&whole, &merged}) {
+        ASSERT_EQUAL(sketch->count(), 200000.0);
+        ASSERT_EQUAL(sketch->min(), values.front());
+        ASSERT_EQUAL(sketch->max(), values.back());
+        ASSERT_TRUE(std::abs(exactRank(values, sketch->quantile(0.5)) - 0.5) < 0.005);
+        ASSERT_TRUE(std::abs(exactRank(values, sketch->quantile(0.99)) - 0.99) < 0.001);
+        ASSERT_TRUE(std::abs(exactRank(values, sketch->quantile(0.001)) - 0.001) < 0.0005);
+        ASSERT_TRUE(std::abs(sketch->cdf(values[150000]) - 0.75) < 0.005);
+        // And its size is bounded by the compression, not the value count
+        ASSERT_TRUE(sketch->centroidCount() <= 200);
+    }
+
+    // And an empty sketch reports NaN
+    QuantileSketch empty;
+    ASSERT_TRUE(std::isnan(empty.quantile(0.5)));
+    empty.add(std::nan(""));
+    ASSERT_EQUAL(empty.count(), 0.0);
+}
+
+// Test that queries leave pending values in place and agree across threads.
+TEST_CASE(QuantileSketch_QueriesAreReadOnly) {
+    // Given a sketch whose values are all still buffered
+    QuantileSketch sketch;
+    for (double v : skewedValues(300, 7)) sketch.add(v);
+    const QuantileSketch& reader = sketch;
+    const double median = reader.quantile(0.5);
+
+    // When four threads query it at once
+    std::vector<double> seen(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < seen.size(); ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 200; ++i) seen[t] = reader.quantile(0.5);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    // Then every thread sees the same estimate, and compacting does not change it
+    for (double v : seen) ASSERT_EQUAL(v, median);
+    sketch.compact();
+    ASSERT_EQUAL(sketch.quantile(0.5), median);
+    ASSERT_EQUAL(sketch.count(), 300.0);
+}
+
+// Test incremental and one-off top-K, and the statistics kept by AlignmentMap.
+TEST_CASE(TopK_MapStatistics) {
+    // Given a map of 1000 genes with distinct expression and a region on every tenth gene
+    AlignmentMap map;
+    std::vector<GeneModel> genes;
+    auto values = skewedValues(1000, 7);
+    for (size_t i = 0; i < values.size(); ++i) {
+        GeneModel g;
+        g.symbol = "G" + std::to_string(i);
+        g.expressionLevel = values[i];
+        g.polygenicScore = double(i % 100) / 100.0;
+        if (i % 10 == 0) g.brainRegionExpression["Cortex"] = values[i] / 10.0;
+        map.addGene(g);
+    }
+
+    // When reading the top 50 by expression
+    const ExpressionStatistics& stats = map.expressionStatistics();
+    auto top = stats.topExpression.sorted(50);
+
+    // Then it equals a partial sort of all genes, highest first
+    ASSERT_EQUAL(top.size(), 50);
+    auto expected = selectTopGenes(map.getGenes(), 50, [](const GeneModel& g) { return g.expressionLevel; });
+    for (size_t i = 0; i < top.size(); ++i) ASSERT_EQUAL(top[i].symbol, expected[i].symbol);
+    ASSERT_TRUE(top[0].value >= top[49].value);
+
+    // And ties in polygenic score rank by symbol
+    auto topScore = stats.topPolygenicScore.sorted(3);
+    ASSERT_EQUAL(topScore[0].symbol, "G199");
+    ASSERT_EQUAL(topScore[1].symbol, "G299");
+
+    // And merging two partial top lists gives the top of the union
+    TopK left(5), right(5);
+    for (int i = 0; i < 10; ++i) (i % 2 ? left : right).add("S" + std::to_string(i), double(i));
+    left.merge(right);
+    ASSERT_EQUAL(left.sorted()[0].symbol, "S9");
+    ASSERT_EQUAL(left.sorted().back().symbol, "S5");
+
+    // And region sketches and region top-K only see genes with that region
+    ASSERT_EQUAL(stats.regions.at("Cortex").count(), 100.0);
+    ASSERT_EQUAL(selectTopGenesInRegion(map.getGenes(), 500, "Cortex").size(), 100);
+
+    // And calculateStatistics reports the sketch median and p99
+    GenomeStats s = map.calculateStatistics();
+    std::sort(values.begin(), values.end());
+    ASSERT_TRUE(std::abs(exactRank(values, s.medianExpression) - 0.5) < 0.01);
+    ASSERT_TRUE(s.p99Expression > s.medianExpression);
+
+    // And clearing the genes resets the statistics
+    map.clearGenes();
+    ASSERT_EQUAL(map.expressionStatistics().expression.count(), 0.0);
+    ASSERT_EQUAL(map.expressionStatistics().topExpression.size(), 0);
+}
@@ -0,0 +1,74 @@
+#include "gene_bitset.h"
+#include "test_runner.h"
+#include <cmath>
+
+// Test basic set algebra on small (array-container) sets built from symbols.
+TEST_CASE(GeneBitset_SetAlgebra) {
+    // Given two overlapping gene sets over a shared universe
+    GeneUniverse universe;
+    auto a = GeneBitset::fromSymbols({"BDNF", "CREB1", "GRIN2B", "CAMK2A"}, universe);
+    auto b = GeneBitset::fromSymbols({"GRIN2B", "CAMK2A", "DLG4", "GRIN2B"}, universe);
+    ASSERT_EQUAL(universe.size(), 5);
+    ASSERT_EQUAL(b.cardinality(), 3);
+
+    // Then intersection, union, difference and Jaccard follow set semantics
+    ASSERT_EQUAL(GeneBitset::intersectionCount(a, b), 2);
+    ASSERT_TRUE(GeneBitset::intersect(a, b).toSymbols(universe) == std::vector<std::string>({"GRIN2B", "CAMK2A"}));
+    ASSERT_EQUAL(GeneBitset::unite(a, b).cardinality(), 5);
+    auto diff = GeneBitset::difference(a, b);
+    ASSERT_EQUAL(diff.cardinality(), 2);
+    ASSERT_TRUE(diff.contains(uint32_t(universe.find("BDNF"))));
+    ASSERT_FALSE(diff.contains(uint32_t(universe.find("DLG4"))));
+    ASSERT_TRUE(std::abs(GeneBitset::jaccard(a, b) - 2.0 / 5.0) < 1e-12);
+}
+
+// Test that dense chunks switch to bitmap containers without changing results.
+TEST_CASE(GeneBitset_DenseContainers) {
+    // Given a dense set (every id below 10000) and a sparse set of multiples of 3
+    std::vector<uint32_t> dense, sparse;
+    for (uint32_t i = 0; i < 10000; ++i) dense.push_back(i);
+    for (uint32_t i = 0; i < 70000; i += 3) sparse.push_back(i);
+    auto d = GeneBitset::fromIds(dense);
+    auto s = GeneBitset::fromIds(sparse);
+
+    // Then counts across mixed containers and chunk boundaries are exact
+    ASSERT_EQUAL(d.cardinality(), 10000);
+    ASSERT_EQUAL(GeneBitset::intersectionCount(d, s), 3334);
+    ASSERT_EQUAL(GeneBitset::intersect(d, s).cardinality(), 3334);
+    ASSERT_EQUAL(GeneBitset::unite(d, s).cardinality(), 10000 + 23334 - 3334);
+    ASSERT_EQUAL(GeneBitset::difference(s, d).cardinality(), 23334 - 3334);
+
+    // And incremental adds keep the set consistent
+    d.add(65536);
+    d.add(65536);
+    ASSERT_EQUAL(d.cardinality(), 10001);
+    ASSERT_TRUE(d.contains(65536));
+    ASSERT_EQUAL(d.toIds().back(), 65536u);
+}
+
+// Test all-pairs similarity and redundancy grouping over a map's gene sets.
+TEST_CASE(GeneBitset_AllPairsSimilarity) {
+    // Given three gene sets where the first two are near-duplicates
+    AlignmentMap map;
+    map.addGeneSet({"SetA", {"G1", "G2", "G3", "G4"}});
+    map.addGeneSet({"SetB", {"G1", "G2", "G3", "G5"}});
+    map.addGeneSet({"SetC", {"G9", "G4"}});
+
+    // When computing similarities above 0.5
+    auto pairs = computeGeneSetSimilarities(map, 0.5, 2);
+
+    // Then only the redundant pair is reported
+    ASSERT_EQUAL(pairs.size(), 1);
+    ASSERT_EQUAL(pairs[0].first, 0);
+    ASSERT_EQUAL(pairs[0].second, 1);
+    ASSERT_EQUAL(pairs[0].intersection, 3);
+
+    // And grouping collapses it while keeping SetC on its own
+    auto groups = groupRedundantGeneSets(3, pairs, 0.5);
+    ASSERT_EQUAL(groups.size(), 2);
+    ASSERT_EQUAL(groups[0].size(), 2);
+    ASSERT_EQUAL(groups[1][0], 2);
+
+    // And a zero threshold reports every overlapping pair
+    ASSERT_EQUAL(computeGeneSetSimilarities(map).size(), 2);
+}
@@ -0,0 +1,181 @@
+#include "gene_cache.h"
+#include "api_logic.h"
+#include "test_runner.h"
+#include <atomic>
+#include <cctype>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Fresh, empty cache directory for a single test.
+static std::string scratchDirectory(const std::string& name) {
+    fs::path dir = fs::temp_directory_path() / ("alignment_map_" + name);
+    fs::remove_all(dir);
+    return dir.string();
+}
+
+static GeneModel sampleGene(const std::string& symbol) {
+    GeneModel g;
+    g.symbol = symbol;
+    g.chromosome = "chr17";
+    g.start = 43044295;
+    g.end = 43125483;
+    g.expressionLevel = 0.75;
+    g.categories = {"DNA Repair"};
+    g.disorderTags = {"Cancer"};
+    g.brainRegionExpression["Cortex"] = 0.4;
+    return g;
+}
+
+// Test that entries round-trip through disk and survive a new cache instance.
+TEST_CASE(GeneCache_PutGetRoundTrip) {
+    // Given a cache holding one gene
+    GeneCacheOptions options;
+    options.directory = scratchDirectory("roundtrip");
+    {
+        GeneCache cache(options);
+        cache.put("BRCA1", "fields", sampleGene("BRCA1"));
+        ASSERT_EQUAL(cache.entryCount(), 1);
+    }
+
+    // When a new instance reads it back
+    GeneCache cache(options);
+    GeneModel out;
+    ASSERT_TRUE(cache.get("BRCA1", "fields", out));
+
+    // Then every field is restored, and other keys miss
+    ASSERT_EQUAL(out.symbol, "BRCA1");
+    ASSERT_EQUAL(out.chromosome, "chr17");
+    ASSERT_EQUAL(out.end, 43125483);
+    ASSERT_EQUAL(out.categories.size(), 1);
+    ASSERT_EQUAL(out.disorderTags[0], "Cancer");
+    ASSERT_EQUAL(out.brainRegionExpression.at("Cortex"), 0.4);
+    ASSERT_FALSE(cache.get("BRCA1", "other-fields", out));
+    ASSERT_FALSE(cache.get("TP53", "fields", out));
+    fs::remove_all(options.directory);
+}
+
+// Test that expired entries are treated as misses and removed.
+TEST_CASE(GeneCache_ExpiresEntries) {
+    // Given a cache whose TTL is already exceeded by every entry
+    GeneCacheOptions options;
+    options.directory = scratchDirectory("ttl");
+    options.ttl = std::chrono::seconds(-1);
+    GeneCache cache(options);
+    cache.put("BRCA1", "fields", sampleGene("BRCA1"));
+
+    // Then the lookup misses and the file is gone
+    GeneModel out;
+    ASSERT_FALSE(cache.get("BRCA1", "fields", out));
+    ASSERT_EQUAL(cache.entryCount(), 0);
+    ASSERT_FALSE(fs::exists(cache.pathFor("BRCA1", "fields")));
+    fs::remove_all(options.directory);
+}
+
+// Test that the least recently used entries are evicted past the size budget.
+TEST_CASE(GeneCache_EvictsLeastRecentlyUsed) {
+    // Given a budget of roughly two records
+    GeneCacheOptions options;
+    options.directory = scratchDirectory("lru");
+    GeneCache probe(options);
+    probe.put("A", "f", sampleGene("A"));
+    uintmax_t record = probe.totalBytes();
+    probe.clear();
+    options.maxBytes = record * 2;
+    GeneCache cache(options);
+
+    // When A and B are stored, A is read, then C is stored
+    GeneModel out;
+    cache.put("A", "f", sampleGene("A"));
+    cache.put("B", "f", sampleGene("B"));
+    ASSERT_TRUE(cache.get("A", "f", out));
+    cache.put("C", "f", sampleGene("C"));
+
+    // Then B, the least recently used, was evicted
+    ASSERT_EQUAL(cache.entryCount(), 2);
+    ASSERT_TRUE(cache.totalBytes() <= options.maxBytes);
+    ASSERT_TRUE(cache.get("A", "f", out));
+    ASSERT_FALSE(cache.get("B", "f", out));
+    ASSERT_TRUE(cache.get("C", "f", out));
+    fs::remove_all(options.directory);
+}
+
+// Test that a cached fetch only requests the accessions it has not seen.
+TEST_CASE(GeneCache_FetchSkipsCachedAccessions) {
+    // Given a fetch backed by a cache and a getter that records requested accessions
+    GeneCacheOptions cache_options;
+    cache_options.directory = scratchDirectory("fetch");
+    GeneCache cache(cache_options);
+    NcbiFetchOptions options;
+    options.cache = &cache;
+    std::atomic<int> calls{0};
+    std::vector<std::string> requested;
+    auto getter = [&](const std::string& url, const std::string&) -> std::string {
+        ++calls;
+        size_t begin = url.find("accession/") + 10;
+        std::stringstream ss(url.substr(begin, url.find('?') - begin)), json;
+        std::string accession;
+        json << "{\"genes\": [";
+        bool first = true;
+        while (std::getline(ss, accession, ',')) {
+            requested.push_back(accession);
+            // The API reports symbols in upper case.
+            for (auto& c : accession) c = char(std::toupper(static_cast<unsigned char>(c)));
+            json << (first ? "" : ",") << "{\"gene_name\": \"" << accession << "\"}";
+            first = false;
+        }
+        json << "]}";
+        return json.str();
+    };
+
+    // When fetching twice, the second time with one extra accession
+    auto first = fetchGeneDataFromNCBI({"brca1", "TP53"}, options, "", getter);
+    ASSERT_EQUAL(calls.load(), 1);
+    ASSERT_EQUAL(first.size(), 2);
+    requested.clear();
+    auto second = fetchGeneDataFromNCBI({"TP53", "EGFR", "brca1"}, options, "", getter);
+
+    // Then only the new accession went over the network, and order follows the input
+    ASSERT_EQUAL(calls.load(), 2);
+    ASSERT_EQUAL(requested.size(), 1);
+    ASSERT_EQUAL(requested[0], "EGFR");
+    ASSERT_EQUAL(second.size(), 3);
+    ASSERT_EQUAL(second[0].symbol, "TP53");
+    ASSERT_EQUAL(second[1].symbol, "EGFR");
+    ASSERT_EQUAL(second[2].symbol, "BRCA1");
+
+    // And a fully cached request makes no HTTP call at all
+    fetchGeneDataFromNCBI({"EGFR", "brca1"}, options, "", getter);
+    ASSERT_EQUAL(calls.load(), 2);
+    fs::remove_all(cache_options.directory);
+}
+
+// Test that accession numbers bypass the symbol-keyed cache.
+TEST_CASE(GeneCache_FetchAlwaysRequestsAccessionNumbers) {
+    // Given a cached fetch whose getter answers an accession with the gene's symbol
+    GeneCacheOptions cache_options;
+    cache_options.directory = scratchDirectory("accessions");
+    GeneCache cache(cache_options);
+    NcbiFetchOptions options;
+    options.cache = &cache;
+    int calls = 0;
+    auto getter = [&](const std::string& url, const std::string&) -> std::string {
+        ++calls;
+        bool accession = url.find("NM_000546.6") != std::string::npos;
+        return std::string("{\"genes\": [{\"gene_name\": \"") + (accession ? "TP53" : "EGFR") + "\"}]}";
+    };
+
+    // When an accession and a symbol are each fetched twice
+    for (int i = 0; i < 2; ++i) {
+        ASSERT_EQUAL(fetchGeneDataFromNCBI({"NM_000546.6"}, options, "", getter)[0].symbol, "TP53");
+        ASSERT_EQUAL(fetchGeneDataFromNCBI({"EGFR"}, options, "", getter)[0].symbol, "EGFR");
+    }
+
+    // Then only the symbol was cached and served from disk the second time
+    ASSERT_EQUAL(calls, 3);
+    ASSERT_EQUAL(cache.entryCount(), 1);
+    fs::remove_all(cache_options.directory);
+}
@@ -0,0 +1,160 @@
+#include "gene_clustering.h"
+#include "test_runner.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+static GeneModel profiledGene(const std::string& symbol, const std::vector<double>& values) {
+    GeneModel g{symbol, "1", 0, 10, 1.0, 0.0, false, {}};
+    for (size_t r = 0; r < values.size(); ++r) {
+        setRegionExpression(g.brainRegionExpression, "region" + std::to_string(r), values[r]);
+    }
+    return g;
+}
+
+// Test linkage heights, cut-tree gene sets and export on two obvious groups.
+TEST_CASE(GeneClustering_TwoGroupsAndGeneSets) {
+    // Given three genes rising across regions, three falling and one flat
+    std::vector<GeneModel> genes = {
+        profiledGene("UP1", {1, 2, 3, 4}),     profiledGene("DOWN1", {4, 3, 2, 1}),
+        profiledGene("UP2", {2, 4, 6, 8.5}),   profiledGene("DOWN2", {8, 6, 4, 2.5}),
+        profiledGene("UP3", {0, 1, 3, 4}),     profiledGene("DOWN3", {5, 4, 2, 0}),
+        profiledGene("FLAT", {3, 3, 3, 3}),
+    };
+
+    for (Linkage linkage : {Linkage::Average, Linkage::Complete, Linkage::Ward}) {
+        // When clustered
+        ClusteringOptions options;
+        options.linkage = linkage;
+        GeneDendrogram tree = clusterGenes(genes, options);
+
+        // Then the flat gene is left out and six leaves take five merges
+        ASSERT_EQUAL(tree.leafCount(), 6);
+        ASSERT_EQUAL(tree.excludedGenes, 1);
+        ASSERT_EQUAL(tree.merges.size(), 5);
+        bool ordered = true;
+        for (size_t m = 1; m < tree.merges.size(); ++m) ordered = ordered && tree.merges[m - 1].height <= tree.merges[m].height;
+        ASSERT_TRUE(ordered);
+        ASSERT_EQUAL(tree.merges.back().size, 6);
+        ASSERT_EQUAL(tree.merges.back().right, 9);
+
+        // And the top merge joins the groups at their anti-correlation
+        const double top = tree.merges.back().height;
+        ASSERT_TRUE(linkage == Linkage::Ward ? top > 2.0 : top > 1.9);
+
+        // And cutting in two separates rising from falling genes
+        ASSERT_TRUE(cutTree(tree, 2) == std::vector<uint32_t>({0, 1, 0, 1, 0, 1}));
+        ASSERT_TRUE(cutTree(tree, 1) == std::vector<uint32_t>(6, 0));
+        ASSERT_TRUE(cutTree(tree, 99) == std::vector<uint32_t>({0, 1, 2, 3, 4, 5}));
+    }
+
+    // And the cut becomes named gene sets that the map indexes
+    GeneDendrogram tree = clusterGenes(genes);
+    std::vector<GeneSet> sets = clusterGeneSets(tree, 2, "average");
+    ASSERT_EQUAL(sets.size(), 2);
+    ASSERT_EQUAL(sets[0].name, "average-1");
+    ASSERT_TRUE(sets[1].geneSymbols == std::vector<std::string>({"DOWN1", "DOWN2", "DOWN3"}));
+    AlignmentMap map;
+    for (const auto& g : genes) map.addGene(g);
+    for (const auto& s : sets) map.addGeneSet(s);
+    ASSERT_EQUAL(map.getGeneSetsForGene("UP2").size(), 1);
+
+    // And the merges can be exported
+    ASSERT_TRUE(writeLinkageCSV(tree, "test_linkage.csv"));
+    std::ifstream in("test_linkage.csv");
+    std::string header, line, last;
+    std::getline(in, header);
+    while (std::getline(in, line)) last = line;
+    ASSERT_EQUAL(header, "left,right,height,size");
+    ASSERT_TRUE(last.find(",9,1") != std::string::npos);
+    ASSERT_EQUAL(last.substr(last.size() - 2), ",6");
+    in.close();
+    std::remove("test_linkage.csv");
+}
+
+// Naive O(N^3) clustering: always merge the closest active pair.
+static std::vector<std::pair<double, std::vector<uint32_t>>> naiveCuts(const std::vector<std::vector<double>>& profiles,
+                                                                       Linkage linkage) {
+    const size_t n = profiles.size();
+    std::vector<std::vector<double>> z = profiles;
+    for (auto& v : z) {
+        double mean = 0, norm = 0;
+        for (double x : v) mean += x / double(v.size());
+        for (double& x : v) norm += (x - mean) * (x - mean);
+        for (double& x : v) x = (x - mean) / std::sqrt(norm);
+    }
+    std::vector<std::vector<double>> d(n, std::vector<double>(n));
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            double r = 0;
+            for (size_t k = 0; k < z[i].size(); ++k) r += z[i][k] * z[j][k];
+            d[i][j] = linkage == Linkage::Ward ? 2 - 2 * r : 1 - r;
+        }
+    }
+    std::vector<uint32_t> label(n), size(n, 1);
+    std::vector<bool> active(n, true);
+    for (size_t i = 0; i < n; ++i) label[i] = uint32_t(i);
+    std::vector<std::pair<double, std::vector<uint32_t>>> cuts; // height and labels after each merge
+    for (size_t step = 1; step < n; ++step) {
+        size_t a = 0, b = 0;
+        double best = 1e300;
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = i + 1; j < n; ++j)
+                if (active[i] && active[j] && d[i][j] < best) best = d[i][j], a = i, b = j;
+        for (size_t k = 0; k < n; ++k) {
+            if (!active[k] || k == a || k == b) continue;
+            double na = size[a], nb = size[b], nk = size[k], merged;
+            if (linkage == Linkage::Average) merged = (na * d[a][k] + nb * d[b][k]) / (na + nb);
+            else if (linkage == Linkage::Complete) merged = std::max(d[a][k], d[b][k]);
+            else merged = ((na + nk) * d[a][k] + (nb + nk) * d[b][k] - nk * best) / (na + nb + nk);
+            d[a][k] = d[k][a] = merged;
+        }
+        size[a] += size[b];
+        active[b] = false;
+        const uint32_t from = label[b], to = label[a];
+        for (auto& l : label) if (l == from) l = to;
+        // Renumber by first appearance, as cutTree does.
+        std::vector<uint32_t> canonical(n), seen(n, UINT32_MAX);
+        uint32_t next = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (seen[label[i]] == UINT32_MAX) seen[label[i]] = next++;
+            canonical[i] = seen[label[i]];
+        }
+        cuts.emplace_back(linkage == Linkage::Ward ? std::sqrt(best) : best, canonical);
+    }
+    return cuts;
+}
+
+// Test that the nearest-neighbour chain builds the same tree as the naive algorithm.
+TEST_CASE(GeneClustering_ChainMatchesNaive) {
+    // Given 40 genes over 7 regions drawn around five patterns
+    std::mt19937 rng(13);
+    std::normal_distribution<double> noise(0.0, 0.6);
+    std::vector<std::vector<double>> profiles;
+    std::vector<GeneModel> genes;
+    for (int g = 0; g < 40; ++g) {
+        std::vector<double> values;
+        for (int r = 0; r < 7; ++r) values.push_back(double((g % 5 + 1) * (r + 2) % 7) + noise(rng));
+        profiles.push_back(values);
+        genes.push_back(profiledGene("G" + std::to_string(g), values));
+    }
+
+    for (Linkage linkage : {Linkage::Average, Linkage::Complete, Linkage::Ward}) {
+        // When clustered on four threads and naively
+        ClusteringOptions options;
+        options.linkage = linkage;
+        options.threads = 4;
+        GeneDendrogram tree = clusterGenes(genes, options);
+        auto naive = naiveCuts(profiles, linkage);
+
+        // Then every merge height and every cut agrees
+        bool same = tree.merges.size() == naive.size();
+        for (size_t m = 0; same && m < naive.size(); ++m) {
+            same = std::abs(tree.merges[m].height - naive[m].first) < 1e-5
+                && cutTree(tree, 40 - (m + 1)) == naive[m].second;
+        }
+        ASSERT_TRUE(same);
+    }
+}
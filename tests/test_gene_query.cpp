@@ -0,0 +1,111 @@
+#include "gene_query.h"
+#include "test_runner.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+static GeneModel queryGene(const std::string& symbol, double expression, double score,
+                           StringList categories, StringList tags) {
+    GeneModel g;
+    g.symbol = symbol;
+    g.expressionLevel = expression;
+    g.polygenicScore = score;
+    g.categories = std::move(categories);
+    g.disorderTags = std::move(tags);
+    return g;
+}
+
+// Test the text syntax, its precedence and its canonical form.
+TEST_CASE(GeneQuery_ParseAndPrint) {
+    // Given the filter from the gene browser
+    GeneQuery q = parseGeneQuery("category = dopamine receptor AND expression > 6 AND tag contains ADHD");
+
+    // Then it is one AND of three terms with multi-word values kept intact
+    ASSERT_TRUE(q.kind() == GeneQuery::Kind::And);
+    ASSERT_EQUAL(q.children().size(), 3);
+    ASSERT_EQUAL(q.children()[0].value(), "dopamine receptor");
+    ASSERT_EQUAL(q.toString(), "category = \"dopamine receptor\" AND expression > 6 AND tag = \"ADHD\"");
+
+    // And AND binds tighter than OR, and the printed form parses back identically
+    GeneQuery mixed = parseGeneQuery("not tag = \"Autism\" or polygenic <= 0.25 and (expr = 2.5 OR category = x)");
+    ASSERT_TRUE(mixed.kind() == GeneQuery::Kind::Or);
+    ASSERT_EQUAL(parseGeneQuery(mixed.toString()).toString(), mixed.toString());
+
+    // And syntax errors report a position
+    for (const char* bad : {"expression >", "colour = red", "category = (x", "expression > six"}) {
+        bool thrown = false;
+        try {
+            parseGeneQuery(bad);
+        } catch (const std::invalid_argument& e) {
+            thrown = std::string(e.what()).find("position") != std::string::npos;
+        }
+        ASSERT_TRUE(thrown);
+    }
+}
+
+// Test indexed evaluation against a brute-force scan, including per-gene probing and incremental sync.
+TEST_CASE(GeneQuery_MatchesLinearScan) {
+    // Given 3000 genes with overlapping categories, tags and scores
+    AlignmentMap map;
+    const char* categories[] = {"dopamine receptor", "synaptic plasticity", "ion channel"};
+    const char* tags[] = {"ADHD", "Autism", "Schizophrenia", "Epilepsy"};
+    auto addGenes = [&](int from, int to) {
+        for (int i = from; i < to; ++i) {
+            StringList cats{categories[i % 3]};
+            if (i % 7 == 0) cats.emplace_back(categories[(i + 1) % 3]);
+            StringList t;
+            if (i % 5 == 0) t.emplace_back(tags[i % 4]);
+            if (i % 11 == 0) t.emplace_back(tags[(i / 11) % 4]);
+            map.addGene(queryGene("G" + std::to_string(i), (i * 37 % 1000) / 100.0, (i * 13 % 100) / 100.0,
+                                  cats, t));
+        }
+    };
+    addGenes(0, 2000);
+    GeneQueryEngine engine(map);
+
+    auto scan = [&](const std::function<bool(const GeneModel&)>& keep) {
+        std::vector<std::string> out;
+        for (const auto& g : map.getGenes()) if (keep(g)) out.push_back(g.symbol);
+        return out;
+    };
+    auto hasValue = [](const StringList& list, const char* value) {
+        return std::find(list.begin(), list.end(), value) != list.end();
+    };
+
+    // When queries are evaluated before and after more genes are appended
+    for (int round = 0; round < 2; ++round) {
+        if (round == 1) addGenes(2000, 3000);
+
+        // Then every plan shape returns exactly the scanned genes
+        auto q1 = "category = dopamine receptor AND expression > 6 AND tag contains ADHD";
+        ASSERT_TRUE(engine.select(parseGeneQuery(q1), "q1").geneSymbols == scan([&](const GeneModel& g) {
+            return hasValue(g.categories, "dopamine receptor") && g.expressionLevel > 6 && hasValue(g.disorderTags, "ADHD");
+        }));
+        auto q2 = "tag = Epilepsy AND expression >= 1 AND expression < 9.5 AND NOT polygenic > 0.5";
+        ASSERT_TRUE(engine.select(parseGeneQuery(q2), "q2").geneSymbols == scan([&](const GeneModel& g) {
+            return hasValue(g.disorderTags, "Epilepsy") && g.expressionLevel >= 1 && g.expressionLevel < 9.5
+                && !(g.polygenicScore > 0.5);
+        }));
+        auto q3 = "(category = ion channel OR tag = Autism) AND NOT category = synaptic plasticity";
+        ASSERT_TRUE(engine.select(parseGeneQuery(q3), "q3").geneSymbols == scan([&](const GeneModel& g) {
+            return (hasValue(g.categories, "ion channel") || hasValue(g.disorderTags, "Autism"))
+                && !hasValue(g.categories, "synaptic plasticity");
+        }));
+        ASSERT_EQUAL(engine.evaluate(parseGeneQuery("NOT ALL")).cardinality(), 0);
+        ASSERT_EQUAL(engine.evaluate(parseGeneQuery("category = unknown")).cardinality(), 0);
+    }
+    ASSERT_EQUAL(engine.indexedGenes(), 3000);
+
+    // And the two ranges on expression were merged into one plan step, most selective first
+    std::string plan = engine.explain(parseGeneQuery("expression >= 1 AND tag = ADHD AND expression < 2"));
+    ASSERT_TRUE(plan.find("(expression >= 1 AND expression < 2)") != std::string::npos);
+    ASSERT_TRUE(plan.find("tag") < plan.find("expression"));
+
+    // And the result can be stored as a gene set and after clearGenes() the engine rebuilds
+    map.addGeneSet(engine.select(GeneQuery::has(GeneField::DisorderTag, "ADHD"), "ADHD genes"));
+    ASSERT_EQUAL(map.getGeneSets().back().name, "ADHD genes");
+    ASSERT_TRUE(!map.getGeneSets().back().geneSymbols.empty());
+    map.clearGenes();
+    addGenes(0, 10);
+    ASSERT_EQUAL(engine.evaluate(GeneQuery{}).cardinality(), 10);
+}
@@ -0,0 +1,175 @@
+#include "gene_snapshot.h"
+#include "test_runner.h"
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+static std::vector<GeneModel> numberedGenes(size_t first, size_t count) {
+    std::vector<GeneModel> genes;
+    for (size_t i = first; i < first + count; ++i) {
+        GeneModel g;
+        g.symbol = "G" + std::to_string(i);
+        g.expressionLevel = double(i);
+        genes.push_back(std::move(g));
+    }
+    return genes;
+}
+
+// Test that versions share untouched chunks and old snapshots never change.
+TEST_CASE(GeneSnapshot_CopyOnWrite) {
+    // Given a store with three and a half chunks of genes
+    GeneSnapshotStore store;
+    size_t count = 3 * kGeneChunkSize + kGeneChunkSize / 2;
+    store.append(numberedGenes(0, count));
+    auto before = store.snapshot();
+    ASSERT_EQUAL(before->version(), 1);
+    ASSERT_EQUAL(before->size(), count);
+    ASSERT_EQUAL(before->chunkCount(), 4);
+
+    // When one gene in the second chunk is toggled
+    store.toggleKnockout("G" + std::to_string(kGeneChunkSize + 5));
+    auto after = store.snapshot();
+
+    // Then only that chunk was copied, and the old snapshot still shows the old value
+    ASSERT_EQUAL(after->version(), 2);
+    ASSERT_TRUE(after->chunk(0) == before->chunk(0));
+    ASSERT_FALSE(after->chunk(1) == before->chunk(1));
+    ASSERT_TRUE(after->chunk(3) == before->chunk(3));
+    ASSERT_TRUE((*after)[kGeneChunkSize + 5].isKnockout);
+    ASSERT_FALSE((*before)[kGeneChunkSize + 5].isKnockout);
+
+    // And appending copies only the partial last chunk
+    GeneBatch batch = store.begin();
+    for (auto& g : numberedGenes(count, kGeneChunkSize)) batch.append(std::move(g));
+    ASSERT_EQUAL(batch.chunksWritten(), 2);
+    ASSERT_TRUE(store.publish(batch));
+    auto appended = store.snapshot();
+    ASSERT_TRUE(appended->chunk(2) == before->chunk(2));
+    ASSERT_EQUAL(appended->size(), count + kGeneChunkSize);
+    ASSERT_EQUAL((*appended)[count + 10].symbol, "G" + std::to_string(count + 10));
+
+    // And a batch begun on a stale snapshot is refused
+    GeneBatch stale = store.begin();
+    stale.edit(0).expressionLevel = -1;
+    store.append(numberedGenes(0, 1));
+    ASSERT_FALSE(store.publish(stale));
+    ASSERT_EQUAL((*store.snapshot())[0].expressionLevel, 0.0);
+
+    // And clearing publishes an empty version
+    store.clear();
+    ASSERT_TRUE(store.snapshot()->empty());
+    ASSERT_EQUAL(appended->size(), count + kGeneChunkSize);
+}
+
+// Test that readers see consistent snapshots while writers keep publishing.
+TEST_CASE(GeneSnapshot_ConcurrentReaders) {
+    // Given a store fed by two writers, 200 batches of 37 genes each
+    GeneSnapshotStore store;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> badSnapshots{0}, reads{0};
+
+    // When two readers repeatedly take snapshots during the writes
+    auto reader = [&]() {
+        uint64_t lastVersion = 0;
+        size_t lastSize = 0;
+        while (!done) {
+            auto snap = store.snapshot();
+            // Then every snapshot is complete: sizes and versions only grow,
+            // and each gene's expression matches its symbol
+            bool ok = snap->version() >= lastVersion && snap->size() >= lastSize && snap->size() % 37 == 0;
+            snap->forEach([&](const GeneModel& g) {
+                if (g.symbol != "G" + std::to_string(size_t(g.expressionLevel))) ok = false;
+            });
+            if (!ok) ++badSnapshots;
+            lastVersion = snap->version();
+            lastSize = snap->size();
+            ++reads;
+        }
+    };
+    std::thread r1(reader), r2(reader);
+    std::thread w([&]() {
+        for (size_t b = 0; b < 100; ++b) store.append(numberedGenes(b * 37, 37));
+    });
+    for (size_t b = 100; b < 200; ++b) store.append(numberedGenes(b * 37, 37));
+    w.join();
+    done = true;
+    r1.join();
+    r2.join();
+
+    ASSERT_EQUAL(badSnapshots.load(), 0);
+    ASSERT_TRUE(reads.load() > 0);
+    ASSERT_EQUAL(store.snapshot()->size(), 200 * 37);
+    ASSERT_EQUAL(store.version(), 200);
+}
+
+// Test that snapshot statistics follow appends, toggles and clears.
+TEST_CASE(GeneSnapshot_StatisticsTrackVersions) {
+    // Given a store with 100 genes whose expression is 0..99
+    GeneSnapshotStore store;
+    store.append(numberedGenes(0, 100));
+    GeneSnapshotStatistics stats;
+
+    // When computing statistics twice for the same version
+    const GenomeStats& first = stats.update(*store.snapshot());
+    std::string timestamp = first.timestamp;
+    ASSERT_EQUAL(first.totalGenes, 100);
+    ASSERT_EQUAL(first.totalKnockouts, 0);
+    ASSERT_TRUE(std::abs(first.avgExpression - 49.5) < 1e-9);
+    ASSERT_TRUE(std::abs(first.medianExpression - 49.5) < 1.0);
+
+    // Then the second call returns the cached result
+    ASSERT_TRUE(&stats.update(*store.snapshot()) == &first);
+    ASSERT_EQUAL(first.timestamp, timestamp);
+
+    // When appending genes and toggling a knockout
+    store.append(numberedGenes(100, 100));
+    store.toggleKnockout("G7");
+    const GenomeStats& grown = stats.update(*store.snapshot());
+
+    // Then counts, averages and quantiles cover every gene
+    ASSERT_EQUAL(grown.totalGenes, 200);
+    ASSERT_EQUAL(grown.totalKnockouts, 1);
+    ASSERT_TRUE(std::abs(grown.avgExpression - 99.5) < 1e-9);
+    ASSERT_TRUE(std::abs(grown.medianExpression - 99.5) < 2.0);
+    ASSERT_TRUE(grown.p99Expression > 190.0);
+
+    // When clearing and loading fewer genes
+    store.clear();
+    store.append(numberedGenes(1000, 10));
+    const GenomeStats& reloaded = stats.update(*store.snapshot());
+
+    // Then the old genes are gone from the sketch as well
+    ASSERT_EQUAL(reloaded.totalGenes, 10);
+    ASSERT_EQUAL(reloaded.totalKnockouts, 0);
+    ASSERT_TRUE(reloaded.medianExpression >= 1000.0);
+
+    // When clearing and loading more genes than before, unseen in between
+    store.clear();
+    store.append(numberedGenes(5000, 300));
+    const GenomeStats& replaced = stats.update(*store.snapshot());
+
+    // Then the sketch restarts for the new generation too
+    ASSERT_EQUAL(store.snapshot()->generation(), 2);
+    ASSERT_EQUAL(replaced.totalGenes, 300);
+    ASSERT_TRUE(replaced.medianExpression >= 5000.0);
+    ASSERT_TRUE(replaced.p99Expression < 5300.0);
+}
+
+// Test that the memory report covers the snapshot's genes without copying them.
+TEST_CASE(GeneSnapshot_MemoryReport) {
+    // Given a store of genes with heap-allocated symbols
+    GeneSnapshotStore store;
+    std::vector<GeneModel> genes = numberedGenes(0, 1000);
+    for (auto& g : genes) g.symbol += std::string(40, 'x');
+    store.append(std::move(genes));
+
+    // When reporting on the current snapshot
+    MemoryReport report = store.snapshot()->memoryReport();
+    const SubsystemMemory* g = report.find("genes");
+
+    // Then every gene is counted with its GeneModel slot and its symbol
+    ASSERT_TRUE(g != nullptr);
+    ASSERT_EQUAL(g->records, 1000);
+    ASSERT_TRUE(g->currentBytes >= 1000 * (sizeof(GeneModel) + 40));
+    ASSERT_TRUE(g->bytesPerRecord() < 2.0 * (sizeof(GeneModel) + 48));
+}
@@ -0,0 +1,137 @@
+#include "knockout_propagation.h"
+#include "test_runner.h"
+
+static AlignmentMap makePathwayMap() {
+    AlignmentMap map;
+    for (const auto& p : createDemoPathways()) map.addPathway(p);
+    return map;
+}
+
+// Test that a knockout silences genes that lose all upstream input.
+TEST_CASE(KnockoutPropagation_SilencesDownstream) {
+    // Given the Neural Plasticity pathway (BDNF -> CREB1/CAMK2A -> GRIN2B)
+    KnockoutPropagator prop(makePathwayMap());
+
+    // When CREB1 is knocked out
+    prop.toggleKnockout("CREB1");
+
+    // Then GRIN2B loses one of its two inputs but stays active
+    ASSERT_TRUE(prop.isSilenced("CREB1"));
+    ASSERT_FALSE(prop.isSilenced("GRIN2B"));
+    ASSERT_EQUAL(prop.impactScore("GRIN2B"), 0.5);
+    ASSERT_EQUAL(prop.perturbationDepth(), 1);
+
+    // When BDNF is knocked out as well
+    prop.toggleKnockout("BDNF");
+
+    // Then everything downstream of BDNF is silenced
+    ASSERT_TRUE(prop.isSilenced("CAMK2A"));
+    ASSERT_TRUE(prop.isSilenced("GRIN2B"));
+    ASSERT_EQUAL(prop.getAffectedGenes().size(), 4);
+    ASSERT_FALSE(prop.isSilenced("CASP3"));
+
+    // When CREB1 is restored while BDNF stays knocked out
+    prop.toggleKnockout("CREB1");
+
+    // Then CREB1 remains silenced through BDNF and the reach is two hops
+    ASSERT_TRUE(prop.isSilenced("CREB1"));
+    ASSERT_EQUAL(prop.perturbationDepth(), 2);
+
+    // When BDNF is restored as well
+    prop.toggleKnockout("BDNF");
+
+    // Then the network is back to its unperturbed state
+    ASSERT_TRUE(prop.getAffectedGenes().empty());
+    ASSERT_EQUAL(prop.perturbationDepth(), 0);
+}
+
+// Test that knockouts already present in the map seed the propagation.
+TEST_CASE(KnockoutPropagation_SeedsFromMap) {
+    // Given a map where BCL2 is already a knockout
+    AlignmentMap map = makePathwayMap();
+    map.addGene({"BCL2", "18", 0, 0, 1.0, 0.0, true});
+
+    // When the propagator is built
+    KnockoutPropagator prop(map);
+
+    // Then CASP9 is silenced and CASP3 loses half of its input
+    ASSERT_TRUE(prop.isSilenced("CASP9"));
+    ASSERT_EQUAL(prop.getImpact("CASP3").lostInputs, 1);
+    ASSERT_EQUAL(prop.getImpact("CASP3").totalInputs, 2);
+}
+
+// Test that a toggle only re-evaluates the affected frontier.
+TEST_CASE(KnockoutPropagation_IncrementalFrontier) {
+    // Given a long regulatory chain plus a small, unrelated pathway
+    Pathway chain;
+    chain.name = "Chain";
+    for (int i = 0; i < 5000; ++i) {
+        chain.geneSymbols.push_back("C" + std::to_string(i));
+        if (i > 0) chain.interactions["C" + std::to_string(i - 1)].push_back("C" + std::to_string(i));
+    }
+    AlignmentMap map = makePathwayMap();
+    map.addPathway(chain);
+    KnockoutPropagator prop(map);
+
+    // When toggling a gene in the small pathway
+    prop.toggleKnockout("CASP8");
+
+    // Then only that gene and its direct successor are visited
+    ASSERT_TRUE(prop.lastUpdateVisited() <= 3);
+    ASSERT_TRUE(prop.nodeCount() > 5000);
+
+    // And knocking out the head of the chain silences it end to end
+    prop.toggleKnockout("C0");
+    ASSERT_TRUE(prop.isSilenced("C4999"));
+    ASSERT_EQUAL(prop.perturbationDepth(), 4999);
+}
+
+// Same silenced state and input counts as a propagator built from scratch.
+static void assertMatchesFresh(const KnockoutPropagator& prop, const AlignmentMap& map,
+                               const std::vector<std::string>& symbols) {
+    KnockoutPropagator fresh(map);
+    for (const auto& s : symbols) {
+        ASSERT_EQUAL(prop.isSilenced(s), fresh.isSilenced(s));
+        ASSERT_EQUAL(prop.getImpact(s).lostInputs, fresh.getImpact(s).lostInputs);
+    }
+}
+
+// Test that restoring a knockout releases a feedback loop it silenced.
+TEST_CASE(KnockoutPropagation_FeedbackLoopMatchesRebuild) {
+    // Given X -> A, A <-> B, B -> C, with A knocked out
+    Pathway loop;
+    loop.name = "Loop";
+    loop.geneSymbols = {"X", "A", "B", "C"};
+    loop.interactions["X"] = {"A"};
+    loop.interactions["A"] = {"B"};
+    loop.interactions["B"] = {"A", "C"};
+    AlignmentMap map;
+    map.addPathway(loop);
+    for (const auto& s : loop.geneSymbols) map.addGene({s, "1", 0, 0, 1.0, 0.0, s == "A"});
+    const std::vector<std::string> symbols = loop.geneSymbols;
+    KnockoutPropagator prop(map);
+    ASSERT_TRUE(prop.isSilenced("B"));
+
+    // When X is knocked out, which also cuts A's only other input
+    prop.toggleKnockout("X");
+    map.toggleKnockout("X");
+    assertMatchesFresh(prop, map, symbols);
+
+    // And A is restored while X stays knocked out
+    prop.toggleKnockout("A");
+    map.toggleKnockout("A");
+
+    // Then the loop is active again, as in a rebuilt propagator
+    ASSERT_FALSE(prop.isSilenced("A"));
+    ASSERT_FALSE(prop.isSilenced("B"));
+    ASSERT_FALSE(prop.isSilenced("C"));
+    assertMatchesFresh(prop, map, symbols);
+
+    // And knocking A out again and restoring X keeps the loop silenced through A
+    prop.toggleKnockout("A");
+    map.toggleKnockout("A");
+    prop.toggleKnockout("X");
+    map.toggleKnockout("X");
+    ASSERT_TRUE(prop.isSilenced("C"));
+    assertMatchesFresh(prop, map, symbols);
+}
@@ -1,6 +1,8 @@
 #include "map_logic.h"
 #include "test_runner.h"
 #include <cmath> // For std::abs
+#include <filesystem>
+#include <fstream>
 
 // BDD Scenario: Gene Statistics
 TEST_CASE(AlignmentMap_Statistics) {
@@ -180,3 +182,158 @@ TEST_CASE(AlignmentEditor_Editing) {
     const auto& seqs_edit = editor_edit.getSequences();
     ASSERT_EQUAL(seqs_edit[1].aligned, "ATXGATTGATCGATCG");
 }
+
+// BDD Scenario: Inverted gene index over pathways and gene sets
+TEST_CASE(AlignmentMap_GeneIndex) {
+    // Given a map with the demo pathways and two gene sets
+    AlignmentMap map;
+    for (const auto& p : createDemoPathways()) map.addPathway(p);
+    map.addGeneSet({"Plasticity Core", {"BDNF", "CREB1"}});
+    map.addGeneSet({"Apoptosis Core", {"CASP3", "BCL2", "BCL2"}});
+
+    // When looking up a gene present in one pathway and one gene set
+    const auto& bdnfPathways = map.getPathwaysForGene("BDNF");
+    const auto& bdnfSets = map.getGeneSetsForGene("BDNF");
+
+    // Then the index should point at exactly those entries
+    ASSERT_EQUAL(bdnfPathways.size(), 1);
+    ASSERT_EQUAL(map.getPathways()[bdnfPathways[0]].name, "Neural Plasticity");
+    ASSERT_EQUAL(bdnfSets.size(), 1);
+    ASSERT_EQUAL(map.getGeneSets()[bdnfSets[0]].name, "Plasticity Core");
+
+    // And duplicate symbols within one set should be indexed once
+    ASSERT_EQUAL(map.getGeneSetsForGene("BCL2").size(), 1);
+
+    // And unknown genes should yield an empty list
+    ASSERT_TRUE(map.getPathwaysForGene("NOT_A_GENE").empty());
+}
+
+// Test that memory accounting tracks records, bytes and peaks per subsystem.
+TEST_CASE(AlignmentMap_MemoryReport) {
+    // Given 1000 genes with heap-allocated strings and region maps
+    AlignmentMap map;
+    for (int i = 0; i < 1000; ++i) {
+        GeneModel g;
+        g.symbol = "GENE_WITH_A_LONG_SYMBOL_" + std::to_string(i);
+        g.disorderTags = {"Schizophrenia"};
+        g.brainRegionExpression["Cortex"] = 0.5;
+        map.addGene(g);
+    }
+    map.addPathway({"P1", "desc", {"A", "B"}, {{"A", {"B"}}}});
+    map.addGeneSet({"S1", {"A", "C"}});
+
+    // When reporting
+    MemoryReport report = map.memoryReport();
+    const SubsystemMemory* genes = report.find("genes");
+
+    // Then each subsystem is present, and genes cost at least their fixed size plus strings
+    ASSERT_TRUE(genes != nullptr);
+    ASSERT_EQUAL(genes->records, 1000);
+    ASSERT_TRUE(genes->currentBytes >= 1000 * (sizeof(GeneModel) + 25));
+    ASSERT_TRUE(genes->peakBytes >= genes->currentBytes);
+    ASSERT_TRUE(genes->bytesPerRecord() > double(sizeof(GeneModel)));
+    ASSERT_EQUAL(report.find("pathways")->records, 1);
+    ASSERT_EQUAL(report.find("geneSets")->records, 1);
+    ASSERT_EQUAL(report.find("geneIndex")->records, 4); // A, B in pathways; A, C in gene sets
+    ASSERT_EQUAL(report.totalBytes(), genes->currentBytes + report.find("pathways")->currentBytes
+                                      + report.find("geneSets")->currentBytes + report.find("geneIndex")->currentBytes);
+    ASSERT_TRUE(formatMemoryReport(report).find("genes") != std::string::npos);
+
+    // Given the demo alignment block
+    AlignmentEditor editor;
+    editor.loadDemoDNA();
+
+    // Then its sequences are counted, and repeated edits do not drift the total
+    ASSERT_EQUAL(editor.memoryReport().find("alignment")->records, 3);
+    editor.reverseComplementSelected();
+    size_t once = editor.memoryReport().find("alignment")->currentBytes;
+    editor.reverseComplementSelected();
+    editor.reverseComplementSelected();
+    ASSERT_EQUAL(editor.memoryReport().find("alignment")->currentBytes, once);
+}
+
+// BDD Scenario: Arena-backed bulk load
+TEST_CASE(AlignmentMap_ArenaBulkLoad) {
+    // Given a map in arena mode and a heap-built gene
+    AlignmentMap map;
+    map.setGeneStorage(GeneStorage::Arena);
+    GeneModel heapGene;
+    heapGene.symbol = "HEAP";
+    heapGene.disorderTags = {"Autism"};
+
+    // When genes are loaded from a file and added by copy
+    map.loadGenesFromJSON("tests/genes.json");
+    map.addGene(heapGene);
+    size_t loaded = map.getGenes().size();
+
+    // Then every gene's containers live in the arena, with values intact
+    ASSERT_TRUE(map.geneArenaBytes() > 0);
+    for (const auto& g : map.getGenes()) {
+        ASSERT_TRUE(g.disorderTags.get_allocator().resource() == map.newGene().disorderTags.get_allocator().resource());
+    }
+    ASSERT_EQUAL(map.getGenes().back().disorderTags[0], "Autism");
+    ASSERT_EQUAL(heapGene.disorderTags.get_allocator().resource(), std::pmr::get_default_resource());
+
+    // And a copy of the map owns heap-backed genes independent of the arena
+    AlignmentMap copy = map;
+    map.clearGenes();
+    ASSERT_EQUAL(map.getGenes().size(), 0);
+    ASSERT_EQUAL(map.geneArenaBytes(), 0);
+    ASSERT_EQUAL(map.memoryReport().find("genes")->records, 0);
+    ASSERT_EQUAL(copy.getGenes().size(), loaded);
+    ASSERT_EQUAL(copy.getGenes().back().disorderTags[0], "Autism");
+
+    // And the map can be reloaded after the release
+    map.loadGenesFromJSON("tests/genes.json");
+    ASSERT_EQUAL(map.getGenes().size(), loaded - 1);
+}
+
+// BDD Scenario: Batch import of a directory of mixed files
+TEST_CASE(AlignmentMap_BatchImport) {
+    // Given a directory with the sample CSV and JSON, JSON saved as .txt, and a non-gene file
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "alignment_map_batch_import";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::copy_file("tests/genes.csv", dir / "a_genes.csv");
+    fs::copy_file("tests/genes.json", dir / "b_genes.json");
+    fs::copy_file("tests/genes.json", dir / "c_export.txt");
+    std::ofstream(dir / "d_notes.md") << "# notes\n";
+    std::ofstream(dir / ".hidden.csv") << "gene_name,knockout,status,expression_level\nHIDDEN,,Active,1\n";
+
+    AlignmentMap single;
+    single.loadGenesFromCSV("tests/genes.csv");
+    single.loadGenesFromJSON("tests/genes.json");
+    single.loadGenesFromJSON("tests/genes.json");
+
+    // When the directory is imported with one and with four workers
+    AlignmentMap serial, parallel;
+    BatchImportReport serialReport = serial.importGeneDirectory(dir.string(), false, 1);
+    BatchImportReport report = parallel.importGeneDirectory(dir.string(), false, 4);
+    fs::remove_all(dir);
+
+    // Then formats are sniffed from content and genes match loading the files one by one
+    ASSERT_EQUAL(report.files.size(), 4);
+    ASSERT_TRUE(report.files[0].format == GeneFileFormat::CSV);
+    ASSERT_TRUE(report.files[2].format == GeneFileFormat::JSON);
+    ASSERT_EQUAL(report.genesLoaded, single.getGenes().size());
+    ASSERT_EQUAL(parallel.getGenes().size(), single.getGenes().size());
+    for (size_t i = 0; i < single.getGenes().size(); ++i) {
+        ASSERT_EQUAL(parallel.getGenes()[i].symbol, single.getGenes()[i].symbol);
+        ASSERT_EQUAL(serial.getGenes()[i].symbol, single.getGenes()[i].symbol);
+    }
+    ASSERT_EQUAL(parallel.expressionStatistics().expression.count(), double(single.getGenes().size()));
+
+    // And skipped lines and unreadable files are reported per file instead of printed
+    ASSERT_EQUAL(report.files[0].warnings.size(), 1);
+    ASSERT_TRUE(report.files[0].ok());
+    ASSERT_FALSE(report.files[3].ok());
+    ASSERT_EQUAL(report.files[3].genesLoaded, 0);
+    ASSERT_EQUAL(report.failedFiles(), 1);
+    ASSERT_EQUAL(serialReport.failedFiles(), 1);
+
+    // And a missing directory is a single failed entry
+    BatchImportReport missing = serial.importGeneDirectory((dir / "nope").string());
+    ASSERT_EQUAL(missing.failedFiles(), 1);
+    ASSERT_TRUE(sniffGeneFileFormat("\xEF\xBB\xBF  [ {}") == GeneFileFormat::JSON);
+}
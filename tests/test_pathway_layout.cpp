@@ -0,0 +1,128 @@
+#include "pathway_layout.h"
+#include "test_runner.h"
+#include <chrono>
+#include <cmath>
+#include <set>
+#include <thread>
+
+// Test that layouts are cached per pathway and keyed by graph version.
+TEST_CASE(PathwayLayout_CacheAndWarmStart) {
+    // Given the Neural Plasticity demo pathway
+    Pathway p = createDemoPathways()[0];
+    PathwayLayoutCache cache;
+
+    // When it is laid out twice without changes
+    const PathwayLayout& first = cache.get(p);
+    uint64_t version = first.graphVersion;
+    const PathwayLayout& second = cache.get(p);
+
+    // Then the cached layout is reused
+    ASSERT_TRUE(&first == &second);
+    ASSERT_EQUAL(cache.size(), 1);
+    ASSERT_EQUAL(second.symbols.size(), 4);
+
+    // When a gene and an interaction are added
+    p.geneSymbols.push_back("ARC");
+    p.interactions["CREB1"].push_back("ARC");
+    LayoutOptions opts;
+    const PathwayLayout& updated = cache.get(p, opts);
+
+    // Then the version changes and only a warm relayout runs
+    ASSERT_NOT_EQUAL(updated.graphVersion, version);
+    ASSERT_EQUAL(updated.symbols.size(), 5);
+    ASSERT_EQUAL(updated.iterations, opts.warmIterations);
+}
+
+// Test that projected labels stay on the grid and do not overlap.
+TEST_CASE(PathwayLayout_GridProjection) {
+    // Given a 60-gene ring pathway
+    Pathway p;
+    p.name = "Ring";
+    for (int i = 0; i < 60; ++i) {
+        p.geneSymbols.push_back("G" + std::to_string(i));
+        p.interactions["G" + std::to_string(i)].push_back("G" + std::to_string((i + 1) % 60));
+    }
+    PathwayLayout layout = computePathwayLayout(p);
+
+    // When projecting onto an 80x20 terminal area
+    auto cells = projectLayoutToGrid(layout, 80, 20);
+
+    // Then every label is inside the grid and no two labels share cells
+    ASSERT_EQUAL(cells.size(), 60);
+    std::set<std::pair<int, int>> occupied;
+    for (const auto& c : cells) {
+        ASSERT_TRUE(c.x >= 0 && c.y >= 0 && c.y < 20);
+        ASSERT_TRUE(c.x + int(c.symbol.size()) + 2 <= 80);
+        for (int x = c.x; x < c.x + int(c.symbol.size()) + 2; ++x) {
+            ASSERT_TRUE(occupied.insert({x, c.y}).second);
+        }
+    }
+}
+
+// Test that large pathways lay out with finite, spread-out positions.
+TEST_CASE(PathwayLayout_LargeGraph) {
+    // Given a 2000-node pathway shaped as a binary tree
+    Pathway p;
+    p.name = "Tree";
+    for (int i = 0; i < 2000; ++i) {
+        p.geneSymbols.push_back("T" + std::to_string(i));
+        if (i > 0) p.interactions["T" + std::to_string((i - 1) / 2)].push_back("T" + std::to_string(i));
+    }
+
+    // When laying it out with a reduced iteration budget
+    LayoutOptions opts;
+    opts.iterations = 50;
+    PathwayLayout layout = computePathwayLayout(p, opts);
+
+    // Then all positions are finite and not collapsed onto one point
+    double minX = 1e300, maxX = -1e300;
+    for (const auto& pt : layout.positions) {
+        ASSERT_TRUE(std::isfinite(pt.x) && std::isfinite(pt.y));
+        minX = std::min(minX, pt.x);
+        maxX = std::max(maxX, pt.x);
+    }
+    ASSERT_TRUE(maxX - minX > 1.0);
+}
+
+// Test that background layouts never block and are picked up once finished.
+TEST_CASE(PathwayLayout_BackgroundLayout) {
+    // Given the Neural Plasticity demo pathway and an empty cache
+    Pathway p = createDemoPathways()[0];
+    PathwayLayoutCache cache;
+
+    // When asking for a layout that has not been computed
+    const PathwayLayout* layout = cache.tryGet(p);
+
+    // Then nothing is returned yet, and one layout is running
+    ASSERT_TRUE(layout == nullptr);
+    ASSERT_EQUAL(cache.pending(), 1);
+    ASSERT_TRUE(cache.tryGet(p) == nullptr);
+    ASSERT_EQUAL(cache.pending(), 1);
+
+    // When polling until it is done
+    while (!(layout = cache.tryGet(p))) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // Then it matches a synchronous cold layout
+    PathwayLayout expected = computePathwayLayout(p);
+    ASSERT_EQUAL(cache.pending(), 0);
+    ASSERT_TRUE(layout->symbols == expected.symbols);
+    for (size_t i = 0; i < expected.positions.size(); ++i) {
+        ASSERT_TRUE(std::abs(layout->positions[i].x - expected.positions[i].x) < 1e-9);
+        ASSERT_TRUE(std::abs(layout->positions[i].y - expected.positions[i].y) < 1e-9);
+    }
+
+    // When the graph changes
+    uint64_t version = layout->graphVersion;
+    p.geneSymbols.push_back("ARC");
+    p.interactions["CREB1"].push_back("ARC");
+
+    // Then the previous layout is shown until a warm relayout replaces it
+    const PathwayLayout* stale = cache.tryGet(p);
+    ASSERT_TRUE(stale != nullptr);
+    ASSERT_EQUAL(stale->graphVersion, version);
+    const PathwayLayout* updated = stale;
+    while ((updated = cache.tryGet(p))->graphVersion == version)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_EQUAL(updated->symbols.size(), 5);
+    ASSERT_EQUAL(updated->iterations, LayoutOptions().warmIterations);
+}
@@ -0,0 +1,103 @@
+#include "pipeline.h"
+#include "test_runner.h"
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+static std::vector<PipelineCommand> parseText(const std::string& text) {
+    std::istringstream in(text);
+    return parsePipelineScript(in);
+}
+
+// Empty scratch directory under the system temp directory, removed again when
+// the guard leaves scope, whether or not the test's asserts passed.
+struct ScratchDirectory {
+    fs::path path;
+    explicit ScratchDirectory(const std::string& name)
+        : path(fs::temp_directory_path() / ("alignment_map_" + name)) {
+        fs::remove_all(path);
+        fs::create_directories(path);
+    }
+    ~ScratchDirectory() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+    std::string file(const std::string& name) const { return (path / name).string(); }
+};
+
+// Test that scripts parse into commands and bad lines are rejected with their line number.
+TEST_CASE(Pipeline_ParseScript) {
+    // Given a script with comments, a two-word verb and a query
+    auto script = parseText("# setup\n"
+                            "load genes a.csv b.json\n"
+                            "\n"
+                            "query expression > 5 AND tag = ADHD  # comment\n");
+
+    // Then blank and comment lines are skipped and arguments split per command
+    ASSERT_EQUAL(script.size(), 2);
+    ASSERT_EQUAL(script[0].verb, "load genes");
+    ASSERT_EQUAL(script[0].args.size(), 2);
+    ASSERT_EQUAL(script[1].line, 4);
+    ASSERT_EQUAL(script[1].args[0], "expression > 5 AND tag = ADHD");
+
+    // And unknown commands, wrong argument counts and bad queries name the line
+    for (const char* bad : {"stats\nfrobnicate", "stats\nexport genes", "stats\nquery expression >"}) {
+        bool thrown = false;
+        try {
+            parseText(bad);
+        } catch (const std::invalid_argument& e) {
+            thrown = std::string(e.what()).find("line 2") != std::string::npos;
+        }
+        ASSERT_TRUE(thrown);
+    }
+}
+
+// Test that a pipeline produces the same streamed output with and without parallel stages.
+TEST_CASE(Pipeline_RunParallelStages) {
+    // Given a script that loads, queries, edits, exports and has one failing command
+    ScratchDirectory scratch("pipeline");
+    const std::string genesPath = scratch.file("genes.csv");
+    auto script = parseText("load genes tests/genes.json tests/genes.csv\n"
+                            "demo sequences\n"
+                            "stats\n"
+                            "query expression > 5\n"
+                            "top expression 2\n"
+                            "seq select 1\n"
+                            "seq edit t\n"
+                            "export genes " + genesPath + "\n"
+                            "knockout NO_SUCH_GENE\n"
+                            "export sequences " + scratch.file("seqs.fasta") + "\n");
+
+    // When it runs serially and with concurrent stages
+    PipelineOptions serialOptions;
+    serialOptions.parallelStages = false;
+    serialOptions.timings = false;
+    PipelineOptions parallelOptions = serialOptions;
+    parallelOptions.parallelStages = true;
+    parallelOptions.threads = 4;
+
+    std::ostringstream serialOut, parallelOut;
+    AlignmentMap serialMap, parallelMap;
+    AlignmentEditor serialEditor, parallelEditor;
+    PipelineReport serial = runPipeline(script, serialMap, serialEditor, serialOut, serialOptions);
+    PipelineReport parallel = runPipeline(script, parallelMap, parallelEditor, parallelOut, parallelOptions);
+
+    // Then the output is identical and in script order
+    ASSERT_EQUAL(parallelOut.str(), serialOut.str());
+    ASSERT_TRUE(serialOut.str().find("[3] stats\n  genes: 6\n") != std::string::npos);
+    ASSERT_TRUE(serialOut.str().find("[4]") < serialOut.str().find("[5]"));
+
+    // And independent commands were grouped into fewer stages
+    ASSERT_EQUAL(serial.stages, 10);
+    ASSERT_TRUE(parallel.stages < serial.stages);
+
+    // And the failing command is reported without stopping the rest
+    ASSERT_EQUAL(parallel.failed, 1);
+    ASSERT_TRUE(parallelOut.str().find("  error: no gene NO_SUCH_GENE") != std::string::npos);
+    AlignmentMap reloaded;
+    reloaded.loadGenesFromCSV(genesPath);
+    ASSERT_EQUAL(reloaded.getGenes().size(), 6);
+    ASSERT_EQUAL(parallelEditor.getSequences()[1].aligned, "TT-GATTGATCGATCG");
+}
@@ -0,0 +1,132 @@
+#include "polygenic_score.h"
+#include "test_runner.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+static bool near(double a, double b) {
+    return std::abs(a - b) < 1e-12;
+}
+
+// Test sample and gene scores, imputation and write-back on a hand-checked input.
+TEST_CASE(PolygenicScore_HandCheckedScores) {
+    // Given weights where rs2 counts towards two genes, plus one malformed row
+    std::istringstream weightsText("variant,gene,effect\n"
+                                   "rs1,GENE1,0.5\n"
+                                   "rs2,GENE1,-1\n"
+                                   "rs2,GENE2,2\n"
+                                   "rs3,GENE3,1\n"
+                                   "rs9,GENE9,not-a-number\n");
+    PolygenicWeights weights = PolygenicWeights::read(weightsText);
+    ASSERT_EQUAL(weights.size(), 4);
+    ASSERT_EQUAL(weights.skippedRows(), 1);
+    ASSERT_EQUAL(weights.genes().size(), 3);
+
+    // And tab-separated dosages with a missing value, an unweighted variant
+    // and a row with too few samples
+    std::istringstream dosages("variant\tS1\tS2\tS3\r\n"
+                               "rs1\t0\t1\t2\r\n"
+                               "rs2\t2\tNA\t0\r\n"
+                               "rs4\t1\t1\t1\r\n"
+                               "rs1\t1\t2\r\n");
+
+    // When scored
+    PolygenicScoreReport report = scorePolygenic(weights, dosages);
+
+    // Then the NA takes rs2's mean dosage (1) and each sample sums effect x dosage
+    ASSERT_TRUE(report.samples == std::vector<std::string>({"S1", "S2", "S3"}));
+    ASSERT_TRUE(near(report.sampleScores[0], 2.0));
+    ASSERT_TRUE(near(report.sampleScores[1], 1.5));
+    ASSERT_TRUE(near(report.sampleScores[2], 1.0));
+    ASSERT_EQUAL(report.variantsRead, 4);
+    ASSERT_EQUAL(report.variantsScored, 2);
+    ASSERT_EQUAL(report.missingDosages, 1);
+    ASSERT_EQUAL(report.malformedRows, 1);
+
+    // And gene scores are per-sample means that add up to the mean sample score
+    ASSERT_TRUE(report.genes == std::vector<std::string>({"GENE1", "GENE2", "GENE3"}));
+    ASSERT_TRUE(near(report.geneScores[0], -0.5));
+    ASSERT_TRUE(near(report.geneScores[1], 2.0));
+    ASSERT_EQUAL(report.geneVariants[2], 0);
+
+    // And only genes with a scored variant are written into the map
+    AlignmentMap map;
+    map.addGene({"GENE1", "1", 0, 10, 1.0, 0.0, false, {}});
+    map.addGene({"GENE3", "2", 0, 10, 1.0, 0.7, false, {}});
+    map.addGene({"OTHER", "3", 0, 10, 1.0, 0.0, false, {}});
+    ASSERT_EQUAL(applyPolygenicScores(report, map), 1);
+    ASSERT_TRUE(near(map.getGenes()[0].polygenicScore, -0.5));
+    ASSERT_TRUE(near(map.getGenes()[1].polygenicScore, 0.7));
+    ASSERT_TRUE(near(map.calculateStatistics().avgPolyScore, 0.2 / 3));
+
+    // And sample scores can be exported
+    ASSERT_TRUE(writeSampleScoresCSV(report, "test_sample_scores.csv"));
+    std::ifstream in("test_sample_scores.csv");
+    std::string header, first;
+    std::getline(in, header);
+    std::getline(in, first);
+    ASSERT_EQUAL(header, "sample,score");
+    ASSERT_EQUAL(first, "S1,2");
+    in.close();
+    std::remove("test_sample_scores.csv");
+}
+
+// Test that block size and thread count do not change any sum.
+TEST_CASE(PolygenicScore_BlocksAndThreadsAgree) {
+    // Given 2000 variants over 37 samples, a third of them weighted
+    std::mt19937 rng(3);
+    std::ostringstream weightsText, dosageText;
+    weightsText << "variant,gene,effect\n";
+    dosageText << "variant";
+    for (int s = 0; s < 37; ++s) dosageText << ",S" << s;
+    dosageText << '\n';
+    for (int v = 0; v < 2000; ++v) {
+        if (v % 3 == 0) weightsText << "rs" << v << ",G" << v % 17 << ',' << (int(rng() % 200) - 100) / 64.0 << '\n';
+        dosageText << "rs" << v;
+        for (int s = 0; s < 37; ++s) {
+            if (rng() % 50 == 0) dosageText << ",NA";
+            else dosageText << ',' << rng() % 3;
+        }
+        dosageText << '\n';
+    }
+    std::istringstream weightsIn(weightsText.str());
+    PolygenicWeights weights = PolygenicWeights::read(weightsIn);
+
+    // When scored in one block on one thread, and in small blocks on four
+    PolygenicScoreOptions whole;
+    whole.threads = 1;
+    whole.blockVariants = 100000;
+    PolygenicScoreOptions small;
+    small.threads = 4;
+    small.blockVariants = 7;
+    std::istringstream a(dosageText.str()), b(dosageText.str());
+    PolygenicScoreReport one = scorePolygenic(weights, a, whole);
+    PolygenicScoreReport many = scorePolygenic(weights, b, small);
+
+    // Then counts are identical and sums agree to rounding
+    ASSERT_EQUAL(one.variantsRead, 2000);
+    ASSERT_EQUAL(many.variantsScored, one.variantsScored);
+    ASSERT_EQUAL(many.missingDosages, one.missingDosages);
+    bool same = true;
+    double geneTotal = 0.0, sampleMean = 0.0;
+    for (size_t s = 0; s < one.sampleScores.size(); ++s) {
+        same = same && std::abs(one.sampleScores[s] - many.sampleScores[s]) < 1e-9;
+        sampleMean += one.sampleScores[s] / double(one.sampleScores.size());
+    }
+    for (size_t g = 0; g < one.geneScores.size(); ++g) {
+        same = same && std::abs(one.geneScores[g] - many.geneScores[g]) < 1e-9;
+        geneTotal += one.geneScores[g];
+    }
+    ASSERT_TRUE(same);
+    ASSERT_TRUE(std::abs(geneTotal - sampleMean) < 1e-9);
+
+    // And the same small blocks on one thread give bit-identical sums
+    PolygenicScoreOptions smallSerial = small;
+    smallSerial.threads = 1;
+    std::istringstream c(dosageText.str());
+    PolygenicScoreReport serial = scorePolygenic(weights, c, smallSerial);
+    ASSERT_TRUE(serial.sampleScores == many.sampleScores);
+    ASSERT_TRUE(serial.geneScores == many.geneScores);
+}
@@ -0,0 +1,103 @@
+#include "shared_gene_store.h"
+#include "test_runner.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+// Test that a built store reads back every field through views and materialised copies.
+TEST_CASE(SharedGeneStore_BuildAndAttach) {
+    // Given the sample genes plus one with every field set
+    AlignmentMap map;
+    map.loadGenesFromJSON("tests/genes.json");
+    GeneModel full;
+    full.symbol = "AAA1";
+    full.chromosome = "chr7";
+    full.start = 100;
+    full.end = 250;
+    full.expressionLevel = 3.25;
+    full.polygenicScore = 0.5;
+    full.isKnockout = true;
+    full.categories = {"kinase", "receptor"};
+    full.disorderTags = {"Autism"};
+    setRegionExpression(full.brainRegionExpression, "Striatum", 0.4);
+    setRegionExpression(full.brainRegionExpression, "Cortex", 0.9);
+    map.addGene(full);
+
+    // When it is built and attached twice, as two reader processes would
+    const std::string path = "test_shared_genes.bin";
+    ASSERT_TRUE(buildSharedGeneStore(map.getGenes(), path));
+    SharedGeneStore first = SharedGeneStore::attach(path);
+    SharedGeneStore second = SharedGeneStore::attach(path);
+
+    // Then both see every gene, and lookups work without copying
+    ASSERT_EQUAL(first.size(), map.getGenes().size());
+    ASSERT_TRUE(first.verify());
+    size_t id = second.find("AAA1");
+    ASSERT_EQUAL(id, map.getGenes().size() - 1);
+    SharedGeneView v = second[id];
+    ASSERT_EQUAL(std::string(v.chromosome()), "chr7");
+    ASSERT_EQUAL(v.end(), 250);
+    ASSERT_TRUE(v.isKnockout());
+    ASSERT_EQUAL(std::string(v.category(1)), "receptor");
+    ASSERT_EQUAL(v.regionExpression("Cortex"), 0.9);
+    ASSERT_TRUE(std::isnan(v.regionExpression("Amygdala")));
+    ASSERT_EQUAL(second.find("NOPE"), second.size());
+
+    // And materialised genes equal the originals
+    for (size_t i = 0; i < first.size(); ++i) {
+        GeneModel g = first[i].materialize();
+        const GeneModel& original = map.getGenes()[i];
+        ASSERT_EQUAL(g.symbol, original.symbol);
+        ASSERT_EQUAL(g.expressionLevel, original.expressionLevel);
+        ASSERT_TRUE(g.categories == original.categories);
+        ASSERT_TRUE(g.disorderTags == original.disorderTags);
+        ASSERT_TRUE(g.brainRegionExpression == original.brainRegionExpression);
+    }
+
+    // And a moved store keeps the mapping while the source is empty
+    SharedGeneStore moved = std::move(first);
+    ASSERT_FALSE(first.attached());
+    ASSERT_EQUAL(std::string(moved[id].symbol()), "AAA1");
+    moved.detach();
+    second.detach();
+    std::remove(path.c_str());
+}
+
+// Test that files that are not stores, or are truncated, are refused at attach.
+TEST_CASE(SharedGeneStore_RejectsDamagedFiles) {
+    // Given a valid store, a truncated copy and a file of text
+    AlignmentMap map;
+    map.loadGenesFromJSON("tests/genes.json");
+    ASSERT_TRUE(buildSharedGeneStore(map.getGenes(), "test_shared_valid.bin"));
+    std::ifstream in("test_shared_valid.bin", std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream("test_shared_truncated.bin", std::ios::binary).write(bytes.data(), std::streamsize(bytes.size() - 8));
+    std::ofstream("test_shared_text.bin") << "gene_name,knockout\nA,X\n";
+    // And a copy whose region records would start 4 bytes off their 8-byte alignment
+    std::string misaligned = bytes;
+    uint64_t regionsOffset;
+    std::memcpy(&regionsOffset, misaligned.data() + offsetof(shared_gene_layout::Header, regionsOffset), 8);
+    regionsOffset += 4;
+    std::memcpy(&misaligned[offsetof(shared_gene_layout::Header, regionsOffset)], &regionsOffset, 8);
+    std::ofstream("test_shared_misaligned.bin", std::ios::binary).write(misaligned.data(), std::streamsize(misaligned.size()));
+
+    // Then attaching any of them throws, as does a missing file
+    for (const char* path : {"test_shared_truncated.bin", "test_shared_text.bin", "test_shared_misaligned.bin",
+                             "no_such_store.bin"}) {
+        bool thrown = false;
+        try {
+            SharedGeneStore::attach(path);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        ASSERT_TRUE(thrown);
+    }
+    for (const char* path : {"test_shared_valid.bin", "test_shared_truncated.bin", "test_shared_text.bin",
+                             "test_shared_misaligned.bin"})
+        std::remove(path);
+}
@@ -0,0 +1,62 @@
+#include "trace.h"
+#include "test_runner.h"
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Test that scopes and counters from several threads end up in one Chrome trace.
+TEST_CASE(Trace_ScopesAndCountersExport) {
+    // Given events recorded on the main thread and two workers
+    clearTrace();
+    TraceCounter genes("test.genes");
+    {
+        TraceScope outer("test.outer");
+        genes.add(5);
+    }
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 2; ++i) {
+        workers.emplace_back([&]() {
+            TraceScope scope("test.worker");
+            genes.add(1);
+        });
+    }
+    for (auto& t : workers) t.join();
+
+    // When exporting
+    std::ostringstream out;
+    writeChromeTrace(out);
+    std::string json = out.str();
+
+    // Then every event is present with its phase, and the counter total is monotonic
+    ASSERT_EQUAL(traceEventCount(), 6);
+    ASSERT_EQUAL(genes.value(), 7);
+    ASSERT_TRUE(json.find("\"traceEvents\"") != std::string::npos);
+    ASSERT_TRUE(json.find("\"name\": \"test.outer\", \"ph\": \"X\"") != std::string::npos);
+    ASSERT_TRUE(json.find("\"name\": \"test.worker\"") != std::string::npos);
+    ASSERT_TRUE(json.find("\"args\": {\"value\": 7}") != std::string::npos);
+    ASSERT_TRUE(json.find("\"thread_name\"") != std::string::npos);
+}
+
+// Test that a full ring keeps only the most recent events.
+TEST_CASE(Trace_RingBufferOverwritesOldest) {
+    // Given a ring capacity of 16 events
+    clearTrace();
+    setTraceRingCapacity(16);
+
+    // When a fresh thread records 100 counter updates
+    std::thread writer([]() {
+        TraceCounter count("test.ring");
+        for (int i = 0; i < 100; ++i) count.add(1);
+    });
+    writer.join();
+
+    // Then only the last 16 survive
+    std::ostringstream out;
+    writeChromeTrace(out);
+    ASSERT_EQUAL(traceEventCount(), 16);
+    ASSERT_TRUE(out.str().find("{\"value\": 100}") != std::string::npos);
+    ASSERT_TRUE(out.str().find("{\"value\": 84}") == std::string::npos);
+    setTraceRingCapacity(32768);
+    clearTrace();
+}
@@ -0,0 +1,143 @@
+#include "variant_extraction.h"
+#include "test_runner.h"
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+static SequenceModel sequence(const std::string& name, const std::string& aligned) {
+    return {name, SequenceType::DNA, aligned, aligned};
+}
+
+static std::string describe(const Variant& v) {
+    return std::to_string(v.sequence) + ":" + variantTypeName(v.type) + "@" + std::to_string(v.column) + "/"
+         + std::to_string(v.position) + ":" + v.ref + ">" + v.alt;
+}
+
+// Column-by-column diff with no skipping, for checking the fast path.
+static std::vector<std::string> naiveVariants(const AlignmentBlock& block) {
+    std::vector<std::string> out;
+    for (size_t s = 0; s < block.sequences.size(); ++s) {
+        const std::string& seq = block.sequences[s].aligned;
+        size_t refPos = 0;
+        Variant open{};
+        bool isOpen = false;
+        for (size_t c = 0; c < seq.size(); ++c) {
+            char r = c < block.reference.size() ? block.reference[c] : '-';
+            bool rg = r == '-' || r == '.', ag = seq[c] == '-' || seq[c] == '.';
+            if (rg && ag) continue;
+            if (!rg && !ag) {
+                if (isOpen) out.push_back(describe(open));
+                isOpen = false;
+                if (std::toupper(r) != std::toupper(seq[c]))
+                    out.push_back(describe({VariantType::SNV, s, c, refPos, std::string(1, r), std::string(1, seq[c])}));
+                ++refPos;
+                continue;
+            }
+            VariantType type = rg ? VariantType::Insertion : VariantType::Deletion;
+            if (isOpen && open.type != type) {
+                out.push_back(describe(open));
+                isOpen = false;
+            }
+            if (!isOpen) open = {type, s, c, refPos, {}, {}};
+            isOpen = true;
+            if (rg) open.alt.push_back(seq[c]);
+            else { open.ref.push_back(r); ++refPos; }
+        }
+        if (isOpen) out.push_back(describe(open));
+    }
+    return out;
+}
+
+// Test SNVs, insertions and deletions against a hand-checked block.
+TEST_CASE(Variants_HandCheckedBlock) {
+    // Given a reference with an insertion column pair and four samples
+    AlignmentBlock block;
+    block.reference = "ACGT--ACGT";
+    block.sequences = {sequence("same", "ACGT--ACGT"),
+                       sequence("mixed", "ACCTGGA--T"),
+                       sequence("longer", "acgt--ACGTAA"),
+                       sequence("shorter", "AC-.--T")};
+
+    // When variants are extracted
+    VariantReport report = extractVariants(block);
+
+    // Then each event has its column and ungapped reference position
+    std::vector<std::string> got;
+    for (const auto& v : report.variants) got.push_back(describe(v));
+    std::vector<std::string> expected = {
+        "1:SNV@2/2:G>C", "1:INS@4/4:>GG", "1:DEL@7/5:CG>",
+        "2:INS@10/8:>AA",
+        "3:DEL@2/2:GT>", "3:SNV@6/4:A>T"};
+    ASSERT_TRUE(got == expected);
+
+    // And the summaries count events and bases per sequence
+    ASSERT_EQUAL(report.sequences[0].compared, 8);
+    ASSERT_EQUAL(report.sequences[0].mismatches, 0);
+    ASSERT_EQUAL(report.sequences[1].mismatches, 1);
+    ASSERT_EQUAL(report.sequences[1].insertedBases, 2);
+    ASSERT_EQUAL(report.sequences[1].deletions, 1);
+    ASSERT_EQUAL(report.sequences[1].deletedBases, 2);
+    ASSERT_EQUAL(report.sequences[2].compared, 8);
+    ASSERT_EQUAL(report.sequences[2].insertions, 1);
+    ASSERT_EQUAL(report.sequences[3].compared, 3);
+
+    // And the CSV export has one row per variant
+    ASSERT_TRUE(writeVariantsCSV(report, block, "test_variants.csv"));
+    std::ifstream in("test_variants.csv");
+    std::string header, first;
+    std::getline(in, header);
+    std::getline(in, first);
+    ASSERT_EQUAL(header, "sequence,type,column,position,ref,alt");
+    ASSERT_EQUAL(first, "mixed,SNV,2,2,G,C");
+    in.close();
+    std::remove("test_variants.csv");
+}
+
+// Test that the bulk-skipping scan agrees with a plain column walk, on any thread count.
+TEST_CASE(Variants_MatchColumnWalk) {
+    // Given long samples that mostly match a gapped reference
+    std::mt19937 rng(11);
+    AlignmentBlock block;
+    for (int i = 0; i < 3000; ++i) block.reference.push_back(rng() % 40 == 0 ? '-' : "ACGT"[rng() % 4]);
+    for (int s = 0; s < 24; ++s) {
+        std::string aligned = block.reference;
+        for (char& c : aligned) {
+            unsigned roll = rng() % 200;
+            if (roll == 0) c = "ACGT"[rng() % 4];
+            else if (roll == 1) c = '-';
+            else if (roll == 2) c = char(std::tolower(c));
+        }
+        aligned.resize(aligned.size() - rng() % 50);
+        if (s % 5 == 0) aligned += "ACGTACGT";
+        block.sequences.push_back(sequence("s" + std::to_string(s), aligned));
+    }
+
+    // When extracted on one thread and on four
+    VariantOptions serial;
+    serial.threads = 1;
+    VariantOptions parallel;
+    parallel.threads = 4;
+    VariantReport one = extractVariants(block, serial);
+    VariantReport four = extractVariants(block, parallel);
+
+    // Then both match the column walk exactly
+    std::vector<std::string> a, b;
+    for (const auto& v : one.variants) a.push_back(describe(v));
+    for (const auto& v : four.variants) b.push_back(describe(v));
+    ASSERT_TRUE(a == naiveVariants(block));
+    ASSERT_TRUE(b == a);
+
+    // And counting alone gives the same summaries
+    VariantOptions countsOnly;
+    countsOnly.collectVariants = false;
+    VariantReport counts = extractVariants(block, countsOnly);
+    ASSERT_TRUE(counts.variants.empty());
+    bool same = true;
+    for (size_t i = 0; i < block.sequences.size(); ++i) {
+        same = same && counts.sequences[i].mismatches == one.sequences[i].mismatches
+                    && counts.sequences[i].deletedBases == one.sequences[i].deletedBases
+                    && counts.sequences[i].insertions == one.sequences[i].insertions;
+    }
+    ASSERT_TRUE(same);
+}